@@ -7,17 +7,24 @@ solaris-cc*:QMAKE_CXXFLAGS_RELEASE -= -O2
 #QMAKE_DOCS = $$PWD/doc/qtopencl.qdocconf
 load(qt_module)
 
+# Resolve OpenCL at runtime rather than at link time, so that applications
+# can start and detect that OpenCL is missing.  The OpenCL framework is
+# always present on Mac OS X, so link to it directly there.
+!macx:!no_opencl_dynamic:CONFIG += opencl_dynamic
+
 win32 {
     !isEmpty(QMAKE_INCDIR_OPENCL) {
         QMAKE_CXXFLAGS += -I$$QMAKE_INCDIR_OPENCL
     }
-    !isEmpty(QMAKE_LIBDIR_OPENCL) {
-        LIBS += -L$$QMAKE_LIBDIR_OPENCL
-    }
-    !isEmpty(QMAKE_LIBS_OPENCL) {
-        LIBS += $$QMAKE_LIBS_OPENCL
-    } else {
-        LIBS += -lOpenCL
+    !opencl_dynamic {
+        !isEmpty(QMAKE_LIBDIR_OPENCL) {
+            LIBS += -L$$QMAKE_LIBDIR_OPENCL
+        }
+        !isEmpty(QMAKE_LIBS_OPENCL) {
+            LIBS += $$QMAKE_LIBS_OPENCL
+        } else {
+            LIBS += -lOpenCL
+        }
     }
 }
 
@@ -26,46 +33,69 @@ macx: {
 }
 
 HEADERS += \
+    qclalgorithms.h \
     qclbuffer.h \
+    qclbufferpool.h \
+    qclcommandlist.h \
     qclcommandqueue.h \
     qclcontext.h \
     qcldevice.h \
     qclevent.h \
+    qcleventwatcher.h \
     qclglobal.h \
     qclimage.h \
     qclimageformat.h \
     qclkernel.h \
     qclmemoryobject.h \
     qclplatform.h \
+    qclprofiler.h \
     qclprogram.h \
     qclsampler.h \
+    qclstreambuffer.h \
     qcluserevent.h \
     qclvector.h \
+    qclvectorexpression.h \
     qclworksize.h
 
 SOURCES += \
+    qclalgorithms.cpp \
     qclbuffer.cpp \
+    qclbufferpool.cpp \
+    qclcommandlist.cpp \
     qclcommandqueue.cpp \
     qclcontext.cpp \
     qcldevice.cpp \
     qclevent.cpp \
+    qcleventwatcher.cpp \
     qclimage.cpp \
     qclimageformat.cpp \
     qclkernel.cpp \
     qclmemoryobject.cpp \
     qclplatform.cpp \
+    qclprofiler.cpp \
     qclprogram.cpp \
     qclsampler.cpp \
+    qclstaging.cpp \
+    qclstreambuffer.cpp \
     qcluserevent.cpp \
     qclvector.cpp \
+    qclvectorexpression.cpp \
     qclworksize.cpp
 
 PRIVATE_HEADERS += \
-    qclext_p.h
+    qclext_p.h \
+    qclkernel_p.h \
+    qclloader_p.h \
+    qclproperties_p.h \
+    qclstaging_p.h
 
 HEADERS += $$PRIVATE_HEADERS
 
 DEFINES += QT_BUILD_CL_LIB
+SOURCES += qclloader.cpp
+opencl_dynamic {
+    DEFINES += QT_OPENCL_DYNAMIC
+}
 config_opencl_1_1 {
     DEFINES += QT_OPENCL_1_1
 }
@@ -0,0 +1,992 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qclalgorithms.h"
+#include "qclcontext.h"
+#include "qclkernel.h"
+#include "qclloader_p.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qvarlengtharray.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QCLAlgorithms
+    \brief The QCLAlgorithms class provides parallel algorithms that run on the device over a QCLVector.
+    \since 4.7
+    \ingroup opencl
+
+    QCLAlgorithms provides reductions, prefix sums, stream compaction,
+    and sorting for QCLVector objects without reading the vector back
+    to the host:
+
+    \code
+    QCLAlgorithms algorithms(&context);
+    QCLVector<float> values = context.createVector<float>(1000000);
+    ...
+    float total = algorithms.reduce(values);
+    float largest = algorithms.reduce(values, QCLAlgorithms::Maximum);
+
+    QCLVector<float> sums;
+    algorithms.inclusiveScan(values, sums);
+
+    algorithms.sort(values);
+    \endcode
+
+    The element type T may be \c cl_int, \c cl_uint, \c cl_long,
+    \c cl_ulong, \c cl_float, or \c cl_double.  Vectors of \c cl_double
+    require a device with the \c{cl_khr_fp64} extension.
+
+    The kernels for each element type are generated and built the first
+    time they are needed, and the resulting programs are shared by all
+    QCLAlgorithms objects on the same context.  The work-group size is
+    chosen from the limits of the context's default device and the
+    amount of local memory that it provides.
+
+    All commands are submitted to the context's active command queue.
+    Functions that return a result, such as reduce() and compact(),
+    wait for the commands to finish; the others return once the
+    commands have been queued.
+
+    Output vectors that are null are created with the same size as the
+    input, and other output vectors are resized to fit; see
+    QCLVector::resize().
+
+    \section1 Host vectors
+
+    Vectors whose elements are kept in host memory, because their
+    context could not be created, are processed on the host instead
+    (see QCLVector::isHostOnly()).  fill(), copy(), transform(), and
+    reduce() split the vector into chunks that run in parallel on
+    QThreadPool::globalInstance(), with simple loops that the compiler
+    can vectorize; the other algorithms run on the calling thread.
+    Code that uses QCLAlgorithms therefore keeps working, on all of
+    the CPU cores, on systems without OpenCL.
+
+    transform() applies a C++ function to each element, so it always
+    runs on the host, mapping device vectors into host memory first.
+
+    \sa QCLVector
+*/
+
+/*!
+    \enum QCLAlgorithms::ReduceOperation
+    This enum defines the operation that is performed by reduce().
+
+    \value Sum Adds all of the elements together.
+    \value Minimum Returns the smallest element.
+    \value Maximum Returns the largest element.
+*/
+
+/*!
+    \enum QCLAlgorithms::ElementType
+    \internal
+*/
+
+static const char qt_cl_algorithms_source[] =
+"__kernel void fill(__global T *output, T value, uint n)\n"
+"{\n"
+"    uint gid = get_global_id(0);\n"
+"    if (gid < n)\n"
+"        output[gid] = value;\n"
+"}\n"
+"\n"
+"inline T qt_combine(T a, T b, int op)\n"
+"{\n"
+"    if (op == 1)\n"
+"        return a < b ? a : b;\n"
+"    else if (op == 2)\n"
+"        return a > b ? a : b;\n"
+"    return a + b;\n"
+"}\n"
+"\n"
+"__kernel void reduce(__global const T *input, __global T *output,\n"
+"                     uint n, int op, __local T *scratch)\n"
+"{\n"
+"    uint lid = get_local_id(0);\n"
+"    uint size = get_local_size(0);\n"
+"    uint base = get_group_id(0) * size * 2;\n"
+"    uint i = base + lid;\n"
+"    T value = (op == 0) ? (T)0 : input[base];\n"
+"    if (i < n)\n"
+"        value = input[i];\n"
+"    if ((i + size) < n)\n"
+"        value = qt_combine(value, input[i + size], op);\n"
+"    scratch[lid] = value;\n"
+"    barrier(CLK_LOCAL_MEM_FENCE);\n"
+"    for (uint s = size / 2; s > 0; s >>= 1) {\n"
+"        if (lid < s)\n"
+"            scratch[lid] = qt_combine(scratch[lid], scratch[lid + s], op);\n"
+"        barrier(CLK_LOCAL_MEM_FENCE);\n"
+"    }\n"
+"    if (lid == 0)\n"
+"        output[get_group_id(0)] = scratch[0];\n"
+"}\n"
+"\n"
+"__kernel void scanBlocks(__global const T *input, __global T *output,\n"
+"                         __global T *blockSums, uint n, int inclusive,\n"
+"                         __local T *scratch)\n"
+"{\n"
+"    uint lid = get_local_id(0);\n"
+"    uint size = get_local_size(0);\n"
+"    uint gid = get_global_id(0);\n"
+"    scratch[lid] = (gid < n) ? input[gid] : (T)0;\n"
+"    barrier(CLK_LOCAL_MEM_FENCE);\n"
+"    for (uint offset = 1; offset < size; offset <<= 1) {\n"
+"        T add = (lid >= offset) ? scratch[lid - offset] : (T)0;\n"
+"        barrier(CLK_LOCAL_MEM_FENCE);\n"
+"        scratch[lid] += add;\n"
+"        barrier(CLK_LOCAL_MEM_FENCE);\n"
+"    }\n"
+"    if (gid < n) {\n"
+"        if (inclusive)\n"
+"            output[gid] = scratch[lid];\n"
+"        else\n"
+"            output[gid] = (lid > 0) ? scratch[lid - 1] : (T)0;\n"
+"    }\n"
+"    if (lid == (size - 1))\n"
+"        blockSums[get_group_id(0)] = scratch[lid];\n"
+"}\n"
+"\n"
+"__kernel void addOffsets(__global T *output, __global const T *offsets,\n"
+"                         uint n)\n"
+"{\n"
+"    uint gid = get_global_id(0);\n"
+"    if (gid < n)\n"
+"        output[gid] += offsets[get_group_id(0)];\n"
+"}\n"
+"\n"
+"__kernel void nonZeroFlags(__global const T *input, __global int *flags,\n"
+"                           uint n)\n"
+"{\n"
+"    uint gid = get_global_id(0);\n"
+"    if (gid < n)\n"
+"        flags[gid] = (input[gid] != (T)0) ? 1 : 0;\n"
+"}\n"
+"\n"
+"__kernel void compact(__global const T *input, __global const int *flags,\n"
+"                      __global const int *positions, __global T *output,\n"
+"                      uint n)\n"
+"{\n"
+"    uint gid = get_global_id(0);\n"
+"    if (gid < n && flags[gid])\n"
+"        output[positions[gid]] = input[gid];\n"
+"}\n"
+"\n"
+"__kernel void radixFlags(__global const T *input, __global uint *flags,\n"
+"                         uint n, uint bit)\n"
+"{\n"
+"    uint gid = get_global_id(0);\n"
+"    if (gid < n)\n"
+"        flags[gid] = ((TO_KEY(input[gid]) >> bit) & 1) ? 0 : 1;\n"
+"}\n"
+"\n"
+"__kernel void radixScatter(__global const T *input, __global T *output,\n"
+"                           __global const uint *flags,\n"
+"                           __global const uint *positions, uint n)\n"
+"{\n"
+"    uint gid = get_global_id(0);\n"
+"    if (gid >= n)\n"
+"        return;\n"
+"    uint zeros = positions[n - 1] + flags[n - 1];\n"
+"    uint index;\n"
+"    if (flags[gid])\n"
+"        index = positions[gid];\n"
+"    else\n"
+"        index = zeros + gid - positions[gid];\n"
+"    output[index] = input[gid];\n"
+"}\n";
+
+struct QCLAlgorithmsTypeInfo
+{
+    const char *name;
+    size_t size;
+    int keyBits;
+    const char *defines;
+};
+
+// Sort keys map each element to an unsigned integer with the same
+// ordering, so that the radix sort can treat all types alike.
+static const QCLAlgorithmsTypeInfo qt_cl_algorithms_types[] = {
+    {"int", sizeof(cl_int), 32,
+     "#define T int\n"
+     "#define TO_KEY(x) (as_uint(x) ^ 0x80000000u)\n"},
+    {"uint", sizeof(cl_uint), 32,
+     "#define T uint\n"
+     "#define TO_KEY(x) (x)\n"},
+    {"long", sizeof(cl_long), 64,
+     "#define T long\n"
+     "#define TO_KEY(x) (as_ulong(x) ^ 0x8000000000000000ul)\n"},
+    {"ulong", sizeof(cl_ulong), 64,
+     "#define T ulong\n"
+     "#define TO_KEY(x) (x)\n"},
+    {"float", sizeof(cl_float), 32,
+     "#define T float\n"
+     "#define TO_KEY(x) ((as_uint(x) & 0x80000000u) ? ~as_uint(x) : "
+     "(as_uint(x) | 0x80000000u))\n"},
+    {"double", sizeof(cl_double), 64,
+     "#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n"
+     "#define T double\n"
+     "#define TO_KEY(x) ((as_ulong(x) & 0x8000000000000000ul) ? ~as_ulong(x) : "
+     "(as_ulong(x) | 0x8000000000000000ul))\n"}
+};
+
+// Arguments for the host implementations that run in chunks.
+struct QCLAlgorithmsHostArgs
+{
+    const void *input;
+    void *output;
+    const void *value;
+    size_t elemSize;
+    QCLAlgorithms::ReduceOperation operation;
+    void *partials;
+};
+
+typedef void (*QCLAlgorithmsHostFunction)
+    (void *closure, int chunk, int begin, int end);
+
+template <typename T>
+struct QCLAlgorithmsHost
+{
+    static void fill(void *closure, int chunk, int begin, int end);
+    static void reduce(void *closure, int chunk, int begin, int end);
+    static void scan(const void *input, void *output, int size, bool inclusive);
+    static int compact(const void *input, const cl_int *flags,
+                       void *output, int size);
+    static void sort(void *data, int size);
+};
+
+template <typename T>
+void QCLAlgorithmsHost<T>::fill(void *closure, int, int begin, int end)
+{
+    QCLAlgorithmsHostArgs *args = static_cast<QCLAlgorithmsHostArgs *>(closure);
+    T *output = static_cast<T *>(args->output);
+    const T value = *static_cast<const T *>(args->value);
+    for (int index = begin; index < end; ++index)
+        output[index] = value;
+}
+
+// Reduces the elements between begin and end into partials[chunk].
+// The operation is switched outside of the loops to keep them simple.
+template <typename T>
+void QCLAlgorithmsHost<T>::reduce(void *closure, int chunk, int begin, int end)
+{
+    QCLAlgorithmsHostArgs *args = static_cast<QCLAlgorithmsHostArgs *>(closure);
+    const T *input = static_cast<const T *>(args->input);
+    T value = input[begin];
+    switch (args->operation) {
+    case QCLAlgorithms::Sum:
+        for (int index = begin + 1; index < end; ++index)
+            value += input[index];
+        break;
+    case QCLAlgorithms::Minimum:
+        for (int index = begin + 1; index < end; ++index)
+            value = qMin(value, input[index]);
+        break;
+    case QCLAlgorithms::Maximum:
+        for (int index = begin + 1; index < end; ++index)
+            value = qMax(value, input[index]);
+        break;
+    }
+    static_cast<T *>(args->partials)[chunk] = value;
+}
+
+template <typename T>
+void QCLAlgorithmsHost<T>::scan
+    (const void *input, void *output, int size, bool inclusive)
+{
+    const T *in = static_cast<const T *>(input);
+    T *out = static_cast<T *>(output);
+    T sum = T(0);
+    for (int index = 0; index < size; ++index) {
+        T value = in[index];
+        if (inclusive) {
+            sum += value;
+            out[index] = sum;
+        } else {
+            out[index] = sum;
+            sum += value;
+        }
+    }
+}
+
+template <typename T>
+int QCLAlgorithmsHost<T>::compact
+    (const void *input, const cl_int *flags, void *output, int size)
+{
+    const T *in = static_cast<const T *>(input);
+    T *out = static_cast<T *>(output);
+    int count = 0;
+    for (int index = 0; index < size; ++index) {
+        if (flags ? flags[index] != 0 : in[index] != T(0))
+            out[count++] = in[index];
+    }
+    return count;
+}
+
+template <typename T>
+void QCLAlgorithmsHost<T>::sort(void *data, int size)
+{
+    T *values = static_cast<T *>(data);
+    qStableSort(values, values + size);
+}
+
+struct QCLAlgorithmsHostFunctions
+{
+    QCLAlgorithmsHostFunction fill;
+    QCLAlgorithmsHostFunction reduce;
+    void (*scan)(const void *input, void *output, int size, bool inclusive);
+    int (*compact)(const void *input, const cl_int *flags,
+                   void *output, int size);
+    void (*sort)(void *data, int size);
+};
+
+#define QT_CL_HOST_FUNCTIONS(type) \
+    {QCLAlgorithmsHost<type>::fill, QCLAlgorithmsHost<type>::reduce, \
+     QCLAlgorithmsHost<type>::scan, QCLAlgorithmsHost<type>::compact, \
+     QCLAlgorithmsHost<type>::sort}
+
+// Indexed by QCLAlgorithms::ElementType, like qt_cl_algorithms_types.
+static const QCLAlgorithmsHostFunctions qt_cl_algorithms_host[] = {
+    QT_CL_HOST_FUNCTIONS(cl_int),
+    QT_CL_HOST_FUNCTIONS(cl_uint),
+    QT_CL_HOST_FUNCTIONS(cl_long),
+    QT_CL_HOST_FUNCTIONS(cl_ulong),
+    QT_CL_HOST_FUNCTIONS(cl_float),
+    QT_CL_HOST_FUNCTIONS(cl_double)
+};
+
+static void qt_cl_host_copy(void *closure, int, int begin, int end)
+{
+    QCLAlgorithmsHostArgs *args = static_cast<QCLAlgorithmsHostArgs *>(closure);
+    size_t elemSize = args->elemSize;
+    ::memmove(static_cast<uchar *>(args->output) + begin * elemSize,
+              static_cast<const uchar *>(args->input) + begin * elemSize,
+              (end - begin) * elemSize);
+}
+
+// Minimum number of elements for each host thread, below which the
+// cost of handing the work to the thread pool outweighs the work.
+enum { QCLAlgorithmsHostGrain = 16384 };
+
+// Returns the number of elements in each host chunk.  The count is
+// rounded up to a multiple of 16 elements so that every chunk starts
+// on a cache line boundary, and no two threads write to the same line.
+static int qt_cl_host_step(int size)
+{
+    int threads = qMax(QThread::idealThreadCount(), 1);
+    int chunks = qBound(1, size / int(QCLAlgorithmsHostGrain), threads);
+    int step = (size + chunks - 1) / chunks;
+    return (step + 15) & ~15;
+}
+
+class QCLAlgorithmsHostTask : public QRunnable
+{
+public:
+    QCLAlgorithmsHostTask()
+        : function(0), closure(0), chunk(0), begin(0), end(0), done(0)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        function(closure, chunk, begin, end);
+        done->release();
+    }
+
+    QCLAlgorithmsHostFunction function;
+    void *closure;
+    int chunk;
+    int begin;
+    int end;
+    QSemaphore *done;
+};
+
+class QCLAlgorithmsPrivate
+{
+public:
+    QCLAlgorithmsPrivate(QCLContext *ctx) : context(ctx)
+    {
+        for (int index = 0; index <= QCLAlgorithms::Double; ++index)
+            workGroupSizes[index] = 0;
+    }
+
+    QCLContext *context;
+    QCLProgram programs[QCLAlgorithms::Double + 1];
+    size_t workGroupSizes[QCLAlgorithms::Double + 1];
+
+    QCLProgram program(QCLAlgorithms::ElementType type);
+    QCLKernel kernel(QCLAlgorithms::ElementType type, const char *name,
+                     size_t count);
+    QCLBuffer createBuffer(QCLAlgorithms::ElementType type, size_t count)
+    {
+        return context->createBufferDevice
+            (qMax(count, size_t(1)) * qt_cl_algorithms_types[type].size,
+             QCLMemoryObject::ReadWrite);
+    }
+
+    bool scan(QCLAlgorithms::ElementType type, const QCLBuffer &input,
+              const QCLBuffer &output, size_t count, bool inclusive);
+    int compact(QCLAlgorithms::ElementType type, const QCLBuffer &input,
+                const QCLBuffer &flags, const QCLBuffer &output, size_t count);
+};
+
+QCLProgram QCLAlgorithmsPrivate::program(QCLAlgorithms::ElementType type)
+{
+    if (!programs[type].isNull())
+        return programs[type];
+    const QCLAlgorithmsTypeInfo &info = qt_cl_algorithms_types[type];
+    if (type == QCLAlgorithms::Double &&
+            !context->defaultDevice().hasExtension("cl_khr_fp64")) {
+        qWarning() << "QCLAlgorithms: device does not support double";
+        return QCLProgram();
+    }
+    QByteArray source(info.defines);
+    source += qt_cl_algorithms_source;
+    programs[type] = context->builtinProgram
+        (QByteArray("QCLAlgorithms:") + info.name, source.constData());
+    if (programs[type].isNull())
+        return programs[type];
+
+    // Pick the largest power of two work-group size that the device
+    // and the reduction kernel support, and that fits the local memory.
+    QCLDevice device = context->defaultDevice();
+    size_t size = qMin(device.maximumWorkItemsPerGroup(), size_t(256));
+    QCLKernel kernel = programs[type].cachedKernel("reduce");
+    size_t kernelSize = 0;
+    if (clGetKernelWorkGroupInfo
+            (kernel.kernelId(), device.deviceId(), CL_KERNEL_WORK_GROUP_SIZE,
+             sizeof(kernelSize), &kernelSize, 0) == CL_SUCCESS &&
+            kernelSize > 0) {
+        size = qMin(size, kernelSize);
+    }
+    quint64 localMemory = device.localMemorySize();
+    while (size > 2 && localMemory > 0 && size * info.size > localMemory / 2)
+        size /= 2;
+    size_t power = 1;
+    while ((power * 2) <= size)
+        power *= 2;
+    workGroupSizes[type] = power;
+    return programs[type];
+}
+
+QCLKernel QCLAlgorithmsPrivate::kernel
+    (QCLAlgorithms::ElementType type, const char *name, size_t count)
+{
+    QCLKernel kernel = program(type).cachedKernel
+        (name, QCLProgram::PerThreadKernel);
+    if (kernel.isNull())
+        return kernel;
+    size_t size = workGroupSizes[type];
+    kernel.setLocalWorkSize(size);
+    kernel.setGlobalWorkSize(((qMax(count, size_t(1)) + size - 1) / size) * size);
+    return kernel;
+}
+
+bool QCLAlgorithmsPrivate::scan
+    (QCLAlgorithms::ElementType type, const QCLBuffer &input,
+     const QCLBuffer &output, size_t count, bool inclusive)
+{
+    QCLKernel scanBlocks = kernel(type, "scanBlocks", count);
+    if (scanBlocks.isNull())
+        return false;
+    size_t size = workGroupSizes[type];
+    if (size < 2) {
+        qWarning() << "QCLAlgorithms: device work-group size is too small for scan";
+        return false;
+    }
+    size_t blocks = (count + size - 1) / size;
+    QCLBuffer sums = createBuffer(type, blocks);
+    scanBlocks.setArg(0, input);
+    scanBlocks.setArg(1, output);
+    scanBlocks.setArg(2, sums);
+    scanBlocks.setArg(3, cl_uint(count));
+    scanBlocks.setArg(4, cl_int(inclusive ? 1 : 0));
+    scanBlocks.setArg(5, 0, size * qt_cl_algorithms_types[type].size);
+    scanBlocks.run();
+    if (blocks > 1) {
+        // Scan the block totals and add them to the following blocks.
+        if (!scan(type, sums, sums, blocks, false))
+            return false;
+        QCLKernel addOffsets = kernel(type, "addOffsets", count);
+        addOffsets.setArg(0, output);
+        addOffsets.setArg(1, sums);
+        addOffsets.setArg(2, cl_uint(count));
+        addOffsets.run();
+    }
+    return true;
+}
+
+int QCLAlgorithmsPrivate::compact
+    (QCLAlgorithms::ElementType type, const QCLBuffer &input,
+     const QCLBuffer &flags, const QCLBuffer &output, size_t count)
+{
+    QCLBuffer positions = createBuffer(QCLAlgorithms::Int, count);
+    if (!scan(QCLAlgorithms::Int, flags, positions, count, false))
+        return 0;
+    QCLKernel compact = kernel(type, "compact", count);
+    if (compact.isNull())
+        return 0;
+    compact.setArg(0, input);
+    compact.setArg(1, flags);
+    compact.setArg(2, positions);
+    compact.setArg(3, output);
+    compact.setArg(4, cl_uint(count));
+    compact.run();
+
+    cl_int last[2] = {0, 0};
+    positions.read((count - 1) * sizeof(cl_int), &last[0], sizeof(cl_int));
+    flags.read((count - 1) * sizeof(cl_int), &last[1], sizeof(cl_int));
+    return last[0] + last[1];
+}
+
+/*!
+    Constructs an algorithms object for running algorithms on
+    vectors that were created by \a context.
+*/
+QCLAlgorithms::QCLAlgorithms(QCLContext *context)
+    : d_ptr(new QCLAlgorithmsPrivate(context))
+{
+}
+
+/*!
+    Destroys this algorithms object.  The programs that it built
+    remain cached by the context.
+*/
+QCLAlgorithms::~QCLAlgorithms()
+{
+}
+
+/*!
+    Returns the context that this algorithms object was constructed with.
+*/
+QCLContext *QCLAlgorithms::context() const
+{
+    Q_D(const QCLAlgorithms);
+    return d->context;
+}
+
+/*!
+    \fn void QCLAlgorithms::fill(QCLVector<T> &vector, const T &value)
+
+    Sets every element of \a vector to \a value.
+
+    \sa copy()
+*/
+bool QCLAlgorithms::runFill
+    (ElementType type, const QCLVectorBase &vector, int size,
+     const void *value)
+{
+    Q_D(QCLAlgorithms);
+    if (size <= 0)
+        return false;
+    if (vector.isHostOnly()) {
+        QCLAlgorithmsHostArgs args;
+        args.output = hostData(vector, true, 0);
+        args.value = value;
+        runOnHost(size, qt_cl_algorithms_host[type].fill, &args);
+        return true;
+    }
+    QCLKernel fill = d->kernel(type, "fill", size);
+    if (fill.isNull())
+        return false;
+    fill.setArg(0, vectorBuffer(vector));
+    fill.setArg(1, value, qt_cl_algorithms_types[type].size);
+    fill.setArg(2, cl_uint(size));
+    fill.run();
+    return true;
+}
+
+/*!
+    \fn void QCLAlgorithms::copy(const QCLVector<T> &input, QCLVector<T> &output)
+
+    Copies the elements of \a input to \a output.  If both vectors
+    are on the device, the copy does not pass through host memory.
+
+    \sa fill(), transform()
+*/
+bool QCLAlgorithms::runCopy
+    (ElementType type, const QCLVectorBase &input,
+     const QCLVectorBase &output, int size)
+{
+    if (size <= 0)
+        return false;
+    if (input.d_ptr == output.d_ptr)
+        return true;
+    size_t bytes = size_t(size) * qt_cl_algorithms_types[type].size;
+    if (input.isHostOnly() || output.isHostOnly()) {
+        QCLAlgorithmsHostArgs args;
+        bool inputMapped, outputMapped;
+        args.input = hostData(input, false, &inputMapped);
+        args.output = hostData(output, true, &outputMapped);
+        args.elemSize = qt_cl_algorithms_types[type].size;
+        bool ok = (args.input && args.output);
+        if (ok)
+            runOnHost(size, qt_cl_host_copy, &args);
+        releaseHostData(output, outputMapped);
+        releaseHostData(input, inputMapped);
+        return ok;
+    }
+    return vectorBuffer(input).copyTo(0, bytes, vectorBuffer(output), 0);
+}
+
+/*!
+    \fn void QCLAlgorithms::transform(const QCLVector<T> &input, QCLVector<T> &output, Function function)
+
+    Sets each element of \a output to the result of calling
+    \a function on the corresponding element of \a input.  The
+    \a input and \a output vectors may be the same.
+
+    The \a function runs on host threads, so vectors on the device
+    are mapped into host memory first.  It is called concurrently
+    from several threads and must not modify shared state:
+
+    \code
+    static float square(float value) { return value * value; }
+    ...
+    algorithms.transform(values, squares, square);
+    \endcode
+
+    \sa copy()
+*/
+
+/*!
+    \fn T QCLAlgorithms::reduce(const QCLVector<T> &vector, ReduceOperation operation)
+
+    Combines all of the elements in \a vector with \a operation and
+    returns the result.  Returns a default-constructed T if \a vector
+    is empty.
+
+    Each work-group reduces two elements per work item in local memory,
+    and the partial results are reduced again until one value remains.
+*/
+bool QCLAlgorithms::runReduce
+    (ElementType type, const QCLVectorBase &vector, int size,
+     ReduceOperation operation, void *result)
+{
+    Q_D(QCLAlgorithms);
+    if (size <= 0)
+        return false;
+    if (vector.isHostOnly()) {
+        // Reduce each chunk in parallel, and then the chunk results.
+        // Every element type fits in a cl_ulong.
+        int chunks = hostChunks(size);
+        QVarLengthArray<cl_ulong, 64> partials(chunks);
+        QCLAlgorithmsHostArgs args;
+        args.input = hostData(vector, false, 0);
+        args.operation = operation;
+        args.partials = partials.data();
+        QCLAlgorithmsHostFunction reduce = qt_cl_algorithms_host[type].reduce;
+        runOnHost(size, reduce, &args);
+        args.input = partials.constData();
+        args.partials = result;
+        reduce(&args, 0, 0, chunks);
+        return true;
+    }
+    QCLBuffer input = vectorBuffer(vector);
+    size_t elemSize = qt_cl_algorithms_types[type].size;
+    size_t count = size_t(size);
+    while (count > 1) {
+        QCLKernel reduce = d->kernel(type, "reduce", count);
+        if (reduce.isNull())
+            return false;
+        size_t groupSize = d->workGroupSizes[type];
+        size_t groups = (count + groupSize * 2 - 1) / (groupSize * 2);
+        QCLBuffer output = d->createBuffer(type, groups);
+        reduce.setGlobalWorkSize(groups * groupSize);
+        reduce.setArg(0, input);
+        reduce.setArg(1, output);
+        reduce.setArg(2, cl_uint(count));
+        reduce.setArg(3, cl_int(operation));
+        reduce.setArg(4, 0, groupSize * elemSize);
+        reduce.run();
+        input = output;
+        count = groups;
+    }
+    return input.read(result, elemSize);
+}
+
+/*!
+    \fn void QCLAlgorithms::inclusiveScan(const QCLVector<T> &input, QCLVector<T> &output)
+
+    Computes the inclusive prefix sum of \a input into \a output, so
+    that each element of \a output is the sum of the elements of
+    \a input up to and including the same index.  The \a input and
+    \a output vectors may be the same.
+
+    \sa exclusiveScan()
+*/
+
+/*!
+    \fn void QCLAlgorithms::exclusiveScan(const QCLVector<T> &input, QCLVector<T> &output)
+
+    Computes the exclusive prefix sum of \a input into \a output, so
+    that each element of \a output is the sum of the elements of
+    \a input before the same index, and the first element is zero.
+    The \a input and \a output vectors may be the same.
+
+    \sa inclusiveScan()
+*/
+bool QCLAlgorithms::runScan
+    (ElementType type, const QCLVectorBase &input,
+     const QCLVectorBase &output, int size, bool inclusive)
+{
+    Q_D(QCLAlgorithms);
+    if (size <= 0)
+        return false;
+    if (input.isHostOnly() || output.isHostOnly()) {
+        bool inputMapped, outputMapped;
+        const void *in = hostData(input, false, &inputMapped);
+        void *out = hostData(output, true, &outputMapped);
+        bool ok = (in && out);
+        if (ok)
+            qt_cl_algorithms_host[type].scan(in, out, size, inclusive);
+        releaseHostData(output, outputMapped);
+        releaseHostData(input, inputMapped);
+        return ok;
+    }
+    return d->scan(type, vectorBuffer(input), vectorBuffer(output),
+                   size_t(size), inclusive);
+}
+
+/*!
+    \fn int QCLAlgorithms::compact(const QCLVector<T> &input, QCLVector<T> &output)
+
+    Copies the non-zero elements of \a input to \a output, preserving
+    their order, and returns the number of elements that were copied.
+    The \a output vector is resized to the number of elements copied.
+    The \a input and \a output vectors must not be the same.
+*/
+
+/*!
+    \fn int QCLAlgorithms::compact(const QCLVector<T> &input, const QCLVector<cl_int> &flags, QCLVector<T> &output)
+    \overload
+
+    Copies the elements of \a input for which the corresponding
+    element of \a flags is non-zero.
+*/
+int QCLAlgorithms::runCompact
+    (ElementType type, const QCLVectorBase &input,
+     const QCLVectorBase *flags, const QCLVectorBase &output, int size)
+{
+    Q_D(QCLAlgorithms);
+    if (size <= 0)
+        return 0;
+    if (input.isHostOnly() || output.isHostOnly() ||
+            (flags && flags->isHostOnly())) {
+        bool inputMapped, flagsMapped = true, outputMapped;
+        const void *in = hostData(input, false, &inputMapped);
+        const void *flagData = flags ? hostData(*flags, false, &flagsMapped) : 0;
+        void *out = hostData(output, true, &outputMapped);
+        int count = 0;
+        if (in && out && (!flags || flagData)) {
+            count = qt_cl_algorithms_host[type].compact
+                (in, static_cast<const cl_int *>(flagData), out, size);
+        }
+        releaseHostData(output, outputMapped);
+        if (flags)
+            releaseHostData(*flags, flagsMapped);
+        releaseHostData(input, inputMapped);
+        return count;
+    }
+    size_t count = size_t(size);
+
+    // Normalize the flags to 0 or 1 so that they can be summed.
+    QCLBuffer source = flags ? vectorBuffer(*flags) : vectorBuffer(input);
+    ElementType sourceType = flags ? Int : type;
+    QCLKernel nonZero = d->kernel(sourceType, "nonZeroFlags", count);
+    if (nonZero.isNull())
+        return 0;
+    QCLBuffer normalized = d->createBuffer(Int, count);
+    nonZero.setArg(0, source);
+    nonZero.setArg(1, normalized);
+    nonZero.setArg(2, cl_uint(count));
+    nonZero.run();
+
+    return d->compact(type, vectorBuffer(input), normalized,
+                      vectorBuffer(output), count);
+}
+
+/*!
+    \fn void QCLAlgorithms::sort(QCLVector<T> &vector)
+
+    Sorts the elements of \a vector into ascending order.  The sort is
+    stable, and floating-point elements are ordered with negative
+    values first.
+
+    This is implemented as a radix sort that processes one bit of the
+    elements per pass, with each pass using a prefix sum to find the
+    new position of every element.
+*/
+bool QCLAlgorithms::runSort(ElementType type, const QCLVectorBase &vector, int size)
+{
+    Q_D(QCLAlgorithms);
+    if (size <= 1)
+        return true;
+    if (vector.isHostOnly()) {
+        qt_cl_algorithms_host[type].sort(hostData(vector, true, 0), size);
+        return true;
+    }
+    size_t count = size_t(size);
+    QCLBuffer input = vectorBuffer(vector);
+    QCLBuffer output = d->createBuffer(type, count);
+    QCLBuffer flags = d->createBuffer(UInt, count);
+    QCLBuffer positions = d->createBuffer(UInt, count);
+    QCLKernel radixFlags = d->kernel(type, "radixFlags", count);
+    QCLKernel radixScatter = d->kernel(type, "radixScatter", count);
+    if (radixFlags.isNull() || radixScatter.isNull())
+        return false;
+
+    // The number of passes is even, so the result ends up in the vector.
+    int bits = qt_cl_algorithms_types[type].keyBits;
+    for (int bit = 0; bit < bits; ++bit) {
+        radixFlags.setArg(0, input);
+        radixFlags.setArg(1, flags);
+        radixFlags.setArg(2, cl_uint(count));
+        radixFlags.setArg(3, cl_uint(bit));
+        radixFlags.run();
+        if (!d->scan(UInt, flags, positions, count, false))
+            return false;
+        radixScatter.setArg(0, input);
+        radixScatter.setArg(1, output);
+        radixScatter.setArg(2, flags);
+        radixScatter.setArg(3, positions);
+        radixScatter.setArg(4, cl_uint(count));
+        radixScatter.run();
+        qSwap(input, output);
+    }
+    return true;
+}
+
+QCLBuffer QCLAlgorithms::vectorBuffer(const QCLVectorBase &vector) const
+{
+    // kernelArg() makes sure that host changes have reached the device.
+    cl_mem id = vector.kernelArg();
+    if (!id)
+        return QCLBuffer();
+    clRetainMemObject(id);
+    return QCLBuffer(vector.context(), id);
+}
+
+// Maps "vector" into host memory for a host operation, and sets
+// "wasMapped" (if not null) to whether it was mapped already.  Device
+// vectors must be passed to releaseHostData() when the operation is done.
+void *QCLAlgorithms::hostData
+    (const QCLVectorBase &vector, bool modify, bool *wasMapped) const
+{
+    // map() reads device vectors into host memory, and does nothing
+    // for host vectors, which are always mapped.
+    QCLVectorBase &v = const_cast<QCLVectorBase &>(vector);
+    if (wasMapped)
+        *wasMapped = (v.m_mapped != 0);
+    if (!v.m_mapped)
+        v.map();
+#ifdef QT_CL_COPY_VECTOR
+    // Every element may be modified, so all of them are written back.
+    if (modify && v.m_mapped && !v.isHostOnly() && v.m_size > 0) {
+        v.markDirty(0);
+        v.m_dirtyStart = 0;
+        v.m_dirtyEnd = v.m_size;
+    }
+#else
+    Q_UNUSED(modify);
+#endif
+    return v.m_mapped;
+}
+
+// Restores the mapping state of "vector" from before hostData(), so that
+// a device vector is not left mapped while kernels use its buffer.
+void QCLAlgorithms::releaseHostData
+    (const QCLVectorBase &vector, bool wasMapped) const
+{
+    if (!wasMapped)
+        vector.unmap();
+}
+
+int QCLAlgorithms::hostChunks(int size)
+{
+    if (size <= 0)
+        return 0;
+    int step = qt_cl_host_step(size);
+    return (size + step - 1) / step;
+}
+
+void QCLAlgorithms::runOnHost(int size, HostFunction function, void *closure)
+{
+    if (size <= 0)
+        return;
+    int step = qt_cl_host_step(size);
+    int chunks = (size + step - 1) / step;
+    if (chunks == 1) {
+        function(closure, 0, 0, size);
+        return;
+    }
+
+    // Hand all but the first chunk to the thread pool.  Chunks that the
+    // pool cannot start right away run on this thread instead, so that
+    // calls from within pool threads cannot deadlock waiting for them.
+    QSemaphore done;
+    QScopedArrayPointer<QCLAlgorithmsHostTask> tasks
+        (new QCLAlgorithmsHostTask [chunks]);
+    QThreadPool *pool = QThreadPool::globalInstance();
+    for (int chunk = 1; chunk < chunks; ++chunk) {
+        QCLAlgorithmsHostTask &task = tasks[chunk];
+        task.function = function;
+        task.closure = closure;
+        task.chunk = chunk;
+        task.begin = chunk * step;
+        task.end = qMin(task.begin + step, size);
+        task.done = &done;
+        if (!pool->tryStart(&task))
+            task.run();
+    }
+    function(closure, 0, 0, step);
+    done.acquire(chunks - 1);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,284 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QCLALGORITHMS_H
+#define QCLALGORITHMS_H
+
+#include "qclcontext.h"
+#include <QtCore/qscopedpointer.h>
+
+QT_BEGIN_HEADER
+
+QT_BEGIN_NAMESPACE
+
+QT_MODULE(CL)
+
+class QCLAlgorithmsPrivate;
+
+class Q_CL_EXPORT QCLAlgorithms
+{
+public:
+    explicit QCLAlgorithms(QCLContext *context);
+    ~QCLAlgorithms();
+
+    QCLContext *context() const;
+
+    enum ReduceOperation
+    {
+        Sum,
+        Minimum,
+        Maximum
+    };
+
+    enum ElementType
+    {
+        Int,
+        UInt,
+        Long,
+        ULong,
+        Float,
+        Double
+    };
+
+    template <typename T>
+    void fill(QCLVector<T> &vector, const T &value);
+    template <typename T>
+    void copy(const QCLVector<T> &input, QCLVector<T> &output);
+    template <typename T, typename Function>
+    void transform(const QCLVector<T> &input, QCLVector<T> &output,
+                   Function function);
+
+    template <typename T>
+    T reduce(const QCLVector<T> &vector, ReduceOperation operation = Sum);
+
+    template <typename T>
+    void inclusiveScan(const QCLVector<T> &input, QCLVector<T> &output);
+    template <typename T>
+    void exclusiveScan(const QCLVector<T> &input, QCLVector<T> &output);
+
+    template <typename T>
+    int compact(const QCLVector<T> &input, QCLVector<T> &output);
+    template <typename T>
+    int compact(const QCLVector<T> &input, const QCLVector<cl_int> &flags,
+                QCLVector<T> &output);
+
+    template <typename T>
+    void sort(QCLVector<T> &vector);
+
+private:
+    QScopedPointer<QCLAlgorithmsPrivate> d_ptr;
+
+    Q_DISABLE_COPY(QCLAlgorithms)
+    Q_DECLARE_PRIVATE(QCLAlgorithms)
+
+    template <typename T>
+    void prepareOutput(const QCLVector<T> &input, QCLVector<T> &output);
+
+    bool runFill(ElementType type, const QCLVectorBase &vector, int size,
+                 const void *value);
+    bool runCopy(ElementType type, const QCLVectorBase &input,
+                 const QCLVectorBase &output, int size);
+    bool runReduce(ElementType type, const QCLVectorBase &vector, int size,
+                   ReduceOperation operation, void *result);
+    bool runScan(ElementType type, const QCLVectorBase &input,
+                 const QCLVectorBase &output, int size, bool inclusive);
+    int runCompact(ElementType type, const QCLVectorBase &input,
+                   const QCLVectorBase *flags, const QCLVectorBase &output,
+                   int size);
+    bool runSort(ElementType type, const QCLVectorBase &vector, int size);
+
+    QCLBuffer vectorBuffer(const QCLVectorBase &vector) const;
+    void *hostData(const QCLVectorBase &vector, bool modify,
+                   bool *wasMapped) const;
+    void releaseHostData(const QCLVectorBase &vector, bool wasMapped) const;
+
+    typedef void (*HostFunction)(void *closure, int chunk, int begin, int end);
+    static int hostChunks(int size);
+    static void runOnHost(int size, HostFunction function, void *closure);
+};
+
+template <typename T, typename Function>
+struct QCLAlgorithmsTransform
+{
+    const T *input;
+    T *output;
+    Function *function;
+
+    static void run(void *closure, int, int begin, int end)
+    {
+        QCLAlgorithmsTransform<T, Function> *transform =
+            static_cast<QCLAlgorithmsTransform<T, Function> *>(closure);
+        const T *input = transform->input;
+        T *output = transform->output;
+        Function &function = *(transform->function);
+        for (int index = begin; index < end; ++index)
+            output[index] = function(input[index]);
+    }
+};
+
+template <typename T>
+struct QCLAlgorithmsType;
+
+#define Q_CL_DECLARE_ALGORITHMS_TYPE(type, elementType) \
+    template <> \
+    struct QCLAlgorithmsType<type> \
+    { \
+        enum { Value = QCLAlgorithms::elementType }; \
+    };
+
+Q_CL_DECLARE_ALGORITHMS_TYPE(cl_int, Int)
+Q_CL_DECLARE_ALGORITHMS_TYPE(cl_uint, UInt)
+Q_CL_DECLARE_ALGORITHMS_TYPE(cl_long, Long)
+Q_CL_DECLARE_ALGORITHMS_TYPE(cl_ulong, ULong)
+Q_CL_DECLARE_ALGORITHMS_TYPE(cl_float, Float)
+Q_CL_DECLARE_ALGORITHMS_TYPE(cl_double, Double)
+
+template <typename T>
+Q_INLINE_TEMPLATE void QCLAlgorithms::prepareOutput
+    (const QCLVector<T> &input, QCLVector<T> &output)
+{
+    if (output.isNull())
+        output = context()->createVector<T>(qMax(input.size(), 1));
+    if (output.size() != input.size())
+        output.resize(input.size());
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE void QCLAlgorithms::fill(QCLVector<T> &vector, const T &value)
+{
+    runFill(ElementType(QCLAlgorithmsType<T>::Value),
+            vector, vector.size(), &value);
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE void QCLAlgorithms::copy
+    (const QCLVector<T> &input, QCLVector<T> &output)
+{
+    prepareOutput(input, output);
+    runCopy(ElementType(QCLAlgorithmsType<T>::Value),
+            input, output, input.size());
+}
+
+template <typename T, typename Function>
+Q_OUTOFLINE_TEMPLATE void QCLAlgorithms::transform
+    (const QCLVector<T> &input, QCLVector<T> &output, Function function)
+{
+    prepareOutput(input, output);
+    if (input.isEmpty())
+        return;
+    QCLAlgorithmsTransform<T, Function> closure;
+    bool inputMapped, outputMapped;
+    closure.input = static_cast<const T *>
+        (hostData(input, false, &inputMapped));
+    closure.output = static_cast<T *>(hostData(output, true, &outputMapped));
+    closure.function = &function;
+    if (closure.input && closure.output) {
+        runOnHost(input.size(),
+                  QCLAlgorithmsTransform<T, Function>::run, &closure);
+    }
+    releaseHostData(output, outputMapped);
+    releaseHostData(input, inputMapped);
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE T QCLAlgorithms::reduce
+    (const QCLVector<T> &vector, ReduceOperation operation)
+{
+    T result = T();
+    runReduce(ElementType(QCLAlgorithmsType<T>::Value),
+              vector, vector.size(), operation, &result);
+    return result;
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE void QCLAlgorithms::inclusiveScan
+    (const QCLVector<T> &input, QCLVector<T> &output)
+{
+    prepareOutput(input, output);
+    runScan(ElementType(QCLAlgorithmsType<T>::Value),
+            input, output, input.size(), true);
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE void QCLAlgorithms::exclusiveScan
+    (const QCLVector<T> &input, QCLVector<T> &output)
+{
+    prepareOutput(input, output);
+    runScan(ElementType(QCLAlgorithmsType<T>::Value),
+            input, output, input.size(), false);
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE int QCLAlgorithms::compact
+    (const QCLVector<T> &input, QCLVector<T> &output)
+{
+    prepareOutput(input, output);
+    int count = runCompact(ElementType(QCLAlgorithmsType<T>::Value),
+                           input, 0, output, input.size());
+    output.resize(count);
+    return count;
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE int QCLAlgorithms::compact
+    (const QCLVector<T> &input, const QCLVector<cl_int> &flags,
+     QCLVector<T> &output)
+{
+    Q_ASSERT(flags.size() >= input.size());
+    prepareOutput(input, output);
+    int count = runCompact(ElementType(QCLAlgorithmsType<T>::Value),
+                           input, &flags, output, input.size());
+    output.resize(count);
+    return count;
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE void QCLAlgorithms::sort(QCLVector<T> &vector)
+{
+    runSort(ElementType(QCLAlgorithmsType<T>::Value), vector, vector.size());
+}
+
+QT_END_NAMESPACE
+
+QT_END_HEADER
+
+#endif
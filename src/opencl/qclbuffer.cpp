@@ -43,6 +43,7 @@
 #include "qclimage.h"
 #include "qclcontext.h"
 #include "qclext_p.h"
+#include "qclloader_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -94,10 +95,15 @@ QT_BEGIN_NAMESPACE
 */
 bool QCLBuffer::read(size_t offset, void *data, size_t size)
 {
+    cl_event event = 0;
     cl_int error = clEnqueueReadBuffer
         (context()->activeQueue(), memoryId(),
-         CL_TRUE, offset, size, data, 0, 0, 0);
+         CL_TRUE, offset, size, data, 0, 0, context()->profilingEvent(&event));
     context()->reportError("QCLBuffer::read:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return error == CL_SUCCESS;
 }
 
@@ -115,10 +121,15 @@ bool QCLBuffer::read(size_t offset, void *data, size_t size)
 */
 bool QCLBuffer::read(void *data, size_t size)
 {
+    cl_event event = 0;
     cl_int error = clEnqueueReadBuffer
         (context()->activeQueue(), memoryId(),
-         CL_TRUE, 0, size, data, 0, 0, 0);
+         CL_TRUE, 0, size, data, 0, 0, context()->profilingEvent(&event));
     context()->reportError("QCLBuffer::read:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return error == CL_SUCCESS;
 }
 
@@ -134,22 +145,101 @@ bool QCLBuffer::read(void *data, size_t size)
     have been signaled as finished.  The request is executed on
     the active command queue for context().
 
-    \sa read(), writeAsync()
+    If staging is enabled on context(), the data is read through a
+    staging buffer and copied to \a data before the returned event
+    is signalled.
+
+    \sa read(), writeAsync(), QCLContext::setStagingEnabled()
 */
 QCLEvent QCLBuffer::readAsync(size_t offset, void *data, size_t size,
                               const QCLEventList &after)
 {
-    cl_event event;
+    QCLEvent staged;
+    if (context()->stagedRead(context()->activeQueue(), memoryId(),
+                              offset, data, size, after, &staged))
+        return staged;
+    cl_event event = 0;
     cl_int error = clEnqueueReadBuffer
         (context()->activeQueue(), memoryId(), CL_FALSE, offset, size, data,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLBuffer::readAsync:", error);
+    context()->recordCommand(event, after);
     if (error != CL_SUCCESS)
         return QCLEvent();
     else
         return QCLEvent(event);
 }
 
+/*!
+    \overload
+
+    Reads \a size bytes from this buffer, starting at \a offset,
+    into the supplied \a data array, using the command \a queue
+    instead of the active command queue for context().
+
+    This function will queue the request and return immediately.
+    Returns an event object that can be used to wait for the
+    request to finish.
+
+    The request will not start until all of the events in \a after
+    have been signaled as finished.
+
+    \sa QCLContext::acquireQueue()
+*/
+QCLEvent QCLBuffer::readAsync(const QCLCommandQueue &queue,
+                              size_t offset, void *data, size_t size,
+                              const QCLEventList &after)
+{
+    QCLEvent staged;
+    if (context()->stagedRead(queue.queueId(), memoryId(),
+                              offset, data, size, after, &staged)) {
+        context()->trackPoolEvent(queue.queueId(), staged.eventId());
+        return staged;
+    }
+    cl_event event = 0;
+    cl_int error = clEnqueueReadBuffer
+        (queue.queueId(), memoryId(), CL_FALSE, offset, size, data,
+         after.size(), after.eventData(), &event);
+    context()->reportError("QCLBuffer::readAsync:", error);
+    context()->recordCommand(event, after);
+    if (error != CL_SUCCESS)
+        return QCLEvent();
+    context()->trackPoolEvent(queue.queueId(), event);
+    return QCLEvent(event);
+}
+
+/*!
+    Reads \a size bytes from this buffer, starting at \a offset,
+    into the supplied \a data array, without creating an event to
+    track the request.  Returns true if the request was queued;
+    false otherwise.
+
+    This function will queue the request and return immediately.
+    The contents of \a data are not valid until the request has
+    finished, which can be determined with QCLContext::finish() or
+    QCLContext::marker().  Staging through pinned memory is not used.
+
+    The request will not start until all of the events in \a after
+    have been signaled as finished.  The request is executed on
+    the active command queue for context().
+
+    \sa readAsync(), writeDetached()
+*/
+bool QCLBuffer::readDetached(size_t offset, void *data, size_t size,
+                             const QCLEventList &after)
+{
+    cl_event event = 0;
+    cl_int error = clEnqueueReadBuffer
+        (context()->activeQueue(), memoryId(), CL_FALSE, offset, size, data,
+         after.size(), after.eventData(), context()->profilingEvent(&event));
+    context()->reportError("QCLBuffer::readDetached:", error);
+    if (event) {
+        context()->recordCommand(event, after);
+        clReleaseEvent(event);
+    }
+    return error == CL_SUCCESS;
+}
+
 /*!
     Reads the bytes defined by \a rect and \a bufferBytesPerLine
     from this buffer into the supplied \a data array, with a line
@@ -171,12 +261,17 @@ bool QCLBuffer::readRect
     size_t bufferOrigin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t bufferRegion[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
     static size_t const hostOrigin[3] = {0, 0, 0};
+    cl_event event = 0;
     cl_int error = clEnqueueReadBufferRect
         (context()->activeQueue(), memoryId(),
          CL_TRUE, bufferOrigin, hostOrigin, bufferRegion,
          bufferBytesPerLine, 0, hostBytesPerLine, 0,
-         data, 0, 0, 0);
+         data, 0, 0, context()->profilingEvent(&event));
     context()->reportError("QCLBuffer::readRect:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return error == CL_SUCCESS;
 #else
     context()->reportError("QCLBuffer::readRect:", CL_INVALID_OPERATION);
@@ -209,12 +304,18 @@ bool QCLBuffer::readRect
 {
 #ifdef QT_OPENCL_1_1
     static size_t const hostOrigin[3] = {0, 0, 0};
+    cl_event event = 0;
     cl_int error = clEnqueueReadBufferRect
         (context()->activeQueue(), memoryId(),
          CL_TRUE, origin, hostOrigin, size,
          bufferBytesPerLine, bufferBytesPerSlice,
-         hostBytesPerLine, hostBytesPerSlice, data, 0, 0, 0);
+         hostBytesPerLine, hostBytesPerSlice, data, 0, 0,
+         context()->profilingEvent(&event));
     context()->reportError("QCLBuffer::readRect(3D):", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return error == CL_SUCCESS;
 #else
     context()->reportError("QCLBuffer::readRect(3D):", CL_INVALID_OPERATION);
@@ -255,13 +356,14 @@ QCLEvent QCLBuffer::readRectAsync
     size_t bufferOrigin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t bufferRegion[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
     static size_t const hostOrigin[3] = {0, 0, 0};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueReadBufferRect
         (context()->activeQueue(), memoryId(),
          CL_FALSE, bufferOrigin, hostOrigin, bufferRegion,
          bufferBytesPerLine, 0, hostBytesPerLine, 0, data,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLBuffer::readRectAsync:", error);
+    context()->recordCommand(event, after);
     if (error != CL_SUCCESS)
         return QCLEvent();
     else
@@ -303,7 +405,7 @@ QCLEvent QCLBuffer::readRectAsync
 {
 #ifdef QT_OPENCL_1_1
     static size_t const hostOrigin[3] = {0, 0, 0};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueReadBufferRect
         (context()->activeQueue(), memoryId(),
          CL_FALSE, origin, hostOrigin, size,
@@ -311,6 +413,7 @@ QCLEvent QCLBuffer::readRectAsync
          hostBytesPerLine, hostBytesPerSlice, data,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLBuffer::readRectAsync(3D):", error);
+    context()->recordCommand(event, after);
     if (error != CL_SUCCESS)
         return QCLEvent();
     else
@@ -341,10 +444,15 @@ QCLEvent QCLBuffer::readRectAsync
 */
 bool QCLBuffer::write(size_t offset, const void *data, size_t size)
 {
+    cl_event event = 0;
     cl_int error = clEnqueueWriteBuffer
         (context()->activeQueue(), memoryId(),
-         CL_TRUE, offset, size, data, 0, 0, 0);
+         CL_TRUE, offset, size, data, 0, 0, context()->profilingEvent(&event));
     context()->reportError("QCLBuffer::write:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return error == CL_SUCCESS;
 }
 
@@ -360,10 +468,15 @@ bool QCLBuffer::write(size_t offset, const void *data, size_t size)
 */
 bool QCLBuffer::write(const void *data, size_t size)
 {
+    cl_event event = 0;
     cl_int error = clEnqueueWriteBuffer
         (context()->activeQueue(), memoryId(),
-         CL_TRUE, 0, size, data, 0, 0, 0);
+         CL_TRUE, 0, size, data, 0, 0, context()->profilingEvent(&event));
     context()->reportError("QCLBuffer::write:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return error == CL_SUCCESS;
 }
 
@@ -379,22 +492,102 @@ bool QCLBuffer::write(const void *data, size_t size)
     have been signaled as finished.  The request is executed on
     the active command queue for context().
 
-    \sa write(), readAsync()
+    If staging is enabled on context(), \a data is copied into a
+    staging buffer before this function returns, and may be reused
+    immediately.
+
+    \sa write(), readAsync(), QCLContext::setStagingEnabled()
 */
 QCLEvent QCLBuffer::writeAsync(size_t offset, const void *data, size_t size,
                                const QCLEventList &after)
 {
-    cl_event event;
+    QCLEvent staged;
+    if (context()->stagedWrite(context()->activeQueue(), memoryId(),
+                               offset, data, size, after, &staged))
+        return staged;
+    cl_event event = 0;
     cl_int error = clEnqueueWriteBuffer
         (context()->activeQueue(), memoryId(), CL_FALSE, offset, size, data,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLBuffer::writeAsync:", error);
+    context()->recordCommand(event, after);
     if (error != CL_SUCCESS)
         return QCLEvent();
     else
         return QCLEvent(event);
 }
 
+/*!
+    \overload
+
+    Writes \a size bytes to this buffer, starting at \a offset,
+    from the supplied \a data array, using the command \a queue
+    instead of the active command queue for context().
+
+    This function will queue the request and return immediately.
+    Returns an event object that can be used to wait for the
+    request to finish.
+
+    The request will not start until all of the events in \a after
+    have been signaled as finished.
+
+    \sa QCLContext::acquireQueue()
+*/
+QCLEvent QCLBuffer::writeAsync(const QCLCommandQueue &queue,
+                               size_t offset, const void *data, size_t size,
+                               const QCLEventList &after)
+{
+    QCLEvent staged;
+    if (context()->stagedWrite(queue.queueId(), memoryId(),
+                               offset, data, size, after, &staged)) {
+        context()->trackPoolEvent(queue.queueId(), staged.eventId());
+        return staged;
+    }
+    cl_event event = 0;
+    cl_int error = clEnqueueWriteBuffer
+        (queue.queueId(), memoryId(), CL_FALSE, offset, size, data,
+         after.size(), after.eventData(), &event);
+    context()->reportError("QCLBuffer::writeAsync:", error);
+    context()->recordCommand(event, after);
+    if (error != CL_SUCCESS)
+        return QCLEvent();
+    context()->trackPoolEvent(queue.queueId(), event);
+    return QCLEvent(event);
+}
+
+/*!
+    Writes \a size bytes to this buffer, starting at \a offset,
+    from the supplied \a data array, without creating an event to
+    track the request.  Returns true if the request was queued;
+    false otherwise.
+
+    This function will queue the request and return immediately.
+    The contents of \a data must not be modified or freed until the
+    request has finished, which can be determined with
+    QCLContext::finish() or QCLContext::marker().  Staging through
+    pinned memory is not used.
+
+    The request will not start until all of the events in \a after
+    have been signaled as finished.  The request is executed on
+    the active command queue for context().
+
+    \sa writeAsync(), readDetached()
+*/
+bool QCLBuffer::writeDetached(size_t offset, const void *data, size_t size,
+                              const QCLEventList &after)
+{
+    cl_event event = 0;
+    cl_int error = clEnqueueWriteBuffer
+        (context()->activeQueue(), memoryId(), CL_FALSE, offset, size, data,
+         after.size(), after.eventData(), context()->profilingEvent(&event));
+    context()->reportError("QCLBuffer::writeDetached:", error);
+    if (event) {
+        context()->recordCommand(event, after);
+        clReleaseEvent(event);
+    }
+    return error == CL_SUCCESS;
+}
+
 /*!
     Writes the bytes at \a data, with a line pitch of \a hostBytesPerLine
     to the region of this buffer defined by \a rect and \a bufferBytesPerLine.
@@ -415,12 +608,17 @@ bool QCLBuffer::writeRect
     size_t bufferOrigin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t bufferRegion[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
     static size_t const hostOrigin[3] = {0, 0, 0};
+    cl_event event = 0;
     cl_int error = clEnqueueWriteBufferRect
         (context()->activeQueue(), memoryId(),
          CL_TRUE, bufferOrigin, hostOrigin, bufferRegion,
          bufferBytesPerLine, 0, hostBytesPerLine, 0,
-         data, 0, 0, 0);
+         data, 0, 0, context()->profilingEvent(&event));
     context()->reportError("QCLBuffer::writeRect:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return error == CL_SUCCESS;
 #else
     context()->reportError("QCLBuffer::writeRect:", CL_INVALID_OPERATION);
@@ -452,12 +650,18 @@ bool QCLBuffer::writeRect
 {
 #ifdef QT_OPENCL_1_1
     static size_t const hostOrigin[3] = {0, 0, 0};
+    cl_event event = 0;
     cl_int error = clEnqueueWriteBufferRect
         (context()->activeQueue(), memoryId(),
          CL_TRUE, origin, hostOrigin, size,
          bufferBytesPerLine, bufferBytesPerSlice,
-         hostBytesPerLine, hostBytesPerSlice, data, 0, 0, 0);
+         hostBytesPerLine, hostBytesPerSlice, data, 0, 0,
+         context()->profilingEvent(&event));
     context()->reportError("QCLBuffer::writeRect(3D):", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return error == CL_SUCCESS;
 #else
     context()->reportError("QCLBuffer::writeRect(3D):", CL_INVALID_OPERATION);
@@ -498,13 +702,14 @@ QCLEvent QCLBuffer::writeRectAsync
     size_t bufferOrigin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t bufferRegion[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
     static size_t const hostOrigin[3] = {0, 0, 0};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueWriteBufferRect
         (context()->activeQueue(), memoryId(),
          CL_FALSE, bufferOrigin, hostOrigin, bufferRegion,
          bufferBytesPerLine, 0, hostBytesPerLine, 0, data,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLBuffer::writeRectAsync:", error);
+    context()->recordCommand(event, after);
     if (error != CL_SUCCESS)
         return QCLEvent();
     else
@@ -546,7 +751,7 @@ QCLEvent QCLBuffer::writeRectAsync
 {
 #ifdef QT_OPENCL_1_1
     static size_t const hostOrigin[3] = {0, 0, 0};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueWriteBufferRect
         (context()->activeQueue(), memoryId(),
          CL_FALSE, origin, hostOrigin, size,
@@ -554,6 +759,7 @@ QCLEvent QCLBuffer::writeRectAsync
          hostBytesPerLine, hostBytesPerSlice, data,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLBuffer::writeRectAsync(3D):", error);
+    context()->recordCommand(event, after);
     if (error != CL_SUCCESS)
         return QCLEvent();
     else
@@ -585,11 +791,12 @@ QCLEvent QCLBuffer::writeRectAsync
 bool QCLBuffer::copyTo
     (size_t offset, size_t size, const QCLBuffer &dest, size_t destOffset)
 {
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyBuffer
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          offset, destOffset, size, 0, 0, &event);
     context()->reportError("QCLBuffer::copyTo(QCLBuffer):", error);
+    context()->recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS) {
         clWaitForEvents(1, &event);
         clReleaseEvent(event);
@@ -614,11 +821,12 @@ bool QCLBuffer::copyTo
 {
     const size_t dst_origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     const size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyBufferToImage
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          offset, dst_origin, region, 0, 0, &event);
     context()->reportError("QCLBuffer::copyTo(QCLImage2D):", error);
+    context()->recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS) {
         clWaitForEvents(1, &event);
         clReleaseEvent(event);
@@ -642,11 +850,12 @@ bool QCLBuffer::copyTo
     (size_t offset, const QCLImage3D &dest,
      const size_t origin[3], const size_t size[3])
 {
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyBufferToImage
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          offset, origin, size, 0, 0, &event);
     context()->reportError("QCLBuffer::copyTo(QCLImage3D):", error);
+    context()->recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS) {
         clWaitForEvents(1, &event);
         clReleaseEvent(event);
@@ -671,18 +880,78 @@ QCLEvent QCLBuffer::copyToAsync
     (size_t offset, size_t size, const QCLBuffer &dest, size_t destOffset,
      const QCLEventList &after)
 {
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyBuffer
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          offset, destOffset, size,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLBuffer::copyToAsync:", error);
+    context()->recordCommand(event, after);
     if (error != CL_SUCCESS)
         return QCLEvent();
     else
         return QCLEvent(event);
 }
 
+/*!
+    Copies the \a size bytes at \a offset in this buffer to
+    \a destOffset in the buffer \a dest, without creating an event to
+    track the request.  Returns true if the request was queued;
+    false otherwise.
+
+    The request will not start until all of the events in \a after
+    have been signaled as finished.  The request is executed on
+    the active command queue for context().
+
+    \sa copyToAsync()
+*/
+bool QCLBuffer::copyToDetached
+    (size_t offset, size_t size, const QCLBuffer &dest, size_t destOffset,
+     const QCLEventList &after)
+{
+    cl_event event = 0;
+    cl_int error = clEnqueueCopyBuffer
+        (context()->activeQueue(), memoryId(), dest.memoryId(),
+         offset, destOffset, size,
+         after.size(), after.eventData(), context()->profilingEvent(&event));
+    context()->reportError("QCLBuffer::copyToDetached:", error);
+    if (event) {
+        context()->recordCommand(event, after);
+        clReleaseEvent(event);
+    }
+    return error == CL_SUCCESS;
+}
+
+/*!
+    \overload
+
+    Copies the \a size bytes at \a offset in this buffer to
+    \a destOffset in the buffer \a dest, using the command \a queue
+    instead of the active command queue for context().  Returns an
+    event object that can be used to wait for the request to finish.
+
+    The request will not start until all of the events in \a after
+    have been signaled as finished.
+
+    \sa QCLContext::acquireQueue()
+*/
+QCLEvent QCLBuffer::copyToAsync
+    (const QCLCommandQueue &queue, size_t offset, size_t size,
+     const QCLBuffer &dest, size_t destOffset, const QCLEventList &after)
+{
+    cl_event event = 0;
+    cl_int error = clEnqueueCopyBuffer
+        (queue.queueId(), memoryId(), dest.memoryId(),
+         offset, destOffset, size,
+         after.size(), after.eventData(), &event);
+    context()->reportError("QCLBuffer::copyToAsync:", error);
+    context()->recordCommand(event, after);
+    if (error != CL_SUCCESS)
+        return QCLEvent();
+    context()->trackPoolEvent(queue.queueId(), event);
+    return QCLEvent(event);
+}
+
 /*!
     Copies the contents of this buffer, starting at \a offset to
     \a rect within \a dest.  Returns an event object that can be used
@@ -700,12 +969,13 @@ QCLEvent QCLBuffer::copyToAsync
 {
     const size_t dst_origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     const size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyBufferToImage
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          offset, dst_origin, region,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLBuffer::copyToAsync(QCLImage2D):", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -728,12 +998,13 @@ QCLEvent QCLBuffer::copyToAsync
      const size_t origin[3], const size_t size[3],
      const QCLEventList &after)
 {
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyBufferToImage
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          offset, origin, size,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLBuffer::copyToAsync(QCLImage3D):", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -762,12 +1033,13 @@ bool QCLBuffer::copyToRect
     const size_t src_origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     const size_t dst_origin[3] = {static_cast<size_t>(destPoint.x()), static_cast<size_t>(destPoint.y()), 0};
     const size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyBufferRect
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          src_origin, dst_origin, region,
          bufferBytesPerLine, 0, destBytesPerLine, 0, 0, 0, &event);
     context()->reportError("QCLBuffer::copyToRect:", error);
+    context()->recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS) {
         clWaitForEvents(1, &event);
         clReleaseEvent(event);
@@ -807,13 +1079,14 @@ bool QCLBuffer::copyToRect
      size_t destBytesPerLine, size_t destBytesPerSlice)
 {
 #ifdef QT_OPENCL_1_1
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyBufferRect
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          origin, destOrigin, size,
          bufferBytesPerLine, bufferBytesPerSlice,
          destBytesPerLine, destBytesPerSlice, 0, 0, &event);
     context()->reportError("QCLBuffer::copyToRect(3D):", error);
+    context()->recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS) {
         clWaitForEvents(1, &event);
         clReleaseEvent(event);
@@ -858,13 +1131,14 @@ QCLEvent QCLBuffer::copyToRectAsync
     const size_t src_origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     const size_t dst_origin[3] = {static_cast<size_t>(destPoint.x()), static_cast<size_t>(destPoint.y()), 0};
     const size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyBufferRect
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          src_origin, dst_origin, region,
          bufferBytesPerLine, 0, destBytesPerLine, 0,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLBuffer::copyToRectAsync:", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -903,7 +1177,7 @@ QCLEvent QCLBuffer::copyToRectAsync
      const QCLEventList &after)
 {
 #ifdef QT_OPENCL_1_1
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyBufferRect
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          origin, destOrigin, size,
@@ -911,6 +1185,7 @@ QCLEvent QCLBuffer::copyToRectAsync
          destBytesPerLine, destBytesPerSlice,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLBuffer::copyToRectAsync(3D):", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -957,10 +1232,16 @@ void *QCLBuffer::map
     (size_t offset, size_t size, QCLMemoryObject::Access access)
 {
     cl_int error;
+    cl_event event = 0;
     void *data = clEnqueueMapBuffer
         (context()->activeQueue(), memoryId(), CL_TRUE,
-         qt_cl_map_flags(access), offset, size, 0, 0, 0, &error);
+         qt_cl_map_flags(access), offset, size, 0, 0,
+         context()->profilingEvent(&event), &error);
     context()->reportError("QCLBuffer::map:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return data;
 }
 
@@ -997,12 +1278,13 @@ QCLEvent QCLBuffer::mapAsync
      QCLMemoryObject::Access access, const QCLEventList &after)
 {
     cl_int error;
-    cl_event event;
+    cl_event event = 0;
     *ptr = clEnqueueMapBuffer
         (context()->activeQueue(), memoryId(), CL_FALSE,
          qt_cl_map_flags(access), offset, size,
          after.size(), after.eventData(), &event, &error);
     context()->reportError("QCLBuffer::mapAsync:", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -54,6 +54,7 @@ QT_MODULE(CL)
 
 class QCLImage2D;
 class QCLImage3D;
+class QCLCommandQueue;
 
 class Q_CL_EXPORT QCLBuffer : public QCLMemoryObject
 {
@@ -74,6 +75,11 @@ public:
     bool read(size_t offset, void *data, size_t size);
     QCLEvent readAsync(size_t offset, void *data, size_t size,
                        const QCLEventList &after = QCLEventList());
+    QCLEvent readAsync(const QCLCommandQueue &queue,
+                       size_t offset, void *data, size_t size,
+                       const QCLEventList &after = QCLEventList());
+    bool readDetached(size_t offset, void *data, size_t size,
+                      const QCLEventList &after = QCLEventList());
 
     bool readRect(const QRect &rect, void *data,
                   size_t bufferBytesPerLine, size_t hostBytesPerLine);
@@ -94,6 +100,11 @@ public:
     bool write(size_t offset, const void *data, size_t size);
     QCLEvent writeAsync(size_t offset, const void *data, size_t size,
                         const QCLEventList &after = QCLEventList());
+    QCLEvent writeAsync(const QCLCommandQueue &queue,
+                        size_t offset, const void *data, size_t size,
+                        const QCLEventList &after = QCLEventList());
+    bool writeDetached(size_t offset, const void *data, size_t size,
+                       const QCLEventList &after = QCLEventList());
 
     bool writeRect(const QRect &rect, const void *data,
                    size_t bufferBytesPerLine, size_t hostBytesPerLine);
@@ -121,6 +132,10 @@ public:
         (size_t offset, size_t size,
          const QCLBuffer &dest, size_t destOffset,
          const QCLEventList &after = QCLEventList());
+    QCLEvent copyToAsync
+        (const QCLCommandQueue &queue, size_t offset, size_t size,
+         const QCLBuffer &dest, size_t destOffset,
+         const QCLEventList &after = QCLEventList());
     QCLEvent copyToAsync
         (size_t offset, const QCLImage2D &dest, const QRect &rect,
          const QCLEventList &after = QCLEventList());
@@ -128,6 +143,10 @@ public:
         (size_t offset, const QCLImage3D &dest,
          const size_t origin[3], const size_t size[3],
          const QCLEventList &after = QCLEventList());
+    bool copyToDetached
+        (size_t offset, size_t size,
+         const QCLBuffer &dest, size_t destOffset,
+         const QCLEventList &after = QCLEventList());
 
     bool copyToRect(const QRect &rect, const QCLBuffer &dest,
                     const QPoint &destPoint, size_t bufferBytesPerLine,
@@ -0,0 +1,547 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qclbufferpool.h"
+#include "qclcontext.h"
+#include "qclloader_p.h"
+#include <QtCore/qvector.h>
+#include <QtCore/qhash.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QCLBufferPool
+    \brief The QCLBufferPool class suballocates small buffers from large OpenCL buffers.
+    \since 4.7
+    \ingroup opencl
+
+    Creating a QCLBuffer with QCLContext::createBufferDevice() costs a
+    round-trip through \c{clCreateBuffer()} and \c{clReleaseMemObject()},
+    and usually a device memory allocation.  Applications that create
+    and discard many small buffers can instead allocate them from a
+    QCLBufferPool, which carves sub-buffers out of a small number of
+    large parent buffers of blockSize() bytes:
+
+    \code
+    QCLBufferPool pool(&context);
+    for (;;) {
+        QCLBuffer params = pool.allocate(sizeof(Params));
+        QCLBuffer scratch = pool.allocate(count * sizeof(float));
+        ...
+        pool.reset();   // End of frame: recycle everything.
+    }
+    \endcode
+
+    Requests are rounded up to a power-of-two size class that is at
+    least alignment() bytes.  A buffer that is handed back with release()
+    goes on the free list for its size class and is reused by the next
+    allocation of that class; otherwise allocation takes the next
+    alignment()-aligned range of the current parent buffer.  Requests
+    larger than blockSize() get a parent buffer of their own.  The
+    buffers returned by allocate() have exactly the requested size.
+
+    reset() makes all of the space in the pool available again at once,
+    which suits per-frame scratch data.  It does not release the parent
+    buffers; use clear() for that.  Buffers that were allocated before
+    reset() or clear() must not be used afterwards, because their
+    storage may be handed out again.
+
+    The statistics functions report how the pool is being used:
+    bytesAllocated() is the sum of the requested sizes, bytesInUse()
+    is the same after rounding to size classes, bytesFree() is the size
+    of the free lists, and highWaterMark() is the largest value that
+    bytesInUse() has reached.  fragmentation() summarizes the wasted
+    space in the parent buffers.
+
+    Sub-buffers are a feature of OpenCL 1.1.  With OpenCL 1.0, allocate()
+    creates a separate buffer for each request, and no space is pooled.
+
+    QCLBufferPool is not thread-safe; use one pool per thread, or
+    protect the pool with a mutex.
+
+    \sa QCLBuffer::createSubBuffer()
+*/
+
+struct QCLBufferPoolSlot
+{
+    int block;
+    size_t offset;
+};
+
+struct QCLBufferPoolAllocation
+{
+    QCLBufferPoolSlot slot;
+    int sizeClass;
+    size_t size;
+};
+
+struct QCLBufferPoolBlock
+{
+    QCLBuffer buffer;
+    size_t size;
+    size_t used;
+};
+
+class QCLBufferPoolPrivate
+{
+public:
+    QCLBufferPoolPrivate(QCLContext *ctx, size_t bsize,
+                         QCLMemoryObject::Access acc)
+        : context(ctx)
+        , blockSize(bsize)
+        , alignment(1)
+        , access(acc)
+        , current(-1)
+        , bytesAllocated(0)
+        , bytesInUse(0)
+        , bytesFree(0)
+        , bytesReserved(0)
+        , highWaterMark(0)
+    {
+    }
+
+    QCLContext *context;
+    size_t blockSize;
+    size_t alignment;
+    QCLMemoryObject::Access access;
+    QVector<QCLBufferPoolBlock> blocks;
+    int current;
+    QHash<int, QVector<QCLBufferPoolSlot> > freeLists;
+    QHash<cl_mem, QCLBufferPoolAllocation> live;
+    size_t bytesAllocated;
+    size_t bytesInUse;
+    size_t bytesFree;
+    size_t bytesReserved;
+    size_t highWaterMark;
+
+    bool takeSlot(int sizeClass, size_t classSize, QCLBufferPoolSlot *slot);
+};
+
+// Rounds size up to a power of two, and returns log2 of the result.
+static int qt_cl_size_class(size_t size)
+{
+    int sizeClass = 0;
+    while ((size_t(1) << sizeClass) < size)
+        ++sizeClass;
+    return sizeClass;
+}
+
+/*!
+    Constructs a buffer pool for \a context that allocates parent
+    buffers of \a blockSize bytes, with the specified \a access mode.
+    No memory is allocated until the first call to allocate().
+
+    \sa allocate()
+*/
+QCLBufferPool::QCLBufferPool
+        (QCLContext *context, size_t blockSize, QCLMemoryObject::Access access)
+    : d_ptr(new QCLBufferPoolPrivate(context, blockSize, access))
+{
+    Q_D(QCLBufferPool);
+
+    // Sub-buffer origins must be aligned to the base address alignment
+    // of every device in the context, not just the data type alignment.
+    QList<QCLDevice> devices = context->devices();
+    for (int index = 0; index < devices.size(); ++index) {
+        const QCLDevice &device = devices.at(index);
+        size_t align = size_t(qMax(device.defaultAlignment(),
+                                   device.minimumAlignment()));
+        d->alignment = qMax(d->alignment, align);
+    }
+    d->alignment = size_t(1) << qt_cl_size_class(d->alignment);
+}
+
+/*!
+    Destroys this buffer pool and releases its parent buffers.
+    The parent buffers are destroyed once all of the buffers that
+    were allocated from them have been released.
+*/
+QCLBufferPool::~QCLBufferPool()
+{
+}
+
+/*!
+    Returns the context that this pool allocates buffers from.
+*/
+QCLContext *QCLBufferPool::context() const
+{
+    Q_D(const QCLBufferPool);
+    return d->context;
+}
+
+/*!
+    Returns the size of the parent buffers that are created by this pool.
+*/
+size_t QCLBufferPool::blockSize() const
+{
+    Q_D(const QCLBufferPool);
+    return d->blockSize;
+}
+
+/*!
+    Returns the alignment of the buffers that are allocated by this pool,
+    in bytes.  This is the largest QCLDevice::defaultAlignment() or
+    QCLDevice::minimumAlignment() of the devices in context(), which
+    is the alignment that OpenCL requires for sub-buffer origins.
+*/
+size_t QCLBufferPool::alignment() const
+{
+    Q_D(const QCLBufferPool);
+    return d->alignment;
+}
+
+/*!
+    Returns the access mode of the buffers in this pool.
+*/
+QCLMemoryObject::Access QCLBufferPool::access() const
+{
+    Q_D(const QCLBufferPool);
+    return d->access;
+}
+
+bool QCLBufferPoolPrivate::takeSlot
+    (int sizeClass, size_t classSize, QCLBufferPoolSlot *slot)
+{
+    // Reuse a released slot of the same size class if possible.
+    QHash<int, QVector<QCLBufferPoolSlot> >::Iterator it =
+        freeLists.find(sizeClass);
+    if (it != freeLists.end() && !it->isEmpty()) {
+        *slot = it->last();
+        it->removeLast();
+        bytesFree -= classSize;
+        return true;
+    }
+
+    // Requests that do not fit in a block get a block of their own.
+    if (classSize > blockSize) {
+        QCLBufferPoolBlock block;
+        block.buffer = context->createBufferDevice(classSize, access);
+        if (block.buffer.isNull())
+            return false;
+        block.size = classSize;
+        block.used = classSize;
+        blocks.append(block);
+        bytesReserved += classSize;
+        slot->block = blocks.size() - 1;
+        slot->offset = 0;
+        return true;
+    }
+
+    // Bump allocate from the current block.  Size classes are multiples
+    // of the alignment, so the offsets stay aligned.
+    if (current < 0 || blocks[current].used + classSize > blocks[current].size) {
+        // Continue with the next block that was kept after reset(),
+        // or create a new one.
+        int next = current + 1;
+        while (next < blocks.size() && blocks[next].size != blockSize)
+            ++next;
+        if (next >= blocks.size()) {
+            QCLBufferPoolBlock block;
+            block.buffer = context->createBufferDevice(blockSize, access);
+            if (block.buffer.isNull())
+                return false;
+            block.size = blockSize;
+            block.used = 0;
+            blocks.append(block);
+            bytesReserved += blockSize;
+            next = blocks.size() - 1;
+        }
+        current = next;
+    }
+    slot->block = current;
+    slot->offset = blocks[current].used;
+    blocks[current].used += classSize;
+    return true;
+}
+
+/*!
+    Allocates a buffer of \a size bytes from this pool.  Returns a null
+    buffer if \a size is zero or the parent buffer could not be created.
+
+    The buffer remains allocated until it is passed to release(),
+    or until reset() or clear() is called.
+
+    \sa release(), reset()
+*/
+QCLBuffer QCLBufferPool::allocate(size_t size)
+{
+    Q_D(QCLBufferPool);
+    if (!size)
+        return QCLBuffer();
+#ifdef QT_OPENCL_1_1
+    int sizeClass = qt_cl_size_class(qMax(size, d->alignment));
+    size_t classSize = size_t(1) << sizeClass;
+    QCLBufferPoolAllocation alloc;
+    if (!d->takeSlot(sizeClass, classSize, &alloc.slot))
+        return QCLBuffer();
+    QCLBuffer buffer = d->blocks[alloc.slot.block].buffer.createSubBuffer
+        (alloc.slot.offset, size, d->access);
+    if (buffer.isNull()) {
+        d->freeLists[sizeClass].append(alloc.slot);
+        d->bytesFree += classSize;
+        return QCLBuffer();
+    }
+    alloc.sizeClass = sizeClass;
+    alloc.size = size;
+    d->live.insert(buffer.memoryId(), alloc);
+    d->bytesAllocated += size;
+    d->bytesInUse += classSize;
+    if (d->bytesInUse > d->highWaterMark)
+        d->highWaterMark = d->bytesInUse;
+    return buffer;
+#else
+    QCLBuffer buffer = d->context->createBufferDevice(size, d->access);
+    if (!buffer.isNull()) {
+        QCLBufferPoolAllocation alloc;
+        alloc.slot.block = -1;
+        alloc.slot.offset = 0;
+        alloc.sizeClass = -1;
+        alloc.size = size;
+        d->live.insert(buffer.memoryId(), alloc);
+        d->bytesAllocated += size;
+        d->bytesInUse += size;
+        d->bytesReserved += size;
+        if (d->bytesInUse > d->highWaterMark)
+            d->highWaterMark = d->bytesInUse;
+    }
+    return buffer;
+#endif
+}
+
+/*!
+    Returns \a buffer to this pool so that its space can be reused
+    by a later allocation of the same size class.  Does nothing if
+    \a buffer was not allocated from this pool or has already
+    been released.
+
+    The caller must not use \a buffer after releasing it, and must
+    not release it while commands that use it are still pending.
+
+    \sa allocate()
+*/
+void QCLBufferPool::release(const QCLBuffer &buffer)
+{
+    Q_D(QCLBufferPool);
+    QHash<cl_mem, QCLBufferPoolAllocation>::Iterator it =
+        d->live.find(buffer.memoryId());
+    if (it == d->live.end())
+        return;
+    QCLBufferPoolAllocation alloc = it.value();
+    d->live.erase(it);
+    d->bytesAllocated -= alloc.size;
+    if (alloc.sizeClass >= 0) {
+        size_t classSize = size_t(1) << alloc.sizeClass;
+        d->bytesInUse -= classSize;
+        d->freeLists[alloc.sizeClass].append(alloc.slot);
+        d->bytesFree += classSize;
+    } else {
+        d->bytesInUse -= alloc.size;
+        d->bytesReserved -= alloc.size;
+    }
+}
+
+/*!
+    Makes all of the space in this pool available for allocation
+    again, without releasing the parent buffers.  This is intended
+    for frame-scoped allocation, where all of the buffers for a
+    frame are discarded together.
+
+    Buffers that were allocated before the reset must not be used
+    afterwards.  highWaterMark() is not affected.
+
+    \sa clear(), allocate()
+*/
+void QCLBufferPool::reset()
+{
+    Q_D(QCLBufferPool);
+    d->live.clear();
+    d->freeLists.clear();
+    // Dedicated blocks for large requests are recycled as free slots.
+    for (int index = 0; index < d->blocks.size(); ++index) {
+        QCLBufferPoolBlock &block = d->blocks[index];
+        if (block.size == d->blockSize) {
+            block.used = 0;
+        } else {
+            QCLBufferPoolSlot slot;
+            slot.block = index;
+            slot.offset = 0;
+            d->freeLists[qt_cl_size_class(block.size)].append(slot);
+        }
+    }
+    d->current = -1;
+    d->bytesAllocated = 0;
+    d->bytesInUse = 0;
+    d->bytesFree = 0;
+    for (int index = 0; index < d->blocks.size(); ++index) {
+        if (d->blocks.at(index).size != d->blockSize)
+            d->bytesFree += d->blocks.at(index).size;
+    }
+#ifndef QT_OPENCL_1_1
+    d->bytesReserved = 0;
+#endif
+}
+
+/*!
+    Releases all of the parent buffers in this pool.  Buffers that
+    were allocated from the pool must not be used afterwards.
+
+    \sa reset()
+*/
+void QCLBufferPool::clear()
+{
+    Q_D(QCLBufferPool);
+    reset();
+    d->freeLists.clear();
+    d->blocks.clear();
+    d->bytesFree = 0;
+    d->bytesReserved = 0;
+}
+
+/*!
+    Returns the number of buffers that are currently allocated
+    from this pool.
+*/
+int QCLBufferPool::allocationCount() const
+{
+    Q_D(const QCLBufferPool);
+    return d->live.size();
+}
+
+/*!
+    Returns the number of parent buffers that this pool has created,
+    including the dedicated parent buffers for large requests.
+
+    \sa bytesReserved()
+*/
+int QCLBufferPool::blockCount() const
+{
+    Q_D(const QCLBufferPool);
+    return d->blocks.size();
+}
+
+/*!
+    Returns the sum of the sizes that were passed to allocate() for
+    the buffers that are currently allocated.
+
+    \sa bytesInUse()
+*/
+size_t QCLBufferPool::bytesAllocated() const
+{
+    Q_D(const QCLBufferPool);
+    return d->bytesAllocated;
+}
+
+/*!
+    Returns the number of bytes in the parent buffers that are taken by
+    the buffers that are currently allocated, after rounding each buffer
+    up to its size class.
+
+    \sa bytesAllocated(), highWaterMark()
+*/
+size_t QCLBufferPool::bytesInUse() const
+{
+    Q_D(const QCLBufferPool);
+    return d->bytesInUse;
+}
+
+/*!
+    Returns the number of bytes on the free lists, waiting to be
+    reused by allocations of the same size class.
+*/
+size_t QCLBufferPool::bytesFree() const
+{
+    Q_D(const QCLBufferPool);
+    return d->bytesFree;
+}
+
+/*!
+    Returns the total size of the parent buffers of this pool.
+
+    \sa blockCount()
+*/
+size_t QCLBufferPool::bytesReserved() const
+{
+    Q_D(const QCLBufferPool);
+    return d->bytesReserved;
+}
+
+/*!
+    Returns the largest value that bytesInUse() has reached during
+    the lifetime of this pool.  This is useful for choosing a
+    blockSize() that fits a whole frame of allocations.
+*/
+size_t QCLBufferPool::highWaterMark() const
+{
+    Q_D(const QCLBufferPool);
+    return d->highWaterMark;
+}
+
+/*!
+    Returns the fraction of the parent buffers that have been handed out
+    but are not holding requested data, between 0 and 1.  This includes
+    the padding added by size classes, the space on the free lists, and
+    the unused tails of parent buffers that have been filled.  The space
+    that has never been handed out at the end of the current parent
+    buffer is not counted.
+
+    \sa bytesAllocated(), bytesFree()
+*/
+qreal QCLBufferPool::fragmentation() const
+{
+    Q_D(const QCLBufferPool);
+#ifdef QT_OPENCL_1_1
+    size_t handedOut = 0;
+    for (int index = 0; index < d->blocks.size(); ++index) {
+        const QCLBufferPoolBlock &block = d->blocks.at(index);
+        if (block.size != d->blockSize || index < d->current)
+            handedOut += block.size;
+        else if (index == d->current)
+            handedOut += block.used;
+    }
+#else
+    size_t handedOut = d->bytesInUse;
+#endif
+    if (!handedOut)
+        return 0.0;
+    return qreal(handedOut - d->bytesAllocated) / qreal(handedOut);
+}
+
+QT_END_NAMESPACE
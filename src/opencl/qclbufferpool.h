@@ -0,0 +1,96 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCLBUFFERPOOL_H
+#define QCLBUFFERPOOL_H
+
+#include "qclbuffer.h"
+#include <QtCore/qscopedpointer.h>
+
+QT_BEGIN_HEADER
+
+QT_BEGIN_NAMESPACE
+
+QT_MODULE(CL)
+
+class QCLContext;
+class QCLBufferPoolPrivate;
+
+class Q_CL_EXPORT QCLBufferPool
+{
+public:
+    explicit QCLBufferPool
+        (QCLContext *context, size_t blockSize = 4 * 1024 * 1024,
+         QCLMemoryObject::Access access = QCLMemoryObject::ReadWrite);
+    ~QCLBufferPool();
+
+    QCLContext *context() const;
+    size_t blockSize() const;
+    size_t alignment() const;
+    QCLMemoryObject::Access access() const;
+
+    QCLBuffer allocate(size_t size);
+    void release(const QCLBuffer &buffer);
+
+    void reset();
+    void clear();
+
+    int allocationCount() const;
+    int blockCount() const;
+    size_t bytesAllocated() const;
+    size_t bytesInUse() const;
+    size_t bytesFree() const;
+    size_t bytesReserved() const;
+    size_t highWaterMark() const;
+    qreal fragmentation() const;
+
+private:
+    QScopedPointer<QCLBufferPoolPrivate> d_ptr;
+
+    Q_DISABLE_COPY(QCLBufferPool)
+    Q_DECLARE_PRIVATE(QCLBufferPool)
+};
+
+QT_END_NAMESPACE
+
+QT_END_HEADER
+
+#endif
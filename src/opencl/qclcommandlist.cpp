@@ -0,0 +1,585 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qclcommandlist.h"
+#include "qclcontext.h"
+#include "qclkernel_p.h"
+#include "qclloader_p.h"
+#include <QtCore/qlist.h>
+#include <QtCore/qdebug.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QCLCommandList
+    \brief The QCLCommandList class records a sequence of OpenCL commands for repeated execution.
+    \since 4.7
+    \ingroup opencl
+
+    Applications that submit the same sequence of kernel launches and
+    copies every frame spend a noticeable amount of host time setting
+    up each command again with QCLKernel::setArg() and QCLKernel::run().
+    QCLCommandList records the sequence once, together with the kernel
+    arguments and work sizes, and replay() then submits the whole
+    sequence to a command queue in one call:
+
+    \code
+    QCLCommandList frame(&context);
+    blur.setGlobalWorkSize(width, height);
+    blur.setArgs(input, temp);
+    frame.addKernel(blur);
+    int shadeCommand = frame.addKernel(shade);
+    frame.addBarrier();
+    frame.addCopy(output, 0, output.size(), display, 0);
+
+    for (;;) {
+        frame.patchArg(shadeCommand, 2, float(time));
+        frame.replay().waitForFinished();
+    }
+    \endcode
+
+    addKernel() takes a snapshot of the kernel's current arguments,
+    global work size and local work size, so later changes to the
+    QCLKernel object do not affect the recorded command.  Individual
+    arguments and work sizes can be changed between replays with
+    patchArg(), setGlobalWorkSize() and setLocalWorkSize(), using
+    the command index that addKernel() returned.
+
+    During replay() the recorded arguments are compared with the
+    arguments that were last set on the kernel, and only those that
+    differ are passed to \c{clSetKernelArg()}.  When a list is the only
+    user of its kernels, a replay normally sets no arguments other
+    than the patched ones.  Only the last command in the list creates
+    an event, which replay() returns.
+
+    QCLVector arguments are prepared for kernel use when they are
+    recorded or patched.  If the host accesses such a vector between
+    replays, pass it to patchArg() again before the next replay().
+
+    QCLCommandList is not thread-safe, and replaying a list modifies
+    the argument state of its kernels in the same way as QCLKernel::run().
+
+    \sa QCLKernel, QCLContext::barrier()
+*/
+
+struct QCLCommand
+{
+    enum Type
+    {
+        Kernel,
+        CopyBuffer,
+        CopyImage,
+        Barrier
+    };
+
+    explicit QCLCommand(Type t)
+        : type(t), args(0), localWorkSize(0), source(0), dest(0)
+    {
+        for (int dim = 0; dim < 3; ++dim) {
+            sourceOrigin[dim] = 0;
+            destOrigin[dim] = 0;
+            region[dim] = 1;
+        }
+    }
+    ~QCLCommand()
+    {
+        delete args;
+        if (source)
+            clReleaseMemObject(source);
+        if (dest)
+            clReleaseMemObject(dest);
+    }
+
+    Type type;
+
+    // Kernel launches.
+    QCLKernel kernel;
+    QCLKernelArgCache *args;
+    QCLWorkSize globalWorkSize;
+    QCLWorkSize localWorkSize;
+
+    // Copies between buffers or images.
+    cl_mem source;
+    cl_mem dest;
+    size_t sourceOrigin[3];
+    size_t destOrigin[3];
+    size_t region[3];
+
+private:
+    Q_DISABLE_COPY(QCLCommand)
+};
+
+class QCLCommandListPrivate
+{
+public:
+    QCLCommandListPrivate(QCLContext *ctx) : context(ctx) {}
+    ~QCLCommandListPrivate() { qDeleteAll(commands); }
+
+    QCLContext *context;
+    QList<QCLCommand *> commands;
+
+    int add(QCLCommand *command)
+    {
+        commands.append(command);
+        return commands.size() - 1;
+    }
+    QCLCommand *kernelCommand(int command, const char *name) const;
+    void patch(int command, int index, QCLKernelArgCache::Kind kind,
+               const void *data, size_t size);
+};
+
+QCLCommand *QCLCommandListPrivate::kernelCommand
+    (int command, const char *name) const
+{
+    if (command < 0 || command >= commands.size() ||
+            commands.at(command)->type != QCLCommand::Kernel) {
+        qWarning() << name << "command" << command
+                   << "is not a kernel launch";
+        return 0;
+    }
+    return commands.at(command);
+}
+
+// Binds the arguments in "args" to a kernel, going through the kernel's
+// shared argument cache so that unchanged arguments are skipped.
+static void qt_cl_apply_args(QCLKernelPrivate *kernel,
+                             const QCLKernelArgCache *args)
+{
+    for (int index = 0; index < args->args.size(); ++index) {
+        const QCLKernelArgCache::Arg &arg = args->args[index];
+        switch (arg.kind) {
+        case QCLKernelArgCache::Value:
+            kernel->setArg(index, arg.kind, arg.value.constData(), arg.size);
+            break;
+        case QCLKernelArgCache::Local:
+            kernel->setArg(index, arg.kind, 0, arg.size);
+            break;
+        case QCLKernelArgCache::MemoryObject:
+        case QCLKernelArgCache::Sampler:
+            kernel->setArg(index, arg.kind, &arg.object, arg.size);
+            break;
+        default: break;
+        }
+    }
+}
+
+void QCLCommandListPrivate::patch
+    (int command, int index, QCLKernelArgCache::Kind kind,
+     const void *data, size_t size)
+{
+    QCLCommand *cmd = kernelCommand(command, "QCLCommandList::patchArg:");
+    if (cmd)
+        cmd->args->update(index, kind, data, size);
+}
+
+/*!
+    Constructs an empty command list for \a context.
+*/
+QCLCommandList::QCLCommandList(QCLContext *context)
+    : d_ptr(new QCLCommandListPrivate(context))
+{
+}
+
+/*!
+    Destroys this command list.  Commands that were submitted by
+    replay() continue to execute.
+*/
+QCLCommandList::~QCLCommandList()
+{
+}
+
+/*!
+    Returns the context that this command list was created for.
+*/
+QCLContext *QCLCommandList::context() const
+{
+    Q_D(const QCLCommandList);
+    return d->context;
+}
+
+/*!
+    Returns true if no commands have been recorded; false otherwise.
+
+    \sa count(), clear()
+*/
+bool QCLCommandList::isEmpty() const
+{
+    Q_D(const QCLCommandList);
+    return d->commands.isEmpty();
+}
+
+/*!
+    Returns the number of commands that have been recorded.
+
+    \sa isEmpty()
+*/
+int QCLCommandList::count() const
+{
+    Q_D(const QCLCommandList);
+    return d->commands.size();
+}
+
+/*!
+    Removes all recorded commands from this list, and releases the
+    memory objects that they refer to.
+*/
+void QCLCommandList::clear()
+{
+    Q_D(QCLCommandList);
+    qDeleteAll(d->commands);
+    d->commands.clear();
+}
+
+/*!
+    Records a launch of \a kernel with its current arguments, global
+    work size and local work size.  Returns the index of the new
+    command, or -1 if \a kernel is null or belongs to a different context.
+
+    If \a kernel does not have an explicit local work size, the local
+    work size that QCLKernel::run() would use at this point is recorded;
+    this includes sizes found by QCLKernel::autoTuneLocalWorkSize().
+
+    \sa patchArg(), setGlobalWorkSize(), setLocalWorkSize()
+*/
+int QCLCommandList::addKernel(const QCLKernel &kernel)
+{
+    Q_D(QCLCommandList);
+    if (kernel.isNull() || kernel.context() != d->context) {
+        qWarning() << "QCLCommandList::addKernel: kernel is null or"
+                      " belongs to a different context";
+        return -1;
+    }
+    QCLCommand *cmd = new QCLCommand(QCLCommand::Kernel);
+    cmd->kernel = kernel;
+    cmd->args = new QCLKernelArgCache();
+    const QCLKernelArgCache *current = kernel.d_func()->args;
+    for (int index = 0; index < current->args.size(); ++index) {
+        const QCLKernelArgCache::Arg &arg = current->args[index];
+        switch (arg.kind) {
+        case QCLKernelArgCache::Value:
+            cmd->args->update(index, arg.kind, arg.value.constData(), arg.size);
+            break;
+        case QCLKernelArgCache::Local:
+            cmd->args->update(index, arg.kind, 0, arg.size);
+            break;
+        case QCLKernelArgCache::MemoryObject:
+        case QCLKernelArgCache::Sampler:
+            cmd->args->update(index, arg.kind, &arg.object, arg.size);
+            break;
+        default: break;
+        }
+    }
+    cmd->globalWorkSize = kernel.globalWorkSize();
+    // The queue is not known until replay(), so use the tuning
+    // results for the default device.
+    const size_t *local = kernel.runLocalWorkSize(0);
+    if (local) {
+        if (cmd->globalWorkSize.dimensions() == 1)
+            cmd->localWorkSize = QCLWorkSize(local[0]);
+        else if (cmd->globalWorkSize.dimensions() == 2)
+            cmd->localWorkSize = QCLWorkSize(local[0], local[1]);
+        else
+            cmd->localWorkSize = QCLWorkSize(local[0], local[1], local[2]);
+    }
+    return d->add(cmd);
+}
+
+/*!
+    Records a copy of \a size bytes from \a offset in \a source to
+    \a destOffset in \a dest.  Returns the index of the new command.
+
+    \sa QCLBuffer::copyToAsync()
+*/
+int QCLCommandList::addCopy
+    (const QCLBuffer &source, size_t offset, size_t size,
+     const QCLBuffer &dest, size_t destOffset)
+{
+    Q_D(QCLCommandList);
+    QCLCommand *cmd = new QCLCommand(QCLCommand::CopyBuffer);
+    cmd->source = source.memoryId();
+    cmd->dest = dest.memoryId();
+    if (cmd->source)
+        clRetainMemObject(cmd->source);
+    if (cmd->dest)
+        clRetainMemObject(cmd->dest);
+    cmd->sourceOrigin[0] = offset;
+    cmd->destOrigin[0] = destOffset;
+    cmd->region[0] = size;
+    return d->add(cmd);
+}
+
+/*!
+    Records a copy of \a rect from \a source to \a destOffset
+    in \a dest.  Returns the index of the new command.
+
+    \sa QCLImage2D::copyToAsync()
+*/
+int QCLCommandList::addCopy
+    (const QCLImage2D &source, const QRect &rect,
+     const QCLImage2D &dest, const QPoint &destOffset)
+{
+    Q_D(QCLCommandList);
+    QCLCommand *cmd = new QCLCommand(QCLCommand::CopyImage);
+    cmd->source = source.memoryId();
+    cmd->dest = dest.memoryId();
+    if (cmd->source)
+        clRetainMemObject(cmd->source);
+    if (cmd->dest)
+        clRetainMemObject(cmd->dest);
+    cmd->sourceOrigin[0] = rect.x();
+    cmd->sourceOrigin[1] = rect.y();
+    cmd->destOrigin[0] = destOffset.x();
+    cmd->destOrigin[1] = destOffset.y();
+    cmd->region[0] = rect.width();
+    cmd->region[1] = rect.height();
+    return d->add(cmd);
+}
+
+/*!
+    Records a barrier that prevents later commands in the list from
+    starting until all earlier commands have finished.  This is only
+    necessary when the list is replayed on an out-of-order command queue.
+    Returns the index of the new command.
+
+    \sa QCLContext::barrier()
+*/
+int QCLCommandList::addBarrier()
+{
+    Q_D(QCLCommandList);
+    return d->add(new QCLCommand(QCLCommand::Barrier));
+}
+
+/*!
+    Sets the global work size for the kernel launch at index
+    \a command to \a size.
+
+    \sa setLocalWorkSize(), QCLKernel::setGlobalWorkSize()
+*/
+void QCLCommandList::setGlobalWorkSize(int command, const QCLWorkSize &size)
+{
+    Q_D(QCLCommandList);
+    QCLCommand *cmd = d->kernelCommand
+        (command, "QCLCommandList::setGlobalWorkSize:");
+    if (cmd)
+        cmd->globalWorkSize = size;
+}
+
+/*!
+    Sets the local work size for the kernel launch at index
+    \a command to \a size.  If \a size has a width of zero, then
+    the OpenCL implementation will choose the local work size.
+
+    \sa setGlobalWorkSize(), QCLKernel::setLocalWorkSize()
+*/
+void QCLCommandList::setLocalWorkSize(int command, const QCLWorkSize &size)
+{
+    Q_D(QCLCommandList);
+    QCLCommand *cmd = d->kernelCommand
+        (command, "QCLCommandList::setLocalWorkSize:");
+    if (cmd)
+        cmd->localWorkSize = size;
+}
+
+/*!
+    Sets argument \a index of the kernel launch at index \a command
+    to \a value for subsequent replays.
+
+    \sa QCLKernel::setArg()
+*/
+void QCLCommandList::patchArg(int command, int index, cl_int value)
+{
+    Q_D(QCLCommandList);
+    d->patch(command, index, QCLKernelArgCache::Value, &value, sizeof(value));
+}
+
+/*!
+    \overload
+*/
+void QCLCommandList::patchArg(int command, int index, cl_uint value)
+{
+    Q_D(QCLCommandList);
+    d->patch(command, index, QCLKernelArgCache::Value, &value, sizeof(value));
+}
+
+/*!
+    \overload
+*/
+void QCLCommandList::patchArg(int command, int index, float value)
+{
+    Q_D(QCLCommandList);
+    d->patch(command, index, QCLKernelArgCache::Value, &value, sizeof(value));
+}
+
+/*!
+    \overload
+*/
+void QCLCommandList::patchArg
+    (int command, int index, const QCLMemoryObject &value)
+{
+    Q_D(QCLCommandList);
+    cl_mem id = value.memoryId();
+    d->patch(command, index, QCLKernelArgCache::MemoryObject, &id, sizeof(id));
+}
+
+/*!
+    \overload
+*/
+void QCLCommandList::patchArg
+    (int command, int index, const QCLVectorBase &value)
+{
+    Q_D(QCLCommandList);
+    cl_mem id = value.kernelArg();
+    d->patch(command, index, QCLKernelArgCache::MemoryObject, &id, sizeof(id));
+}
+
+/*!
+    \overload
+
+    Sets argument \a index of the kernel launch at index \a command
+    to the \a size bytes at \a data.  If \a data is null, then the
+    argument is a \c __local buffer of \a size bytes.
+*/
+void QCLCommandList::patchArg
+    (int command, int index, const void *data, size_t size)
+{
+    Q_D(QCLCommandList);
+    d->patch(command, index,
+             data ? QCLKernelArgCache::Value : QCLKernelArgCache::Local,
+             data, size);
+}
+
+/*!
+    Submits all recorded commands to the active command queue for
+    context().  None of the commands will start until all of the
+    events in \a after have been signaled as finished, even if the
+    queue executes commands out of order.  Returns an
+    event that is signaled when the last command finishes, or a null
+    event if the list is empty or a command could not be queued.
+
+    \sa QCLContext::commandQueue()
+*/
+QCLEvent QCLCommandList::replay(const QCLEventList &after)
+{
+    Q_D(QCLCommandList);
+    return enqueue(d->context->activeQueue(), after);
+}
+
+/*!
+    \overload
+
+    Submits all recorded commands to \a queue.
+*/
+QCLEvent QCLCommandList::replay
+    (const QCLCommandQueue &queue, const QCLEventList &after)
+{
+    return enqueue(queue.queueId(), after);
+}
+
+QCLEvent QCLCommandList::enqueue
+    (cl_command_queue queue, const QCLEventList &after)
+{
+    Q_D(QCLCommandList);
+    int count = d->commands.size();
+    cl_event event = 0;
+    cl_int error = CL_SUCCESS;
+    for (int index = 0; index < count && error == CL_SUCCESS; ++index) {
+        QCLCommand *cmd = d->commands.at(index);
+        // Every command waits for "after", because on an out-of-order
+        // queue a later command could otherwise start before the first.
+        cl_uint numEvents = after.size();
+        const cl_event *events = after.eventData();
+        // Only the last command needs an event, unless a profiler
+        // is recording, in which case every command except barriers
+        // gets one so that it can be timed.
+        cl_event profiled = 0;
+        cl_event *lastEvent = (index == count - 1) ? &event : 0;
+        if (!lastEvent && cmd->type != QCLCommand::Barrier)
+            lastEvent = d->context->profilingEvent(&profiled);
+        cl_kernel kernelId = 0;
+        switch (cmd->type) {
+        case QCLCommand::Kernel: {
+            QCLKernelPrivate *kernel = cmd->kernel.d_func();
+            qt_cl_apply_args(kernel, cmd->args);
+            kernelId = kernel->id;
+            error = clEnqueueNDRangeKernel
+                (queue, kernel->id, cmd->globalWorkSize.dimensions(),
+                 0, cmd->globalWorkSize.sizes(),
+                 cmd->localWorkSize.width() ? cmd->localWorkSize.sizes() : 0,
+                 numEvents, events, lastEvent);
+            break; }
+        case QCLCommand::CopyBuffer:
+            error = clEnqueueCopyBuffer
+                (queue, cmd->source, cmd->dest, cmd->sourceOrigin[0],
+                 cmd->destOrigin[0], cmd->region[0],
+                 numEvents, events, lastEvent);
+            break;
+        case QCLCommand::CopyImage:
+            error = clEnqueueCopyImage
+                (queue, cmd->source, cmd->dest, cmd->sourceOrigin,
+                 cmd->destOrigin, cmd->region,
+                 numEvents, events, lastEvent);
+            break;
+        case QCLCommand::Barrier:
+            if (numEvents)
+                error = clEnqueueWaitForEvents(queue, numEvents, events);
+            if (error == CL_SUCCESS)
+                error = clEnqueueBarrier(queue);
+            if (error == CL_SUCCESS && lastEvent)
+                error = clEnqueueMarker(queue, lastEvent);
+            break;
+        }
+        if (error == CL_SUCCESS && lastEvent &&
+                cmd->type != QCLCommand::Barrier) {
+            d->context->recordCommand
+                (*lastEvent, after, kernelId);
+        }
+        if (profiled)
+            clReleaseEvent(profiled);
+    }
+    d->context->reportError("QCLCommandList::replay:", error);
+    if (error == CL_SUCCESS && event)
+        return QCLEvent(event);
+    else
+        return QCLEvent();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,116 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QCLCOMMANDLIST_H
+#define QCLCOMMANDLIST_H
+
+#include "qclevent.h"
+#include "qclworksize.h"
+#include "qclmemoryobject.h"
+#include <QtCore/qscopedpointer.h>
+#include <QtCore/qrect.h>
+
+QT_BEGIN_HEADER
+
+QT_BEGIN_NAMESPACE
+
+QT_MODULE(CL)
+
+class QCLContext;
+class QCLKernel;
+class QCLBuffer;
+class QCLImage2D;
+class QCLVectorBase;
+class QCLCommandQueue;
+class QCLCommandListPrivate;
+
+class Q_CL_EXPORT QCLCommandList
+{
+public:
+    explicit QCLCommandList(QCLContext *context);
+    ~QCLCommandList();
+
+    QCLContext *context() const;
+
+    bool isEmpty() const;
+    int count() const;
+    void clear();
+
+    int addKernel(const QCLKernel &kernel);
+    int addCopy(const QCLBuffer &source, size_t offset, size_t size,
+                const QCLBuffer &dest, size_t destOffset);
+    int addCopy(const QCLImage2D &source, const QRect &rect,
+                const QCLImage2D &dest, const QPoint &destOffset);
+    int addBarrier();
+
+    void setGlobalWorkSize(int command, const QCLWorkSize &size);
+    void setLocalWorkSize(int command, const QCLWorkSize &size);
+
+    void patchArg(int command, int index, cl_int value);
+    void patchArg(int command, int index, cl_uint value);
+    void patchArg(int command, int index, float value);
+    void patchArg(int command, int index, const QCLMemoryObject &value);
+#if defined(qdoc)
+    void patchArg(int command, int index, const QCLVector<T> &value);
+#else
+    void patchArg(int command, int index, const QCLVectorBase &value);
+#endif
+    void patchArg(int command, int index, const void *data, size_t size);
+
+    QCLEvent replay(const QCLEventList &after = QCLEventList());
+    QCLEvent replay(const QCLCommandQueue &queue,
+                    const QCLEventList &after = QCLEventList());
+
+private:
+    QScopedPointer<QCLCommandListPrivate> d_ptr;
+
+    Q_DISABLE_COPY(QCLCommandList)
+    Q_DECLARE_PRIVATE(QCLCommandList)
+
+    QCLEvent enqueue(cl_command_queue queue, const QCLEventList &after);
+};
+
+QT_END_NAMESPACE
+
+QT_END_HEADER
+
+#endif
@@ -41,6 +41,7 @@
 
 #include "qclcommandqueue.h"
 #include "qclcontext.h"
+#include "qclloader_p.h"
 #include <QtCore/qvarlengtharray.h>
 
 QT_BEGIN_NAMESPACE
@@ -57,6 +58,12 @@ QT_BEGIN_NAMESPACE
     QCLContext::commandQueue() as the command destination.
     QCLContext::setCommandQueue() can be used to alter the
     destination queue.
+
+    QCLKernel::run() and the asynchronous QCLBuffer transfer functions
+    also accept an explicit queue, which is typically obtained from
+    the pool of queues that is managed by QCLContext::createQueuePool()
+    and QCLContext::acquireQueue().  Work on different queues may
+    overlap; flush() and finish() control each queue independently.
 */
 
 /*!
@@ -133,6 +140,51 @@ bool QCLCommandQueue::isProfilingEnabled() const
     return (props & CL_QUEUE_PROFILING_ENABLE) != 0;
 }
 
+/*!
+    Flushes all previously queued commands on this queue to the
+    device.  The commands are delivered to the device, but no
+    guarantees are given that they will be executed.
+
+    \sa finish(), QCLContext::flush()
+*/
+void QCLCommandQueue::flush()
+{
+    if (m_id)
+        clFlush(m_id);
+}
+
+/*!
+    Blocks until all previously queued commands on this queue
+    have finished execution.
+
+    \sa flush(), QCLContext::finish()
+*/
+void QCLCommandQueue::finish()
+{
+    if (m_id)
+        clFinish(m_id);
+}
+
+/*!
+    Returns a marker event for this queue.  The event will be
+    signalled when all commands that were queued on this queue
+    before this point have finished.
+
+    \sa QCLContext::marker()
+*/
+QCLEvent QCLCommandQueue::marker()
+{
+    if (!m_id)
+        return QCLEvent();
+    cl_event evid;
+    cl_int error = clEnqueueMarker(m_id, &evid);
+    m_context->reportError("QCLCommandQueue::marker:", error);
+    if (error != CL_SUCCESS)
+        return QCLEvent();
+    else
+        return QCLEvent(evid);
+}
+
 /*!
     \fn cl_command_queue QCLCommandQueue::queueId() const
 
@@ -43,6 +43,7 @@
 #define QCLCOMMANDQUEUE_H
 
 #include "qclglobal.h"
+#include "qclevent.h"
 
 QT_BEGIN_HEADER
 
@@ -68,6 +69,11 @@ public:
     bool isOutOfOrder() const;
     bool isProfilingEnabled() const;
 
+    void flush();
+    void finish();
+
+    QCLEvent marker();
+
     cl_command_queue queueId() const { return m_id; }
     QCLContext *context() const { return m_context; }
 
@@ -83,22 +89,22 @@ inline QCLCommandQueue::QCLCommandQueue(const QCLCommandQueue &other)
     : m_context(other.m_context), m_id(other.m_id)
 {
     if (m_id)
-        clRetainCommandQueue(m_id);
+        qt_clRetainCommandQueue(m_id);
 }
 
 inline QCLCommandQueue::~QCLCommandQueue()
 {
     if (m_id)
-        clReleaseCommandQueue(m_id);
+        qt_clReleaseCommandQueue(m_id);
 }
 
 inline QCLCommandQueue &QCLCommandQueue::operator=(const QCLCommandQueue &other)
 {
     m_context = other.m_context;
     if (other.m_id)
-        clRetainCommandQueue(other.m_id);
+        qt_clRetainCommandQueue(other.m_id);
     if (m_id)
-        clReleaseCommandQueue(m_id);
+        qt_clReleaseCommandQueue(m_id);
     m_id = other.m_id;
     return *this;
 }
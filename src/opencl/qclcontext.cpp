@@ -41,9 +41,27 @@
 
 #include "qclcontext.h"
 #include "qclext_p.h"
+#include "qclkernel_p.h"
+#include "qclloader_p.h"
+#include "qclprofiler.h"
+#include "qclstaging_p.h"
 #include <QtCore/qdebug.h>
 #include <QtCore/qvarlengtharray.h>
 #include <QtCore/qfile.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qdatastream.h>
+#include <QtCore/qcryptographichash.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qfutureinterface.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qset.h>
+#include <QtCore/qreadwritelock.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qthreadstorage.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qrunnable.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -56,6 +74,174 @@ QT_BEGIN_NAMESPACE
     \sa QCLContextGL
 */
 
+// "serial" is zero for the shared kernels of a context, and the
+// context's kernelSerial for the per-thread kernels.
+struct QCLKernelCacheKey
+{
+    cl_program program;
+    int serial;
+    QByteArray name;
+};
+
+inline bool operator==(const QCLKernelCacheKey &a, const QCLKernelCacheKey &b)
+{
+    return a.program == b.program && a.serial == b.serial && a.name == b.name;
+}
+
+inline uint qHash(const QCLKernelCacheKey &key)
+{
+    return qHash(key.name) ^
+           qHash(reinterpret_cast<quintptr>(key.program)) ^
+           qHash(key.serial);
+}
+
+struct QCLQueuePoolEntry
+{
+    QCLCommandQueue queue;
+    QVector<cl_event> inFlight;
+
+    int prune();
+    void release();
+};
+
+// Drops the events that have completed and returns the number of
+// commands that are still in flight on the queue.
+int QCLQueuePoolEntry::prune()
+{
+    int out = 0;
+    for (int index = 0; index < inFlight.size(); ++index) {
+        cl_int status = CL_COMPLETE;
+        clGetEventInfo(inFlight[index], CL_EVENT_COMMAND_EXECUTION_STATUS,
+                       sizeof(status), &status, 0);
+        if (status == CL_COMPLETE || status < 0)
+            clReleaseEvent(inFlight[index]);
+        else
+            inFlight[out++] = inFlight[index];
+    }
+    inFlight.resize(out);
+    return out;
+}
+
+void QCLQueuePoolEntry::release()
+{
+    for (int index = 0; index < inFlight.size(); ++index)
+        clReleaseEvent(inFlight[index]);
+    inFlight.clear();
+}
+
+// Per-thread active command queues, keyed by QCLContextPrivate::serial.
+// The queues are retained by the context in threadQueues, so stale
+// entries for released contexts are never used because the serial
+// of a context changes whenever it is released.
+typedef QHash<int, cl_command_queue> QCLThreadQueueMap;
+Q_GLOBAL_STATIC(QThreadStorage<QCLThreadQueueMap>, qt_cl_thread_queues)
+
+static QBasicAtomicInt qt_cl_context_serial = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+static int qt_cl_next_context_serial()
+{
+    return qt_cl_context_serial.fetchAndAddRelaxed(1) + 1;
+}
+
+// The serials that may still have entries in the per-thread queue or
+// kernel maps.  A released context can only remove its entries from the
+// maps of the thread that released it, so the other threads drop the
+// entries of retired serials the next time that they add one.
+struct QCLThreadSerials
+{
+    QMutex lock;
+    QSet<int> live;
+};
+Q_GLOBAL_STATIC(QCLThreadSerials, qt_cl_thread_queue_serials)
+
+static void qt_cl_retire_thread_serial(int serial)
+{
+    QCLThreadSerials *serials = qt_cl_thread_queue_serials();
+    if (serials) {
+        QMutexLocker locker(&serials->lock);
+        serials->live.remove(serial);
+    }
+    QThreadStorage<QCLThreadQueueMap> *storage = qt_cl_thread_queues();
+    if (storage && storage->hasLocalData())
+        storage->localData().remove(serial);
+}
+
+static void qt_cl_insert_thread_queue
+    (QCLThreadQueueMap *map, int serial, cl_command_queue queue)
+{
+    QCLThreadSerials *serials = qt_cl_thread_queue_serials();
+    if (serials) {
+        QMutexLocker locker(&serials->lock);
+        serials->live.insert(serial);
+        QCLThreadQueueMap::Iterator it = map->begin();
+        while (it != map->end()) {
+            if (serials->live.contains(it.key()))
+                ++it;
+            else
+                it = map->erase(it);
+        }
+    }
+    map->insert(serial, queue);
+}
+
+// Per-thread kernels created by cachedKernel() in PerThreadKernel mode.
+// The kernels belong to the thread, so they are released when the
+// thread exits rather than being handed to a new thread that reuses
+// its id.  Entries are keyed by QCLContextPrivate::kernelSerial, which
+// is retired when the kernel cache of a context is cleared or the
+// context is released or destroyed.  Retiring a serial drops the
+// entries of the calling thread at once; other threads drop theirs the
+// next time that they cache a kernel, and the map is also emptied when
+// it reaches qt_cl_max_thread_kernels.  Until then, a stale entry keeps
+// its kernel, and therefore the OpenCL context, alive, but it is never
+// returned again.
+typedef QHash<QCLKernelCacheKey, QCLKernel> QCLThreadKernelMap;
+Q_GLOBAL_STATIC(QThreadStorage<QCLThreadKernelMap>, qt_cl_thread_kernels)
+Q_GLOBAL_STATIC(QCLThreadSerials, qt_cl_thread_kernel_serials)
+
+enum { qt_cl_max_thread_kernels = 64 };
+
+static void qt_cl_retire_kernel_serial(int serial)
+{
+    QCLThreadSerials *serials = qt_cl_thread_kernel_serials();
+    if (serials) {
+        QMutexLocker locker(&serials->lock);
+        serials->live.remove(serial);
+    }
+    QThreadStorage<QCLThreadKernelMap> *storage = qt_cl_thread_kernels();
+    if (!storage || !storage->hasLocalData())
+        return;
+    QCLThreadKernelMap &map = storage->localData();
+    QCLThreadKernelMap::Iterator it = map.begin();
+    while (it != map.end()) {
+        if (it.key().serial == serial)
+            it = map.erase(it);
+        else
+            ++it;
+    }
+}
+
+static void qt_cl_insert_thread_kernel
+    (QCLThreadKernelMap *map, const QCLKernelCacheKey &key,
+     const QCLKernel &kernel)
+{
+    QCLThreadSerials *serials = qt_cl_thread_kernel_serials();
+    if (serials) {
+        QMutexLocker locker(&serials->lock);
+        serials->live.insert(key.serial);
+        QCLThreadKernelMap::Iterator it = map->begin();
+        while (it != map->end()) {
+            if (serials->live.contains(it.key().serial))
+                ++it;
+            else
+                it = map->erase(it);
+        }
+    }
+    if (map->size() >= qt_cl_max_thread_kernels)
+        map->clear();
+    map->insert(key, kernel);
+}
+
 class QCLContextPrivate
 {
 public:
@@ -63,13 +249,35 @@ public:
         : id(0)
         , isCreated(false)
         , lastError(CL_SUCCESS)
+        , queuePoolNext(0)
+        , serial(qt_cl_next_context_serial())
+        , kernelSerial(qt_cl_next_context_serial())
+        , staging(0)
+        , stagingSlotSize(1024 * 1024)
+        , hostFallback(false)
     {
     }
     ~QCLContextPrivate()
     {
+        // A profiler that is still recording must not call back into
+        // this context after it has gone.
+        QCLProfiler *attached = profiler.fetchAndStoreOrdered(0);
+        if (attached)
+            attached->contextDestroyed();
+
+        // Release the cached kernels, which hold references to programs.
+        kernelCache.clear();
+        qt_cl_retire_kernel_serial(kernelSerial.loadAcquire());
+        builtinPrograms.clear();
+
         // Release the command queues for the context.
+        releaseQueuePool();
+        releaseThreadQueues();
+        releaseStaging();
         commandQueue = QCLCommandQueue();
         defaultCommandQueue = QCLCommandQueue();
+        profiledQueue = QCLCommandQueue();
+        unprofiledQueue = QCLCommandQueue();
 
         // Release the context.
         if (isCreated)
@@ -82,8 +290,272 @@ public:
     QCLCommandQueue defaultCommandQueue;
     QCLDevice defaultDevice;
     cl_int lastError;
+    QString programCacheDirectory;
+    QAtomicInt programCacheHits;
+    QAtomicInt programCacheMisses;
+    QHash<QCLKernelCacheKey, QCLKernel> kernelCache;
+    QReadWriteLock kernelCacheLock;
+    QAtomicInt kernelSerial;
+    QHash<QByteArray, QCLProgram> builtinPrograms;
+    QMutex builtinProgramsLock;
+    QString workSizeTuningFile;
+    QString discoveryCacheFile;
+    QHash<QString, QString> tunedWorkSizes;
+    QAtomicInt tunedWorkSizeGeneration;
+    QReadWriteLock tunedWorkSizesLock;
+    QVector<QCLQueuePoolEntry> queuePool;
+    QAtomicInt queuePoolSize;
+    int queuePoolNext;
+    mutable QMutex queuePoolLock;
+
+    void releaseQueuePool()
+    {
+        QMutexLocker locker(&queuePoolLock);
+        for (int index = 0; index < queuePool.size(); ++index)
+            queuePool[index].release();
+        queuePool.clear();
+        queuePoolSize.store(0);
+        queuePoolNext = 0;
+    }
+
+    QAtomicInt serial;
+    QAtomicInt hasThreadQueues;
+    QList<QCLCommandQueue> threadQueues;
+    QMutex threadQueuesLock;
+
+    cl_command_queue threadQueue() const
+    {
+        if (!hasThreadQueues.load())
+            return 0;
+        QThreadStorage<QCLThreadQueueMap> *storage = qt_cl_thread_queues();
+        if (!storage || !storage->hasLocalData())
+            return 0;
+        return storage->localData().value(serial.loadAcquire(), 0);
+    }
+
+    void releaseThreadQueues()
+    {
+        QMutexLocker locker(&threadQueuesLock);
+        int oldSerial = serial.loadAcquire();
+        threadQueues.clear();
+        hasThreadQueues.store(0);
+        serial.storeRelease(qt_cl_next_context_serial());
+        qt_cl_retire_thread_serial(oldSerial);
+    }
+
+    QAtomicInt stagingEnabled;
+    QCLStagingPool *staging;
+    size_t stagingSlotSize;
+    mutable QMutex stagingLock;
+
+    // True if createVector() may keep vectors in host memory while
+    // the context has not been created; see setHostFallbackEnabled().
+    bool hostFallback;
+
+    // Must be called with stagingLock held, which must stay held for
+    // as long as the pool is used.
+    QCLStagingPool *stagingPool()
+    {
+        if (!staging && isCreated)
+            staging = new QCLStagingPool(id, stagingSlotSize);
+        return staging;
+    }
+
+    void releaseStaging()
+    {
+        QMutexLocker locker(&stagingLock);
+        delete staging;
+        staging = 0;
+    }
+
+    // The profiler that is recording commands, if any; see QCLProfiler.
+    // profilerLock is held for reading while a command is recorded, so
+    // that detachProfiler() can wait for recordings in progress.
+    QAtomicPointer<QCLProfiler> profiler;
+    QReadWriteLock profilerLock;
+
+    // If the context-wide queue had to be replaced with a profiling one,
+    // the replacement is profiledQueue and the original is kept in
+    // unprofiledQueue until the profiler detaches.  commandQueueLock
+    // guards commandQueue against being swapped while it is read.
+    QCLCommandQueue profiledQueue;
+    QCLCommandQueue unprofiledQueue;
+    QReadWriteLock commandQueueLock;
+
+    // Raw identifier of commandQueue, which activeQueue() reads without
+    // taking commandQueueLock.  Another thread may still be enqueuing on
+    // a queue after it has been replaced, so every queue that has been
+    // the context-wide queue stays in replacedQueues until the context
+    // is destroyed.
+    QAtomicPointer<_cl_command_queue> activeCommandQueue;
+    QList<QCLCommandQueue> replacedQueues;
+
+    // Must be called with commandQueueLock held for writing.
+    void setActiveQueue(const QCLCommandQueue &queue)
+    {
+        if (!commandQueue.isNull() && !replacedQueues.contains(commandQueue))
+            replacedQueues.append(commandQueue);
+        commandQueue = queue;
+        activeCommandQueue.storeRelease(queue.queueId());
+    }
+
+    void initDefaultDevice();
 };
 
+// Looks up the first device of a newly created context and loads its
+// property snapshot, so that queries on defaultDevice() do not need
+// to call into OpenCL later.
+void QCLContextPrivate::initDefaultDevice()
+{
+    if (defaultDevice.isNull()) {
+        size_t size = 0;
+        if (clGetContextInfo(id, CL_CONTEXT_DEVICES, 0, 0, &size)
+                == CL_SUCCESS && size > 0) {
+            QVarLengthArray<cl_device_id> buf(size / sizeof(cl_device_id));
+            if (clGetContextInfo(id, CL_CONTEXT_DEVICES,
+                                 size, buf.data(), 0) == CL_SUCCESS)
+                defaultDevice = QCLDevice(buf[0]);
+        }
+    }
+    defaultDevice.versionFlags();
+}
+
+// Defined in qcldevice.cpp.
+QByteArray qt_cl_save_device_properties(cl_device_id id);
+bool qt_cl_restore_device_properties
+    (cl_device_id id, cl_platform_id platform, const QByteArray &data);
+
+static const quint32 qt_cl_discovery_magic = 0x51434C44;    // "QCLD"
+static const quint32 qt_cl_discovery_version = 1;
+
+static QByteArray qt_cl_platform_info(cl_platform_id id, cl_platform_info name)
+{
+    size_t size;
+    if (clGetPlatformInfo(id, name, 0, 0, &size) != CL_SUCCESS || !size)
+        return QByteArray();
+    QVarLengthArray<char> buf(size);
+    clGetPlatformInfo(id, name, size, buf.data(), &size);
+    return QByteArray(buf.constData());
+}
+
+static QByteArray qt_cl_device_info(cl_device_id id, cl_device_info name)
+{
+    size_t size;
+    if (clGetDeviceInfo(id, name, 0, 0, &size) != CL_SUCCESS || !size)
+        return QByteArray();
+    QVarLengthArray<char> buf(size);
+    clGetDeviceInfo(id, name, size, buf.data(), &size);
+    return QByteArray(buf.constData());
+}
+
+// The identity strings are what the discovery cache verifies on
+// startup; if a driver update or a hardware change alters any of
+// them, then the cache is discarded.
+static QByteArray qt_cl_platform_identity(cl_platform_id id)
+{
+    return qt_cl_platform_info(id, CL_PLATFORM_NAME) + '\n' +
+           qt_cl_platform_info(id, CL_PLATFORM_VENDOR) + '\n' +
+           qt_cl_platform_info(id, CL_PLATFORM_VERSION);
+}
+
+static QByteArray qt_cl_device_identity(cl_device_id id)
+{
+    return qt_cl_device_info(id, CL_DEVICE_NAME) + '\n' +
+           qt_cl_device_info(id, CL_DEVICE_VENDOR) + '\n' +
+           qt_cl_device_info(id, CL_DEVICE_VERSION) + '\n' +
+           qt_cl_device_info(id, CL_DRIVER_VERSION);
+}
+
+// Returns the devices that were recorded in "fileName" for "type",
+// after checking that the same platform and devices are still present;
+// or an empty list if the cache is missing or out of date.
+static QList<QCLDevice> qt_cl_load_discovery_cache
+    (const QString &fileName, QCLDevice::DeviceTypes type)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QList<QCLDevice>();
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    quint32 magic = 0, version = 0;
+    qint32 cachedType = 0;
+    QByteArray platformIdentity;
+    QList<QByteArray> deviceIdentities;
+    QList<QByteArray> deviceProperties;
+    stream >> magic >> version;
+    if (magic != qt_cl_discovery_magic || version != qt_cl_discovery_version)
+        return QList<QCLDevice>();
+    stream >> cachedType >> platformIdentity
+           >> deviceIdentities >> deviceProperties;
+    if (stream.status() != QDataStream::Ok ||
+            cachedType != qint32(type) || deviceIdentities.isEmpty() ||
+            deviceIdentities.size() != deviceProperties.size())
+        return QList<QCLDevice>();
+
+    // Find the recorded platform without enumerating any devices.
+    cl_uint count = 0;
+    if (clGetPlatformIDs(0, 0, &count) != CL_SUCCESS || !count)
+        return QList<QCLDevice>();
+    QVarLengthArray<cl_platform_id> platforms(count);
+    clGetPlatformIDs(count, platforms.data(), &count);
+    cl_platform_id platform = 0;
+    for (int index = 0; index < platforms.size() && !platform; ++index) {
+        if (qt_cl_platform_identity(platforms[index]) == platformIdentity)
+            platform = platforms[index];
+    }
+    if (!platform)
+        return QList<QCLDevice>();
+
+    if (clGetDeviceIDs(platform, cl_device_type(type), 0, 0, &count)
+            != CL_SUCCESS || count != cl_uint(deviceIdentities.size()))
+        return QList<QCLDevice>();
+    QVarLengthArray<cl_device_id> ids(count);
+    clGetDeviceIDs(platform, cl_device_type(type), count, ids.data(), &count);
+    for (int index = 0; index < ids.size(); ++index) {
+        if (qt_cl_device_identity(ids[index]) != deviceIdentities.at(index))
+            return QList<QCLDevice>();
+    }
+
+    // A snapshot that cannot be read back makes the whole cache a miss.
+    QList<QCLDevice> devices;
+    for (int index = 0; index < ids.size(); ++index) {
+        if (!qt_cl_restore_device_properties
+                (ids[index], platform, deviceProperties.at(index)))
+            return QList<QCLDevice>();
+        devices.append(QCLDevice(ids[index]));
+    }
+    return devices;
+}
+
+// Records the devices of the platform that create() chose, which is
+// the platform of the first device; qt_cl_load_discovery_cache()
+// compares the cache against that platform's devices only.
+static void qt_cl_save_discovery_cache
+    (const QString &fileName, QCLDevice::DeviceTypes type,
+     const QList<QCLDevice> &devices)
+{
+    QCLPlatform platform = devices.at(0).platform();
+    QList<QByteArray> deviceIdentities;
+    QList<QByteArray> deviceProperties;
+    foreach (QCLDevice device, devices) {
+        if (device.platform() != platform)
+            continue;
+        deviceIdentities.append(qt_cl_device_identity(device.deviceId()));
+        deviceProperties.append(qt_cl_save_device_properties(device.deviceId()));
+    }
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << qt_cl_discovery_magic << qt_cl_discovery_version
+           << qint32(type)
+           << qt_cl_platform_identity(platform.platformId())
+           << deviceIdentities << deviceProperties;
+    if (stream.status() == QDataStream::Ok)
+        file.commit();
+}
+
 /*!
     Constructs a new OpenCL context object.  This constructor is
     typically followed by calls to setPlatform() and create().
@@ -153,8 +625,14 @@ bool QCLContext::create(QCLDevice::DeviceTypes type)
         return true;
     // The "cl_khr_icd" extension says that a null platform cannot
     // be supplied to OpenCL any more, so find the first platform
-    // that has devices that match "type".
-    QList<QCLDevice> devices = QCLDevice::devices(type);
+    // that has devices that match "type".  The discovery cache from
+    // an earlier run can tell us which platform that is.
+    QList<QCLDevice> devices;
+    if (!d->discoveryCacheFile.isEmpty())
+        devices = qt_cl_load_discovery_cache(d->discoveryCacheFile, type);
+    bool cached = !devices.isEmpty();
+    if (!cached)
+        devices = QCLDevice::devices(type);
     if (!devices.isEmpty()) {
         QVector<cl_device_id> devs;
         foreach (QCLDevice dev, devices)
@@ -175,6 +653,10 @@ bool QCLContext::create(QCLDevice::DeviceTypes type)
     if (!d->isCreated) {
         qWarning() << "QCLContext::create(type:" << int(type) << "):"
                    << errorName(d->lastError);
+    } else {
+        d->initDefaultDevice();
+        if (!cached && !d->discoveryCacheFile.isEmpty())
+            qt_cl_save_discovery_cache(d->discoveryCacheFile, type, devices);
     }
     return d->isCreated;
 }
@@ -213,6 +695,8 @@ bool QCLContext::create(const QList<QCLDevice> &devices)
     d->isCreated = (d->id != 0);
     if (!d->isCreated)
         qWarning() << "QCLContext::create:" << errorName(d->lastError);
+    else
+        d->initDefaultDevice();
     return d->isCreated;
 }
 
@@ -226,7 +710,23 @@ void QCLContext::release()
 {
     Q_D(QCLContext);
     if (d->isCreated) {
-        d->commandQueue = QCLCommandQueue();
+        d->kernelCacheLock.lockForWrite();
+        d->kernelCache.clear();
+        int oldSerial = d->kernelSerial.fetchAndStoreOrdered
+            (qt_cl_next_context_serial());
+        d->kernelCacheLock.unlock();
+        qt_cl_retire_kernel_serial(oldSerial);
+        d->builtinProgramsLock.lock();
+        d->builtinPrograms.clear();
+        d->builtinProgramsLock.unlock();
+        d->releaseQueuePool();
+        d->releaseThreadQueues();
+        d->releaseStaging();
+        d->commandQueueLock.lockForWrite();
+        d->setActiveQueue(QCLCommandQueue());
+        d->profiledQueue = QCLCommandQueue();
+        d->unprofiledQueue = QCLCommandQueue();
+        d->commandQueueLock.unlock();
         d->defaultCommandQueue = QCLCommandQueue();
         clReleaseContext(d->id);
         d->id = 0;
@@ -267,6 +767,7 @@ void QCLContext::setContextId(cl_context id)
     clRetainContext(id);
     d->id = id;
     d->isCreated = true;
+    d->initDefaultDevice();
 }
 
 /*!
@@ -283,10 +784,10 @@ QList<QCLDevice> QCLContext::devices() const
         size_t size = 0;
         if (clGetContextInfo(d->id, CL_CONTEXT_DEVICES, 0, 0, &size)
                 == CL_SUCCESS && size > 0) {
-            QVarLengthArray<cl_device_id> buf(size);
+            QVarLengthArray<cl_device_id> buf(size / sizeof(cl_device_id));
             if (clGetContextInfo(d->id, CL_CONTEXT_DEVICES,
                                  size, buf.data(), 0) == CL_SUCCESS) {
-                for (size_t index = 0; index < size; ++index)
+                for (int index = 0; index < buf.size(); ++index)
                     devs.append(QCLDevice(buf[index]));
             }
         }
@@ -310,7 +811,7 @@ QCLDevice QCLContext::defaultDevice() const
         size_t size = 0;
         if (clGetContextInfo(d->id, CL_CONTEXT_DEVICES, 0, 0, &size)
                 == CL_SUCCESS && size > 0) {
-            QVarLengthArray<cl_device_id> buf(size);
+            QVarLengthArray<cl_device_id> buf(size / sizeof(cl_device_id));
             if (clGetContextInfo(d->id, CL_CONTEXT_DEVICES,
                                  size, buf.data(), 0) == CL_SUCCESS) {
                 return QCLDevice(buf[0]);
@@ -516,36 +1017,134 @@ QString QCLContext::errorName(cl_int code)
 }
 
 /*!
-    Returns the context's active command queue, which will be
-    defaultCommandQueue() if the queue has not yet been set.
+    Returns true if an OpenCL implementation with at least one platform
+    is available on this system; false otherwise.
+
+    When QtOpenCL is built to load the OpenCL library at runtime, this
+    function loads the library on first use.  Applications can call it
+    before create() to decide whether to use OpenCL at all, rather than
+    failing later with CL_PLATFORM_NOT_FOUND_KHR.
+
+    \sa create(), QCLPlatform::platforms()
+*/
+bool QCLContext::isOpenCLAvailable()
+{
+#ifdef QT_OPENCL_DYNAMIC
+    if (!qt_cl_library_loaded())
+        return false;
+#endif
+    return !QCLPlatform::platforms().isEmpty();
+}
+
+/*!
+    Returns the context's active command queue for the calling thread.
+    This is the queue set with setThreadCommandQueue() in the calling
+    thread if there is one; otherwise the queue set with
+    setCommandQueue(), which will be defaultCommandQueue() if the
+    queue has not yet been set.
 
-    \sa setCommandQueue(), defaultCommandQueue()
+    \sa setCommandQueue(), setThreadCommandQueue(), defaultCommandQueue()
 */
 QCLCommandQueue QCLContext::commandQueue()
 {
     Q_D(QCLContext);
-    if (!d->commandQueue.isNull())
-        return d->commandQueue;
-    else
-        return defaultCommandQueue();
+    cl_command_queue queue = d->threadQueue();
+    if (queue) {
+        clRetainCommandQueue(queue);
+        return QCLCommandQueue(this, queue);
+    }
+    {
+        QReadLocker locker(&d->commandQueueLock);
+        if (!d->commandQueue.isNull())
+            return d->commandQueue;
+    }
+    return defaultCommandQueue();
 }
 
 /*!
     Sets the context's active command \a queue.  If \a queue is
     null, then defaultCommandQueue() will be used.
 
+    The queue applies to all threads that use this context, except
+    those that have set their own queue with setThreadCommandQueue().
+    Since other threads may still be enqueuing commands on the queue
+    that is replaced, the context keeps a reference to every queue set
+    with this function until the context is destroyed.
+
     \sa commandQueue(), defaultCommandQueue()
 */
 void QCLContext::setCommandQueue(const QCLCommandQueue &queue)
 {
     Q_D(QCLContext);
-    d->commandQueue = queue;
+    QWriteLocker locker(&d->commandQueueLock);
+    d->setActiveQueue(queue);
+}
+
+/*!
+    Returns the active command queue for the calling thread, as set
+    by setThreadCommandQueue(); or a null queue if the calling thread
+    has not set one.
+
+    \sa setThreadCommandQueue(), commandQueue()
+*/
+QCLCommandQueue QCLContext::threadCommandQueue() const
+{
+    Q_D(const QCLContext);
+    cl_command_queue queue = d->threadQueue();
+    if (!queue)
+        return QCLCommandQueue();
+    clRetainCommandQueue(queue);
+    return QCLCommandQueue(const_cast<QCLContext *>(this), queue);
+}
+
+/*!
+    Sets the active command \a queue for the calling thread only.
+    While it is set, commandQueue() returns \a queue in this thread,
+    and the commands that QCLBuffer, QCLImage2D, QCLImage3D, QCLVector
+    and QCLKernel::run() enqueue from this thread are sent to \a queue.
+    Other threads continue to use their own queue, or the context-wide
+    queue set with setCommandQueue().
+
+    This allows a pool of worker threads to share a single context
+    and enqueue work concurrently on separate queues without any
+    locking around the context.  A typical \a queue is obtained from
+    acquireQueue().
+
+    If \a queue is null, then the calling thread reverts to using
+    the context-wide active command queue.
+
+    The context keeps a reference to every queue set with this function
+    until release() is called, which also clears the per-thread queues
+    of all threads.
+
+    \sa threadCommandQueue(), setCommandQueue()
+*/
+void QCLContext::setThreadCommandQueue(const QCLCommandQueue &queue)
+{
+    Q_D(QCLContext);
+    QThreadStorage<QCLThreadQueueMap> *storage = qt_cl_thread_queues();
+    if (!storage)
+        return;
+    QCLThreadQueueMap &map = storage->localData();
+    if (queue.isNull()) {
+        map.remove(d->serial.loadAcquire());
+        return;
+    }
+    {
+        QMutexLocker locker(&d->threadQueuesLock);
+        if (!d->threadQueues.contains(queue))
+            d->threadQueues.append(queue);
+        qt_cl_insert_thread_queue
+            (&map, d->serial.loadAcquire(), queue.queueId());
+    }
+    d->hasThreadQueues.store(1);
 }
 
 /*!
     Returns the default command queue for defaultDevice().  If the queue
     has not been created, it will be created with the default properties
-    of in-order execution of commands, and profiling disabled.
+    of in-order execution of commands, and profiling disabled unless a
+    QCLProfiler is recording on this context.
 
     Use createCommandQueue() to create a queue that supports
     out-of-order execution or profiling.  For example:
@@ -568,9 +1167,12 @@ QCLCommandQueue QCLContext::defaultCommandQueue()
         QCLDevice dev = defaultDevice();
         if (dev.isNull())
             return QCLCommandQueue();
+        cl_command_queue_properties properties = 0;
+        if (d->profiler.load())
+            properties = CL_QUEUE_PROFILING_ENABLE;
         cl_command_queue queue;
         cl_int error = CL_INVALID_VALUE;
-        queue = clCreateCommandQueue(d->id, dev.deviceId(), 0, &error);
+        queue = clCreateCommandQueue(d->id, dev.deviceId(), properties, &error);
         d->lastError = error;
         if (!queue) {
             qWarning() << "QCLContext::defaultCommandQueue:"
@@ -586,7 +1188,10 @@ QCLCommandQueue QCLContext::defaultCommandQueue()
 cl_command_queue QCLContext::activeQueue()
 {
     Q_D(QCLContext);
-    cl_command_queue queue = d->commandQueue.queueId();
+    cl_command_queue queue = d->threadQueue();
+    if (queue)
+        return queue;
+    queue = d->activeCommandQueue.loadAcquire();
     if (queue)
         return queue;
     queue = d->defaultCommandQueue.queueId();
@@ -604,12 +1209,18 @@ cl_command_queue QCLContext::activeQueue()
     every time it is called.  The queue will be deleted when the last
     reference to the returned object is removed.
 
+    While a QCLProfiler is recording on this context, the queue is
+    created with \c{CL_QUEUE_PROFILING_ENABLE} in addition to
+    \a properties.
+
     \sa defaultCommandQueue(), lastError()
 */
 QCLCommandQueue QCLContext::createCommandQueue
     (cl_command_queue_properties properties, const QCLDevice &device)
 {
     Q_D(QCLContext);
+    if (d->profiler.load())
+        properties |= CL_QUEUE_PROFILING_ENABLE;
     cl_command_queue queue;
     cl_int error = CL_INVALID_VALUE;
     if (device.isNull())
@@ -623,6 +1234,272 @@ QCLCommandQueue QCLContext::createCommandQueue
         return QCLCommandQueue();
 }
 
+/*!
+    \enum QCLContext::QueueSelection
+    This enum defines how acquireQueue() chooses a queue from the
+    queuePool().
+
+    \value RoundRobin Hand out the queues in the pool in turn.
+    \value LeastBusy Hand out the queue with the fewest commands
+    still in flight, breaking ties in round-robin order.
+*/
+
+/*!
+    Creates a pool of \a count command queues for \a device, with the
+    specified \a properties.  If \a device is null, then \a count queues
+    are created for each of the devices() in this context.  Any existing
+    pool is released first.  Returns true if all of the queues could be
+    created; false otherwise, in which case the pool will be empty.
+
+    The queues in the pool are handed out by acquireQueue() and can
+    be passed to QCLKernel::run(), QCLBuffer::readAsync(),
+    QCLBuffer::writeAsync(), and QCLBuffer::copyToAsync() so that
+    independent streams of work, such as transfers and compute,
+    are not serialized on a single in-order queue.
+
+    \sa releaseQueuePool(), queuePool(), acquireQueue()
+*/
+bool QCLContext::createQueuePool
+    (int count, cl_command_queue_properties properties,
+     const QCLDevice &device)
+{
+    Q_D(QCLContext);
+    d->releaseQueuePool();
+    if (count <= 0) {
+        reportError("QCLContext::createQueuePool:", CL_INVALID_VALUE);
+        return false;
+    }
+    QList<QCLDevice> poolDevices;
+    if (device.isNull())
+        poolDevices = devices();
+    else
+        poolDevices.append(device);
+    QVector<QCLQueuePoolEntry> pool;
+    for (int index = 0; index < count; ++index) {
+        // Interleave the devices so that round-robin selection
+        // spreads consecutive work across all of them.
+        for (int dev = 0; dev < poolDevices.size(); ++dev) {
+            QCLQueuePoolEntry entry;
+            entry.queue = createCommandQueue(properties, poolDevices.at(dev));
+            if (entry.queue.isNull())
+                return false;
+            pool.append(entry);
+        }
+    }
+    QMutexLocker locker(&d->queuePoolLock);
+    d->queuePool = pool;
+    d->queuePoolSize.store(pool.size());
+    d->queuePoolNext = 0;
+    return !pool.isEmpty();
+}
+
+/*!
+    Releases the queue pool that was created by createQueuePool().
+    Queues that were handed out by acquireQueue() remain valid
+    until the last reference to them is removed.
+
+    \sa createQueuePool()
+*/
+void QCLContext::releaseQueuePool()
+{
+    Q_D(QCLContext);
+    d->releaseQueuePool();
+}
+
+/*!
+    Returns the list of command queues in the queue pool, or an
+    empty list if createQueuePool() has not been called.
+
+    \sa createQueuePool(), acquireQueue()
+*/
+QList<QCLCommandQueue> QCLContext::queuePool() const
+{
+    Q_D(const QCLContext);
+    QMutexLocker locker(&d->queuePoolLock);
+    QList<QCLCommandQueue> queues;
+    for (int index = 0; index < d->queuePool.size(); ++index)
+        queues.append(d->queuePool.at(index).queue);
+    return queues;
+}
+
+/*!
+    Returns a queue from the queue pool, chosen according to
+    \a selection.  If there is no queue pool, then the active
+    command queue, commandQueue(), is returned.
+
+    LeastBusy selection counts the commands that have been submitted
+    to a pool queue with QCLKernel::run(), QCLBuffer::readAsync(),
+    QCLBuffer::writeAsync(), or QCLBuffer::copyToAsync() and which
+    have not yet finished.  Commands that reach a pool queue by other
+    means, such as after setCommandQueue(), are not counted.
+
+    This function is thread-safe.
+
+    \sa createQueuePool(), QCLCommandQueue::flush()
+*/
+QCLCommandQueue QCLContext::acquireQueue(QueueSelection selection)
+{
+    Q_D(QCLContext);
+    {
+        QMutexLocker locker(&d->queuePoolLock);
+        int size = d->queuePool.size();
+        if (size > 0) {
+            int chosen = d->queuePoolNext % size;
+            if (selection == LeastBusy) {
+                int least = d->queuePool[chosen].prune();
+                for (int offset = 1; offset < size && least > 0; ++offset) {
+                    int index = (d->queuePoolNext + offset) % size;
+                    int busy = d->queuePool[index].prune();
+                    if (busy < least) {
+                        least = busy;
+                        chosen = index;
+                    }
+                }
+            }
+            d->queuePoolNext = chosen + 1;
+            return d->queuePool.at(chosen).queue;
+        }
+    }
+    return commandQueue();
+}
+
+/*!
+    \internal
+
+    Records \a event as in flight on \a queue if the queue belongs
+    to the queue pool.  Used to implement LeastBusy selection.
+*/
+void QCLContext::trackPoolEvent(cl_command_queue queue, cl_event event)
+{
+    Q_D(QCLContext);
+    if (!event || !d->queuePoolSize.load())
+        return;
+    QMutexLocker locker(&d->queuePoolLock);
+    for (int index = 0; index < d->queuePool.size(); ++index) {
+        QCLQueuePoolEntry &entry = d->queuePool[index];
+        if (entry.queue.queueId() == queue) {
+            // Keep the list short for queues that are never polled.
+            if (entry.inFlight.size() >= 64)
+                entry.prune();
+            clRetainEvent(event);
+            entry.inFlight.append(event);
+            break;
+        }
+    }
+}
+
+/*!
+    \internal
+
+    Returns \a event if a QCLProfiler is recording on this context, so
+    that commands that would otherwise be enqueued without an event
+    can be timed; or null if not.  The caller must release the event
+    that is returned in \a event.
+*/
+cl_event *QCLContext::profilingEvent(cl_event *event) const
+{
+    Q_D(const QCLContext);
+    return d->profiler.load() ? event : 0;
+}
+
+/*!
+    \internal
+
+    Passes \a event to the QCLProfiler that is recording on this
+    context, if any, together with the \a after events that the command
+    waited for, and the \a kernel that it ran.  Does nothing if
+    \a event is null, so it can be called whether or not the command
+    was enqueued successfully.
+*/
+void QCLContext::recordCommand
+    (cl_event event, const QCLEventList &after, cl_kernel kernel)
+{
+    Q_D(QCLContext);
+    if (!event || !d->profiler.load())
+        return;
+    QReadLocker locker(&d->profilerLock);
+    QCLProfiler *profiler = d->profiler.load();
+    if (profiler)
+        profiler->record(event, after, kernel);
+}
+
+/*!
+    \internal
+
+    Makes \a profiler the profiler that records the commands of this
+    context.  If the context-wide command queue was created without
+    profiling, it is finished and replaced with an equivalent queue
+    that has CL_QUEUE_PROFILING_ENABLE set, until detachProfiler()
+    is called.
+
+    Returns false if another profiler is already attached.
+*/
+bool QCLContext::attachProfiler(QCLProfiler *profiler)
+{
+    Q_D(QCLContext);
+    if (!d->profiler.testAndSetOrdered(0, profiler))
+        return false;
+    d->commandQueueLock.lockForRead();
+    QCLCommandQueue current = d->commandQueue;
+    d->commandQueueLock.unlock();
+    QCLCommandQueue queue = current;
+    if (queue.isNull())
+        queue = d->defaultCommandQueue;
+    if (queue.isNull() || queue.isProfilingEnabled())
+        return true;
+    cl_device_id device = 0;
+    if (clGetCommandQueueInfo(queue.queueId(), CL_QUEUE_DEVICE,
+                              sizeof(device), &device, 0) != CL_SUCCESS)
+        return true;
+    cl_command_queue_properties properties = 0;
+    if (queue.isOutOfOrder())
+        properties = CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+    QCLCommandQueue profiled =
+        createCommandQueue(properties, QCLDevice(device));
+    if (profiled.isNull())
+        return true;
+    queue.finish();
+
+    // Leave the queue alone if it was changed in the meantime.
+    QWriteLocker locker(&d->commandQueueLock);
+    if (d->commandQueue == current) {
+        d->unprofiledQueue = current;
+        d->profiledQueue = profiled;
+        d->setActiveQueue(profiled);
+    }
+    return true;
+}
+
+/*!
+    \internal
+
+    Detaches \a profiler from this context, restoring the context-wide
+    command queue that attachProfiler() replaced, if any.  The queue is
+    not restored if setCommandQueue() was called while profiling.
+    Recordings that are in progress on other threads finish before
+    this function returns.
+*/
+void QCLContext::detachProfiler(QCLProfiler *profiler)
+{
+    Q_D(QCLContext);
+    {
+        QWriteLocker locker(&d->profilerLock);
+        if (!d->profiler.testAndSetOrdered(profiler, 0))
+            return;
+    }
+    QCLCommandQueue profiled;
+    {
+        QWriteLocker locker(&d->commandQueueLock);
+        profiled = d->profiledQueue;
+        if (!profiled.isNull() && d->commandQueue == profiled)
+            d->setActiveQueue(d->unprofiledQueue);
+        d->profiledQueue = QCLCommandQueue();
+        d->unprofiledQueue = QCLCommandQueue();
+    }
+    if (!profiled.isNull())
+        profiled.finish();
+}
+
 /*!
     Creates an OpenCL memory buffer of \a size bytes in length,
     with the specified \a access mode.
@@ -721,7 +1598,12 @@ QCLBuffer QCLContext::createBufferCopy
     will access the vector.  When the host maps the vector, it will always
     be mapped as ReadWrite.
 
-    \sa createBufferHost()
+    If the context has not been created, this returns a null vector,
+    unless host fallback is enabled or OpenCL is not available at all.
+    In that case the vector's elements are kept in host memory; see
+    QCLVector::isHostOnly().
+
+    \sa createBufferHost(), setHostFallbackEnabled()
 */
 
 /*!
@@ -1142,34 +2024,212 @@ QCLProgram QCLContext::createProgramFromBinaries
         return QCLProgram();
 }
 
-/*!
-    Creates an OpenCL program object from the supplied \a sourceCode
-    and then builds it.  Returns a null QCLProgram if the program
-    could not be built.
+// Program binary cache.  Each entry is stored in a file called
+// "<key>.clbin" in programCacheDirectory(), where <key> is a hash of the
+// source, the build options, and the identity of every device and
+// platform that the program is built for.
+static const quint32 qt_cl_program_cache_magic = 0x51434c50; // "QCLP"
+static const quint32 qt_cl_program_cache_version = 1;
 
-    \sa createProgramFromSourceCode(), buildProgramFromSourceFile()
-*/
-QCLProgram QCLContext::buildProgramFromSourceCode(const QByteArray &sourceCode)
+static QByteArray qt_cl_program_cache_key
+    (const QByteArray &sourceCode, const QString &options,
+     const QList<QCLDevice> &devices)
 {
-    QCLProgram program = createProgramFromSourceCode(sourceCode);
-    if (program.isNull() || program.build())
-        return program;
-    return QCLProgram();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(sourceCode);
+    hash.addData("\0", 1);
+    hash.addData(options.toUtf8());
+    foreach (QCLDevice dev, devices) {
+        QCLPlatform platform = dev.platform();
+        QStringList identity;
+        identity << platform.name() << platform.vendor() << platform.version()
+                 << dev.name() << dev.vendor() << dev.version()
+                 << dev.driverVersion();
+        hash.addData("\0", 1);
+        hash.addData(identity.join(QLatin1String("\n")).toUtf8());
+    }
+    return hash.result().toHex();
 }
 
-/*!
-    Creates an OpenCL program object from the contents of the supplied
-    \a fileName and then builds it.  Returns a null QCLProgram if the
-    program could not be built.
+static QString qt_cl_program_cache_file
+    (const QString &directory, const QByteArray &key)
+{
+    return QDir(directory).filePath
+        (QString::fromLatin1(key) + QLatin1String(".clbin"));
+}
+
+static bool qt_cl_program_cache_load
+    (const QString &directory, const QByteArray &key, int count,
+     QList<QByteArray> *binaries)
+{
+    QFile file(qt_cl_program_cache_file(directory, key));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray storedKey;
+    stream >> magic >> version;
+    if (magic == qt_cl_program_cache_magic &&
+            version == qt_cl_program_cache_version) {
+        stream >> storedKey >> *binaries;
+        if (stream.status() == QDataStream::Ok && storedKey == key &&
+                binaries->size() == count)
+            return true;
+    }
+
+    // The entry is corrupt or was written by an incompatible version.
+    file.remove();
+    return false;
+}
+
+static void qt_cl_program_cache_store
+    (const QString &directory, const QByteArray &key,
+     const QList<QCLDevice> &devices, const QCLProgram &program)
+{
+    // binaries() is in CL_PROGRAM_DEVICES order, which may differ from
+    // the context's device order that we use when reloading the entry.
+    QList<QCLDevice> programDevices = program.devices();
+    QList<QByteArray> programBinaries = program.binaries();
+    if (programDevices.size() != programBinaries.size())
+        return;
+    QList<QByteArray> binaries;
+    foreach (QCLDevice dev, devices) {
+        int index = programDevices.indexOf(dev);
+        if (index < 0 || programBinaries.at(index).isEmpty())
+            return;
+        binaries.append(programBinaries.at(index));
+    }
+
+    if (!QDir().mkpath(directory))
+        return;
+    QSaveFile file(qt_cl_program_cache_file(directory, key));
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << qt_cl_program_cache_magic << qt_cl_program_cache_version
+           << key << binaries;
+    if (stream.status() == QDataStream::Ok)
+        file.commit();
+}
+
+// Creates and builds a program from cached binaries.  Failures are not
+// reported because the caller will quietly fall back to a source build.
+static cl_program qt_cl_program_cache_build
+    (cl_context ctx, const QList<QCLDevice> &devices,
+     const QList<QByteArray> &binaries, const QString &options)
+{
+    QVarLengthArray<cl_device_id> devs;
+    QVarLengthArray<const uchar *> bins;
+    QVarLengthArray<size_t> lens;
+    for (int index = 0; index < devices.size(); ++index) {
+        devs.append(devices.at(index).deviceId());
+        bins.append(reinterpret_cast<const uchar *>
+            (binaries.at(index).constData()));
+        lens.append(binaries.at(index).size());
+    }
+    QVarLengthArray<cl_int> status(devs.size());
+    cl_int error = CL_INVALID_CONTEXT;
+    cl_program prog = clCreateProgramWithBinary
+        (ctx, devs.size(), devs.data(), lens.data(), bins.data(),
+         status.data(), &error);
+    if (!prog)
+        return 0;
+    bool ok = (error == CL_SUCCESS);
+    for (int index = 0; ok && index < status.size(); ++index)
+        ok = (status[index] == CL_SUCCESS);
+    if (ok) {
+        QByteArray opts = options.toLatin1();
+        ok = (clBuildProgram(prog, 0, 0, opts.isEmpty() ? 0 : opts.constData(),
+                             0, 0) == CL_SUCCESS);
+    }
+    if (!ok) {
+        clReleaseProgram(prog);
+        return 0;
+    }
+    return prog;
+}
+
+/*!
+    Creates an OpenCL program object from the supplied \a sourceCode
+    and then builds it with the specified compiler \a options.
+    Returns a null QCLProgram if the program could not be built.
+
+    If programCacheDirectory() is set, the binaries for a previous
+    build of the same \a sourceCode and \a options on the same
+    devices and driver will be loaded from the cache instead of
+    compiling the source again.  Binaries that are rejected by the
+    OpenCL implementation are discarded and the program is rebuilt
+    from source.
+
+    \sa createProgramFromSourceCode(), buildProgramFromSourceFile()
+    \sa setProgramCacheDirectory()
+*/
+QCLProgram QCLContext::buildProgramFromSourceCode
+    (const QByteArray &sourceCode, const QString &options)
+{
+    Q_D(QCLContext);
+    QList<QCLDevice> devs;
+    QByteArray key;
+    if (d->isCreated && !d->programCacheDirectory.isEmpty()) {
+        devs = devices();
+        key = qt_cl_program_cache_key(sourceCode, options, devs);
+        QList<QByteArray> binaries;
+        if (qt_cl_program_cache_load(d->programCacheDirectory, key,
+                                     devs.size(), &binaries)) {
+            cl_program prog = qt_cl_program_cache_build
+                (d->id, devs, binaries, options);
+            if (prog) {
+                d->programCacheHits.ref();
+                d->lastError = CL_SUCCESS;
+                return QCLProgram(this, prog);
+            }
+            QFile::remove(qt_cl_program_cache_file
+                (d->programCacheDirectory, key));
+        }
+        d->programCacheMisses.ref();
+    }
+    QCLProgram program = createProgramFromSourceCode(sourceCode);
+    if (program.isNull() || !program.build(options))
+        return QCLProgram();
+    if (!key.isEmpty()) {
+        qt_cl_program_cache_store
+            (d->programCacheDirectory, key, devs, program);
+    }
+    return program;
+}
+
+/*!
+    Creates an OpenCL program object from the contents of the supplied
+    \a fileName and then builds it with the specified compiler \a options.
+    Returns a null QCLProgram if the program could not be built.
+
+    The program cache is consulted in the same way as for
+    buildProgramFromSourceCode().
 
     \sa createProgramFromSourceFile(), buildProgramFromSourceCode()
 */
-QCLProgram QCLContext::buildProgramFromSourceFile(const QString &fileName)
+QCLProgram QCLContext::buildProgramFromSourceFile
+    (const QString &fileName, const QString &options)
 {
-    QCLProgram program = createProgramFromSourceFile(fileName);
-    if (program.isNull() || program.build())
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        qWarning() << "QCLContext::buildProgramFromSourceFile: Unable to open file" << fileName;
+        return QCLProgram();
+    }
+    qint64 size = file.size();
+    uchar *data;
+    if (size > 0 && size <= 0x7fffffff && (data = file.map(0, size)) != 0) {
+        QByteArray array = QByteArray::fromRawData
+            (reinterpret_cast<char *>(data), int(size));
+        QCLProgram program = buildProgramFromSourceCode(array, options);
+        file.unmap(data);
         return program;
-    return QCLProgram();
+    }
+    QByteArray contents = file.readAll();
+    return buildProgramFromSourceCode(contents, options);
 }
 
 /*!
@@ -1223,6 +2283,605 @@ QCLProgram QCLContext::buildProgramFromBinaries
     return QCLProgram();
 }
 
+#ifndef QT_NO_CONCURRENT
+
+// Defined in qclprogram.cpp.
+extern cl_int qt_cl_build_program_async
+    (QCLContext *context, cl_program program,
+     const QList<QCLDevice> &devices, const QString &options,
+     void (*notify)(cl_program program, bool ok, void *data), void *data);
+
+class QCLProgramBatch
+{
+public:
+    QCLProgramBatch(QCLContext *ctx, int count)
+        : context(ctx), remaining(count) {}
+
+    QCLContext *context;
+    QAtomicInt remaining;
+    QFutureInterface<QCLProgram> iface;
+    QString cacheDirectory;
+    QList<QCLDevice> devices;
+
+    void report(int index, const QCLProgram &program);
+};
+
+void QCLProgramBatch::report(int index, const QCLProgram &program)
+{
+    iface.reportResult(program, index);
+    if (!remaining.deref()) {
+        iface.reportFinished();
+        delete this;
+    }
+}
+
+struct QCLProgramBatchEntry
+{
+    QCLProgramBatch *batch;
+    int index;
+    QByteArray cacheKey;
+};
+
+// Writes a newly built program to the program cache and then reports
+// it.  The build notification arrives on a thread that belongs to the
+// OpenCL implementation, which must not be blocked by file I/O, so the
+// store is handed to the global thread pool instead.
+class QCLProgramCacheStore : public QRunnable
+{
+public:
+    QCLProgramCacheStore(QCLProgramBatchEntry *e, const QCLProgram &prog)
+        : entry(e), program(prog) {}
+    ~QCLProgramCacheStore() { delete entry; }
+
+    void run();
+
+private:
+    QCLProgramBatchEntry *entry;
+    QCLProgram program;
+};
+
+void QCLProgramCacheStore::run()
+{
+    QCLProgramBatch *batch = entry->batch;
+    qt_cl_program_cache_store
+        (batch->cacheDirectory, entry->cacheKey, batch->devices, program);
+    batch->report(entry->index, program);
+}
+
+static void qt_cl_program_batch_notify(cl_program program, bool ok, void *data)
+{
+    QCLProgramBatchEntry *entry = reinterpret_cast<QCLProgramBatchEntry *>(data);
+    QCLProgramBatch *batch = entry->batch;
+    if (ok) {
+        clRetainProgram(program);
+        QCLProgram prog(batch->context, program);
+        if (!entry->cacheKey.isEmpty()) {
+            QThreadPool::globalInstance()->start
+                (new QCLProgramCacheStore(entry, prog));
+            return;
+        }
+        batch->report(entry->index, prog);
+    } else {
+        batch->report(entry->index, QCLProgram());
+    }
+    delete entry;
+}
+
+/*!
+    Creates OpenCL programs for each of the elements in \a sources and
+    starts building them all in parallel with the specified compiler
+    \a options.  Returns immediately with a future that will contain
+    one result for each element of \a sources, in the same order.
+    A result is a null QCLProgram if that source could not be built.
+
+    This is intended for starting the compilation of all of an
+    application's programs early during startup, so that compilation
+    overlaps with the rest of the application's initialization:
+
+    \code
+    QFuture<QCLProgram> programs = context.buildProgramsAsync(sources);
+    ... // initialize the rest of the application
+    QCLProgram blur = programs.resultAt(0);
+    QCLProgram sharpen = programs.resultAt(1);
+    \endcode
+
+    Programs that are present in the programCacheDirectory() are loaded
+    from the cache before this function returns, and newly built programs
+    are added to the cache as they finish.
+
+    \sa QCLProgram::buildAsync(), buildProgramFromSourceCode()
+*/
+QFuture<QCLProgram> QCLContext::buildProgramsAsync
+    (const QList<QByteArray> &sources, const QString &options)
+{
+    Q_D(QCLContext);
+    QCLProgramBatch *batch = new QCLProgramBatch(this, sources.size());
+    batch->iface.reportStarted();
+    QFuture<QCLProgram> future = batch->iface.future();
+    if (sources.isEmpty()) {
+        batch->iface.reportFinished();
+        delete batch;
+        return future;
+    }
+    bool useCache = (d->isCreated && !d->programCacheDirectory.isEmpty());
+    if (useCache) {
+        batch->cacheDirectory = d->programCacheDirectory;
+        batch->devices = devices();
+    }
+
+    // Note: "batch" may be deleted by another thread as soon as the
+    // last program has been handed to qt_cl_build_program_async().
+    for (int index = 0; index < sources.size(); ++index) {
+        QByteArray key;
+        if (useCache) {
+            key = qt_cl_program_cache_key
+                (sources.at(index), options, batch->devices);
+            QList<QByteArray> binaries;
+            if (qt_cl_program_cache_load(d->programCacheDirectory, key,
+                                         batch->devices.size(), &binaries)) {
+                cl_program prog = qt_cl_program_cache_build
+                    (d->id, batch->devices, binaries, options);
+                if (prog) {
+                    d->programCacheHits.ref();
+                    batch->report(index, QCLProgram(this, prog));
+                    continue;
+                }
+                QFile::remove(qt_cl_program_cache_file
+                    (d->programCacheDirectory, key));
+            }
+            d->programCacheMisses.ref();
+        }
+        QCLProgram program = createProgramFromSourceCode(sources.at(index));
+        if (program.isNull()) {
+            batch->report(index, QCLProgram());
+            continue;
+        }
+        QCLProgramBatchEntry *entry = new QCLProgramBatchEntry;
+        entry->batch = batch;
+        entry->index = index;
+        entry->cacheKey = key;
+        qt_cl_build_program_async
+            (this, program.programId(), QList<QCLDevice>(), options,
+             qt_cl_program_batch_notify, entry);
+    }
+    return future;
+}
+
+#endif // QT_NO_CONCURRENT
+
+/*!
+    Returns the directory that is used to cache program binaries
+    between runs of the application; or an empty string if the
+    program cache is disabled.  The default is an empty string.
+
+    \sa setProgramCacheDirectory(), buildProgramFromSourceCode()
+*/
+QString QCLContext::programCacheDirectory() const
+{
+    Q_D(const QCLContext);
+    return d->programCacheDirectory;
+}
+
+/*!
+    Sets the directory that is used to cache program binaries between
+    runs of the application to \a path.  If \a path is empty, then
+    the program cache is disabled.
+
+    Once the cache is enabled, buildProgramFromSourceCode() and
+    buildProgramFromSourceFile() store the binaries for each program
+    that they build in \a path, and load them again on subsequent
+    builds of the same source code.  Entries are keyed on the source,
+    the build options, and the name, vendor, and driver version of
+    the devices and platform, so a driver upgrade automatically
+    causes the program to be recompiled.
+
+    \code
+    context.setProgramCacheDirectory
+        (QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+         QLatin1String("/opencl"));
+    \endcode
+
+    \sa programCacheDirectory(), programCacheHits()
+*/
+void QCLContext::setProgramCacheDirectory(const QString &path)
+{
+    Q_D(QCLContext);
+    d->programCacheDirectory = path;
+}
+
+/*!
+    Returns the file that the result of device discovery is stored in
+    between runs of the application; or an empty string if devices are
+    discovered from scratch by every call to create().  The default is
+    an empty string.
+
+    \sa setDiscoveryCacheFile()
+*/
+QString QCLContext::discoveryCacheFile() const
+{
+    Q_D(const QCLContext);
+    return d->discoveryCacheFile;
+}
+
+/*!
+    Sets the file that the result of device discovery is stored in
+    to \a fileName.  This must be called before create() to have
+    any effect.
+
+    Enumerating the OpenCL platforms and querying the properties of
+    their devices can take a noticeable amount of time during application
+    startup with some drivers.  When a discovery cache file is set,
+    create(QCLDevice::DeviceTypes) records the platform and devices that
+    it chose, together with their properties.  On the next run, it goes
+    straight to the recorded platform and only checks that the name,
+    vendor, and version strings of the platform and devices still match
+    before creating the context.  The device properties are then served
+    from the cache instead of being queried again.
+
+    If the hardware or the driver has changed, or the file was written
+    for a different device type, then the cache is ignored and devices
+    are discovered from scratch and recorded again.  The cache is not
+    used by create(const QList<QCLDevice> &), because the caller has
+    already done the discovery in that case.
+
+    \code
+    QCLContext context;
+    context.setDiscoveryCacheFile
+        (QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+         QLatin1String("/opencl-devices.dat"));
+    context.create(QCLDevice::GPU);
+    \endcode
+
+    \sa discoveryCacheFile(), setWorkSizeTuningFile()
+*/
+void QCLContext::setDiscoveryCacheFile(const QString &fileName)
+{
+    Q_D(QCLContext);
+    d->discoveryCacheFile = fileName;
+}
+
+static const quint32 qt_cl_tuning_magic = 0x51434C54;    // "QCLT"
+static const quint32 qt_cl_tuning_version = 1;
+
+// Rounds each dimension of the global work size up to a power of two,
+// so that nearby global sizes share the same tuning result.
+static QString qt_cl_work_size_class(const QCLWorkSize &size)
+{
+    size_t rounded[3];
+    for (int dim = 0; dim < 3; ++dim) {
+        size_t value = 1;
+        while (value < size.sizes()[dim] && value < (size_t(1) << 31))
+            value *= 2;
+        rounded[dim] = value;
+    }
+    if (size.dimensions() == 1)
+        return QCLWorkSize(rounded[0]).toString();
+    else if (size.dimensions() == 2)
+        return QCLWorkSize(rounded[0], rounded[1]).toString();
+    else
+        return QCLWorkSize(rounded[0], rounded[1], rounded[2]).toString();
+}
+
+static QString qt_cl_tuned_work_size_key
+    (cl_device_id device, const QString &kernelName,
+     const QCLWorkSize &globalWorkSize)
+{
+    QCLDevice dev(device);
+    return dev.platform().name() + QLatin1Char('/') +
+           dev.name() + QLatin1Char('/') + dev.driverVersion() +
+           QLatin1Char('|') + kernelName +
+           QLatin1Char('|') + qt_cl_work_size_class(globalWorkSize);
+}
+
+/*!
+    Returns the file that local work sizes found by
+    QCLKernel::autoTuneLocalWorkSize() are stored in between runs of
+    the application; or an empty string if tuning results are only
+    kept in memory.  The default is an empty string.
+
+    \sa setWorkSizeTuningFile()
+*/
+QString QCLContext::workSizeTuningFile() const
+{
+    Q_D(const QCLContext);
+    return d->workSizeTuningFile;
+}
+
+/*!
+    Sets the file that local work sizes found by
+    QCLKernel::autoTuneLocalWorkSize() are stored in to \a fileName,
+    and loads any results that were stored there by earlier runs.
+
+    Each result is keyed on the device that the kernel was tuned on
+    and its driver version, the kernel name, and the global work size rounded
+    up to a power of two in each dimension.  When a kernel is run
+    without an explicit local work size, QCLKernel::run() uses the
+    stored result for the device of the queue that it runs on and
+    its global work size, if there is one.
+
+    \code
+    context.setWorkSizeTuningFile
+        (QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+         QLatin1String("/opencl-tuning.dat"));
+    \endcode
+
+    \sa workSizeTuningFile(), QCLKernel::autoTuneLocalWorkSize()
+*/
+void QCLContext::setWorkSizeTuningFile(const QString &fileName)
+{
+    Q_D(QCLContext);
+    QWriteLocker locker(&d->tunedWorkSizesLock);
+    d->workSizeTuningFile = fileName;
+    if (fileName.isEmpty())
+        return;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    quint32 magic = 0, version = 0;
+    QHash<QString, QString> sizes;
+    stream >> magic >> version;
+    if (magic != qt_cl_tuning_magic || version != qt_cl_tuning_version)
+        return;
+    stream >> sizes;
+    if (stream.status() != QDataStream::Ok)
+        return;
+    QHash<QString, QString>::ConstIterator it;
+    for (it = sizes.constBegin(); it != sizes.constEnd(); ++it)
+        d->tunedWorkSizes.insert(it.key(), it.value());
+    if (!d->tunedWorkSizes.isEmpty())
+        d->tunedWorkSizeGeneration.ref();
+}
+
+/*!
+    \internal
+
+    Returns a number that changes whenever the table of tuned local
+    work sizes changes, or zero if the table is empty.
+*/
+int QCLContext::tunedWorkSizeGeneration() const
+{
+    Q_D(const QCLContext);
+    return d->tunedWorkSizeGeneration.load();
+}
+
+/*!
+    \internal
+
+    Looks up the tuned local work size for \a kernelName when it is
+    run on \a device with \a globalWorkSize, and returns it in
+    \a localWorkSize.
+*/
+bool QCLContext::tunedLocalWorkSize
+    (const QString &kernelName, cl_device_id device,
+     const QCLWorkSize &globalWorkSize, QCLWorkSize *localWorkSize)
+{
+    Q_D(QCLContext);
+    QString key = qt_cl_tuned_work_size_key(device, kernelName, globalWorkSize);
+    QReadLocker locker(&d->tunedWorkSizesLock);
+    QHash<QString, QString>::ConstIterator it = d->tunedWorkSizes.constFind(key);
+    if (it == d->tunedWorkSizes.constEnd())
+        return false;
+    *localWorkSize = QCLWorkSize::fromString(it.value());
+    return true;
+}
+
+/*!
+    \internal
+
+    Records \a localWorkSize as the best local work size for
+    \a kernelName when it is run on \a device with \a globalWorkSize,
+    and saves the table to workSizeTuningFile().
+*/
+void QCLContext::setTunedLocalWorkSize
+    (const QString &kernelName, cl_device_id device,
+     const QCLWorkSize &globalWorkSize, const QCLWorkSize &localWorkSize)
+{
+    Q_D(QCLContext);
+    QString key = qt_cl_tuned_work_size_key(device, kernelName, globalWorkSize);
+    QWriteLocker locker(&d->tunedWorkSizesLock);
+    d->tunedWorkSizes.insert(key, localWorkSize.toString());
+    d->tunedWorkSizeGeneration.ref();
+    if (d->workSizeTuningFile.isEmpty())
+        return;
+    QSaveFile file(d->workSizeTuningFile);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << qt_cl_tuning_magic << qt_cl_tuning_version << d->tunedWorkSizes;
+    if (stream.status() == QDataStream::Ok)
+        file.commit();
+}
+
+/*!
+    Returns the number of programs that were loaded from the program
+    cache instead of being compiled from source.
+
+    \sa programCacheMisses(), setProgramCacheDirectory()
+*/
+int QCLContext::programCacheHits() const
+{
+    Q_D(const QCLContext);
+    return d->programCacheHits.load();
+}
+
+/*!
+    Returns the number of programs that had to be compiled from source
+    because they were not present in the program cache, or because the
+    cached binaries were rejected by the OpenCL implementation.
+
+    \sa programCacheHits(), setProgramCacheDirectory()
+*/
+int QCLContext::programCacheMisses() const
+{
+    Q_D(const QCLContext);
+    return d->programCacheMisses.load();
+}
+
+/*!
+    Returns true if asynchronous buffer transfers are staged through
+    driver-allocated host memory; false otherwise.  The default is false.
+
+    \sa setStagingEnabled()
+*/
+bool QCLContext::isStagingEnabled() const
+{
+    Q_D(const QCLContext);
+    return d->stagingEnabled.load() != 0;
+}
+
+/*!
+    Enables or disables staging of asynchronous buffer transfers,
+    according to \a enabled.
+
+    Without staging, QCLBuffer::writeAsync() and QCLBuffer::readAsync()
+    pass the caller's host pointer to OpenCL.  That memory is usually
+    pageable, so many implementations make a hidden copy into pinned
+    memory before the transfer.  With staging enabled, transfers of up
+    to stagingSlotSize() bytes go through a small pool of buffers that
+    are created with \c{CL_MEM_ALLOC_HOST_PTR} and mapped once for the
+    lifetime of the pool:
+
+    \list
+    \o writeAsync() copies the data into a staging buffer before it
+       returns, so the caller may reuse its memory immediately.
+    \o readAsync() transfers into a staging buffer and copies the data
+       to the caller's memory when the transfer completes.  The returned
+       event is signalled after that copy.  Staged reads require
+       OpenCL 1.1.
+    \endlist
+
+    Staging buffers are recycled when the events of their transfers
+    complete.  If every staging buffer is busy, or a transfer is too
+    large, the transfer is issued directly without blocking.
+
+    Disabling staging releases the staging buffers.  Buffers that are
+    still in use by outstanding staged transfers are released when
+    those transfers complete.
+
+    \sa isStagingEnabled(), setStagingSlotSize()
+*/
+void QCLContext::setStagingEnabled(bool enabled)
+{
+    Q_D(QCLContext);
+    d->stagingEnabled.store(enabled ? 1 : 0);
+    if (!enabled)
+        d->releaseStaging();
+}
+
+/*!
+    Returns the size of each staging buffer; the default is 1 megabyte.
+    Transfers that are larger than this are not staged.
+
+    \sa setStagingSlotSize(), setStagingEnabled()
+*/
+size_t QCLContext::stagingSlotSize() const
+{
+    Q_D(const QCLContext);
+    QMutexLocker locker(&d->stagingLock);
+    return d->stagingSlotSize;
+}
+
+/*!
+    Sets the \a size of each staging buffer.  Changing the size
+    releases the existing staging buffers in the same way as
+    setStagingEnabled(false).
+
+    \sa stagingSlotSize()
+*/
+void QCLContext::setStagingSlotSize(size_t size)
+{
+    Q_D(QCLContext);
+    QMutexLocker locker(&d->stagingLock);
+    if (d->stagingSlotSize == size)
+        return;
+    delete d->staging;
+    d->staging = 0;
+    d->stagingSlotSize = size;
+}
+
+/*!
+    Returns true if createVector() falls back to host memory while
+    this context has not been created; false otherwise.  The default
+    is false.
+
+    \sa setHostFallbackEnabled(), isOpenCLAvailable()
+*/
+bool QCLContext::isHostFallbackEnabled() const
+{
+    Q_D(const QCLContext);
+    return d->hostFallback;
+}
+
+/*!
+    Enables or disables host fallback for vectors, according to
+    \a enabled.
+
+    When host fallback is enabled and the context has not been created,
+    createVector() returns a vector whose elements are kept in host
+    memory, and QCLAlgorithms operates on it with host threads.  This
+    lets code that is written against QCLVector run on systems where
+    OpenCL cannot be used.  Host fallback is always used if
+    isOpenCLAvailable() returns false.
+
+    \sa isHostFallbackEnabled(), QCLVector::isHostOnly()
+*/
+void QCLContext::setHostFallbackEnabled(bool enabled)
+{
+    Q_D(QCLContext);
+    d->hostFallback = enabled;
+}
+
+/*!
+    \internal
+
+    Stages a write to \a buffer through the staging pool if staging
+    is enabled.  Returns false if the caller should issue the
+    transfer directly.
+*/
+bool QCLContext::stagedWrite
+    (cl_command_queue queue, cl_mem buffer, size_t offset,
+     const void *data, size_t size, const QCLEventList &after,
+     QCLEvent *event)
+{
+    Q_D(QCLContext);
+    if (!d->stagingEnabled.load())
+        return false;
+    QMutexLocker locker(&d->stagingLock);
+    QCLStagingPool *pool = d->stagingPool();
+    cl_event id;
+    if (!pool || !pool->write(queue, buffer, offset, data, size, after, &id))
+        return false;
+    *event = QCLEvent(id);
+    return true;
+}
+
+/*!
+    \internal
+
+    Stages a read from \a buffer through the staging pool if staging
+    is enabled.  Returns false if the caller should issue the
+    transfer directly.
+*/
+bool QCLContext::stagedRead
+    (cl_command_queue queue, cl_mem buffer, size_t offset,
+     void *data, size_t size, const QCLEventList &after,
+     QCLEvent *event)
+{
+    Q_D(QCLContext);
+    if (!d->stagingEnabled.load())
+        return false;
+    QMutexLocker locker(&d->stagingLock);
+    QCLStagingPool *pool = d->stagingPool();
+    cl_event id;
+    if (!pool || !pool->read(queue, buffer, offset, data, size, after, &id))
+        return false;
+    *event = QCLEvent(id);
+    return true;
+}
+
 static QList<QCLImageFormat> qt_cl_supportedImageFormats
     (cl_context ctx, cl_mem_flags flags, cl_mem_object_type image_type)
 {
@@ -1418,6 +3077,111 @@ void QCLContext::setDefaultDevice(const QCLDevice &device)
     d->defaultDevice = device;
 }
 
+/*!
+    \internal
+
+    Used by QCLProgram::cachedKernel() to look up the kernel called
+    \a name in \a program, creating it on first use.
+*/
+QCLKernel QCLContext::cachedKernel
+    (const QCLProgram &program, const char *name, bool perThread)
+{
+    Q_D(QCLContext);
+    QCLKernelCacheKey key;
+    key.program = program.programId();
+    key.serial = 0;
+    key.name = QByteArray::fromRawData(name, qstrlen(name));
+
+    if (perThread) {
+        QThreadStorage<QCLThreadKernelMap> *storage = qt_cl_thread_kernels();
+        if (!storage)
+            return program.createKernel(name);
+        QCLThreadKernelMap &map = storage->localData();
+        key.serial = d->kernelSerial.loadAcquire();
+        QCLThreadKernelMap::ConstIterator it = map.constFind(key);
+        if (it != map.constEnd())
+            return it.value();
+        QCLKernel kernel = program.createKernel(name);
+        if (kernel.isNull())
+            return kernel;
+        kernel.d_func()->args->transient = true;
+        key.name = QByteArray(name);
+        qt_cl_insert_thread_kernel(&map, key, kernel);
+        return kernel;
+    }
+
+    d->kernelCacheLock.lockForRead();
+    QHash<QCLKernelCacheKey, QCLKernel>::ConstIterator it =
+        d->kernelCache.constFind(key);
+    if (it != d->kernelCache.constEnd()) {
+        QCLKernel kernel(it.value());
+        d->kernelCacheLock.unlock();
+        return kernel;
+    }
+    d->kernelCacheLock.unlock();
+
+    // Create the kernel outside the lock.  If another thread races us
+    // to create the same shared kernel, then the first one wins.
+    QCLKernel kernel = program.createKernel(name);
+    if (kernel.isNull())
+        return kernel;
+    key.name = QByteArray(name);
+    QWriteLocker locker(&d->kernelCacheLock);
+    it = d->kernelCache.constFind(key);
+    if (it != d->kernelCache.constEnd())
+        return it.value();
+    d->kernelCache.insert(key, kernel);
+    return kernel;
+}
+
+/*!
+    \internal
+
+    Returns the program for \a source that was built with \a options
+    and registered under \a key, building it on first use.  Used by
+    classes such as QCLAlgorithms that generate their kernels
+    internally, so that each program is only built once per context.
+*/
+QCLProgram QCLContext::builtinProgram
+    (const QByteArray &key, const char *source, const QString &options)
+{
+    Q_D(QCLContext);
+    QMutexLocker locker(&d->builtinProgramsLock);
+    QHash<QByteArray, QCLProgram>::ConstIterator it =
+        d->builtinPrograms.constFind(key);
+    if (it != d->builtinPrograms.constEnd())
+        return it.value();
+    QCLProgram program = buildProgramFromSourceCode(source, options);
+    if (!program.isNull())
+        d->builtinPrograms.insert(key, program);
+    return program;
+}
+
+/*!
+    \internal
+
+    Used by QCLProgram::clearKernelCache().
+*/
+void QCLContext::clearKernelCache(cl_program program)
+{
+    Q_D(QCLContext);
+    QWriteLocker locker(&d->kernelCacheLock);
+    QHash<QCLKernelCacheKey, QCLKernel>::Iterator it = d->kernelCache.begin();
+    while (it != d->kernelCache.end()) {
+        if (it.key().program == program)
+            it = d->kernelCache.erase(it);
+        else
+            ++it;
+    }
+
+    // The per-thread kernels live in the storage of other threads,
+    // so invalidate them all by moving to a new serial.
+    int oldSerial = d->kernelSerial.fetchAndStoreOrdered
+        (qt_cl_next_context_serial());
+    locker.unlock();
+    qt_cl_retire_kernel_serial(oldSerial);
+}
+
 /*!
     \internal
 */
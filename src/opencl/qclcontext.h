@@ -64,6 +64,7 @@ QT_MODULE(CL)
 class QCLContextPrivate;
 class QCLKernel;
 class QCLVectorBase;
+class QCLProfiler;
 
 class Q_CL_EXPORT QCLContext
 {
@@ -88,14 +89,32 @@ public:
 
     static QString errorName(cl_int code);
 
+    static bool isOpenCLAvailable();
+
     QCLCommandQueue commandQueue();
     void setCommandQueue(const QCLCommandQueue &queue);
 
+    QCLCommandQueue threadCommandQueue() const;
+    void setThreadCommandQueue(const QCLCommandQueue &queue);
+
     QCLCommandQueue defaultCommandQueue();
     QCLCommandQueue createCommandQueue
         (cl_command_queue_properties properties,
          const QCLDevice &device = QCLDevice());
 
+    enum QueueSelection
+    {
+        RoundRobin,
+        LeastBusy
+    };
+
+    bool createQueuePool
+        (int count, cl_command_queue_properties properties = 0,
+         const QCLDevice &device = QCLDevice());
+    void releaseQueuePool();
+    QList<QCLCommandQueue> queuePool() const;
+    QCLCommandQueue acquireQueue(QueueSelection selection = RoundRobin);
+
     QCLBuffer createBufferDevice
         (size_t size, QCLMemoryObject::Access access);
     QCLBuffer createBufferHost
@@ -137,13 +156,40 @@ public:
     QCLProgram createProgramFromBinaries
         (const QList<QCLDevice> &devices, const QList<QByteArray> &binaries);
 
-    QCLProgram buildProgramFromSourceCode(const QByteArray &sourceCode);
-    QCLProgram buildProgramFromSourceFile(const QString &fileName);
+    QCLProgram buildProgramFromSourceCode
+        (const QByteArray &sourceCode, const QString &options = QString());
+    QCLProgram buildProgramFromSourceFile
+        (const QString &fileName, const QString &options = QString());
     QCLProgram buildProgramFromBinaryCode(const QByteArray &binary);
     QCLProgram buildProgramFromBinaryFile(const QString &fileName);
     QCLProgram buildProgramFromBinaries
         (const QList<QCLDevice> &devices, const QList<QByteArray> &binaries);
 
+#ifndef QT_NO_CONCURRENT
+    QFuture<QCLProgram> buildProgramsAsync
+        (const QList<QByteArray> &sources, const QString &options = QString());
+#endif
+
+    QString programCacheDirectory() const;
+    void setProgramCacheDirectory(const QString &path);
+
+    int programCacheHits() const;
+    int programCacheMisses() const;
+
+    QString workSizeTuningFile() const;
+    void setWorkSizeTuningFile(const QString &fileName);
+
+    QString discoveryCacheFile() const;
+    void setDiscoveryCacheFile(const QString &fileName);
+
+    bool isStagingEnabled() const;
+    void setStagingEnabled(bool enabled);
+    size_t stagingSlotSize() const;
+    void setStagingSlotSize(size_t size);
+
+    bool isHostFallbackEnabled() const;
+    void setHostFallbackEnabled(bool enabled);
+
     QList<QCLImageFormat> supportedImage2DFormats(cl_mem_flags flags) const;
     QList<QCLImageFormat> supportedImage3DFormats(cl_mem_flags flags) const;
 
@@ -183,8 +229,43 @@ private:
     friend class QCLProgram;
     friend class QCLVectorBase;
     friend class QCLSampler;
+    friend class QCLAlgorithms;
+    friend class QCLVectorExpressionBuilder;
+    friend class QCLCommandList;
+    friend class QCLProfiler;
+    friend class QCLContextGL;
 
     void reportError(const char *name, cl_int error);
+
+    QCLKernel cachedKernel(const QCLProgram &program, const char *name,
+                           bool perThread);
+    void clearKernelCache(cl_program program);
+
+    void trackPoolEvent(cl_command_queue queue, cl_event event);
+
+    cl_event *profilingEvent(cl_event *event) const;
+    void recordCommand(cl_event event, const QCLEventList &after,
+                       cl_kernel kernel = 0);
+    bool attachProfiler(QCLProfiler *profiler);
+    void detachProfiler(QCLProfiler *profiler);
+
+    QCLProgram builtinProgram(const QByteArray &key, const char *source,
+                              const QString &options = QString());
+
+    int tunedWorkSizeGeneration() const;
+    bool tunedLocalWorkSize(const QString &kernelName, cl_device_id device,
+                            const QCLWorkSize &globalWorkSize,
+                            QCLWorkSize *localWorkSize);
+    void setTunedLocalWorkSize(const QString &kernelName, cl_device_id device,
+                               const QCLWorkSize &globalWorkSize,
+                               const QCLWorkSize &localWorkSize);
+
+    bool stagedWrite(cl_command_queue queue, cl_mem buffer, size_t offset,
+                     const void *data, size_t size,
+                     const QCLEventList &after, QCLEvent *event);
+    bool stagedRead(cl_command_queue queue, cl_mem buffer, size_t offset,
+                    void *data, size_t size,
+                    const QCLEventList &after, QCLEvent *event);
 };
 
 template <typename T>
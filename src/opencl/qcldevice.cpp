@@ -41,7 +41,10 @@
 
 #include "qcldevice.h"
 #include "qclext_p.h"
+#include "qclproperties_p.h"
+#include "qclloader_p.h"
 #include <QtCore/qvarlengtharray.h>
+#include <QtCore/qdatastream.h>
 #include <QtCore/qdebug.h>
 
 QT_BEGIN_NAMESPACE
@@ -67,6 +70,13 @@ QT_BEGIN_NAMESPACE
     specific type, optionally constrained by the QCLPlatform
     they belong to.
 
+    The properties of a device are queried once, the first time that
+    any QCLDevice object for the device asks for one of them, and are
+    then shared by all QCLDevice objects for the same device.  Property
+    accessors are therefore cheap enough to call on hot paths.
+    The exception is isAvailable(), which always asks the OpenCL
+    implementation because a device can become unavailable at any time.
+
     The \l{Querying OpenCL Device Capabilities}{clinfo} utility
     program can be used to dump all of the devices that are
     supported by the system's OpenCL implementation.
@@ -165,20 +175,322 @@ static QString qt_cl_paramString(cl_device_id id, cl_device_info name)
     return QString::fromLatin1(buf.data());
 }
 
-static bool qt_cl_isParamString
-    (cl_device_id id, cl_device_info name, const char *str)
-{
-    size_t len = qstrlen(str);
-    size_t size;
-    if (!id || clGetDeviceInfo(id, name, 0, 0, &size) != CL_SUCCESS)
-        return false;
-    if (size <= len)
-        return false;
-    QVarLengthArray<char> buf(size);
-    clGetDeviceInfo(id, name, size, buf.data(), &size);
-    if (qstrncmp(buf.constData(), str, len) != 0)
+// Defined later in this file.
+int qt_cl_version_flags(const QString &version);
+
+// Snapshot of the properties of a device, which cannot change over the
+// lifetime of the device.  Availability is the exception and is always
+// queried directly; see QCLDevice::isAvailable().
+struct QCLDeviceProperties
+{
+    QCLDeviceProperties(cl_device_id id);
+
+    void save(QDataStream &stream) const;
+    void load(QDataStream &stream);
+
+    int deviceType;
+    cl_platform_id platform;
+    uint vendorId;
+    bool hasCompiler;
+    bool hasNativeKernels;
+    bool hasOutOfOrderExecution;
+    bool hasErrorCorrectingMemory;
+    bool hasUnifiedMemory;
+    bool hasImages;
+    bool isLittleEndian;
+    bool isLocalMemorySeparate;
+    int computeUnits;
+    int clockFrequency;
+    int addressBits;
+    QCLWorkSize maximumWorkItemSize;
+    size_t maximumWorkItemsPerGroup;
+    QSize maximumImage2DSize;
+    QCLWorkSize maximumImage3DSize;
+    int maximumSamplers;
+    int maximumReadImages;
+    int maximumWriteImages;
+
+    // Indexed by char, short, int, long, float, double, half.
+    int preferredVectorSizes[7];
+    int nativeVectorSizes[7];
+
+    int floatCapabilities;
+    int doubleCapabilities;
+    int halfFloatCapabilities;
+    quint64 profilingTimerResolution;
+    quint64 maximumAllocationSize;
+    quint64 globalMemorySize;
+    int globalMemoryCacheType;
+    quint64 globalMemoryCacheSize;
+    int globalMemoryCacheLineSize;
+    quint64 localMemorySize;
+    quint64 maximumConstantBufferSize;
+    int maximumConstantArguments;
+    int defaultAlignment;
+    int minimumAlignment;
+    int maximumParameterBytes;
+    QString profile;
+    QString version;
+    QString driverVersion;
+    QString name;
+    QString vendor;
+    QString languageVersion;
+    QByteArray extensionData;
+    QStringList extensions;
+    int versionFlags;
+};
+
+template <typename T>
+static T qt_cl_paramValue(cl_device_id id, cl_device_info name)
+{
+    T value;
+    if (!id || clGetDeviceInfo(id, name, sizeof(value), &value, 0)
+            != CL_SUCCESS)
+        return T(0);
+    else
+        return value;
+}
+
+QCLDeviceProperties::QCLDeviceProperties(cl_device_id id)
+{
+    deviceType = int(qt_cl_paramValue<cl_device_type>(id, CL_DEVICE_TYPE));
+    platform = qt_cl_paramValue<cl_platform_id>(id, CL_DEVICE_PLATFORM);
+    vendorId = qt_cl_paramUInt(id, CL_DEVICE_VENDOR_ID);
+    hasCompiler = qt_cl_paramBool(id, CL_DEVICE_COMPILER_AVAILABLE);
+    hasNativeKernels = (qt_cl_paramValue<cl_device_exec_capabilities>
+        (id, CL_DEVICE_EXECUTION_CAPABILITIES) & CL_EXEC_NATIVE_KERNEL) != 0;
+    hasOutOfOrderExecution = (qt_cl_paramValue<cl_command_queue_properties>
+        (id, CL_DEVICE_QUEUE_PROPERTIES) &
+            CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) != 0;
+    hasErrorCorrectingMemory =
+        qt_cl_paramBool(id, CL_DEVICE_ERROR_CORRECTION_SUPPORT);
+    hasUnifiedMemory = qt_cl_paramBool(id, CL_DEVICE_HOST_UNIFIED_MEMORY);
+    hasImages = qt_cl_paramBool(id, CL_DEVICE_IMAGE_SUPPORT);
+    isLittleEndian = qt_cl_paramBool(id, CL_DEVICE_ENDIAN_LITTLE);
+    isLocalMemorySeparate = qt_cl_paramValue<cl_device_local_mem_type>
+        (id, CL_DEVICE_LOCAL_MEM_TYPE) == CL_LOCAL;
+    computeUnits = qt_cl_paramInt(id, CL_DEVICE_MAX_COMPUTE_UNITS);
+    clockFrequency = qt_cl_paramInt(id, CL_DEVICE_MAX_CLOCK_FREQUENCY);
+    addressBits = qt_cl_paramInt(id, CL_DEVICE_ADDRESS_BITS);
+
+    size_t dims = qt_cl_paramSize(id, CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS);
+    if (dims) {
+        QVarLengthArray<size_t> buf(dims);
+        clGetDeviceInfo(id, CL_DEVICE_MAX_WORK_ITEM_SIZES,
+                        sizeof(size_t) * dims, buf.data(), 0);
+        if (dims == 1)
+            maximumWorkItemSize = QCLWorkSize(buf[0]);
+        else if (dims == 2)
+            maximumWorkItemSize = QCLWorkSize(buf[0], buf[1]);
+        else
+            maximumWorkItemSize = QCLWorkSize(buf[0], buf[1], buf[2]);
+    } else {
+        maximumWorkItemSize = QCLWorkSize(1, 1, 1);
+    }
+    maximumWorkItemsPerGroup = qt_cl_paramSize(id, CL_DEVICE_MAX_WORK_GROUP_SIZE);
+
+    if (hasImages) {
+        maximumImage2DSize = QSize
+            (qt_cl_paramSize(id, CL_DEVICE_IMAGE2D_MAX_WIDTH),
+             qt_cl_paramSize(id, CL_DEVICE_IMAGE2D_MAX_HEIGHT));
+        maximumImage3DSize = QCLWorkSize
+            (qt_cl_paramSize(id, CL_DEVICE_IMAGE3D_MAX_WIDTH),
+             qt_cl_paramSize(id, CL_DEVICE_IMAGE3D_MAX_HEIGHT),
+             qt_cl_paramSize(id, CL_DEVICE_IMAGE3D_MAX_DEPTH));
+        maximumSamplers = qt_cl_paramInt(id, CL_DEVICE_MAX_SAMPLERS);
+        maximumReadImages = qt_cl_paramInt(id, CL_DEVICE_MAX_READ_IMAGE_ARGS);
+        maximumWriteImages = qt_cl_paramInt(id, CL_DEVICE_MAX_WRITE_IMAGE_ARGS);
+    } else {
+        maximumImage3DSize = QCLWorkSize(0, 0, 0);
+        maximumSamplers = 0;
+        maximumReadImages = 0;
+        maximumWriteImages = 0;
+    }
+
+    static const cl_device_info preferred[7] = {
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_CHAR,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_SHORT,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_LONG,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE,
+        CL_DEVICE_PREFERRED_VECTOR_WIDTH_HALF
+    };
+    static const cl_device_info native[7] = {
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_CHAR,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_SHORT,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_INT,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_LONG,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_FLOAT,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_DOUBLE,
+        CL_DEVICE_NATIVE_VECTOR_WIDTH_HALF
+    };
+    for (int index = 0; index < 7; ++index) {
+        preferredVectorSizes[index] = qt_cl_paramInt(id, preferred[index]);
+        nativeVectorSizes[index] = qt_cl_paramInt(id, native[index]);
+    }
+
+    floatCapabilities = int(qt_cl_paramValue<cl_device_fp_config>
+        (id, CL_DEVICE_SINGLE_FP_CONFIG));
+    doubleCapabilities = int(qt_cl_paramValue<cl_device_fp_config>
+        (id, CL_DEVICE_DOUBLE_FP_CONFIG));
+    halfFloatCapabilities = int(qt_cl_paramValue<cl_device_fp_config>
+        (id, CL_DEVICE_HALF_FP_CONFIG));
+
+    // Spec says size_t, even though actual times are cl_ulong.
+    profilingTimerResolution =
+        qt_cl_paramSize(id, CL_DEVICE_PROFILING_TIMER_RESOLUTION);
+    maximumAllocationSize = qt_cl_paramULong(id, CL_DEVICE_MAX_MEM_ALLOC_SIZE);
+    globalMemorySize = qt_cl_paramULong(id, CL_DEVICE_GLOBAL_MEM_SIZE);
+    globalMemoryCacheType = int(qt_cl_paramValue<cl_device_mem_cache_type>
+        (id, CL_DEVICE_GLOBAL_MEM_CACHE_TYPE));
+    globalMemoryCacheSize =
+        qt_cl_paramULong(id, CL_DEVICE_GLOBAL_MEM_CACHE_SIZE);
+    globalMemoryCacheLineSize =
+        qt_cl_paramInt(id, CL_DEVICE_GLOBAL_MEM_CACHELINE_SIZE);
+    localMemorySize = qt_cl_paramULong(id, CL_DEVICE_LOCAL_MEM_SIZE);
+    maximumConstantBufferSize =
+        qt_cl_paramULong(id, CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE);
+    maximumConstantArguments = qt_cl_paramInt(id, CL_DEVICE_MAX_CONSTANT_ARGS);
+
+    // OpenCL setting is in bits, but that is inconsistent with
+    // every other alignment value, so return bytes instead.
+    defaultAlignment = qt_cl_paramInt(id, CL_DEVICE_MEM_BASE_ADDR_ALIGN) / 8;
+    minimumAlignment = qt_cl_paramInt(id, CL_DEVICE_MIN_DATA_TYPE_ALIGN_SIZE);
+    maximumParameterBytes =
+        int(qt_cl_paramSize(id, CL_DEVICE_MAX_PARAMETER_SIZE));
+
+    profile = qt_cl_paramString(id, CL_DEVICE_PROFILE);
+    version = qt_cl_paramString(id, CL_DEVICE_VERSION);
+    driverVersion = qt_cl_paramString(id, CL_DRIVER_VERSION);
+    name = qt_cl_paramString(id, CL_DEVICE_NAME);
+    vendor = qt_cl_paramString(id, CL_DEVICE_VENDOR);
+    versionFlags = qt_cl_version_flags(version);
+
+    // The define was introduced in OpenCL 1.1.  If the device is
+    // only OpenCL 1.0 and doesn't respond to the query, then assume
+    // that the device supports at least the OpenCL 1.0 language.
+    languageVersion = qt_cl_paramString(id, CL_DEVICE_OPENCL_C_VERSION);
+    if (languageVersion.isEmpty() && !(versionFlags & QCLPlatform::Version_1_1))
+        languageVersion = QLatin1String("OpenCL 1.0");
+
+    QString extns = qt_cl_paramString(id, CL_DEVICE_EXTENSIONS).simplified();
+    extensionData = extns.toLatin1();
+    if (!extns.isEmpty())
+        extensions = extns.split(QChar(' '));
+}
+
+void QCLDeviceProperties::save(QDataStream &stream) const
+{
+    stream << qint32(deviceType) << quint32(vendorId)
+           << hasCompiler << hasNativeKernels << hasOutOfOrderExecution
+           << hasErrorCorrectingMemory << hasUnifiedMemory << hasImages
+           << isLittleEndian << isLocalMemorySeparate
+           << qint32(computeUnits) << qint32(clockFrequency)
+           << qint32(addressBits) << maximumWorkItemSize.toString()
+           << quint64(maximumWorkItemsPerGroup) << maximumImage2DSize
+           << maximumImage3DSize.toString() << qint32(maximumSamplers)
+           << qint32(maximumReadImages) << qint32(maximumWriteImages);
+    for (int index = 0; index < 7; ++index) {
+        stream << qint32(preferredVectorSizes[index])
+               << qint32(nativeVectorSizes[index]);
+    }
+    stream << qint32(floatCapabilities) << qint32(doubleCapabilities)
+           << qint32(halfFloatCapabilities) << profilingTimerResolution
+           << maximumAllocationSize << globalMemorySize
+           << qint32(globalMemoryCacheType) << globalMemoryCacheSize
+           << qint32(globalMemoryCacheLineSize) << localMemorySize
+           << maximumConstantBufferSize << qint32(maximumConstantArguments)
+           << qint32(defaultAlignment) << qint32(minimumAlignment)
+           << qint32(maximumParameterBytes) << profile << version
+           << driverVersion << name << vendor << languageVersion
+           << extensionData << extensions << qint32(versionFlags);
+}
+
+void QCLDeviceProperties::load(QDataStream &stream)
+{
+    qint32 ints[12];
+    quint32 vendor32;
+    quint64 groupSize;
+    QString itemSize, image3DSize;
+    stream >> ints[0] >> vendor32
+           >> hasCompiler >> hasNativeKernels >> hasOutOfOrderExecution
+           >> hasErrorCorrectingMemory >> hasUnifiedMemory >> hasImages
+           >> isLittleEndian >> isLocalMemorySeparate
+           >> ints[1] >> ints[2] >> ints[3] >> itemSize >> groupSize
+           >> maximumImage2DSize >> image3DSize
+           >> ints[4] >> ints[5] >> ints[6];
+    deviceType = ints[0];
+    vendorId = vendor32;
+    computeUnits = ints[1];
+    clockFrequency = ints[2];
+    addressBits = ints[3];
+    maximumWorkItemSize = QCLWorkSize::fromString(itemSize);
+    maximumWorkItemsPerGroup = size_t(groupSize);
+    maximumImage3DSize = QCLWorkSize::fromString(image3DSize);
+    maximumSamplers = ints[4];
+    maximumReadImages = ints[5];
+    maximumWriteImages = ints[6];
+    for (int index = 0; index < 7; ++index) {
+        stream >> ints[0] >> ints[1];
+        preferredVectorSizes[index] = ints[0];
+        nativeVectorSizes[index] = ints[1];
+    }
+    stream >> ints[0] >> ints[1] >> ints[2] >> profilingTimerResolution
+           >> maximumAllocationSize >> globalMemorySize
+           >> ints[3] >> globalMemoryCacheSize
+           >> ints[4] >> localMemorySize
+           >> maximumConstantBufferSize >> ints[5]
+           >> ints[6] >> ints[7] >> ints[8] >> profile >> version
+           >> driverVersion >> name >> vendor >> languageVersion
+           >> extensionData >> extensions >> ints[9];
+    floatCapabilities = ints[0];
+    doubleCapabilities = ints[1];
+    halfFloatCapabilities = ints[2];
+    globalMemoryCacheType = ints[3];
+    globalMemoryCacheLineSize = ints[4];
+    maximumConstantArguments = ints[5];
+    defaultAlignment = ints[6];
+    minimumAlignment = ints[7];
+    maximumParameterBytes = ints[8];
+    versionFlags = ints[9];
+}
+
+typedef QCLPropertyRegistry<cl_device_id, QCLDeviceProperties> QCLDeviceRegistry;
+Q_GLOBAL_STATIC(QCLDeviceRegistry, qt_cl_device_registry)
+
+// Used by the device discovery cache in qclcontext.cpp to store the
+// property snapshot for a device and to restore it in a later run.
+QByteArray qt_cl_save_device_properties(cl_device_id id)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_6);
+    qt_cl_device_registry()->find(id)->save(stream);
+    return data;
+}
+
+bool qt_cl_restore_device_properties
+    (cl_device_id id, cl_platform_id platform, const QByteArray &data)
+{
+    QCLDeviceProperties *props = new QCLDeviceProperties(0);
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_4_6);
+    props->load(stream);
+    if (stream.status() != QDataStream::Ok) {
+        delete props;
         return false;
-    return buf[len] == '\0';
+    }
+    props->platform = platform;
+    qt_cl_device_registry()->insert(id, props);
+    return true;
+}
+
+// Returns the property snapshot for a device, creating it the
+// first time that any QCLDevice object asks for it.
+static inline const QCLDeviceProperties *qt_cl_device_properties(cl_device_id id)
+{
+    return qt_cl_device_registry()->find(id);
 }
 
 /*!
@@ -187,12 +499,7 @@ static bool qt_cl_isParamString
 */
 QCLDevice::DeviceTypes QCLDevice::deviceType() const
 {
-    cl_device_type type;
-    if (!m_id || clGetDeviceInfo(m_id, CL_DEVICE_TYPE, sizeof(type), &type, 0)
-            != CL_SUCCESS)
-        return QCLDevice::DeviceTypes(0);
-    else
-        return QCLDevice::DeviceTypes(static_cast<int>(type));
+    return QCLDevice::DeviceTypes(qt_cl_device_properties(m_id)->deviceType);
 }
 
 /*!
@@ -200,12 +507,7 @@ QCLDevice::DeviceTypes QCLDevice::deviceType() const
 */
 QCLPlatform QCLDevice::platform() const
 {
-    cl_platform_id plat;
-    if (!m_id || clGetDeviceInfo(m_id, CL_DEVICE_PLATFORM, sizeof(plat), &plat, 0)
-            != CL_SUCCESS)
-        return QCLPlatform();
-    else
-        return QCLPlatform(plat);
+    return QCLPlatform(qt_cl_device_properties(m_id)->platform);
 }
 
 /*!
@@ -213,7 +515,7 @@ QCLPlatform QCLDevice::platform() const
 */
 uint QCLDevice::vendorId() const
 {
-    return qt_cl_paramUInt(m_id, CL_DEVICE_VENDOR_ID);
+    return qt_cl_device_properties(m_id)->vendorId;
 }
 
 /*!
@@ -230,7 +532,7 @@ bool QCLDevice::isAvailable() const
 */
 bool QCLDevice::hasCompiler() const
 {
-    return qt_cl_paramBool(m_id, CL_DEVICE_COMPILER_AVAILABLE);
+    return qt_cl_device_properties(m_id)->hasCompiler;
 }
 
 /*!
@@ -239,13 +541,7 @@ bool QCLDevice::hasCompiler() const
 */
 bool QCLDevice::hasNativeKernels() const
 {
-    cl_device_exec_capabilities caps;
-    if (!m_id || clGetDeviceInfo(m_id, CL_DEVICE_EXECUTION_CAPABILITIES,
-                        sizeof(caps), &caps, 0)
-            != CL_SUCCESS)
-        return false;
-    else
-        return (caps & CL_EXEC_NATIVE_KERNEL) != 0;
+    return qt_cl_device_properties(m_id)->hasNativeKernels;
 }
 
 /*!
@@ -256,13 +552,7 @@ bool QCLDevice::hasNativeKernels() const
 */
 bool QCLDevice::hasOutOfOrderExecution() const
 {
-    cl_command_queue_properties props;
-    if (!m_id || clGetDeviceInfo(m_id, CL_DEVICE_QUEUE_PROPERTIES,
-                        sizeof(props), &props, 0)
-            != CL_SUCCESS)
-        return false;
-    else
-        return (props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) != 0;
+    return qt_cl_device_properties(m_id)->hasOutOfOrderExecution;
 }
 
 /*!
@@ -295,7 +585,7 @@ bool QCLDevice::hasHalfFloat() const
 */
 bool QCLDevice::hasErrorCorrectingMemory() const
 {
-    return qt_cl_paramBool(m_id, CL_DEVICE_ERROR_CORRECTION_SUPPORT);
+    return qt_cl_device_properties(m_id)->hasErrorCorrectingMemory;
 }
 
 /*!
@@ -308,7 +598,7 @@ bool QCLDevice::hasErrorCorrectingMemory() const
 */
 bool QCLDevice::hasUnifiedMemory() const
 {
-    return qt_cl_paramBool(m_id, CL_DEVICE_HOST_UNIFIED_MEMORY);
+    return qt_cl_device_properties(m_id)->hasUnifiedMemory;
 }
 
 /*!
@@ -316,7 +606,7 @@ bool QCLDevice::hasUnifiedMemory() const
 */
 int QCLDevice::computeUnits() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_MAX_COMPUTE_UNITS);
+    return qt_cl_device_properties(m_id)->computeUnits;
 }
 
 /*!
@@ -324,7 +614,7 @@ int QCLDevice::computeUnits() const
 */
 int QCLDevice::clockFrequency() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_MAX_CLOCK_FREQUENCY);
+    return qt_cl_device_properties(m_id)->clockFrequency;
 }
 
 /*!
@@ -333,7 +623,7 @@ int QCLDevice::clockFrequency() const
 */
 int QCLDevice::addressBits() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_ADDRESS_BITS);
+    return qt_cl_device_properties(m_id)->addressBits;
 }
 
 /*!
@@ -342,7 +632,7 @@ int QCLDevice::addressBits() const
 */
 QSysInfo::Endian QCLDevice::byteOrder() const
 {
-    if (qt_cl_paramBool(m_id, CL_DEVICE_ENDIAN_LITTLE))
+    if (qt_cl_device_properties(m_id)->isLittleEndian)
         return QSysInfo::LittleEndian;
     else
         return QSysInfo::BigEndian;
@@ -355,19 +645,7 @@ QSysInfo::Endian QCLDevice::byteOrder() const
 */
 QCLWorkSize QCLDevice::maximumWorkItemSize() const
 {
-    size_t dims = 0;
-    if (!m_id || clGetDeviceInfo(m_id, CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS,
-                        sizeof(dims), &dims, 0) != CL_SUCCESS || !dims)
-        return QCLWorkSize(1, 1, 1);
-    QVarLengthArray<size_t> buf(dims);
-    clGetDeviceInfo(m_id, CL_DEVICE_MAX_WORK_ITEM_SIZES,
-                    sizeof(size_t) * dims, buf.data(), 0);
-    if (dims == 1)
-        return QCLWorkSize(buf[0]);
-    else if (dims == 2)
-        return QCLWorkSize(buf[0], buf[1]);
-    else
-        return QCLWorkSize(buf[0], buf[1], buf[2]);
+    return qt_cl_device_properties(m_id)->maximumWorkItemSize;
 }
 
 /*!
@@ -378,7 +656,7 @@ QCLWorkSize QCLDevice::maximumWorkItemSize() const
 */
 size_t QCLDevice::maximumWorkItemsPerGroup() const
 {
-    return qt_cl_paramSize(m_id, CL_DEVICE_MAX_WORK_GROUP_SIZE);
+    return qt_cl_device_properties(m_id)->maximumWorkItemsPerGroup;
 }
 
 /*!
@@ -386,7 +664,7 @@ size_t QCLDevice::maximumWorkItemsPerGroup() const
 */
 bool QCLDevice::hasImage2D() const
 {
-    return qt_cl_paramBool(m_id, CL_DEVICE_IMAGE_SUPPORT);
+    return qt_cl_device_properties(m_id)->hasImages;
 }
 
 /*!
@@ -394,11 +672,8 @@ bool QCLDevice::hasImage2D() const
 */
 bool QCLDevice::hasImage3D() const
 {
-    if (!qt_cl_paramBool(m_id, CL_DEVICE_IMAGE_SUPPORT))
-        return false;
-    return qt_cl_paramSize(m_id, CL_DEVICE_IMAGE3D_MAX_WIDTH) != 0 ||
-           qt_cl_paramSize(m_id, CL_DEVICE_IMAGE3D_MAX_HEIGHT) != 0 ||
-           qt_cl_paramSize(m_id, CL_DEVICE_IMAGE3D_MAX_DEPTH) != 0;
+    const QCLWorkSize &size = qt_cl_device_properties(m_id)->maximumImage3DSize;
+    return size.width() != 0 || size.height() != 0 || size.depth() != 0;
 }
 
 /*!
@@ -418,10 +693,7 @@ bool QCLDevice::hasWritableImage3D() const
 */
 QSize QCLDevice::maximumImage2DSize() const
 {
-    if (!qt_cl_paramBool(m_id, CL_DEVICE_IMAGE_SUPPORT))
-        return QSize();
-    return QSize(qt_cl_paramSize(m_id, CL_DEVICE_IMAGE2D_MAX_WIDTH),
-                 qt_cl_paramSize(m_id, CL_DEVICE_IMAGE2D_MAX_HEIGHT));
+    return qt_cl_device_properties(m_id)->maximumImage2DSize;
 }
 
 /*!
@@ -432,11 +704,7 @@ QSize QCLDevice::maximumImage2DSize() const
 */
 QCLWorkSize QCLDevice::maximumImage3DSize() const
 {
-    if (!qt_cl_paramBool(m_id, CL_DEVICE_IMAGE_SUPPORT))
-        return QCLWorkSize(0, 0, 0);
-    return QCLWorkSize(qt_cl_paramSize(m_id, CL_DEVICE_IMAGE3D_MAX_WIDTH),
-                       qt_cl_paramSize(m_id, CL_DEVICE_IMAGE3D_MAX_HEIGHT),
-                       qt_cl_paramSize(m_id, CL_DEVICE_IMAGE3D_MAX_DEPTH));
+    return qt_cl_device_properties(m_id)->maximumImage3DSize;
 }
 
 /*!
@@ -445,9 +713,7 @@ QCLWorkSize QCLDevice::maximumImage3DSize() const
 */
 int QCLDevice::maximumSamplers() const
 {
-    if (!qt_cl_paramBool(m_id, CL_DEVICE_IMAGE_SUPPORT))
-        return 0;
-    return qt_cl_paramInt(m_id, CL_DEVICE_MAX_SAMPLERS);
+    return qt_cl_device_properties(m_id)->maximumSamplers;
 }
 
 /*!
@@ -458,9 +724,7 @@ int QCLDevice::maximumSamplers() const
 */
 int QCLDevice::maximumReadImages() const
 {
-    if (!qt_cl_paramBool(m_id, CL_DEVICE_IMAGE_SUPPORT))
-        return 0;
-    return qt_cl_paramInt(m_id, CL_DEVICE_MAX_READ_IMAGE_ARGS);
+    return qt_cl_device_properties(m_id)->maximumReadImages;
 }
 
 /*!
@@ -471,9 +735,7 @@ int QCLDevice::maximumReadImages() const
 */
 int QCLDevice::maximumWriteImages() const
 {
-    if (!qt_cl_paramBool(m_id, CL_DEVICE_IMAGE_SUPPORT))
-        return 0;
-    return qt_cl_paramInt(m_id, CL_DEVICE_MAX_WRITE_IMAGE_ARGS);
+    return qt_cl_device_properties(m_id)->maximumWriteImages;
 }
 
 /*!
@@ -484,7 +746,7 @@ int QCLDevice::maximumWriteImages() const
 */
 int QCLDevice::preferredCharVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_PREFERRED_VECTOR_WIDTH_CHAR);
+    return qt_cl_device_properties(m_id)->preferredVectorSizes[0];
 }
 
 /*!
@@ -495,7 +757,7 @@ int QCLDevice::preferredCharVectorSize() const
 */
 int QCLDevice::preferredShortVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_PREFERRED_VECTOR_WIDTH_SHORT);
+    return qt_cl_device_properties(m_id)->preferredVectorSizes[1];
 }
 
 /*!
@@ -506,7 +768,7 @@ int QCLDevice::preferredShortVectorSize() const
 */
 int QCLDevice::preferredIntVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT);
+    return qt_cl_device_properties(m_id)->preferredVectorSizes[2];
 }
 
 /*!
@@ -517,7 +779,7 @@ int QCLDevice::preferredIntVectorSize() const
 */
 int QCLDevice::preferredLongVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_PREFERRED_VECTOR_WIDTH_LONG);
+    return qt_cl_device_properties(m_id)->preferredVectorSizes[3];
 }
 
 /*!
@@ -528,7 +790,7 @@ int QCLDevice::preferredLongVectorSize() const
 */
 int QCLDevice::preferredFloatVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT);
+    return qt_cl_device_properties(m_id)->preferredVectorSizes[4];
 }
 
 /*!
@@ -543,7 +805,7 @@ int QCLDevice::preferredFloatVectorSize() const
 */
 int QCLDevice::preferredDoubleVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE);
+    return qt_cl_device_properties(m_id)->preferredVectorSizes[5];
 }
 
 /*!
@@ -559,7 +821,7 @@ int QCLDevice::preferredDoubleVectorSize() const
 */
 int QCLDevice::preferredHalfFloatVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_PREFERRED_VECTOR_WIDTH_HALF);
+    return qt_cl_device_properties(m_id)->preferredVectorSizes[6];
 }
 
 /*!
@@ -570,7 +832,7 @@ int QCLDevice::preferredHalfFloatVectorSize() const
 */
 int QCLDevice::nativeCharVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_NATIVE_VECTOR_WIDTH_CHAR);
+    return qt_cl_device_properties(m_id)->nativeVectorSizes[0];
 }
 
 /*!
@@ -581,7 +843,7 @@ int QCLDevice::nativeCharVectorSize() const
 */
 int QCLDevice::nativeShortVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_NATIVE_VECTOR_WIDTH_SHORT);
+    return qt_cl_device_properties(m_id)->nativeVectorSizes[1];
 }
 
 /*!
@@ -592,7 +854,7 @@ int QCLDevice::nativeShortVectorSize() const
 */
 int QCLDevice::nativeIntVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_NATIVE_VECTOR_WIDTH_INT);
+    return qt_cl_device_properties(m_id)->nativeVectorSizes[2];
 }
 
 /*!
@@ -603,7 +865,7 @@ int QCLDevice::nativeIntVectorSize() const
 */
 int QCLDevice::nativeLongVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_NATIVE_VECTOR_WIDTH_LONG);
+    return qt_cl_device_properties(m_id)->nativeVectorSizes[3];
 }
 
 /*!
@@ -614,7 +876,7 @@ int QCLDevice::nativeLongVectorSize() const
 */
 int QCLDevice::nativeFloatVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_NATIVE_VECTOR_WIDTH_FLOAT);
+    return qt_cl_device_properties(m_id)->nativeVectorSizes[4];
 }
 
 /*!
@@ -628,7 +890,7 @@ int QCLDevice::nativeFloatVectorSize() const
 */
 int QCLDevice::nativeDoubleVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_NATIVE_VECTOR_WIDTH_DOUBLE);
+    return qt_cl_device_properties(m_id)->nativeVectorSizes[5];
 }
 
 /*!
@@ -642,7 +904,7 @@ int QCLDevice::nativeDoubleVectorSize() const
 */
 int QCLDevice::nativeHalfFloatVectorSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_NATIVE_VECTOR_WIDTH_HALF);
+    return qt_cl_device_properties(m_id)->nativeVectorSizes[6];
 }
 
 /*!
@@ -667,13 +929,7 @@ int QCLDevice::nativeHalfFloatVectorSize() const
 */
 QCLDevice::FloatCapabilities QCLDevice::floatCapabilities() const
 {
-    cl_device_fp_config config;
-    if (!m_id || clGetDeviceInfo(m_id, CL_DEVICE_SINGLE_FP_CONFIG,
-                        sizeof(config), &config, 0)
-            != CL_SUCCESS)
-        return NotSupported;
-    else
-        return QCLDevice::FloatCapabilities(static_cast<int>(config));
+    return QCLDevice::FloatCapabilities(qt_cl_device_properties(m_id)->floatCapabilities);
 }
 
 /*!
@@ -687,13 +943,7 @@ QCLDevice::FloatCapabilities QCLDevice::floatCapabilities() const
 */
 QCLDevice::FloatCapabilities QCLDevice::doubleCapabilities() const
 {
-    cl_device_fp_config config;
-    if (!m_id || clGetDeviceInfo(m_id, CL_DEVICE_DOUBLE_FP_CONFIG,
-                        sizeof(config), &config, 0)
-            != CL_SUCCESS)
-        return NotSupported;
-    else
-        return QCLDevice::FloatCapabilities(static_cast<int>(config));
+    return QCLDevice::FloatCapabilities(qt_cl_device_properties(m_id)->doubleCapabilities);
 }
 
 /*!
@@ -707,13 +957,7 @@ QCLDevice::FloatCapabilities QCLDevice::doubleCapabilities() const
 */
 QCLDevice::FloatCapabilities QCLDevice::halfFloatCapabilities() const
 {
-    cl_device_fp_config config;
-    if (!m_id || clGetDeviceInfo(m_id, CL_DEVICE_HALF_FP_CONFIG,
-                        sizeof(config), &config, 0)
-            != CL_SUCCESS)
-        return NotSupported;
-    else
-        return QCLDevice::FloatCapabilities(static_cast<int>(config));
+    return QCLDevice::FloatCapabilities(qt_cl_device_properties(m_id)->halfFloatCapabilities);
 }
 
 /*!
@@ -724,8 +968,7 @@ QCLDevice::FloatCapabilities QCLDevice::halfFloatCapabilities() const
 */
 quint64 QCLDevice::profilingTimerResolution() const
 {
-    // Spec says size_t, even though actual times are cl_ulong.
-    return qt_cl_paramSize(m_id, CL_DEVICE_PROFILING_TIMER_RESOLUTION);
+    return qt_cl_device_properties(m_id)->profilingTimerResolution;
 }
 
 /*!
@@ -735,7 +978,7 @@ quint64 QCLDevice::profilingTimerResolution() const
 */
 quint64 QCLDevice::maximumAllocationSize() const
 {
-    return qt_cl_paramULong(m_id, CL_DEVICE_MAX_MEM_ALLOC_SIZE);
+    return qt_cl_device_properties(m_id)->maximumAllocationSize;
 }
 
 /*!
@@ -745,7 +988,7 @@ quint64 QCLDevice::maximumAllocationSize() const
 */
 quint64 QCLDevice::globalMemorySize() const
 {
-    return qt_cl_paramULong(m_id, CL_DEVICE_GLOBAL_MEM_SIZE);
+    return qt_cl_device_properties(m_id)->globalMemorySize;
 }
 
 /*!
@@ -764,13 +1007,7 @@ quint64 QCLDevice::globalMemorySize() const
 */
 QCLDevice::CacheType QCLDevice::globalMemoryCacheType() const
 {
-    cl_device_mem_cache_type type;
-    if (!m_id || clGetDeviceInfo(m_id, CL_DEVICE_GLOBAL_MEM_CACHE_TYPE,
-                        sizeof(type), &type, 0)
-            != CL_SUCCESS)
-        return NoCache;
-    else
-        return QCLDevice::CacheType(type);
+    return QCLDevice::CacheType(qt_cl_device_properties(m_id)->globalMemoryCacheType);
 }
 
 /*!
@@ -780,7 +1017,7 @@ QCLDevice::CacheType QCLDevice::globalMemoryCacheType() const
 */
 quint64 QCLDevice::globalMemoryCacheSize() const
 {
-    return qt_cl_paramULong(m_id, CL_DEVICE_GLOBAL_MEM_CACHE_SIZE);
+    return qt_cl_device_properties(m_id)->globalMemoryCacheSize;
 }
 
 /*!
@@ -790,7 +1027,7 @@ quint64 QCLDevice::globalMemoryCacheSize() const
 */
 int QCLDevice::globalMemoryCacheLineSize() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_GLOBAL_MEM_CACHELINE_SIZE);
+    return qt_cl_device_properties(m_id)->globalMemoryCacheLineSize;
 }
 
 /*!
@@ -800,7 +1037,7 @@ int QCLDevice::globalMemoryCacheLineSize() const
 */
 quint64 QCLDevice::localMemorySize() const
 {
-    return qt_cl_paramULong(m_id, CL_DEVICE_LOCAL_MEM_SIZE);
+    return qt_cl_device_properties(m_id)->localMemorySize;
 }
 
 /*!
@@ -812,13 +1049,7 @@ quint64 QCLDevice::localMemorySize() const
 */
 bool QCLDevice::isLocalMemorySeparate() const
 {
-    cl_device_local_mem_type type;
-    if (!m_id || clGetDeviceInfo(m_id, CL_DEVICE_LOCAL_MEM_TYPE,
-                        sizeof(type), &type, 0)
-            != CL_SUCCESS)
-        return false;
-    else
-        return type == CL_LOCAL;
+    return qt_cl_device_properties(m_id)->isLocalMemorySeparate;
 }
 
 /*!
@@ -828,7 +1059,7 @@ bool QCLDevice::isLocalMemorySeparate() const
 */
 quint64 QCLDevice::maximumConstantBufferSize() const
 {
-    return qt_cl_paramULong(m_id, CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE);
+    return qt_cl_device_properties(m_id)->maximumConstantBufferSize;
 }
 
 /*!
@@ -839,7 +1070,7 @@ quint64 QCLDevice::maximumConstantBufferSize() const
 */
 int QCLDevice::maximumConstantArguments() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_MAX_CONSTANT_ARGS);
+    return qt_cl_device_properties(m_id)->maximumConstantArguments;
 }
 
 /*!
@@ -849,9 +1080,7 @@ int QCLDevice::maximumConstantArguments() const
 */
 int QCLDevice::defaultAlignment() const
 {
-    // OpenCL setting is in bits, but that is inconsistent with
-    // every other alignment value, so return bytes instead.
-    return qt_cl_paramInt(m_id, CL_DEVICE_MEM_BASE_ADDR_ALIGN) / 8;
+    return qt_cl_device_properties(m_id)->defaultAlignment;
 }
 
 /*!
@@ -861,7 +1090,7 @@ int QCLDevice::defaultAlignment() const
 */
 int QCLDevice::minimumAlignment() const
 {
-    return qt_cl_paramInt(m_id, CL_DEVICE_MIN_DATA_TYPE_ALIGN_SIZE);
+    return qt_cl_device_properties(m_id)->minimumAlignment;
 }
 
 /*!
@@ -870,7 +1099,7 @@ int QCLDevice::minimumAlignment() const
 */
 int QCLDevice::maximumParameterBytes() const
 {
-    return int(qt_cl_paramSize(m_id, CL_DEVICE_MAX_PARAMETER_SIZE));
+    return qt_cl_device_properties(m_id)->maximumParameterBytes;
 }
 
 /*!
@@ -880,7 +1109,7 @@ int QCLDevice::maximumParameterBytes() const
 */
 bool QCLDevice::isFullProfile() const
 {
-    return qt_cl_isParamString(m_id, CL_DEVICE_PROFILE, "FULL_PROFILE");
+    return qt_cl_device_properties(m_id)->profile == QLatin1String("FULL_PROFILE");
 }
 
 /*!
@@ -890,7 +1119,7 @@ bool QCLDevice::isFullProfile() const
 */
 bool QCLDevice::isEmbeddedProfile() const
 {
-    return qt_cl_isParamString(m_id, CL_DEVICE_PROFILE, "EMBEDDED_PROFILE");
+    return qt_cl_device_properties(m_id)->profile == QLatin1String("EMBEDDED_PROFILE");
 }
 
 /*!
@@ -901,7 +1130,7 @@ bool QCLDevice::isEmbeddedProfile() const
 */
 QString QCLDevice::profile() const
 {
-    return qt_cl_paramString(m_id, CL_DEVICE_PROFILE);
+    return qt_cl_device_properties(m_id)->profile;
 }
 
 /*!
@@ -915,7 +1144,7 @@ QString QCLDevice::profile() const
 */
 QString QCLDevice::version() const
 {
-    return qt_cl_paramString(m_id, CL_DEVICE_VERSION);
+    return qt_cl_device_properties(m_id)->version;
 }
 
 /*!
@@ -925,7 +1154,7 @@ QString QCLDevice::version() const
 */
 QString QCLDevice::driverVersion() const
 {
-    return qt_cl_paramString(m_id, CL_DRIVER_VERSION);
+    return qt_cl_device_properties(m_id)->driverVersion;
 }
 
 /*!
@@ -933,7 +1162,7 @@ QString QCLDevice::driverVersion() const
 */
 QString QCLDevice::name() const
 {
-    return qt_cl_paramString(m_id, CL_DEVICE_NAME);
+    return qt_cl_device_properties(m_id)->name;
 }
 
 /*!
@@ -941,7 +1170,7 @@ QString QCLDevice::name() const
 */
 QString QCLDevice::vendor() const
 {
-    return qt_cl_paramString(m_id, CL_DEVICE_VENDOR);
+    return qt_cl_device_properties(m_id)->vendor;
 }
 
 /*!
@@ -951,13 +1180,7 @@ QString QCLDevice::vendor() const
 */
 QStringList QCLDevice::extensions() const
 {
-    if (!m_id)
-        return QStringList();
-    QString extns = qt_cl_paramString(m_id, CL_DEVICE_EXTENSIONS).simplified();
-    if (!extns.isEmpty())
-        return extns.split(QChar(' '));
-    else
-        return QStringList();
+    return qt_cl_device_properties(m_id)->extensions;
 }
 
 /*!
@@ -966,15 +1189,7 @@ QStringList QCLDevice::extensions() const
 */
 QString QCLDevice::languageVersion() const
 {
-    QString vers = qt_cl_paramString(m_id, CL_DEVICE_OPENCL_C_VERSION);
-
-    // The define was introduced in OpenCL 1.1.  If the device is
-    // only OpenCL 1.0 and doesn't respond to the query, then assume
-    // that the device supports at least the OpenCL 1.0 language.
-    if (vers.isEmpty() && !(versionFlags() & QCLPlatform::Version_1_1))
-        vers = QLatin1String("OpenCL 1.0");
-
-    return vers;
+    return qt_cl_device_properties(m_id)->languageVersion;
 }
 
 bool qt_cl_has_extension(const char *list, size_t listLen, const char *name)
@@ -1014,12 +1229,8 @@ bool qt_cl_has_extension(const char *list, size_t listLen, const char *name)
 */
 bool QCLDevice::hasExtension(const char *name) const
 {
-    size_t size;
-    if (!m_id || clGetDeviceInfo(m_id, CL_DEVICE_EXTENSIONS, 0, 0, &size) != CL_SUCCESS)
-        return false;
-    QVarLengthArray<char> buf(size);
-    clGetDeviceInfo(m_id, CL_DEVICE_EXTENSIONS, size, buf.data(), &size);
-    return qt_cl_has_extension(buf.constData(), size, name);
+    const QByteArray &extns = qt_cl_device_properties(m_id)->extensionData;
+    return qt_cl_has_extension(extns.constData(), extns.size(), name);
 }
 
 int qt_cl_version_flags(const QString &version)
@@ -1051,6 +1262,8 @@ int qt_cl_version_flags(const QString &version)
         flags |= QCLPlatform::Version_1_0;
     if ((major == 1 && minor >= 1) || major >= 2)
         flags |= QCLPlatform::Version_1_1;
+    if ((major == 1 && minor >= 2) || major >= 2)
+        flags |= QCLPlatform::Version_1_2;
     return flags;
 }
 
@@ -1061,11 +1274,7 @@ int qt_cl_version_flags(const QString &version)
 */
 QCLPlatform::VersionFlags QCLDevice::versionFlags() const
 {
-    if (!m_flags) {
-        m_flags = qt_cl_version_flags
-            (qt_cl_paramString(m_id, CL_DEVICE_VERSION));
-    }
-    return QCLPlatform::VersionFlags(m_flags);
+    return QCLPlatform::VersionFlags(qt_cl_device_properties(m_id)->versionFlags);
 }
 
 /*!
@@ -43,8 +43,11 @@
 #include "qclcommandqueue.h"
 #include "qclcontext.h"
 #include "qclext_p.h"
+#include "qclloader_p.h"
 #include <QtCore/qdebug.h>
 #include <QtConcurrent>
+#include <QtCore/qfutureinterface.h>
+#include <QtCore/qatomic.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -348,23 +351,116 @@ quint64 QCLEvent::finishTime() const
     \sa operator==()
 */
 
-static void qt_cl_future_wait(cl_event event)
+#if !defined(QT_NO_CONCURRENT)
+
+#ifdef QT_OPENCL_1_1
+
+// Shared state for a future that is completed from OpenCL event
+// callbacks rather than by a thread that blocks in clWaitForEvents().
+class QCLEventFutureState
+{
+public:
+    QCLEventFutureState(int count) : remaining(count)
+    {
+        futureInterface.reportStarted();
+    }
+
+    void deref()
+    {
+        if (!remaining.deref()) {
+            futureInterface.reportFinished();
+            delete this;
+        }
+    }
+
+    QFutureInterface<void> futureInterface;
+    QAtomicInt remaining;
+};
+
+extern "C" {
+
+static void CL_CALLBACK qt_cl_future_notify
+    (cl_event event, cl_int status, void *user_data)
 {
-    clWaitForEvents(1, &event);
+    QCLEventFutureState *state =
+        reinterpret_cast<QCLEventFutureState *>(user_data);
+    if (status < 0)
+        state->futureInterface.reportCanceled();
     clReleaseEvent(event);
+    state->deref();
 }
 
-#if !defined(QT_NO_CONCURRENT)
+}
+
+#else
+
+static void qt_cl_future_wait(QVector<cl_event> events)
+{
+    clWaitForEvents(events.size(), events.constData());
+    for (int index = 0; index < events.size(); ++index)
+        clReleaseEvent(events[index]);
+}
+
+#endif
+
+// Returns a future that finishes when all of the \a count events
+// in \a events have finished.  With OpenCL 1.1 the future is completed
+// from clSetEventCallback() and no host thread is used while waiting.
+QFuture<void> qt_cl_event_future(const cl_event *events, int count)
+{
+    if (count <= 0)
+        return QFuture<void>();
+#ifdef QT_OPENCL_1_1
+    // The extra reference stops the state from being deleted before
+    // all callbacks are registered, if the events finish quickly.
+    QCLEventFutureState *state = new QCLEventFutureState(count + 1);
+    QFuture<void> future = state->futureInterface.future();
+    for (int index = 0; index < count; ++index) {
+        cl_event event = events[index];
+        clRetainEvent(event);
+
+        // Callbacks only fire once the command has been submitted,
+        // so make sure that the event's queue has been flushed.
+        cl_command_queue queue = 0;
+        if (clGetEventInfo(event, CL_EVENT_COMMAND_QUEUE,
+                           sizeof(queue), &queue, 0) == CL_SUCCESS && queue)
+            clFlush(queue);
+
+        cl_int error = clSetEventCallback
+            (event, CL_COMPLETE, qt_cl_future_notify, state);
+        if (error != CL_SUCCESS) {
+            qWarning() << "QCLEvent::toFuture:"
+                       << QCLContext::errorName(error);
+            state->futureInterface.reportCanceled();
+            clReleaseEvent(event);
+            state->deref();
+        }
+    }
+    state->deref();
+    return future;
+#else
+    QVector<cl_event> list;
+    list.reserve(count);
+    for (int index = 0; index < count; ++index) {
+        clRetainEvent(events[index]);
+        list.append(events[index]);
+    }
+    return QtConcurrent::run(qt_cl_future_wait, list);
+#endif
+}
 
 /*!
     Returns a QFuture object that can be used to track when this
     OpenCL event finishes.
 
-    This function creates a thread on the host CPU to monitor the
-    event in the background.  If the caller wants to block in the
-    foreground thread, then waitForFinished() is recommended instead
-    of using toFuture(), because waitForFinished() does not need to
-    create an extra thread on the host CPU.
+    With OpenCL 1.1 and higher, the future is completed from an
+    event callback that is registered with \c{clSetEventCallback()},
+    so no host thread is blocked while the event is outstanding.
+    The future is canceled if the event terminates abnormally.
+    With OpenCL 1.0, this function uses a thread on the host CPU
+    to monitor the event in the background.  If the caller wants to
+    block in the foreground thread, then waitForFinished() is
+    recommended instead of using toFuture().
 
     If however the caller wants to receive notification of the event
     finishing via a signal, then toFuture() can be used with
@@ -397,12 +493,7 @@ static void qt_cl_future_wait(cl_event event)
 */
 QFuture<void> QCLEvent::toFuture() const
 {
-    if (m_id) {
-        clRetainEvent(m_id);
-        return QtConcurrent::run(qt_cl_future_wait, m_id);
-    } else {
-        return QFuture<void>();
-    }
+    return qt_cl_event_future(&m_id, m_id ? 1 : 0);
 }
 
 /*!
@@ -735,24 +826,19 @@ void QCLEventList::waitForFinished()
     }
 }
 
-static void qt_cl_future_list_wait(QVector<cl_event> events)
-{
-    clWaitForEvents(events.size(), events.constData());
-    for (int index = 0; index < events.size(); ++index)
-        clReleaseEvent(events[index]);
-}
-
 #if !defined(QT_NO_CONCURRENT)
 
 /*!
     Returns a QFuture object that can be used to track when all
     of the events on this list finish.
 
-    This function creates a thread on the host CPU to monitor the
-    events in the background.  If the caller wants to block in the
-    foreground thread, then waitForFinished() is recommended instead
-    of using toFuture(), because waitForFinished() does not need to
-    create an extra thread on the host CPU.
+    With OpenCL 1.1 and higher, the future is completed from event
+    callbacks, so no host thread is blocked while the events are
+    outstanding.  The future is canceled if any of the events
+    terminates abnormally.  With OpenCL 1.0, this function uses a
+    thread on the host CPU to monitor the events in the background.
+    If the caller wants to block in the foreground thread, then
+    waitForFinished() is recommended instead of using toFuture().
 
     If however the caller wants to receive notification of the events
     finishing via a signal, then toFuture() can be used with
@@ -777,15 +863,7 @@ static void qt_cl_future_list_wait(QVector<cl_event> events)
 */
 QFuture<void> QCLEventList::toFuture() const
 {
-    if (!m_events.isEmpty()) {
-        QVector<cl_event> events(m_events);
-        events.detach();
-        for (int index = 0; index < events.size(); ++index)
-            clRetainEvent(events[index]);
-        return QtConcurrent::run(qt_cl_future_list_wait, events);
-    } else {
-        return QFuture<void>();
-    }
+    return qt_cl_event_future(m_events.constData(), m_events.size());
 }
 
 /*!
@@ -102,21 +102,21 @@ inline QCLEvent::QCLEvent(const QCLEvent &other)
     : m_id(other.m_id)
 {
     if (m_id)
-        clRetainEvent(m_id);
+        qt_clRetainEvent(m_id);
 }
 
 inline QCLEvent::~QCLEvent()
 {
     if (m_id)
-        clReleaseEvent(m_id);
+        qt_clReleaseEvent(m_id);
 }
 
 inline QCLEvent &QCLEvent::operator=(const QCLEvent &other)
 {
     if (other.m_id)
-        clRetainEvent(other.m_id);
+        qt_clRetainEvent(other.m_id);
     if (m_id)
-        clReleaseEvent(m_id);
+        qt_clReleaseEvent(m_id);
     m_id = other.m_id;
     return *this;
 }
@@ -0,0 +1,359 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcleventwatcher.h"
+#include "qclcontext.h"
+#include "qclext_p.h"
+#include "qclloader_p.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qpair.h>
+#ifndef QT_OPENCL_1_1
+#include <QtConcurrent>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QCLEventWatcher
+    \brief The QCLEventWatcher class delivers Qt signals when OpenCL events finish.
+    \since 4.7
+    \ingroup opencl
+
+    QCLEventWatcher watches a set of QCLEvent objects and emits
+    finished() in the thread that owns the watcher when they complete,
+    without polling QCLEvent::isFinished() and without blocking a
+    thread per event.
+
+    \code
+    QCLEventWatcher *watcher = new QCLEventWatcher(this);
+    connect(watcher, SIGNAL(finished(QCLEventList)),
+            this, SLOT(framesReady(QCLEventList)));
+    connect(watcher, SIGNAL(allFinished()), this, SLOT(pipelineIdle()));
+
+    watcher->addEvent(buffer.readAsync(0, data, size));
+    watcher->addEvent(kernel.run());
+    \endcode
+
+    With OpenCL 1.1 and higher, completion is detected with
+    \c{clSetEventCallback()}.  The callbacks run on a thread that belongs
+    to the OpenCL implementation and only record the event; the signals
+    are delivered by a queued call into the watcher's thread.  Events
+    that complete before that call is processed are coalesced into a
+    single finished() signal, so a pipeline with thousands of events
+    produces a small number of notifications.
+
+    With OpenCL 1.0, a thread from the global QThreadPool waits on each
+    event instead; the signals are delivered in the same way.
+
+    \sa QCLEvent::toFuture()
+*/
+
+/*!
+    \fn void QCLEventWatcher::finished(const QCLEventList &events)
+
+    This signal is emitted in the watcher's thread when one or more
+    of the watched \a events have finished successfully.  Events that
+    finish close together are reported in a single batch.
+
+    \sa errored(), allFinished()
+*/
+
+/*!
+    \fn void QCLEventWatcher::errored(const QCLEvent &event, cl_int status)
+
+    This signal is emitted in the watcher's thread when the watched
+    \a event terminates abnormally with the negative error \a status.
+
+    \sa finished()
+*/
+
+/*!
+    \fn void QCLEventWatcher::allFinished()
+
+    This signal is emitted in the watcher's thread after finished()
+    or errored() when no watched events remain outstanding.
+
+    \sa pendingCount()
+*/
+
+// State that is shared between the watcher and the event callbacks.
+// The callbacks may outlive the watcher, so the state is reference
+// counted, and the back pointer is cleared under the lock when the
+// watcher is destroyed.
+class QCLEventWatcherShared
+{
+public:
+    QCLEventWatcherShared(QCLEventWatcher *w)
+        : ref(1), watcher(w), deliveryPending(false) {}
+
+    void deref()
+    {
+        if (!ref.deref())
+            delete this;
+    }
+
+    void notify(cl_event event, cl_int status);
+
+    QAtomicInt ref;
+    QMutex lock;
+    QCLEventWatcher *watcher;
+    QVector<cl_event> finished;
+    QVector< QPair<cl_event, cl_int> > errors;
+    bool deliveryPending;
+};
+
+// Called from an OpenCL callback thread.  Takes over the
+// reference to the event and to the shared state.
+void QCLEventWatcherShared::notify(cl_event event, cl_int status)
+{
+    {
+        QMutexLocker locker(&lock);
+        if (watcher) {
+            if (status < 0)
+                errors.append(qMakePair(event, status));
+            else
+                finished.append(event);
+            event = 0;
+            if (!deliveryPending) {
+                deliveryPending = true;
+                QMetaObject::invokeMethod
+                    (watcher, "deliver", Qt::QueuedConnection);
+            }
+        }
+    }
+    if (event)
+        clReleaseEvent(event);
+    deref();
+}
+
+#ifdef QT_OPENCL_1_1
+
+extern "C" {
+
+static void CL_CALLBACK qt_cl_watcher_notify
+    (cl_event event, cl_int status, void *user_data)
+{
+    reinterpret_cast<QCLEventWatcherShared *>(user_data)->notify
+        (event, status);
+}
+
+}
+
+#else
+
+static void qt_cl_watcher_wait(cl_event event, QCLEventWatcherShared *shared)
+{
+    clWaitForEvents(1, &event);
+    cl_int status = CL_COMPLETE;
+    clGetEventInfo(event, CL_EVENT_COMMAND_EXECUTION_STATUS,
+                   sizeof(status), &status, 0);
+    shared->notify(event, status);
+}
+
+#endif
+
+class QCLEventWatcherPrivate
+{
+public:
+    QCLEventWatcherPrivate(QCLEventWatcher *watcher)
+        : shared(new QCLEventWatcherShared(watcher))
+        , pending(0)
+    {
+    }
+    ~QCLEventWatcherPrivate()
+    {
+        QVector<cl_event> events;
+        QVector< QPair<cl_event, cl_int> > errors;
+        {
+            QMutexLocker locker(&shared->lock);
+            shared->watcher = 0;
+            qSwap(events, shared->finished);
+            qSwap(errors, shared->errors);
+        }
+        for (int index = 0; index < events.size(); ++index)
+            clReleaseEvent(events[index]);
+        for (int index = 0; index < errors.size(); ++index)
+            clReleaseEvent(errors[index].first);
+        shared->deref();
+    }
+
+    QCLEventWatcherShared *shared;
+    int pending;
+
+    static int queued(const QCLEventWatcher *watcher)
+    {
+        QCLEventWatcherShared *shared = watcher->d_func()->shared;
+        QMutexLocker locker(&shared->lock);
+        return shared->finished.size() + shared->errors.size();
+    }
+};
+
+// Returns the number of completions that the callbacks have recorded
+// for "watcher" but which have not been delivered yet.  Used by the
+// unit tests to check coalescing without depending on callback timing,
+// and only exported in developer builds.
+Q_AUTOTEST_EXPORT int qt_cl_event_watcher_queued(const QCLEventWatcher *watcher)
+{
+    return QCLEventWatcherPrivate::queued(watcher);
+}
+
+/*!
+    Constructs an event watcher with the specified \a parent.
+*/
+QCLEventWatcher::QCLEventWatcher(QObject *parent)
+    : QObject(parent)
+    , d_ptr(new QCLEventWatcherPrivate(this))
+{
+    qRegisterMetaType<QCLEvent>();
+    qRegisterMetaType<QCLEventList>();
+}
+
+/*!
+    Destroys this event watcher.  Events that are still outstanding
+    continue to execute, but no further signals will be emitted.
+*/
+QCLEventWatcher::~QCLEventWatcher()
+{
+}
+
+/*!
+    Adds \a event to the set of events that are watched.  The event
+    is retained until it has been reported by finished() or errored().
+    Null events are ignored.
+
+    This function should be called from the thread that owns
+    the watcher.
+
+    \sa addEvents()
+*/
+void QCLEventWatcher::addEvent(const QCLEvent &event)
+{
+    Q_D(QCLEventWatcher);
+    cl_event id = event.eventId();
+    if (!id)
+        return;
+    clRetainEvent(id);
+    d->shared->ref.ref();
+    ++(d->pending);
+#ifdef QT_OPENCL_1_1
+    // Callbacks only fire once the command has been submitted.
+    cl_command_queue queue = 0;
+    if (clGetEventInfo(id, CL_EVENT_COMMAND_QUEUE,
+                       sizeof(queue), &queue, 0) == CL_SUCCESS && queue)
+        clFlush(queue);
+    cl_int error = clSetEventCallback
+        (id, CL_COMPLETE, qt_cl_watcher_notify, d->shared);
+    if (error != CL_SUCCESS) {
+        qWarning() << "QCLEventWatcher::addEvent:"
+                   << QCLContext::errorName(error);
+        d->shared->notify(id, error);
+    }
+#else
+    QtConcurrent::run(qt_cl_watcher_wait, id, d->shared);
+#endif
+}
+
+/*!
+    Adds all of the events in \a events to the set of events
+    that are watched.
+
+    \sa addEvent()
+*/
+void QCLEventWatcher::addEvents(const QCLEventList &events)
+{
+    for (int index = 0; index < events.size(); ++index)
+        addEvent(events.at(index));
+}
+
+/*!
+    Returns the number of watched events that have not been reported
+    by finished() or errored() yet.
+
+    \sa isFinished()
+*/
+int QCLEventWatcher::pendingCount() const
+{
+    Q_D(const QCLEventWatcher);
+    return d->pending;
+}
+
+/*!
+    Returns true if there are no watched events outstanding;
+    false otherwise.
+
+    \sa pendingCount(), allFinished()
+*/
+bool QCLEventWatcher::isFinished() const
+{
+    Q_D(const QCLEventWatcher);
+    return d->pending == 0;
+}
+
+void QCLEventWatcher::deliver()
+{
+    Q_D(QCLEventWatcher);
+    QVector<cl_event> events;
+    QVector< QPair<cl_event, cl_int> > errors;
+    {
+        QMutexLocker locker(&d->shared->lock);
+        qSwap(events, d->shared->finished);
+        qSwap(errors, d->shared->errors);
+        d->shared->deliveryPending = false;
+    }
+    d->pending -= events.size() + errors.size();
+
+    // The QCLEvent objects take over the references from the callbacks.
+    if (!events.isEmpty()) {
+        QCLEventList list;
+        for (int index = 0; index < events.size(); ++index)
+            list.append(QCLEvent(events[index]));
+        emit finished(list);
+    }
+    for (int index = 0; index < errors.size(); ++index)
+        emit errored(QCLEvent(errors[index].first), errors[index].second);
+    if (d->pending == 0 && (!events.isEmpty() || !errors.isEmpty()))
+        emit allFinished();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,93 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCLEVENTWATCHER_H
+#define QCLEVENTWATCHER_H
+
+#include "qclevent.h"
+#include <QtCore/qobject.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qscopedpointer.h>
+
+QT_BEGIN_HEADER
+
+QT_BEGIN_NAMESPACE
+
+QT_MODULE(CL)
+
+class QCLEventWatcherPrivate;
+
+class Q_CL_EXPORT QCLEventWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QCLEventWatcher(QObject *parent = 0);
+    ~QCLEventWatcher();
+
+    void addEvent(const QCLEvent &event);
+    void addEvents(const QCLEventList &events);
+
+    int pendingCount() const;
+    bool isFinished() const;
+
+Q_SIGNALS:
+    void finished(const QCLEventList &events);
+    void errored(const QCLEvent &event, cl_int status);
+    void allFinished();
+
+private Q_SLOTS:
+    void deliver();
+
+private:
+    QScopedPointer<QCLEventWatcherPrivate> d_ptr;
+
+    Q_DISABLE_COPY(QCLEventWatcher)
+    Q_DECLARE_PRIVATE(QCLEventWatcher)
+};
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(QCLEvent)
+Q_DECLARE_METATYPE(QCLEventList)
+
+QT_END_HEADER
+
+#endif
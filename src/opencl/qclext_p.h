@@ -47,6 +47,12 @@
 // This file provides standard and extension definitions
 // that we cannot rely upon being present in the system headers.
 
+// Calling convention for notification callbacks.  OpenCL 1.0
+// headers do not define this.
+#ifndef CL_CALLBACK
+#define CL_CALLBACK
+#endif
+
 // OpenCL 1.1
 #ifndef CL_MISALIGNED_SUB_BUFFER_OFFSET
 #define CL_MISALIGNED_SUB_BUFFER_OFFSET -13
@@ -84,6 +90,10 @@
 #ifndef CL_COMMAND_USER
 #define CL_COMMAND_USER 0x1204
 #endif
+#ifndef CL_COMMAND_ACQUIRE_GL_OBJECTS
+#define CL_COMMAND_ACQUIRE_GL_OBJECTS 0x11FF
+#define CL_COMMAND_RELEASE_GL_OBJECTS 0x1200
+#endif
 #ifndef CL_MEM_ASSOCIATED_MEMOBJECT
 #define CL_MEM_ASSOCIATED_MEMOBJECT 0x1107
 #endif
@@ -94,6 +104,11 @@
 #define CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE 0x11B3
 #endif
 
+// OpenCL 1.2
+#ifndef CL_MAP_WRITE_INVALIDATE_REGION
+#define CL_MAP_WRITE_INVALIDATE_REGION (1 << 2)
+#endif
+
 // OpenCL-OpenGL sharing.
 #ifndef CL_INVALID_CL_SHAREGROUP_REFERENCE_KHR
 #define CL_INVALID_CL_SHAREGROUP_REFERENCE_KHR -1000
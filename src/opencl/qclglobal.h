@@ -80,4 +80,23 @@ QT_END_NAMESPACE
 #include <CL/cl.h>
 #endif
 
+QT_BEGIN_NAMESPACE
+
+// Reference counting for the OpenCL objects that are held by the inline
+// functions in the QtOpenCL headers.  These go through the QtOpenCL
+// library so that applications do not need to link against OpenCL
+// when QtOpenCL loads it at runtime.  Not part of the public API.
+Q_CL_EXPORT cl_int qt_clRetainCommandQueue(cl_command_queue command_queue);
+Q_CL_EXPORT cl_int qt_clReleaseCommandQueue(cl_command_queue command_queue);
+Q_CL_EXPORT cl_int qt_clRetainMemObject(cl_mem memobj);
+Q_CL_EXPORT cl_int qt_clReleaseMemObject(cl_mem memobj);
+Q_CL_EXPORT cl_int qt_clRetainSampler(cl_sampler sampler);
+Q_CL_EXPORT cl_int qt_clReleaseSampler(cl_sampler sampler);
+Q_CL_EXPORT cl_int qt_clRetainProgram(cl_program program);
+Q_CL_EXPORT cl_int qt_clReleaseProgram(cl_program program);
+Q_CL_EXPORT cl_int qt_clRetainEvent(cl_event event);
+Q_CL_EXPORT cl_int qt_clReleaseEvent(cl_event event);
+
+QT_END_NAMESPACE
+
 #endif
@@ -42,6 +42,7 @@
 #include "qclimage.h"
 #include "qclbuffer.h"
 #include "qclcontext.h"
+#include "qclloader_p.h"
 #include <QtGui/qpainter.h>
 #include <QtGui/qpaintdevice.h>
 #include <qpa/qplatformpixmap.h>
@@ -224,10 +225,16 @@ bool QCLImage2D::read(void *data, const QRect &rect, int bytesPerLine)
 {
     size_t origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
+    cl_event event = 0;
     cl_int error = clEnqueueReadImage
         (context()->activeQueue(), memoryId(), CL_TRUE,
-         origin, region, bytesPerLine, 0, data, 0, 0, 0);
+         origin, region, bytesPerLine, 0, data, 0, 0,
+         context()->profilingEvent(&event));
     context()->reportError("QCLImage2D::read:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return error == CL_SUCCESS;
 }
 
@@ -274,18 +281,54 @@ QCLEvent QCLImage2D::readAsync
 {
     size_t origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueReadImage
         (context()->activeQueue(), memoryId(), CL_FALSE,
          origin, region, bytesPerLine, 0, data,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLImage2D::readAsync:", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
         return QCLEvent();
 }
 
+/*!
+    Reads the contents of \a rect from within this image into \a data,
+    without creating an event to track the request.  Returns true if
+    the request was queued; false otherwise.  If \a bytesPerLine is
+    not zero, it indicates the number of bytes between lines in \a data.
+
+    The contents of \a data are not valid until the request has
+    finished, which can be determined with QCLContext::finish() or
+    QCLContext::marker().
+
+    The request will not start until all of the events in \a after
+    have been signaled as finished.  The request is executed on
+    the active command queue for context().
+
+    \sa readAsync(), writeDetached()
+*/
+bool QCLImage2D::readDetached
+    (void *data, const QRect &rect,
+     const QCLEventList &after, int bytesPerLine)
+{
+    size_t origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
+    size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
+    cl_event event = 0;
+    cl_int error = clEnqueueReadImage
+        (context()->activeQueue(), memoryId(), CL_FALSE,
+         origin, region, bytesPerLine, 0, data,
+         after.size(), after.eventData(), context()->profilingEvent(&event));
+    context()->reportError("QCLImage2D::readDetached:", error);
+    if (event) {
+        context()->recordCommand(event, after);
+        clReleaseEvent(event);
+    }
+    return error == CL_SUCCESS;
+}
+
 /*!
     Writes the contents \a data to \a rect within this image.
     Returns true if the write was successful; false otherwise.
@@ -301,10 +344,16 @@ bool QCLImage2D::write(const void *data, const QRect &rect, int bytesPerLine)
 {
     size_t origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
+    cl_event event = 0;
     cl_int error = clEnqueueWriteImage
         (context()->activeQueue(), memoryId(), CL_TRUE,
-         origin, region, bytesPerLine, 0, data, 0, 0, 0);
+         origin, region, bytesPerLine, 0, data, 0, 0,
+         context()->profilingEvent(&event));
     context()->reportError("QCLImage2D::write:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return error == CL_SUCCESS;
 }
 
@@ -351,18 +400,54 @@ QCLEvent QCLImage2D::writeAsync
 {
     size_t origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueWriteImage
         (context()->activeQueue(), memoryId(), CL_FALSE,
          origin, region, bytesPerLine, 0, data,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLImage2D::writeAsync:", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
         return QCLEvent();
 }
 
+/*!
+    Writes the contents of \a data into \a rect within this image,
+    without creating an event to track the request.  Returns true if
+    the request was queued; false otherwise.  If \a bytesPerLine is
+    not zero, it indicates the number of bytes between lines in \a data.
+
+    The \a data array must remain valid until the request has finished,
+    which can be determined with QCLContext::finish() or
+    QCLContext::marker().
+
+    The request will not start until all of the events in \a after
+    have been signaled as finished.  The request is executed on
+    the active command queue for context().
+
+    \sa writeAsync(), readDetached()
+*/
+bool QCLImage2D::writeDetached
+    (const void *data, const QRect &rect,
+     const QCLEventList &after, int bytesPerLine)
+{
+    size_t origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
+    size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
+    cl_event event = 0;
+    cl_int error = clEnqueueWriteImage
+        (context()->activeQueue(), memoryId(), CL_FALSE,
+         origin, region, bytesPerLine, 0, data,
+         after.size(), after.eventData(), context()->profilingEvent(&event));
+    context()->reportError("QCLImage2D::writeDetached:", error);
+    if (event) {
+        context()->recordCommand(event, after);
+        clReleaseEvent(event);
+    }
+    return error == CL_SUCCESS;
+}
+
 /*!
     Copies the contents of \a rect from this image to \a destOffset
     in \a dest.  Returns true if the copy was successful; false otherwise.
@@ -378,11 +463,12 @@ bool QCLImage2D::copyTo
     size_t src_origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t dst_origin[3] = {static_cast<size_t>(destOffset.x()), static_cast<size_t>(destOffset.y()), 0};
     size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyImage
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          src_origin, dst_origin, region, 0, 0, &event);
     context()->reportError("QCLImage2D::copyTo(QCLImage2D):", error);
+    context()->recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS) {
         clWaitForEvents(1, &event);
         clReleaseEvent(event);
@@ -406,11 +492,12 @@ bool QCLImage2D::copyTo
 {
     size_t src_origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyImage
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          src_origin, destOffset, region, 0, 0, &event);
     context()->reportError("QCLImage2D::copyTo(QCLImage3D):", error);
+    context()->recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS) {
         clWaitForEvents(1, &event);
         clReleaseEvent(event);
@@ -434,11 +521,12 @@ bool QCLImage2D::copyTo
 {
     size_t src_origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyImageToBuffer
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          src_origin, region, destOffset, 0, 0, &event);
     context()->reportError("QCLImage2D::copyTo(QCLBuffer):", error);
+    context()->recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS) {
         clWaitForEvents(1, &event);
         clReleaseEvent(event);
@@ -466,12 +554,13 @@ QCLEvent QCLImage2D::copyToAsync
     size_t src_origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t dst_origin[3] = {static_cast<size_t>(destOffset.x()), static_cast<size_t>(destOffset.y()), 0};
     size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyImage
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          src_origin, dst_origin, region,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLImage2D::copyToAsync(QCLImage2D):", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -495,12 +584,13 @@ QCLEvent QCLImage2D::copyToAsync
 {
     size_t src_origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyImage
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          src_origin, destOffset, region,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLImage2D::copyToAsync(QCLImage3D):", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -524,12 +614,13 @@ QCLEvent QCLImage2D::copyToAsync
 {
     size_t src_origin[3] = {static_cast<size_t>(rect.x()), static_cast<size_t>(rect.y()), 0};
     size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyImageToBuffer
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          src_origin, region, destOffset,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLImage2D::copyToAsync(QCLBuffer):", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -558,11 +649,16 @@ void *QCLImage2D::map
     size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
     cl_int error;
     size_t rowPitch;
+    cl_event event = 0;
     void *data = clEnqueueMapImage
         (context()->activeQueue(), memoryId(), CL_TRUE,
          qt_cl_map_flags(access), origin, region,
-         &rowPitch, 0, 0, 0, 0, &error);
+         &rowPitch, 0, 0, 0, context()->profilingEvent(&event), &error);
     context()->reportError("QCLImage2D::map:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     if (bytesPerLine)
         *bytesPerLine = int(rowPitch);
     return data;
@@ -594,12 +690,13 @@ QCLEvent QCLImage2D::mapAsync
     size_t region[3] = {static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()), 1};
     cl_int error;
     size_t rowPitch;
-    cl_event event;
+    cl_event event = 0;
     *ptr = clEnqueueMapImage
         (context()->activeQueue(), memoryId(), CL_FALSE,
          qt_cl_map_flags(access), origin, region, &rowPitch, 0,
          after.size(), after.eventData(), &event, &error);
     context()->reportError("QCLImage2D::mapAsync:", error);
+    context()->recordCommand(event, after);
     if (bytesPerLine)
         *bytesPerLine = int(rowPitch);
     if (error == CL_SUCCESS)
@@ -956,10 +1053,16 @@ bool QCLImage3D::read
     (void *data, const size_t origin[3], const size_t size[3],
      int bytesPerLine, int bytesPerSlice)
 {
+    cl_event event = 0;
     cl_int error = clEnqueueReadImage
         (context()->activeQueue(), memoryId(), CL_TRUE,
-         origin, size, bytesPerLine, bytesPerSlice, data, 0, 0, 0);
+         origin, size, bytesPerLine, bytesPerSlice, data, 0, 0,
+         context()->profilingEvent(&event));
     context()->reportError("QCLImage3D::read:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return error == CL_SUCCESS;
 }
 
@@ -985,12 +1088,13 @@ QCLEvent QCLImage3D::readAsync
     (void *data, const size_t origin[3], const size_t size[3],
      const QCLEventList &after, int bytesPerLine, int bytesPerSlice)
 {
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueReadImage
         (context()->activeQueue(), memoryId(), CL_FALSE,
          origin, size, bytesPerLine, bytesPerSlice, data,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLImage3D::readAsync:", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -1014,10 +1118,16 @@ bool QCLImage3D::write
     (const void *data, const size_t origin[3], const size_t size[3],
      int bytesPerLine, int bytesPerSlice)
 {
+    cl_event event = 0;
     cl_int error = clEnqueueWriteImage
         (context()->activeQueue(), memoryId(), CL_TRUE,
-         origin, size, bytesPerLine, bytesPerSlice, data, 0, 0, 0);
+         origin, size, bytesPerLine, bytesPerSlice, data, 0, 0,
+         context()->profilingEvent(&event));
     context()->reportError("QCLImage3D::write:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     return error == CL_SUCCESS;
 }
 
@@ -1043,12 +1153,13 @@ QCLEvent QCLImage3D::writeAsync
     (const void *data, const size_t origin[3], const size_t size[3],
      const QCLEventList &after, int bytesPerLine, int bytesPerSlice)
 {
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueWriteImage
         (context()->activeQueue(), memoryId(), CL_FALSE,
          origin, size, bytesPerLine, bytesPerSlice, data,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLImage3D::writeAsync:", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -1069,11 +1180,12 @@ bool QCLImage3D::copyTo
     (const size_t origin[3], const size_t size[3],
      const QCLImage3D &dest, const size_t destOffset[3])
 {
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyImage
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          origin, destOffset, size, 0, 0, &event);
     context()->reportError("QCLImage3D::copyTo(QCLImage3D):", error);
+    context()->recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS) {
         clWaitForEvents(1, &event);
         clReleaseEvent(event);
@@ -1100,11 +1212,12 @@ bool QCLImage3D::copyTo
 {
     size_t dst_origin[3] = {static_cast<size_t>(destOffset.x()), static_cast<size_t>(destOffset.y()), 0};
     size_t region[3] = {static_cast<size_t>(size.width()), static_cast<size_t>(size.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyImage
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          origin, dst_origin, region, 0, 0, &event);
     context()->reportError("QCLImage3D::copyTo(QCLImage2D):", error);
+    context()->recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS) {
         clWaitForEvents(1, &event);
         clReleaseEvent(event);
@@ -1128,11 +1241,12 @@ bool QCLImage3D::copyTo
     (const size_t origin[3], const size_t size[3],
      const QCLBuffer &dest, size_t destOffset)
 {
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyImageToBuffer
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          origin, size, destOffset, 0, 0, &event);
     context()->reportError("QCLImage3D::copyTo(QCLBuffer):", error);
+    context()->recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS) {
         clWaitForEvents(1, &event);
         clReleaseEvent(event);
@@ -1162,12 +1276,13 @@ QCLEvent QCLImage3D::copyToAsync
      const QCLImage3D &dest, const size_t destOffset[3],
      const QCLEventList &after)
 {
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyImage
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          origin, destOffset, size,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLImage3D::copyToAsync(QCLImage3D):", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -1197,12 +1312,13 @@ QCLEvent QCLImage3D::copyToAsync
 {
     size_t dst_origin[3] = {static_cast<size_t>(destOffset.x()), static_cast<size_t>(destOffset.y()), 0};
     size_t region[3] = {static_cast<size_t>(size.width()), static_cast<size_t>(size.height()), 1};
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyImage
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          origin, dst_origin, region,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLImage3D::copyToAsync(QCLImage2D):", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -1229,12 +1345,13 @@ QCLEvent QCLImage3D::copyToAsync
      const QCLBuffer &dest, size_t destOffset,
      const QCLEventList &after)
 {
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueCopyImageToBuffer
         (context()->activeQueue(), memoryId(), dest.memoryId(),
          origin, size, destOffset,
          after.size(), after.eventData(), &event);
     context()->reportError("QCLImage3D::copyToAsync(QCLBuffer):", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -1261,11 +1378,17 @@ void *QCLImage3D::map
 {
     cl_int error;
     size_t rowPitch, slicePitch;
+    cl_event event = 0;
     void *data = clEnqueueMapImage
         (context()->activeQueue(), memoryId(), CL_TRUE,
          qt_cl_map_flags(access), origin, size,
-         &rowPitch, &slicePitch, 0, 0, 0, &error);
+         &rowPitch, &slicePitch, 0, 0,
+         context()->profilingEvent(&event), &error);
     context()->reportError("QCLImage3D::map:", error);
+    if (event) {
+        context()->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
     if (bytesPerLine)
         *bytesPerLine = int(rowPitch);
     if (bytesPerSlice)
@@ -1300,13 +1423,14 @@ QCLEvent QCLImage3D::mapAsync
 {
     cl_int error;
     size_t rowPitch, slicePitch;
-    cl_event event;
+    cl_event event = 0;
     *ptr = clEnqueueMapImage
         (context()->activeQueue(), memoryId(),
          CL_FALSE, qt_cl_map_flags(access),
          origin, size, &rowPitch, &slicePitch,
          after.size(), after.eventData(), &event, &error);
     context()->reportError("QCLImage3D::mapAsync:", error);
+    context()->recordCommand(event, after);
     if (bytesPerLine)
         *bytesPerLine = int(rowPitch);
     if (bytesPerSlice)
@@ -82,6 +82,9 @@ public:
     QCLEvent readAsync(void *data, const QRect &rect,
                        const QCLEventList &after = QCLEventList(),
                        int bytesPerLine = 0);
+    bool readDetached(void *data, const QRect &rect,
+                      const QCLEventList &after = QCLEventList(),
+                      int bytesPerLine = 0);
 
     bool write(const void *data, const QRect &rect, int bytesPerLine = 0);
     bool write(const QImage &image, const QRect &rect = QRect());
@@ -89,6 +92,10 @@ public:
         (const void *data, const QRect &rect,
          const QCLEventList &after = QCLEventList(),
          int bytesPerLine = 0);
+    bool writeDetached
+        (const void *data, const QRect &rect,
+         const QCLEventList &after = QCLEventList(),
+         int bytesPerLine = 0);
 
     bool copyTo(const QRect &rect, const QCLImage2D &dest,
                 const QPoint &destOffset);
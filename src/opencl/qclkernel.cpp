@@ -43,8 +43,9 @@
 #include "qclprogram.h"
 #include "qclbuffer.h"
 #include "qclcontext.h"
+#include "qclkernel_p.h"
 #include "qclext_p.h"
-#include <QtCore/qvarlengtharray.h>
+#include "qclloader_p.h"
 #include <QtCore/qpoint.h>
 #include <QtGui/qvector2d.h>
 #include <QtGui/qvector3d.h>
@@ -93,9 +94,10 @@ QT_BEGIN_NAMESPACE
     kernel(a2, b2);
     \endcode
 
-    Up to 10 arguments can be provided to operator()().  Use explicit
-    setArg() and run() calls with kernels that have more than
-    10 arguments.
+    Any number of arguments can be provided to operator()().  The type
+    of each argument is checked at compile time, and in debug builds
+    the arguments are also checked against the kernel's declared
+    parameters; see setArgs() for details.
 
     The following types are handled specially via setArg() and operator()():
     \c cl_int, \c cl_uint, \c cl_long, \c cl_ulong, \c float,
@@ -104,6 +106,27 @@ QT_BEGIN_NAMESPACE
     Other argument types must be set explicitly by calling the
     setArg() override that takes a buffer and size.
 
+    \section1 Argument caching
+
+    QCLKernel remembers the arguments that were last set on the
+    kernel and skips the call to \c{clSetKernelArg()} when setArg()
+    or operator()() is called with an unchanged value.  A render loop
+    that passes the same arguments every frame therefore only pays for
+    the arguments that actually change.  The cache is shared between
+    QCLKernel objects that were copied from each other, including the
+    handles returned by QCLProgram::cachedKernel().
+
+    Memory objects and samplers that are bound as arguments are
+    retained by the kernel until the argument is changed or the
+    kernel is destroyed.  Kernels that are returned by
+    QCLProgram::cachedKernel() in QCLProgram::PerThreadKernel mode
+    only retain them until the kernel is next run, because the
+    context keeps those kernels for as long as the thread lives.
+    Call invalidateArgCache() after changing arguments with
+    \c{clSetKernelArg()} on kernelId() directly.
+    The argUpdatesIssued() and argUpdatesSkipped() functions can be
+    used to check how effective the cache is.
+
     \section1 Asynchronous execution
 
     Note that both run() and operator()() return immediately;
@@ -147,10 +170,11 @@ QT_BEGIN_NAMESPACE
     This will create a background thread on the main CPU to enqueue
     the kernel for execution and to wait for the kernel to complete.
 
-    Only 5 arguments can be passed to a kernel using
-    QtConcurrent::run(), which is the same as for regular functions
-    and QtConcurrent.  Use explicit setArg() calls and runInThread()
-    for kernels with more than 5 arguments.
+    Unlike QtConcurrent::run() on regular functions, any number of
+    arguments can be passed to a kernel on compilers that support
+    variadic templates.  Otherwise, only 5 arguments are supported;
+    use explicit setArg() calls and runInThread() for kernels with
+    more than 5 arguments.
 
     Because kernels do not have return values, QtConcurrent::run()
     on a QCLKernel will always return a QFuture<void>.
@@ -171,49 +195,113 @@ QT_BEGIN_NAMESPACE
     \sa QCLProgram, {OpenCL and QtConcurrent}
 */
 
-class QCLKernelPrivate
-{
-public:
-    QCLKernelPrivate(QCLContext *ctx, cl_kernel kid)
-        : context(ctx)
-        , id(kid)
-        , globalWorkSize(1)
-        , localWorkSize(0)
-    {}
-    QCLKernelPrivate(const QCLKernelPrivate *other)
-        : context(other->context)
-        , id(other->id)
-        , globalWorkSize(other->globalWorkSize)
-        , localWorkSize(other->localWorkSize)
-    {
-        if (id)
-            clRetainKernel(id);
+bool QCLKernelArgCache::isCurrent
+    (int index, Kind kind, const void *data, size_t size) const
+{
+    if (index < 0 || index >= args.size())
+        return false;
+    const Arg &arg = args[index];
+    if (arg.kind != kind || arg.size != size)
+        return false;
+    switch (kind) {
+    case Value:
+        return memcmp(arg.value.constData(), data, size) == 0;
+    case Local:
+        return true;
+    case MemoryObject:
+    case Sampler:
+        return arg.object == *reinterpret_cast<void * const *>(data);
+    default: break;
     }
-    ~QCLKernelPrivate()
-    {
-        if (id)
-            clReleaseKernel(id);
+    return false;
+}
+
+void QCLKernelArgCache::update
+    (int index, Kind kind, const void *data, size_t size)
+{
+    if (index < 0)
+        return;
+    if (index >= args.size())
+        args.resize(index + 1);
+    Arg &arg = args[index];
+    void *object = 0;
+    if (kind == MemoryObject || kind == Sampler) {
+        object = *reinterpret_cast<void * const *>(data);
+        retain(kind, object);
     }
+    release(arg.kind, arg.object);
+    arg.kind = kind;
+    arg.size = size;
+    arg.object = object;
+    if (kind == Value) {
+        if (arg.value.size() != int(size))
+            arg.value.resize(int(size));
+        memcpy(arg.value.data(), data, size);
+    }
+}
 
-    void copy(const QCLKernelPrivate *other)
-    {
-        context = other->context;
-        globalWorkSize = other->globalWorkSize;
-        localWorkSize = other->localWorkSize;
-        if (id != other->id) {
-            if (id)
-                clReleaseKernel(id);
-            id = other->id;
-            if (id)
-                clRetainKernel(id);
-        }
+void QCLKernelArgCache::invalidate(int index)
+{
+    if (index < 0 || index >= args.size())
+        return;
+    Arg &arg = args[index];
+    release(arg.kind, arg.object);
+    arg.kind = Invalid;
+    arg.object = 0;
+}
+
+void QCLKernelArgCache::invalidate()
+{
+    for (int index = 0; index < args.size(); ++index)
+        invalidate(index);
+}
+
+// Called after the kernel has been enqueued.  The kernel's arguments
+// were captured by the enqueue, so a transient cache can let go of
+// the objects that are bound to it.
+void QCLKernelArgCache::launched()
+{
+    if (!transient)
+        return;
+    for (int index = 0; index < args.size(); ++index) {
+        if (args[index].kind == MemoryObject || args[index].kind == Sampler)
+            invalidate(index);
     }
+}
+
+void QCLKernelArgCache::retain(Kind kind, void *object)
+{
+    if (!object)
+        return;
+    if (kind == MemoryObject)
+        clRetainMemObject(cl_mem(object));
+    else if (kind == Sampler)
+        clRetainSampler(cl_sampler(object));
+}
 
-    QCLContext *context;
-    cl_kernel id;
-    QCLWorkSize globalWorkSize;
-    QCLWorkSize localWorkSize;
-};
+void QCLKernelArgCache::release(Kind kind, void *object)
+{
+    if (!object)
+        return;
+    if (kind == MemoryObject)
+        clReleaseMemObject(cl_mem(object));
+    else if (kind == Sampler)
+        clReleaseSampler(cl_sampler(object));
+}
+
+void QCLKernelPrivate::setArg
+    (int index, QCLKernelArgCache::Kind kind, const void *data, size_t size)
+{
+    if (args->isCurrent(index, kind, data, size)) {
+        ++(args->skipped);
+        return;
+    }
+    ++(args->issued);
+    if (clSetKernelArg(id, index, size, data) == CL_SUCCESS)
+        args->update(index, kind, data, size);
+    else
+        args->invalidate(index);
+}
 
 /*!
     Constructs a null OpenCL kernel object.
@@ -518,8 +606,10 @@ void QCLKernel::setLocalWorkSize(const QCLWorkSize &size)
 */
 QCLWorkSize QCLKernel::bestLocalWorkSizeImage2D() const
 {
-    QList<QCLDevice> devices = program().devices();
-    size_t maxItems = devices.isEmpty() ? 1 : devices.at(0). maximumWorkItemsPerGroup();
+    Q_D(const QCLKernel);
+    size_t maxItems = d->context ? d->context->defaultDevice().maximumWorkItemsPerGroup() : 0;
+    if (!maxItems)
+        maxItems = 1;
     size_t size = 8;
     while (size > 1 && (size * size) > maxItems)
         size /= 2;
@@ -535,8 +625,10 @@ QCLWorkSize QCLKernel::bestLocalWorkSizeImage2D() const
 */
 QCLWorkSize QCLKernel::bestLocalWorkSizeImage3D() const
 {
-    QList<QCLDevice> devices = program().devices();
-    size_t maxItems = devices.isEmpty() ? 1 : devices.at(0). maximumWorkItemsPerGroup();
+    Q_D(const QCLKernel);
+    size_t maxItems = d->context ? d->context->defaultDevice().maximumWorkItemsPerGroup() : 0;
+    if (!maxItems)
+        maxItems = 1;
     size_t size = 8;
     while (size > 1 && (size * size * size) > maxItems)
         size /= 2;
@@ -562,6 +654,212 @@ size_t QCLKernel::preferredWorkSizeMultiple() const
         return size;
 }
 
+const QString &QCLKernelPrivate::kernelName() const
+{
+    if (tuningName.isEmpty()) {
+        size_t size = 0;
+        if (clGetKernelInfo(id, CL_KERNEL_FUNCTION_NAME,
+                            0, 0, &size) == CL_SUCCESS && size > 1) {
+            QVarLengthArray<char> buf(size);
+            if (clGetKernelInfo(id, CL_KERNEL_FUNCTION_NAME,
+                                size, buf.data(), 0) == CL_SUCCESS)
+                tuningName = QString::fromLatin1(buf.constData(), int(size) - 1);
+        }
+    }
+    return tuningName;
+}
+
+/*!
+    Runs this kernel several times with different local work sizes
+    on the context's default device, and returns the local work size
+    that was fastest for the current globalWorkSize().  A zero local
+    work size in the result indicates that it is fastest to let the
+    OpenCL implementation choose.
+
+    The candidates are the implementation's own choice and every
+    combination of powers of two that divides globalWorkSize() in each
+    dimension and fits within the device and kernel work-group limits.
+    Each candidate is run once to warm up, and then \a iterations times
+    on a separate command queue with profiling enabled; the candidate
+    with the lowest total device time wins.
+
+    The result is recorded in the context and, if a file has been set
+    with QCLContext::setWorkSizeTuningFile(), saved for later runs of
+    the application.  From then on, run() uses the result whenever this
+    kernel, or another kernel with the same name, is run without an
+    explicit localWorkSize() on a global work size that rounds up to
+    the same powers of two.
+
+    The kernel's arguments must be set before calling this function,
+    and it must be safe to run the kernel repeatedly with them.
+    This function blocks until all of the runs have finished.
+
+    \sa setLocalWorkSize(), QCLContext::setWorkSizeTuningFile()
+*/
+QCLWorkSize QCLKernel::autoTuneLocalWorkSize(int iterations)
+{
+    Q_D(QCLKernel);
+    if (!d->id || !d->context)
+        return QCLWorkSize(0);
+    QCLDevice device = d->context->defaultDevice();
+    QCLCommandQueue queue = d->context->createCommandQueue
+        (CL_QUEUE_PROFILING_ENABLE, device);
+    if (queue.isNull())
+        return QCLWorkSize(0);
+
+    size_t maxItems = device.maximumWorkItemsPerGroup();
+    size_t kernelItems = 0;
+    if (clGetKernelWorkGroupInfo
+            (d->id, device.deviceId(), CL_KERNEL_WORK_GROUP_SIZE,
+             sizeof(kernelItems), &kernelItems, 0) == CL_SUCCESS &&
+            kernelItems > 0)
+        maxItems = qMin(maxItems, kernelItems);
+    QCLWorkSize maxItemSize = device.maximumWorkItemSize();
+    QCLWorkSize global = d->globalWorkSize;
+    size_t dims = global.dimensions();
+
+    QList<QCLWorkSize> candidates;
+    candidates.append(QCLWorkSize(0));
+    for (size_t w = 1; w <= maxItems && w <= maxItemSize.width(); w *= 2) {
+        if ((global.width() % w) != 0)
+            continue;
+        if (dims == 1) {
+            candidates.append(QCLWorkSize(w));
+            continue;
+        }
+        for (size_t h = 1; (w * h) <= maxItems && h <= maxItemSize.height(); h *= 2) {
+            if ((global.height() % h) != 0)
+                continue;
+            if (dims == 2) {
+                candidates.append(QCLWorkSize(w, h));
+                continue;
+            }
+            for (size_t z = 1; (w * h * z) <= maxItems && z <= maxItemSize.depth(); z *= 2) {
+                if ((global.depth() % z) == 0)
+                    candidates.append(QCLWorkSize(w, h, z));
+            }
+        }
+    }
+
+    QCLWorkSize saved = d->localWorkSize;
+    QCLWorkSize best(0);
+    quint64 bestTime = 0;
+    bool haveBest = false;
+    d->tuning = true;
+    for (int index = 0; index < candidates.size(); ++index) {
+        d->localWorkSize = candidates.at(index);
+        QCLEvent event = run(queue);
+        if (event.isNull())
+            continue;
+        event.waitForFinished();
+        quint64 total = 0;
+        int iteration;
+        for (iteration = 0; iteration < iterations; ++iteration) {
+            event = run(queue);
+            if (event.isNull())
+                break;
+            event.waitForFinished();
+            total += event.finishTime() - event.runTime();
+        }
+        if (iteration < iterations)
+            continue;
+        if (!haveBest || total < bestTime) {
+            best = candidates.at(index);
+            bestTime = total;
+            haveBest = true;
+        }
+    }
+    d->tuning = false;
+    d->localWorkSize = saved;
+
+    if (haveBest)
+        d->context->setTunedLocalWorkSize
+            (d->kernelName(), device.deviceId(), global, best);
+    return best;
+}
+
+/*!
+    \internal
+
+    Returns the local work size to pass to clEnqueueNDRangeKernel():
+    the explicit localWorkSize() if there is one, otherwise the size
+    found by autoTuneLocalWorkSize() for this kernel, the device of
+    \a queue, and the global work size, or null to let the OpenCL
+    implementation choose.  If \a queue is null, the tuning results
+    for the context's default device are used.
+*/
+const size_t *QCLKernel::runLocalWorkSize(cl_command_queue queue) const
+{
+    Q_D(const QCLKernel);
+    if (d->localWorkSize.width())
+        return d->localWorkSize.sizes();
+    if (d->tuning)
+        return 0;
+    int generation = d->context->tunedWorkSizeGeneration();
+    if (!generation)
+        return 0;
+    cl_device_id device = d->tunedDevice;
+    if (queue != d->tunedQueue || !device) {
+        device = 0;
+        if (queue) {
+            clGetCommandQueueInfo(queue, CL_QUEUE_DEVICE,
+                                  sizeof(device), &device, 0);
+        }
+        if (!device)
+            device = d->context->defaultDevice().deviceId();
+        d->tunedQueue = queue;
+    }
+    if (generation != d->tunedGeneration ||
+            d->globalWorkSize != d->tunedGlobalWorkSize ||
+            device != d->tunedDevice) {
+        d->tunedGeneration = generation;
+        d->tunedGlobalWorkSize = d->globalWorkSize;
+        d->tunedDevice = device;
+        if (!d->context->tunedLocalWorkSize
+                (d->kernelName(), device, d->globalWorkSize,
+                 &d->tunedLocalWorkSize))
+            d->tunedLocalWorkSize = QCLWorkSize(0);
+    }
+
+    // The tuned size may have been found for a different global size
+    // in the same size class, so check that it divides this one.
+    const QCLWorkSize &local = d->tunedLocalWorkSize;
+    const QCLWorkSize &global = d->globalWorkSize;
+    if (!local.width() || local.dimensions() != global.dimensions())
+        return 0;
+    for (size_t dim = 0; dim < global.dimensions(); ++dim) {
+        if (!local.sizes()[dim] || (global.sizes()[dim] % local.sizes()[dim]) != 0)
+            return 0;
+    }
+    return local.sizes();
+}
+
+QCLWorkSize QCLKernelPrivate::runLocalWorkSize(const QCLKernel &kernel)
+{
+    QCLContext *context = kernel.d_func()->context;
+    if (!context)
+        return QCLWorkSize(0);
+    const size_t *local = kernel.runLocalWorkSize
+        (context->commandQueue().queueId());
+    if (!local)
+        return QCLWorkSize(0);
+    size_t dims = kernel.globalWorkSize().dimensions();
+    if (dims == 1)
+        return QCLWorkSize(local[0]);
+    else if (dims == 2)
+        return QCLWorkSize(local[0], local[1]);
+    else
+        return QCLWorkSize(local[0], local[1], local[2]);
+}
+
+// Returns the local work size that QCLKernel::run() would use for
+// "kernel" on the active command queue.  Used by the unit tests,
+// and only exported in developer builds.
+Q_AUTOTEST_EXPORT QCLWorkSize qt_cl_run_local_work_size(const QCLKernel &kernel)
+{
+    return QCLKernelPrivate::runLocalWorkSize(kernel);
+}
+
 /*!
     \fn void QCLKernel::setArg(int index, cl_int value)
 
@@ -647,7 +945,7 @@ void QCLKernel::setArg(int index, const QColor &value)
 {
     qreal values[4] =
         {value.redF(), value.greenF(), value.blueF(), value.alphaF()};
-    clSetKernelArg(m_kernelId, index, sizeof(values), values);
+    setArg(index, values, sizeof(values));
 }
 
 /*!
@@ -663,7 +961,7 @@ void QCLKernel::setArg(int index, Qt::GlobalColor value)
     QColor color(value);
     qreal values[4] =
         {color.redF(), color.greenF(), color.blueF(), color.alphaF()};
-    clSetKernelArg(m_kernelId, index, sizeof(values), values);
+    setArg(index, values, sizeof(values));
 }
 
 /*!
@@ -693,24 +991,28 @@ void QCLKernel::setArg(int index, Qt::GlobalColor value)
 void QCLKernel::setArg(int index, const QMatrix4x4 &value)
 {
     if (sizeof(qreal) == sizeof(float)) {
-        clSetKernelArg(m_kernelId, index, sizeof(float) * 16, value.constData());
+        setArg(index, value.constData(), sizeof(float) * 16);
     } else {
         float values[16];
         for (int posn = 0; posn < 16; ++posn)
             values[posn] = float(value.constData()[posn]);
-        clSetKernelArg(m_kernelId, index, sizeof(values), values);
+        setArg(index, values, sizeof(values));
     }
 }
 
 /*!
-    \fn void QCLKernel::setArg(int index, const QCLMemoryObject &value)
-
     Sets argument \a index for this kernel to \a value.
 
     The argument is assumed to have been declared with the
     type \c image2d_t, \c image3d_t, or be a pointer to a buffer,
     according to the type of memory object represented by \a value.
 */
+void QCLKernel::setArg(int index, const QCLMemoryObject &value)
+{
+    Q_D(QCLKernel);
+    cl_mem id = value.memoryId();
+    d->setArg(index, QCLKernelArgCache::MemoryObject, &id, sizeof(id));
+}
 
 /*!
     \fn void QCLKernel::setArg(int index, const QCLVector<T> &value)
@@ -720,21 +1022,78 @@ void QCLKernel::setArg(int index, const QMatrix4x4 &value)
     The argument is assumed to have been declared as a pointer
     to a buffer.
 */
+void QCLKernel::setArg(int index, const QCLVectorBase &value)
+{
+    Q_D(QCLKernel);
+    cl_mem id = value.kernelArg();
+    d->setArg(index, QCLKernelArgCache::MemoryObject, &id, sizeof(id));
+}
 
 /*!
-    \fn void QCLKernel::setArg(int index, const QCLSampler &value)
-
     Sets argument \a index for this kernel to \a value.
 
     The argument is assumed to have been declared with the
     type \c sampler_t.
 */
+void QCLKernel::setArg(int index, const QCLSampler &value)
+{
+    Q_D(QCLKernel);
+    cl_sampler id = value.samplerId();
+    d->setArg(index, QCLKernelArgCache::Sampler, &id, sizeof(id));
+}
+
+/*!
+    Sets argument \a index to the \a size bytes at \a data.
+
+    If \a data is null, then the argument is assumed to have been
+    declared as a \c __local pointer and \a size bytes of local
+    memory will be allocated for it.
+*/
+void QCLKernel::setArg(int index, const void *data, size_t size)
+{
+    Q_D(QCLKernel);
+    d->setArg(index, data ? QCLKernelArgCache::Value : QCLKernelArgCache::Local,
+              data, size);
+}
 
 /*!
-    \fn void QCLKernel::setArg(int index, const void *data, size_t size)
+    Returns the number of argument updates on this kernel that were
+    passed to \c{clSetKernelArg()} because the argument value changed.
 
-    Sets argument \a index to the \a size bytes at \a data.
+    \sa argUpdatesSkipped(), {Argument caching}
 */
+quint64 QCLKernel::argUpdatesIssued() const
+{
+    Q_D(const QCLKernel);
+    return d->args->issued;
+}
+
+/*!
+    Returns the number of argument updates on this kernel that were
+    skipped because the argument already had the requested value.
+
+    \sa argUpdatesIssued(), {Argument caching}
+*/
+quint64 QCLKernel::argUpdatesSkipped() const
+{
+    Q_D(const QCLKernel);
+    return d->args->skipped;
+}
+
+/*!
+    Forgets the argument values that were previously set on this
+    kernel, so that the next setArg() call for each argument will
+    always be passed to OpenCL.  This must be called if the
+    arguments are modified by calling \c{clSetKernelArg()} directly
+    on kernelId().
+
+    \sa {Argument caching}
+*/
+void QCLKernel::invalidateArgCache()
+{
+    Q_D(QCLKernel);
+    d->args->invalidate();
+}
 
 /*!
     Requests that this kernel instance be run on globalWorkSize() items,
@@ -749,13 +1108,16 @@ void QCLKernel::setArg(int index, const QMatrix4x4 &value)
 QCLEvent QCLKernel::run()
 {
     Q_D(const QCLKernel);
-    cl_event event;
+    cl_event event = 0;
+    cl_command_queue queue = d->context->activeQueue();
     cl_int error = clEnqueueNDRangeKernel
-        (d->context->activeQueue(), m_kernelId, d->globalWorkSize.dimensions(),
+        (queue, m_kernelId, d->globalWorkSize.dimensions(),
          0, d->globalWorkSize.sizes(),
-         (d->localWorkSize.width() ? d->localWorkSize.sizes() : 0),
+         runLocalWorkSize(queue),
          0, 0, &event);
     d->context->reportError("QCLKernel::run:", error);
+    d->args->launched();
+    d->context->recordCommand(event, QCLEventList(), m_kernelId);
     if (error != CL_SUCCESS)
         return QCLEvent();
     else
@@ -778,21 +1140,131 @@ QCLEvent QCLKernel::run()
 QCLEvent QCLKernel::run(const QCLEventList &after)
 {
     Q_D(const QCLKernel);
-    cl_event event;
+    cl_event event = 0;
+    cl_command_queue queue = d->context->activeQueue();
     cl_int error = clEnqueueNDRangeKernel
-        (d->context->activeQueue(), m_kernelId, d->globalWorkSize.dimensions(),
+        (queue, m_kernelId, d->globalWorkSize.dimensions(),
          0, d->globalWorkSize.sizes(),
-         (d->localWorkSize.width() ? d->localWorkSize.sizes() : 0),
+         runLocalWorkSize(queue),
          after.size(), after.eventData(), &event);
     d->context->reportError("QCLKernel::run:", error);
+    d->args->launched();
+    d->context->recordCommand(event, after, m_kernelId);
     if (error != CL_SUCCESS)
         return QCLEvent();
     else
         return QCLEvent(event);
 }
 
+/*!
+    \overload
+
+    Requests that this kernel instance be run on globalWorkSize() items,
+    optionally subdivided into work groups of localWorkSize() items,
+    using the command \a queue instead of the active command queue
+    for context().  The \a queue is typically obtained from
+    QCLContext::acquireQueue().
+
+    If \a after is not an empty list, it indicates the events that must
+    be signaled as finished before this kernel instance can begin executing.
+
+    Returns an event object that can be used to wait for the kernel
+    to finish execution.
+
+    \sa QCLContext::createQueuePool()
+*/
+QCLEvent QCLKernel::run(const QCLCommandQueue &queue, const QCLEventList &after)
+{
+    Q_D(const QCLKernel);
+    cl_event event = 0;
+    cl_int error = clEnqueueNDRangeKernel
+        (queue.queueId(), m_kernelId, d->globalWorkSize.dimensions(),
+         0, d->globalWorkSize.sizes(),
+         runLocalWorkSize(queue.queueId()),
+         after.size(), after.eventData(), &event);
+    d->context->reportError("QCLKernel::run:", error);
+    d->args->launched();
+    d->context->recordCommand(event, after, m_kernelId);
+    if (error != CL_SUCCESS)
+        return QCLEvent();
+    d->context->trackPoolEvent(queue.queueId(), event);
+    return QCLEvent(event);
+}
+
+/*!
+    Requests that this kernel instance be run on globalWorkSize() items,
+    optionally subdivided into work groups of localWorkSize() items,
+    without creating an event to track the request.  Returns true if
+    the request was queued; false otherwise.
+
+    This avoids the cost of allocating, retaining, and releasing an
+    event object for each launch, which is significant for small
+    kernels that are launched at a high rate.  Completion can be
+    observed with QCLContext::finish() or QCLContext::marker(), or by
+    a later command on the same in-order queue.
+
+    If \a after is not an empty list, it indicates the events that must
+    be signaled as finished before this kernel instance can begin executing.
+    The request is executed on the active command queue for context().
+
+    \sa run()
+*/
+bool QCLKernel::runDetached(const QCLEventList &after)
+{
+    Q_D(const QCLKernel);
+    cl_event event = 0;
+    cl_command_queue queue = d->context->activeQueue();
+    cl_int error = clEnqueueNDRangeKernel
+        (queue, m_kernelId, d->globalWorkSize.dimensions(),
+         0, d->globalWorkSize.sizes(),
+         runLocalWorkSize(queue),
+         after.size(), after.eventData(), d->context->profilingEvent(&event));
+    d->context->reportError("QCLKernel::runDetached:", error);
+    d->args->launched();
+    if (event) {
+        d->context->recordCommand(event, after, m_kernelId);
+        clReleaseEvent(event);
+    }
+    return error == CL_SUCCESS;
+}
+
+/*!
+    \overload
+
+    Requests that this kernel instance be run without an event, using
+    the command \a queue instead of the active command queue for
+    context().  Launches made with this function are not counted by
+    QCLContext::LeastBusy queue selection.
+
+    \sa run(), QCLContext::acquireQueue()
+*/
+bool QCLKernel::runDetached(const QCLCommandQueue &queue, const QCLEventList &after)
+{
+    Q_D(const QCLKernel);
+    cl_event event = 0;
+    cl_int error = clEnqueueNDRangeKernel
+        (queue.queueId(), m_kernelId, d->globalWorkSize.dimensions(),
+         0, d->globalWorkSize.sizes(),
+         runLocalWorkSize(queue.queueId()),
+         after.size(), after.eventData(), d->context->profilingEvent(&event));
+    d->context->reportError("QCLKernel::runDetached:", error);
+    d->args->launched();
+    if (event) {
+        d->context->recordCommand(event, after, m_kernelId);
+        clReleaseEvent(event);
+    }
+    return error == CL_SUCCESS;
+}
+
 #ifndef QT_NO_CONCURRENT
 
+#ifdef QT_OPENCL_1_1
+
+// Defined in qclevent.cpp.
+QFuture<void> qt_cl_event_future(const cl_event *events, int count);
+
+#else
+
 static void qt_run_kernel
     (cl_kernel kernel, cl_command_queue queue,
      const QCLWorkSize &globalWorkSize, const QCLWorkSize &localWorkSize)
@@ -812,15 +1284,22 @@ static void qt_run_kernel
     clReleaseCommandQueue(queue);
 }
 
+#endif
+
 /*!
     Requests that this kernel instance be run on globalWorkSize() items,
     optionally subdivided into work groups of localWorkSize() items.
-    The kernel will be enqueued and executed in a background thread.
 
     Returns a QFuture object that can be used to wait for the kernel
     to finish execution.  The request is executed on the active
     command queue for context().
 
+    With OpenCL 1.1 and higher, the kernel is enqueued immediately
+    in the calling thread, and the future is completed from an event
+    callback; no host thread is blocked while the kernel executes,
+    so many kernels can be outstanding at once.  With OpenCL 1.0,
+    the kernel is enqueued and waited for in a background thread.
+
     Usually runInThread() is called implicitly via QtConcurrent::run():
 
     \code
@@ -829,9 +1308,9 @@ static void qt_run_kernel
     future.waitForFinished();
     \endcode
 
-    The kernel object must not be reused until the background
-    thread finishes execution of the kernel.  Thus, the following
-    code will have unexpected effects:
+    With OpenCL 1.0, the kernel object must not be reused until the
+    background thread finishes execution of the kernel.  Thus, the
+    following code will have unexpected effects:
 
     \code
     QFuture<void> future1 = QtConcurrent::run(kernel, a1, b1);
@@ -857,6 +1336,13 @@ static void qt_run_kernel
 */
 QFuture<void> QCLKernel::runInThread()
 {
+#ifdef QT_OPENCL_1_1
+    if (!m_kernelId)
+        return QFuture<void>();
+    QCLEvent event = run();
+    cl_event id = event.eventId();
+    return qt_cl_event_future(&id, id ? 1 : 0);
+#else
     Q_D(const QCLKernel);
     cl_kernel kernel = m_kernelId;
     cl_command_queue queue = d->context->activeQueue();
@@ -866,99 +1352,103 @@ QFuture<void> QCLKernel::runInThread()
     clRetainCommandQueue(queue);
     return QtConcurrent::run
         (qt_run_kernel, kernel, queue, d->globalWorkSize, d->localWorkSize);
+#endif
 }
 
 #endif
 
 /*!
-    \fn QCLEvent QCLKernel::operator()()
+    \fn QCLEvent QCLKernel::operator()(const Args &...args)
 
-    Runs this kernel instance with zero arguments.
+    Runs this kernel instance with the arguments \a args, which are
+    assigned to kernel argument indices 0, 1, 2, and so on.
     Returns an event object that can be used to wait for the
     kernel to finish execution.
-*/
-
-/*!
-    \fn QCLEvent QCLKernel::operator()(const T1 &arg1)
-
-    Runs this kernel instance with the argument \a arg1.
-    Returns an event object that can be used to wait for the
-    kernel to finish execution.
-*/
-
-/*!
-    \fn QCLEvent QCLKernel::operator()(const T1 &arg1, const T2 &arg2)
-
-    Runs this kernel instance with the arguments \a arg1 and \a arg2.
-    Returns an event object that can be used to wait for the
-    kernel to finish execution.
-*/
-
-/*!
-    \fn QCLEvent QCLKernel::operator()(const T1 &arg1, const T2 &arg2, const T3 &arg3)
-
-    Runs this kernel instance with the arguments \a arg1, \a arg2,
-    and \a arg3.  Returns an event object that can be used to wait for the
-    kernel to finish execution.
-*/
-
-/*!
-    \fn QCLEvent QCLKernel::operator()(const T1 &arg1, const T2 &arg2, const T3 &arg3, const T4 &arg4)
-
-    Runs this kernel instance with the arguments \a arg1, \a arg2,
-    \a arg3, and \a arg4.  Returns an event object that can be used to
-    wait for the kernel to finish execution.
-*/
-
-/*!
-    \fn QCLEvent QCLKernel::operator()(const T1 &arg1, const T2 &arg2, const T3 &arg3, const T4 &arg4, const T5 &arg5)
 
-    Runs this kernel instance with the arguments \a arg1, \a arg2,
-    \a arg3, \a arg4, and \a arg5.  Returns an event object that can be
-    used to wait for the kernel to finish execution.
-*/
-
-/*!
-    \fn QCLEvent QCLKernel::operator()(const T1 &arg1, const T2 &arg2, const T3 &arg3, const T4 &arg4, const T5 &arg5, const T6 &arg6)
+    Any number of arguments may be supplied.  The type of each argument
+    is checked at compile time against the setArg() overloads; a type
+    without an unambiguous setArg() overload is rejected with a static
+    assertion rather than an overload resolution failure.
 
-    Runs this kernel instance with the arguments \a arg1, \a arg2,
-    \a arg3, \a arg4, \a arg5, and \a arg6.  Returns an event object that
-    can be used to wait for the kernel to finish execution.
+    \sa setArgs(), run()
 */
 
 /*!
-    \fn QCLEvent QCLKernel::operator()(const T1 &arg1, const T2 &arg2, const T3 &arg3, const T4 &arg4, const T5 &arg5, const T6 &arg6, const T7 &arg7)
-
-    Runs this kernel instance with the arguments \a arg1, \a arg2,
-    \a arg3, \a arg4, \a arg5, \a arg6, and \a arg7.  Returns an event
-    object that can be used to wait for the kernel to finish execution.
+    \fn void QCLKernel::setArgs(const Args &...args)
+
+    Sets the arguments of this kernel to \a args, starting at
+    argument index 0.  This is equivalent to calling setArg() once
+    for each argument, and is expanded inline at compile time without
+    any per-argument allocation.
+
+    In debug builds, the number of arguments is checked against
+    argCount().  If the kernel was built from source with OpenCL 1.2
+    or later, the kind of each argument (memory object, sampler, or
+    plain value) is also checked against the argument information
+    reported by the OpenCL implementation.  Mismatches are reported
+    with qWarning() the first time a particular argument signature
+    is used with this kernel.
+
+    \sa operator()(), setArg()
 */
 
 /*!
-    \fn QCLEvent QCLKernel::operator()(const T1 &arg1, const T2 &arg2, const T3 &arg3, const T4 &arg4, const T5 &arg5, const T6 &arg6, const T7 &arg7, const T8 &arg8)
-
-    Runs this kernel instance with the arguments \a arg1, \a arg2,
-    \a arg3, \a arg4, \a arg5, \a arg6, \a arg7, and \a arg8.  Returns
-    an event object that can be used to wait for the kernel to finish
-    execution.
-*/
-
-/*!
-    \fn QCLEvent QCLKernel::operator()(const T1 &arg1, const T2 &arg2, const T3 &arg3, const T4 &arg4, const T5 &arg5, const T6 &arg6, const T7 &arg7, const T8 &arg8, const T9 &arg9)
-
-    Runs this kernel instance with the arguments \a arg1, \a arg2,
-    \a arg3, \a arg4, \a arg5, \a arg6, \a arg7, \a arg8, and \a arg9.
-    Returns an event object that can be used to wait for the kernel
-    to finish execution.
+    \internal
 */
+void QCLKernel::verifyArgs(int count, const int *kinds)
+{
+    Q_D(QCLKernel);
 
-/*!
-    \fn QCLEvent QCLKernel::operator()(const T1 &arg1, const T2 &arg2, const T3 &arg3, const T4 &arg4, const T5 &arg5, const T6 &arg6, const T7 &arg7, const T8 &arg8, const T9 &arg9, const T10 &arg10)
+    // The kinds array is a function-local static for each distinct
+    // argument signature, so its address identifies the signature.
+    if (d->verifiedKinds == kinds)
+        return;
+    d->verifiedKinds = kinds;
+
+    int expected = argCount();
+    if (count > expected) {
+        qWarning("QCLKernel::setArgs: %d arguments supplied to kernel %s, "
+                 "which expects %d",
+                 count, qPrintable(name()), expected);
+        count = expected;
+    }
 
-    Runs this kernel instance with the arguments \a arg1, \a arg2,
-    \a arg3, \a arg4, \a arg5, \a arg6, \a arg7, \a arg8, \a arg9,
-    and \a arg10.  Returns an event object that can be used to wait
-    for the kernel to finish execution.
-*/
+#if defined(QT_OPENCL_1_1) && defined(CL_VERSION_1_2)
+    for (int index = 0; index < count; ++index) {
+        cl_kernel_arg_address_qualifier qualifier;
+        cl_int error = clGetKernelArgInfo
+            (d->id, cl_uint(index), CL_KERNEL_ARG_ADDRESS_QUALIFIER,
+             sizeof(qualifier), &qualifier, 0);
+        if (error != CL_SUCCESS)
+            return;     // No argument information; e.g. built from binary.
+        char typeName[64];
+        error = clGetKernelArgInfo
+            (d->id, cl_uint(index), CL_KERNEL_ARG_TYPE_NAME,
+             sizeof(typeName), typeName, 0);
+        if (error != CL_SUCCESS)
+            return;
+        typeName[sizeof(typeName) - 1] = '\0';
+        bool isSampler = (qstrcmp(typeName, "sampler_t") == 0);
+        bool isMemory = (qualifier == CL_KERNEL_ARG_ADDRESS_GLOBAL ||
+                         qualifier == CL_KERNEL_ARG_ADDRESS_CONSTANT ||
+                         qstrncmp(typeName, "image", 5) == 0);
+        if (qualifier == CL_KERNEL_ARG_ADDRESS_LOCAL)
+            continue;   // Set with a size only; cannot be checked here.
+        const char *problem = 0;
+        if (kinds[index] == 1 && !isMemory)
+            problem = "memory object passed to non-memory argument";
+        else if (kinds[index] == 2 && !isSampler)
+            problem = "sampler passed to non-sampler argument";
+        else if (kinds[index] == 0 && (isMemory || isSampler))
+            problem = "plain value passed to memory or sampler argument";
+        if (problem) {
+            qWarning("QCLKernel::setArgs: %s %d (%s) of kernel %s",
+                     problem, index, typeName, qPrintable(name()));
+        }
+    }
+#else
+    Q_UNUSED(kinds);
+#endif
+}
 
 QT_END_NAMESPACE
@@ -55,6 +55,9 @@
 #include <QtGui/qvector2d.h>
 #include <QtGui/qvector3d.h>
 #include <QtGui/qvector4d.h>
+#if defined(Q_COMPILER_VARIADIC_TEMPLATES)
+#include <type_traits>
+#endif
 
 QT_BEGIN_HEADER
 
@@ -64,6 +67,7 @@ QT_MODULE(CL)
 
 class QCLContext;
 class QCLProgram;
+class QCLCommandQueue;
 class QCLVectorBase;
 class QCLDevice;
 class QMatrix4x4;
@@ -71,6 +75,10 @@ class QColor;
 
 class QCLKernelPrivate;
 
+#if defined(Q_COMPILER_VARIADIC_TEMPLATES)
+template <typename T> struct QCLKernelArgTraits;
+#endif
+
 class Q_CL_EXPORT QCLKernel
 {
 public:
@@ -115,6 +123,8 @@ public:
 
     size_t preferredWorkSizeMultiple() const;
 
+    QCLWorkSize autoTuneLocalWorkSize(int iterations = 3);
+
     void setArg(int index, cl_int value);
     void setArg(int index, cl_uint value);
     void setArg(int index, cl_long value);
@@ -137,9 +147,37 @@ public:
     void setArg(int index, const QCLSampler &value);
     void setArg(int index, const void *data, size_t size);
 
+    quint64 argUpdatesIssued() const;
+    quint64 argUpdatesSkipped() const;
+    void invalidateArgCache();
+
     QCLEvent run();
     QCLEvent run(const QCLEventList &after);
+    QCLEvent run(const QCLCommandQueue &queue,
+                 const QCLEventList &after = QCLEventList());
+
+    bool runDetached(const QCLEventList &after = QCLEventList());
+    bool runDetached(const QCLCommandQueue &queue,
+                     const QCLEventList &after = QCLEventList());
 
+#if defined(Q_COMPILER_VARIADIC_TEMPLATES) || defined(qdoc)
+    template <typename... Args>
+    inline QCLEvent operator()(const Args &...args)
+    {
+        setArgs(args...);
+        return run();
+    }
+
+    template <typename... Args>
+    inline void setArgs(const Args &...args)
+    {
+        setArgsFrom(0, args...);
+#ifndef QT_NO_DEBUG
+        static const int kinds[] = { QCLKernelArgTraits<Args>::Kind..., -1 };
+        verifyArgs(int(sizeof...(Args)), kinds);
+#endif
+    }
+#else
     inline QCLEvent operator()() { return run(); }
 
     template <typename T1>
@@ -281,6 +319,8 @@ public:
         return run();
     }
 
+#endif
+
 #ifndef QT_NO_CONCURRENT
     QFuture<void> runInThread();
 #endif
@@ -290,8 +330,51 @@ private:
     cl_kernel m_kernelId;
 
     Q_DECLARE_PRIVATE(QCLKernel)
+
+    friend class QCLCommandList;
+    friend class QCLContext;
+
+#if defined(Q_COMPILER_VARIADIC_TEMPLATES)
+    inline void setArgsFrom(int) {}
+
+    template <typename T, typename... Rest>
+    inline void setArgsFrom(int index, const T &arg, const Rest &...rest)
+    {
+        Q_STATIC_ASSERT_X(QCLKernelArgTraits<T>::IsSupported,
+                          "QCLKernel: argument type is not supported by QCLKernel::setArg()");
+        setArg(index, arg);
+        setArgsFrom(index + 1, rest...);
+    }
+#endif
+
+    void verifyArgs(int count, const int *kinds);
+    const size_t *runLocalWorkSize(cl_command_queue queue) const;
+};
+
+#if defined(Q_COMPILER_VARIADIC_TEMPLATES)
+
+// Compile-time classification of kernel arguments for QCLKernel::setArgs().
+// IsSupported is true if there is an unambiguous setArg() overload for T.
+template <typename T>
+struct QCLKernelArgTraits
+{
+    template <typename U>
+    static char test(decltype(static_cast<QCLKernel *>(0)->setArg
+                              (0, *static_cast<const U *>(0))) *);
+    template <typename U>
+    static long test(...);
+
+    enum
+    {
+        IsSupported = (sizeof(test<T>(0)) == sizeof(char)),
+        Kind = (std::is_base_of<QCLMemoryObject, T>::value ||
+                std::is_base_of<QCLVectorBase, T>::value) ? 1 :
+               std::is_base_of<QCLSampler, T>::value ? 2 : 0
+    };
 };
 
+#endif
+
 inline void QCLKernel::setGlobalWorkSize(size_t width, size_t height)
 {
     setGlobalWorkSize(QCLWorkSize(width, height));
@@ -329,94 +412,71 @@ inline void QCLKernel::setLocalWorkSize(size_t width, size_t height, size_t dept
 
 inline void QCLKernel::setArg(int index, cl_int value)
 {
-    clSetKernelArg(m_kernelId, index, sizeof(value), &value);
+    setArg(index, &value, sizeof(value));
 }
 
 inline void QCLKernel::setArg(int index, cl_uint value)
 {
-    clSetKernelArg(m_kernelId, index, sizeof(value), &value);
+    setArg(index, &value, sizeof(value));
 }
 
 inline void QCLKernel::setArg(int index, cl_long value)
 {
-    clSetKernelArg(m_kernelId, index, sizeof(value), &value);
+    setArg(index, &value, sizeof(value));
 }
 
 inline void QCLKernel::setArg(int index, cl_ulong value)
 {
-    clSetKernelArg(m_kernelId, index, sizeof(value), &value);
+    setArg(index, &value, sizeof(value));
 }
 
 inline void QCLKernel::setArg(int index, float value)
 {
-    clSetKernelArg(m_kernelId, index, sizeof(value), &value);
+    setArg(index, &value, sizeof(value));
 }
 
 inline void QCLKernel::setArg(int index, const QVector2D &value)
 {
     if (sizeof(value) == (sizeof(float) * 2)) {
-        clSetKernelArg(m_kernelId, index, sizeof(value), &value);
+        setArg(index, &value, sizeof(value));
     } else {
         float values[2] = {value.x(), value.y()};
-        clSetKernelArg(m_kernelId, index, sizeof(values), values);
+        setArg(index, values, sizeof(values));
     }
 }
 
 inline void QCLKernel::setArg(int index, const QVector3D &value)
 {
     float values[4] = {value.x(), value.y(), value.z(), 1.0f};
-    clSetKernelArg(m_kernelId, index, sizeof(values), values);
+    setArg(index, values, sizeof(values));
 }
 
 inline void QCLKernel::setArg(int index, const QVector4D &value)
 {
     if (sizeof(value) == (sizeof(float) * 4)) {
-        clSetKernelArg(m_kernelId, index, sizeof(value), &value);
+        setArg(index, &value, sizeof(value));
     } else {
         float values[4] = {value.x(), value.y(), value.z(), value.w()};
-        clSetKernelArg(m_kernelId, index, sizeof(values), values);
+        setArg(index, values, sizeof(values));
     }
 }
 
 inline void QCLKernel::setArg(int index, const QPoint &value)
 {
     cl_int values[2] = {value.x(), value.y()};
-    clSetKernelArg(m_kernelId, index, sizeof(values), values);
+    setArg(index, values, sizeof(values));
 }
 
 inline void QCLKernel::setArg(int index, const QPointF &value)
 {
     if (sizeof(value) == (sizeof(float) * 2)) {
-        clSetKernelArg(m_kernelId, index, sizeof(value), &value);
+        setArg(index, &value, sizeof(value));
     } else {
         qreal values[2] = {value.x(), value.y()};
-        clSetKernelArg(m_kernelId, index, sizeof(values), values);
+        setArg(index, values, sizeof(values));
     }
 }
 
-inline void QCLKernel::setArg(int index, const QCLMemoryObject &value)
-{
-    cl_mem id = value.memoryId();
-    clSetKernelArg(m_kernelId, index, sizeof(id), &id);
-}
-
-inline void QCLKernel::setArg(int index, const QCLVectorBase &value)
-{
-    cl_mem id = value.kernelArg();
-    clSetKernelArg(m_kernelId, index, sizeof(id), &id);
-}
-
-inline void QCLKernel::setArg(int index, const QCLSampler &value)
-{
-    cl_sampler id = value.samplerId();
-    clSetKernelArg(m_kernelId, index, sizeof(id), &id);
-}
-
-inline void QCLKernel::setArg(int index, const void *data, size_t size)
-{
-    clSetKernelArg(m_kernelId, index, size, data);
-}
-
 #ifndef QT_NO_CONCURRENT
 
 // Convenience function definitions that make it possible to say
@@ -431,44 +491,78 @@ inline QFuture<void> run(QCLKernel &kernel)
 template <typename Arg1>
 inline QFuture<void> run(QCLKernel &kernel, const Arg1 &arg1)
 {
+#if defined(Q_COMPILER_VARIADIC_TEMPLATES)
+    kernel.setArgs(arg1);
+#else
     kernel.setArg(0, arg1);
+#endif
     return kernel.runInThread();
 }
 template <typename Arg1, typename Arg2>
 inline QFuture<void> run(QCLKernel &kernel, const Arg1 &arg1, const Arg2 &arg2)
 {
+#if defined(Q_COMPILER_VARIADIC_TEMPLATES)
+    kernel.setArgs(arg1, arg2);
+#else
     kernel.setArg(0, arg1);
     kernel.setArg(1, arg2);
+#endif
     return kernel.runInThread();
 }
 template <typename Arg1, typename Arg2, typename Arg3>
 inline QFuture<void> run(QCLKernel &kernel, const Arg1 &arg1, const Arg2 &arg2, const Arg3 &arg3)
 {
+#if defined(Q_COMPILER_VARIADIC_TEMPLATES)
+    kernel.setArgs(arg1, arg2, arg3);
+#else
     kernel.setArg(0, arg1);
     kernel.setArg(1, arg2);
     kernel.setArg(2, arg3);
+#endif
     return kernel.runInThread();
 }
 template <typename Arg1, typename Arg2, typename Arg3, typename Arg4>
 inline QFuture<void> run(QCLKernel &kernel, const Arg1 &arg1, const Arg2 &arg2, const Arg3 &arg3, const Arg4 &arg4)
 {
+#if defined(Q_COMPILER_VARIADIC_TEMPLATES)
+    kernel.setArgs(arg1, arg2, arg3, arg4);
+#else
     kernel.setArg(0, arg1);
     kernel.setArg(1, arg2);
     kernel.setArg(2, arg3);
     kernel.setArg(3, arg4);
+#endif
     return kernel.runInThread();
 }
 template <typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5>
 inline QFuture<void> run(QCLKernel &kernel, const Arg1 &arg1, const Arg2 &arg2, const Arg3 &arg3, const Arg4 &arg4, const Arg5 &arg5)
 {
+#if defined(Q_COMPILER_VARIADIC_TEMPLATES)
+    kernel.setArgs(arg1, arg2, arg3, arg4, arg5);
+#else
     kernel.setArg(0, arg1);
     kernel.setArg(1, arg2);
     kernel.setArg(2, arg3);
     kernel.setArg(3, arg4);
     kernel.setArg(4, arg5);
+#endif
     return kernel.runInThread();
 }
 
+#if defined(Q_COMPILER_VARIADIC_TEMPLATES)
+// The fixed-arity overloads above are kept because they are more
+// specialized than QtConcurrent's own run(Functor, ...) overloads,
+// which a variadic template alone would be ambiguous with.  This
+// overload handles kernels with more than 5 arguments.
+template <typename Arg1, typename Arg2, typename Arg3, typename Arg4,
+          typename Arg5, typename Arg6, typename... Args>
+inline QFuture<void> run(QCLKernel &kernel, const Arg1 &arg1, const Arg2 &arg2, const Arg3 &arg3, const Arg4 &arg4, const Arg5 &arg5, const Arg6 &arg6, const Args &...args)
+{
+    kernel.setArgs(arg1, arg2, arg3, arg4, arg5, arg6, args...);
+    return kernel.runInThread();
+}
+#endif
+
 } // namespace QtConcurrent
 
 #endif // QT_NO_CONCURRENT
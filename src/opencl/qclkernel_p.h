@@ -0,0 +1,211 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QCLKERNEL_P_H
+#define QCLKERNEL_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of the QtOpenCL library.  This header file may change from version
+// to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qclkernel.h"
+#include "qclworksize.h"
+#include "qclloader_p.h"
+#include <QtCore/qvarlengtharray.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qstring.h>
+
+QT_BEGIN_NAMESPACE
+
+// Shadow copy of the arguments that were last passed to clSetKernelArg()
+// for a kernel.  It is shared by all QCLKernel objects that were copied
+// from each other, so that they agree on the kernel's argument state.
+// Memory objects and samplers are retained while they are bound, so that
+// their handle values cannot be recycled for a different object.  For a
+// transient cache, such as that of a per-thread kernel that is kept by
+// the context, they are only held until the next launch so that the
+// kernel does not keep the caller's buffers alive.
+class QCLKernelArgCache
+{
+public:
+    enum Kind
+    {
+        Invalid,
+        Value,
+        Local,
+        MemoryObject,
+        Sampler
+    };
+
+    struct Arg
+    {
+        Arg() : kind(Invalid), size(0), object(0) {}
+
+        Kind kind;
+        size_t size;
+        void *object;
+        QByteArray value;
+    };
+
+    QCLKernelArgCache() : ref(1), issued(0), skipped(0), transient(false) {}
+    ~QCLKernelArgCache() { invalidate(); }
+
+    QAtomicInt ref;
+    quint64 issued;
+    quint64 skipped;
+    bool transient;
+    QVarLengthArray<Arg, 8> args;
+
+    bool isCurrent(int index, Kind kind, const void *data, size_t size) const;
+    void update(int index, Kind kind, const void *data, size_t size);
+    void invalidate(int index);
+    void invalidate();
+    void launched();
+
+    static void retain(Kind kind, void *object);
+    static void release(Kind kind, void *object);
+};
+
+class QCLKernelPrivate
+{
+public:
+    QCLKernelPrivate(QCLContext *ctx, cl_kernel kid)
+        : context(ctx)
+        , id(kid)
+        , globalWorkSize(1)
+        , localWorkSize(0)
+        , args(new QCLKernelArgCache())
+        , verifiedKinds(0)
+        , tunedLocalWorkSize(0)
+        , tunedGeneration(0)
+        , tunedQueue(0)
+        , tunedDevice(0)
+        , tuning(false)
+    {}
+    QCLKernelPrivate(const QCLKernelPrivate *other)
+        : context(other->context)
+        , id(other->id)
+        , globalWorkSize(other->globalWorkSize)
+        , localWorkSize(other->localWorkSize)
+        , args(other->args)
+        , verifiedKinds(other->verifiedKinds)
+        , tuningName(other->tuningName)
+        , tunedLocalWorkSize(0)
+        , tunedGeneration(0)
+        , tunedQueue(0)
+        , tunedDevice(0)
+        , tuning(false)
+    {
+        if (id)
+            clRetainKernel(id);
+        args->ref.ref();
+    }
+    ~QCLKernelPrivate()
+    {
+        if (!args->ref.deref())
+            delete args;
+        if (id)
+            clReleaseKernel(id);
+    }
+
+    void copy(const QCLKernelPrivate *other)
+    {
+        context = other->context;
+        verifiedKinds = other->verifiedKinds;
+        tuningName = other->tuningName;
+        tunedGeneration = 0;
+        tunedQueue = 0;
+        tunedDevice = 0;
+        globalWorkSize = other->globalWorkSize;
+        localWorkSize = other->localWorkSize;
+        if (id != other->id) {
+            if (id)
+                clReleaseKernel(id);
+            id = other->id;
+            if (id)
+                clRetainKernel(id);
+        }
+        if (args != other->args) {
+            other->args->ref.ref();
+            if (!args->ref.deref())
+                delete args;
+            args = other->args;
+        }
+    }
+
+    void setArg(int index, QCLKernelArgCache::Kind kind,
+                const void *data, size_t size);
+
+    QCLContext *context;
+    cl_kernel id;
+    QCLWorkSize globalWorkSize;
+    QCLWorkSize localWorkSize;
+    QCLKernelArgCache *args;
+    const int *verifiedKinds;
+
+    // Cached result of looking up the tuned local work size for
+    // globalWorkSize on tunedDevice in the context, and the last queue
+    // whose device was looked up; see QCLKernel::runLocalWorkSize().
+    mutable QString tuningName;
+    mutable QCLWorkSize tunedGlobalWorkSize;
+    mutable QCLWorkSize tunedLocalWorkSize;
+    mutable int tunedGeneration;
+    mutable cl_command_queue tunedQueue;
+    mutable cl_device_id tunedDevice;
+    bool tuning;
+
+    const QString &kernelName() const;
+
+    static QCLWorkSize runLocalWorkSize(const QCLKernel &kernel);
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,180 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#define QT_CL_LOADER
+#include "qclloader_p.h"
+#include <QtCore/qlibrary.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qdebug.h>
+
+// When QT_OPENCL_DYNAMIC is defined, QtOpenCL does not link against
+// the OpenCL library.  Instead, this file provides "qt_" prefixed
+// forwarders for the OpenCL entry points that QtOpenCL and QtOpenCLGL
+// call, routing each one through a dispatch table that is resolved the
+// first time that OpenCL is used.  Applications therefore start even when
+// no OpenCL implementation is installed, and every entry point reports
+// an error instead of crashing.
+
+#ifdef QT_OPENCL_DYNAMIC
+
+QT_BEGIN_NAMESPACE
+
+struct QCLFunctions
+{
+#define QT_CL_DECLARE_FUNCTION(ret, name, params, args, fail) \
+    typedef ret (CL_API_CALL *name##_t) params; \
+    name##_t name;
+    QT_CL_FUNCTIONS(QT_CL_DECLARE_FUNCTION)
+#undef QT_CL_DECLARE_FUNCTION
+};
+
+class QCLLoader
+{
+public:
+    QCLLoader();
+
+    QLibrary library;
+    bool loaded;
+    QCLFunctions functions;
+};
+
+QCLLoader::QCLLoader()
+    : loaded(false)
+{
+    // QT_OPENCL_LIBRARY can name a specific implementation to load,
+    // bypassing the ICD loader that is normally installed.
+    QByteArray name = qgetenv("QT_OPENCL_LIBRARY");
+    if (!name.isEmpty()) {
+        library.setFileName(QFile::decodeName(name));
+        loaded = library.load();
+    } else {
+#if defined(Q_OS_WIN)
+        library.setFileName(QLatin1String("OpenCL"));
+        loaded = library.load();
+#else
+        library.setFileNameAndVersion(QLatin1String("OpenCL"), 1);
+        loaded = library.load();
+        if (!loaded) {
+            library.setFileNameAndVersion(QLatin1String("OpenCL"), QString());
+            loaded = library.load();
+        }
+#endif
+    }
+    if (!loaded) {
+        qWarning() << "QtOpenCL: could not load the OpenCL library:"
+                   << library.errorString();
+    }
+
+    // Resolve the whole table up front so that the entry points below
+    // never have to synchronize with each other.
+#define QT_CL_RESOLVE_FUNCTION(ret, name, params, args, fail) \
+    functions.name = loaded \
+        ? reinterpret_cast<QCLFunctions::name##_t>(library.resolve(#name)) \
+        : 0;
+    QT_CL_FUNCTIONS(QT_CL_RESOLVE_FUNCTION)
+#undef QT_CL_RESOLVE_FUNCTION
+}
+
+Q_GLOBAL_STATIC(QCLLoader, qt_cl_loader)
+
+bool qt_cl_library_loaded()
+{
+    QCLLoader *loader = qt_cl_loader();
+    return loader && loader->loaded;
+}
+
+QFunctionPointer qt_cl_resolve(const char *name)
+{
+    QCLLoader *loader = qt_cl_loader();
+    if (!loader || !loader->loaded)
+        return 0;
+    return loader->library.resolve(name);
+}
+
+static inline const QCLFunctions *qt_cl_functions()
+{
+    QCLLoader *loader = qt_cl_loader();
+    return loader ? &(loader->functions) : 0;
+}
+
+// Entry points that are missing from the library fail with
+// CL_INVALID_OPERATION, except for clGetPlatformIDs which reports
+// that no platforms are available.
+#define QT_CL_DEFINE_FUNCTION(ret, name, params, args, fail) \
+    ret qt_##name params \
+    { \
+        const QCLFunctions *functions = qt_cl_functions(); \
+        if (!functions || !functions->name) { \
+            fail \
+        } \
+        return functions->name args; \
+    }
+QT_CL_FUNCTIONS(QT_CL_DEFINE_FUNCTION)
+#undef QT_CL_DEFINE_FUNCTION
+
+QT_END_NAMESPACE
+
+#else // !QT_OPENCL_DYNAMIC
+
+QT_BEGIN_NAMESPACE
+
+// The inline functions in the QtOpenCL headers always reference count
+// through these, so provide them when OpenCL is linked directly as well.
+#define QT_CL_DEFINE_FUNCTION(type, name) \
+    cl_int qt_##name(type id) \
+    { \
+        return name(id); \
+    }
+QT_CL_DEFINE_FUNCTION(cl_command_queue, clRetainCommandQueue)
+QT_CL_DEFINE_FUNCTION(cl_command_queue, clReleaseCommandQueue)
+QT_CL_DEFINE_FUNCTION(cl_mem, clRetainMemObject)
+QT_CL_DEFINE_FUNCTION(cl_mem, clReleaseMemObject)
+QT_CL_DEFINE_FUNCTION(cl_sampler, clRetainSampler)
+QT_CL_DEFINE_FUNCTION(cl_sampler, clReleaseSampler)
+QT_CL_DEFINE_FUNCTION(cl_program, clRetainProgram)
+QT_CL_DEFINE_FUNCTION(cl_program, clReleaseProgram)
+QT_CL_DEFINE_FUNCTION(cl_event, clRetainEvent)
+QT_CL_DEFINE_FUNCTION(cl_event, clReleaseEvent)
+#undef QT_CL_DEFINE_FUNCTION
+
+QT_END_NAMESPACE
+
+#endif // QT_OPENCL_DYNAMIC
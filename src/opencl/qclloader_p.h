@@ -0,0 +1,513 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCLLOADER_P_H
+#define QCLLOADER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of the QtOpenCL library.  This header file may change from version
+// to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qclext_p.h"
+
+#ifdef QT_OPENCL_DYNAMIC
+
+#include <CL/cl_gl.h>
+
+// The OpenCL entry points that QtOpenCL and QtOpenCLGL call.  Each entry
+// gives the return type, name, parameters, arguments, and the statements
+// that report failure when the entry point is not available.
+#define QT_CL_FUNCTIONS_1_0(F) \
+    F(cl_int, clGetPlatformIDs,\
+      (cl_uint num_entries, cl_platform_id *platforms, cl_uint *num_platforms),\
+      (num_entries, platforms, num_platforms),\
+      if (num_platforms) *num_platforms = 0; return CL_PLATFORM_NOT_FOUND_KHR;) \
+    F(cl_int, clGetPlatformInfo,\
+      (cl_platform_id platform, cl_platform_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (platform, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetDeviceIDs,\
+      (cl_platform_id platform, cl_device_type device_type, cl_uint num_entries, cl_device_id *devices, cl_uint *num_devices),\
+      (platform, device_type, num_entries, devices, num_devices),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetDeviceInfo,\
+      (cl_device_id device, cl_device_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (device, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_context, clCreateContext,\
+      (const cl_context_properties *properties, cl_uint num_devices, const cl_device_id *devices, void (CL_CALLBACK *pfn_notify)(const char *, const void *, size_t, void *), void *user_data, cl_int *errcode_ret),\
+      (properties, num_devices, devices, pfn_notify, user_data, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_int, clRetainContext,\
+      (cl_context context),\
+      (context),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clReleaseContext,\
+      (cl_context context),\
+      (context),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetContextInfo,\
+      (cl_context context, cl_context_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (context, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_command_queue, clCreateCommandQueue,\
+      (cl_context context, cl_device_id device, cl_command_queue_properties properties, cl_int *errcode_ret),\
+      (context, device, properties, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_int, clRetainCommandQueue,\
+      (cl_command_queue command_queue),\
+      (command_queue),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clReleaseCommandQueue,\
+      (cl_command_queue command_queue),\
+      (command_queue),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetCommandQueueInfo,\
+      (cl_command_queue command_queue, cl_command_queue_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (command_queue, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_mem, clCreateBuffer,\
+      (cl_context context, cl_mem_flags flags, size_t size, void *host_ptr, cl_int *errcode_ret),\
+      (context, flags, size, host_ptr, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_mem, clCreateImage2D,\
+      (cl_context context, cl_mem_flags flags, const cl_image_format *image_format, size_t image_width, size_t image_height, size_t image_row_pitch, void *host_ptr, cl_int *errcode_ret),\
+      (context, flags, image_format, image_width, image_height, image_row_pitch, host_ptr, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_mem, clCreateImage3D,\
+      (cl_context context, cl_mem_flags flags, const cl_image_format *image_format, size_t image_width, size_t image_height, size_t image_depth, size_t image_row_pitch, size_t image_slice_pitch, void *host_ptr, cl_int *errcode_ret),\
+      (context, flags, image_format, image_width, image_height, image_depth, image_row_pitch, image_slice_pitch, host_ptr, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_int, clRetainMemObject,\
+      (cl_mem memobj),\
+      (memobj),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clReleaseMemObject,\
+      (cl_mem memobj),\
+      (memobj),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetSupportedImageFormats,\
+      (cl_context context, cl_mem_flags flags, cl_mem_object_type image_type, cl_uint num_entries, cl_image_format *image_formats, cl_uint *num_image_formats),\
+      (context, flags, image_type, num_entries, image_formats, num_image_formats),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetMemObjectInfo,\
+      (cl_mem memobj, cl_mem_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (memobj, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetImageInfo,\
+      (cl_mem image, cl_image_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (image, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_sampler, clCreateSampler,\
+      (cl_context context, cl_bool normalized_coords, cl_addressing_mode addressing_mode, cl_filter_mode filter_mode, cl_int *errcode_ret),\
+      (context, normalized_coords, addressing_mode, filter_mode, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_int, clRetainSampler,\
+      (cl_sampler sampler),\
+      (sampler),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clReleaseSampler,\
+      (cl_sampler sampler),\
+      (sampler),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetSamplerInfo,\
+      (cl_sampler sampler, cl_sampler_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (sampler, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_program, clCreateProgramWithSource,\
+      (cl_context context, cl_uint count, const char **strings, const size_t *lengths, cl_int *errcode_ret),\
+      (context, count, strings, lengths, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_program, clCreateProgramWithBinary,\
+      (cl_context context, cl_uint num_devices, const cl_device_id *device_list, const size_t *lengths, const unsigned char **binaries, cl_int *binary_status, cl_int *errcode_ret),\
+      (context, num_devices, device_list, lengths, binaries, binary_status, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_int, clRetainProgram,\
+      (cl_program program),\
+      (program),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clReleaseProgram,\
+      (cl_program program),\
+      (program),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clBuildProgram,\
+      (cl_program program, cl_uint num_devices, const cl_device_id *device_list, const char *options, void (CL_CALLBACK *pfn_notify)(cl_program, void *), void *user_data),\
+      (program, num_devices, device_list, options, pfn_notify, user_data),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clUnloadCompiler,\
+      (void),\
+      (),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetProgramInfo,\
+      (cl_program program, cl_program_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (program, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetProgramBuildInfo,\
+      (cl_program program, cl_device_id device, cl_program_build_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (program, device, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_kernel, clCreateKernel,\
+      (cl_program program, const char *kernel_name, cl_int *errcode_ret),\
+      (program, kernel_name, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_int, clCreateKernelsInProgram,\
+      (cl_program program, cl_uint num_kernels, cl_kernel *kernels, cl_uint *num_kernels_ret),\
+      (program, num_kernels, kernels, num_kernels_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clRetainKernel,\
+      (cl_kernel kernel),\
+      (kernel),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clReleaseKernel,\
+      (cl_kernel kernel),\
+      (kernel),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clSetKernelArg,\
+      (cl_kernel kernel, cl_uint arg_index, size_t arg_size, const void *arg_value),\
+      (kernel, arg_index, arg_size, arg_value),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetKernelInfo,\
+      (cl_kernel kernel, cl_kernel_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (kernel, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetKernelWorkGroupInfo,\
+      (cl_kernel kernel, cl_device_id device, cl_kernel_work_group_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (kernel, device, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clWaitForEvents,\
+      (cl_uint num_events, const cl_event *event_list),\
+      (num_events, event_list),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetEventInfo,\
+      (cl_event event, cl_event_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (event, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clRetainEvent,\
+      (cl_event event),\
+      (event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clReleaseEvent,\
+      (cl_event event),\
+      (event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clGetEventProfilingInfo,\
+      (cl_event event, cl_profiling_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (event, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clFlush,\
+      (cl_command_queue command_queue),\
+      (command_queue),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clFinish,\
+      (cl_command_queue command_queue),\
+      (command_queue),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueReadBuffer,\
+      (cl_command_queue command_queue, cl_mem buffer, cl_bool blocking_read, size_t offset, size_t size, void *ptr, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, buffer, blocking_read, offset, size, ptr, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueWriteBuffer,\
+      (cl_command_queue command_queue, cl_mem buffer, cl_bool blocking_write, size_t offset, size_t size, const void *ptr, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, buffer, blocking_write, offset, size, ptr, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueCopyBuffer,\
+      (cl_command_queue command_queue, cl_mem src_buffer, cl_mem dst_buffer, size_t src_offset, size_t dst_offset, size_t size, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, src_buffer, dst_buffer, src_offset, dst_offset, size, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueReadImage,\
+      (cl_command_queue command_queue, cl_mem image, cl_bool blocking_read, const size_t *origin, const size_t *region, size_t row_pitch, size_t slice_pitch, void *ptr, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, image, blocking_read, origin, region, row_pitch, slice_pitch, ptr, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueWriteImage,\
+      (cl_command_queue command_queue, cl_mem image, cl_bool blocking_write, const size_t *origin, const size_t *region, size_t input_row_pitch, size_t input_slice_pitch, const void *ptr, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, image, blocking_write, origin, region, input_row_pitch, input_slice_pitch, ptr, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueCopyImage,\
+      (cl_command_queue command_queue, cl_mem src_image, cl_mem dst_image, const size_t *src_origin, const size_t *dst_origin, const size_t *region, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, src_image, dst_image, src_origin, dst_origin, region, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueCopyImageToBuffer,\
+      (cl_command_queue command_queue, cl_mem src_image, cl_mem dst_buffer, const size_t *src_origin, const size_t *region, size_t dst_offset, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, src_image, dst_buffer, src_origin, region, dst_offset, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueCopyBufferToImage,\
+      (cl_command_queue command_queue, cl_mem src_buffer, cl_mem dst_image, size_t src_offset, const size_t *dst_origin, const size_t *region, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, src_buffer, dst_image, src_offset, dst_origin, region, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(void *, clEnqueueMapBuffer,\
+      (cl_command_queue command_queue, cl_mem buffer, cl_bool blocking_map, cl_map_flags map_flags, size_t offset, size_t size, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event, cl_int *errcode_ret),\
+      (command_queue, buffer, blocking_map, map_flags, offset, size, num_events_in_wait_list, event_wait_list, event, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(void *, clEnqueueMapImage,\
+      (cl_command_queue command_queue, cl_mem image, cl_bool blocking_map, cl_map_flags map_flags, const size_t *origin, const size_t *region, size_t *image_row_pitch, size_t *image_slice_pitch, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event, cl_int *errcode_ret),\
+      (command_queue, image, blocking_map, map_flags, origin, region, image_row_pitch, image_slice_pitch, num_events_in_wait_list, event_wait_list, event, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_int, clEnqueueUnmapMemObject,\
+      (cl_command_queue command_queue, cl_mem memobj, void *mapped_ptr, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, memobj, mapped_ptr, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueNDRangeKernel,\
+      (cl_command_queue command_queue, cl_kernel kernel, cl_uint work_dim, const size_t *global_work_offset, const size_t *global_work_size, const size_t *local_work_size, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, kernel, work_dim, global_work_offset, global_work_size, local_work_size, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueTask,\
+      (cl_command_queue command_queue, cl_kernel kernel, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, kernel, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueNativeKernel,\
+      (cl_command_queue command_queue, void (CL_CALLBACK *user_func)(void *), void *args, size_t cb_args, cl_uint num_mem_objects, const cl_mem *mem_list, const void **args_mem_loc, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, user_func, args, cb_args, num_mem_objects, mem_list, args_mem_loc, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueMarker,\
+      (cl_command_queue command_queue, cl_event *event),\
+      (command_queue, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueWaitForEvents,\
+      (cl_command_queue command_queue, cl_uint num_events, const cl_event *event_list),\
+      (command_queue, num_events, event_list),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueBarrier,\
+      (cl_command_queue command_queue),\
+      (command_queue),\
+      return CL_INVALID_OPERATION;) \
+    F(void *, clGetExtensionFunctionAddress,\
+      (const char *func_name),\
+      (func_name),\
+      return 0;)
+
+#ifdef CL_VERSION_1_1
+#define QT_CL_FUNCTIONS_1_1(F) \
+    F(cl_mem, clCreateSubBuffer,\
+      (cl_mem buffer, cl_mem_flags flags, cl_buffer_create_type buffer_create_type, const void *buffer_create_info, cl_int *errcode_ret),\
+      (buffer, flags, buffer_create_type, buffer_create_info, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_event, clCreateUserEvent,\
+      (cl_context context, cl_int *errcode_ret),\
+      (context, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_int, clSetUserEventStatus,\
+      (cl_event event, cl_int execution_status),\
+      (event, execution_status),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clSetEventCallback,\
+      (cl_event event, cl_int command_exec_callback_type, void (CL_CALLBACK *pfn_notify)(cl_event, cl_int, void *), void *user_data),\
+      (event, command_exec_callback_type, pfn_notify, user_data),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueReadBufferRect,\
+      (cl_command_queue command_queue, cl_mem buffer, cl_bool blocking_read, const size_t *buffer_offset, const size_t *host_offset, const size_t *region, size_t buffer_row_pitch, size_t buffer_slice_pitch, size_t host_row_pitch, size_t host_slice_pitch, void *ptr, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, buffer, blocking_read, buffer_offset, host_offset, region, buffer_row_pitch, buffer_slice_pitch, host_row_pitch, host_slice_pitch, ptr, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueWriteBufferRect,\
+      (cl_command_queue command_queue, cl_mem buffer, cl_bool blocking_write, const size_t *buffer_offset, const size_t *host_offset, const size_t *region, size_t buffer_row_pitch, size_t buffer_slice_pitch, size_t host_row_pitch, size_t host_slice_pitch, const void *ptr, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, buffer, blocking_write, buffer_offset, host_offset, region, buffer_row_pitch, buffer_slice_pitch, host_row_pitch, host_slice_pitch, ptr, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueCopyBufferRect,\
+      (cl_command_queue command_queue, cl_mem src_buffer, cl_mem dst_buffer, const size_t *src_origin, const size_t *dst_origin, const size_t *region, size_t src_row_pitch, size_t src_slice_pitch, size_t dst_row_pitch, size_t dst_slice_pitch, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, src_buffer, dst_buffer, src_origin, dst_origin, region, src_row_pitch, src_slice_pitch, dst_row_pitch, dst_slice_pitch, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;)
+#else
+#define QT_CL_FUNCTIONS_1_1(F)
+#endif
+
+#ifdef CL_VERSION_1_2
+#define QT_CL_FUNCTIONS_1_2(F) \
+    F(cl_int, clGetKernelArgInfo,\
+      (cl_kernel kernel, cl_uint arg_index, cl_kernel_arg_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),\
+      (kernel, arg_index, param_name, param_value_size, param_value, param_value_size_ret),\
+      return CL_INVALID_OPERATION;)
+#else
+#define QT_CL_FUNCTIONS_1_2(F)
+#endif
+
+// Sharing with OpenGL, which QtOpenCLGL uses.
+#define QT_CL_FUNCTIONS_GL(F) \
+    F(cl_mem, clCreateFromGLBuffer,\
+      (cl_context context, cl_mem_flags flags, cl_GLuint bufobj, cl_int *errcode_ret),\
+      (context, flags, bufobj, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_mem, clCreateFromGLTexture2D,\
+      (cl_context context, cl_mem_flags flags, cl_GLenum target, cl_GLint miplevel, cl_GLuint texture, cl_int *errcode_ret),\
+      (context, flags, target, miplevel, texture, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_mem, clCreateFromGLTexture3D,\
+      (cl_context context, cl_mem_flags flags, cl_GLenum target, cl_GLint miplevel, cl_GLuint texture, cl_int *errcode_ret),\
+      (context, flags, target, miplevel, texture, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_mem, clCreateFromGLRenderbuffer,\
+      (cl_context context, cl_mem_flags flags, cl_GLuint renderbuffer, cl_int *errcode_ret),\
+      (context, flags, renderbuffer, errcode_ret),\
+      if (errcode_ret) *errcode_ret = CL_INVALID_OPERATION; return 0;) \
+    F(cl_int, clGetGLObjectInfo,\
+      (cl_mem memobj, cl_gl_object_type *gl_object_type, cl_GLuint *gl_object_name),\
+      (memobj, gl_object_type, gl_object_name),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueAcquireGLObjects,\
+      (cl_command_queue command_queue, cl_uint num_objects, const cl_mem *mem_objects, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, num_objects, mem_objects, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;) \
+    F(cl_int, clEnqueueReleaseGLObjects,\
+      (cl_command_queue command_queue, cl_uint num_objects, const cl_mem *mem_objects, cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event),\
+      (command_queue, num_objects, mem_objects, num_events_in_wait_list, event_wait_list, event),\
+      return CL_INVALID_OPERATION;)
+
+#define QT_CL_FUNCTIONS(F) \
+    QT_CL_FUNCTIONS_1_0(F) \
+    QT_CL_FUNCTIONS_1_1(F) \
+    QT_CL_FUNCTIONS_1_2(F) \
+    QT_CL_FUNCTIONS_GL(F)
+
+QT_BEGIN_NAMESPACE
+
+// Loads the OpenCL library the first time that it is called, and
+// returns true if it was loaded.  Defined in qclloader.cpp.
+bool qt_cl_library_loaded();
+
+// Returns the address of the OpenCL entry point "name", or null if the
+// library or the entry point is not available.
+QFunctionPointer qt_cl_resolve(const char *name);
+
+// Forwarders for each of the entry points above, defined in qclloader.cpp.
+// They have a "qt_" prefix so that QtOpenCL does not export the OpenCL API
+// under its standard names and clash with the real OpenCL library.
+#define QT_CL_DECLARE_FUNCTION(ret, name, params, args, fail) \
+    Q_CL_EXPORT ret qt_##name params;
+QT_CL_FUNCTIONS(QT_CL_DECLARE_FUNCTION)
+#undef QT_CL_DECLARE_FUNCTION
+
+QT_END_NAMESPACE
+
+// Send the OpenCL calls in the rest of the module to the forwarders.
+#ifndef QT_CL_LOADER
+#define clGetPlatformIDs QT_PREPEND_NAMESPACE(qt_clGetPlatformIDs)
+#define clGetPlatformInfo QT_PREPEND_NAMESPACE(qt_clGetPlatformInfo)
+#define clGetDeviceIDs QT_PREPEND_NAMESPACE(qt_clGetDeviceIDs)
+#define clGetDeviceInfo QT_PREPEND_NAMESPACE(qt_clGetDeviceInfo)
+#define clCreateContext QT_PREPEND_NAMESPACE(qt_clCreateContext)
+#define clRetainContext QT_PREPEND_NAMESPACE(qt_clRetainContext)
+#define clReleaseContext QT_PREPEND_NAMESPACE(qt_clReleaseContext)
+#define clGetContextInfo QT_PREPEND_NAMESPACE(qt_clGetContextInfo)
+#define clCreateCommandQueue QT_PREPEND_NAMESPACE(qt_clCreateCommandQueue)
+#define clRetainCommandQueue QT_PREPEND_NAMESPACE(qt_clRetainCommandQueue)
+#define clReleaseCommandQueue QT_PREPEND_NAMESPACE(qt_clReleaseCommandQueue)
+#define clGetCommandQueueInfo QT_PREPEND_NAMESPACE(qt_clGetCommandQueueInfo)
+#define clCreateBuffer QT_PREPEND_NAMESPACE(qt_clCreateBuffer)
+#define clCreateImage2D QT_PREPEND_NAMESPACE(qt_clCreateImage2D)
+#define clCreateImage3D QT_PREPEND_NAMESPACE(qt_clCreateImage3D)
+#define clRetainMemObject QT_PREPEND_NAMESPACE(qt_clRetainMemObject)
+#define clReleaseMemObject QT_PREPEND_NAMESPACE(qt_clReleaseMemObject)
+#define clGetSupportedImageFormats QT_PREPEND_NAMESPACE(qt_clGetSupportedImageFormats)
+#define clGetMemObjectInfo QT_PREPEND_NAMESPACE(qt_clGetMemObjectInfo)
+#define clGetImageInfo QT_PREPEND_NAMESPACE(qt_clGetImageInfo)
+#define clCreateSampler QT_PREPEND_NAMESPACE(qt_clCreateSampler)
+#define clRetainSampler QT_PREPEND_NAMESPACE(qt_clRetainSampler)
+#define clReleaseSampler QT_PREPEND_NAMESPACE(qt_clReleaseSampler)
+#define clGetSamplerInfo QT_PREPEND_NAMESPACE(qt_clGetSamplerInfo)
+#define clCreateProgramWithSource QT_PREPEND_NAMESPACE(qt_clCreateProgramWithSource)
+#define clCreateProgramWithBinary QT_PREPEND_NAMESPACE(qt_clCreateProgramWithBinary)
+#define clRetainProgram QT_PREPEND_NAMESPACE(qt_clRetainProgram)
+#define clReleaseProgram QT_PREPEND_NAMESPACE(qt_clReleaseProgram)
+#define clBuildProgram QT_PREPEND_NAMESPACE(qt_clBuildProgram)
+#define clUnloadCompiler QT_PREPEND_NAMESPACE(qt_clUnloadCompiler)
+#define clGetProgramInfo QT_PREPEND_NAMESPACE(qt_clGetProgramInfo)
+#define clGetProgramBuildInfo QT_PREPEND_NAMESPACE(qt_clGetProgramBuildInfo)
+#define clCreateKernel QT_PREPEND_NAMESPACE(qt_clCreateKernel)
+#define clCreateKernelsInProgram QT_PREPEND_NAMESPACE(qt_clCreateKernelsInProgram)
+#define clRetainKernel QT_PREPEND_NAMESPACE(qt_clRetainKernel)
+#define clReleaseKernel QT_PREPEND_NAMESPACE(qt_clReleaseKernel)
+#define clSetKernelArg QT_PREPEND_NAMESPACE(qt_clSetKernelArg)
+#define clGetKernelInfo QT_PREPEND_NAMESPACE(qt_clGetKernelInfo)
+#define clGetKernelWorkGroupInfo QT_PREPEND_NAMESPACE(qt_clGetKernelWorkGroupInfo)
+#define clWaitForEvents QT_PREPEND_NAMESPACE(qt_clWaitForEvents)
+#define clGetEventInfo QT_PREPEND_NAMESPACE(qt_clGetEventInfo)
+#define clRetainEvent QT_PREPEND_NAMESPACE(qt_clRetainEvent)
+#define clReleaseEvent QT_PREPEND_NAMESPACE(qt_clReleaseEvent)
+#define clGetEventProfilingInfo QT_PREPEND_NAMESPACE(qt_clGetEventProfilingInfo)
+#define clFlush QT_PREPEND_NAMESPACE(qt_clFlush)
+#define clFinish QT_PREPEND_NAMESPACE(qt_clFinish)
+#define clEnqueueReadBuffer QT_PREPEND_NAMESPACE(qt_clEnqueueReadBuffer)
+#define clEnqueueWriteBuffer QT_PREPEND_NAMESPACE(qt_clEnqueueWriteBuffer)
+#define clEnqueueCopyBuffer QT_PREPEND_NAMESPACE(qt_clEnqueueCopyBuffer)
+#define clEnqueueReadImage QT_PREPEND_NAMESPACE(qt_clEnqueueReadImage)
+#define clEnqueueWriteImage QT_PREPEND_NAMESPACE(qt_clEnqueueWriteImage)
+#define clEnqueueCopyImage QT_PREPEND_NAMESPACE(qt_clEnqueueCopyImage)
+#define clEnqueueCopyImageToBuffer QT_PREPEND_NAMESPACE(qt_clEnqueueCopyImageToBuffer)
+#define clEnqueueCopyBufferToImage QT_PREPEND_NAMESPACE(qt_clEnqueueCopyBufferToImage)
+#define clEnqueueMapBuffer QT_PREPEND_NAMESPACE(qt_clEnqueueMapBuffer)
+#define clEnqueueMapImage QT_PREPEND_NAMESPACE(qt_clEnqueueMapImage)
+#define clEnqueueUnmapMemObject QT_PREPEND_NAMESPACE(qt_clEnqueueUnmapMemObject)
+#define clEnqueueNDRangeKernel QT_PREPEND_NAMESPACE(qt_clEnqueueNDRangeKernel)
+#define clEnqueueTask QT_PREPEND_NAMESPACE(qt_clEnqueueTask)
+#define clEnqueueNativeKernel QT_PREPEND_NAMESPACE(qt_clEnqueueNativeKernel)
+#define clEnqueueMarker QT_PREPEND_NAMESPACE(qt_clEnqueueMarker)
+#define clEnqueueWaitForEvents QT_PREPEND_NAMESPACE(qt_clEnqueueWaitForEvents)
+#define clEnqueueBarrier QT_PREPEND_NAMESPACE(qt_clEnqueueBarrier)
+#define clGetExtensionFunctionAddress QT_PREPEND_NAMESPACE(qt_clGetExtensionFunctionAddress)
+#ifdef CL_VERSION_1_1
+#define clCreateSubBuffer QT_PREPEND_NAMESPACE(qt_clCreateSubBuffer)
+#define clCreateUserEvent QT_PREPEND_NAMESPACE(qt_clCreateUserEvent)
+#define clSetUserEventStatus QT_PREPEND_NAMESPACE(qt_clSetUserEventStatus)
+#define clSetEventCallback QT_PREPEND_NAMESPACE(qt_clSetEventCallback)
+#define clEnqueueReadBufferRect QT_PREPEND_NAMESPACE(qt_clEnqueueReadBufferRect)
+#define clEnqueueWriteBufferRect QT_PREPEND_NAMESPACE(qt_clEnqueueWriteBufferRect)
+#define clEnqueueCopyBufferRect QT_PREPEND_NAMESPACE(qt_clEnqueueCopyBufferRect)
+#endif
+#ifdef CL_VERSION_1_2
+#define clGetKernelArgInfo QT_PREPEND_NAMESPACE(qt_clGetKernelArgInfo)
+#endif
+#define clCreateFromGLBuffer QT_PREPEND_NAMESPACE(qt_clCreateFromGLBuffer)
+#define clCreateFromGLTexture2D QT_PREPEND_NAMESPACE(qt_clCreateFromGLTexture2D)
+#define clCreateFromGLTexture3D QT_PREPEND_NAMESPACE(qt_clCreateFromGLTexture3D)
+#define clCreateFromGLRenderbuffer QT_PREPEND_NAMESPACE(qt_clCreateFromGLRenderbuffer)
+#define clGetGLObjectInfo QT_PREPEND_NAMESPACE(qt_clGetGLObjectInfo)
+#define clEnqueueAcquireGLObjects QT_PREPEND_NAMESPACE(qt_clEnqueueAcquireGLObjects)
+#define clEnqueueReleaseGLObjects QT_PREPEND_NAMESPACE(qt_clEnqueueReleaseGLObjects)
+#endif
+
+#endif
+
+#endif
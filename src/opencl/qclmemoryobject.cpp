@@ -41,6 +41,7 @@
 
 #include "qclmemoryobject.h"
 #include "qclcontext.h"
+#include "qclloader_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -184,6 +185,7 @@ void QCLMemoryObject::unmap(void *ptr)
     cl_int error = clEnqueueUnmapMemObject
         (context()->activeQueue(), memoryId(), ptr, 0, 0, &event);
     context()->reportError("QCLMemoryObject::unmap:", error);
+    context()->recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS) {
         clWaitForEvents(1, &event);
         clReleaseEvent(event);
@@ -205,11 +207,12 @@ void QCLMemoryObject::unmap(void *ptr)
 */
 QCLEvent QCLMemoryObject::unmapAsync(void *ptr, const QCLEventList &after)
 {
-    cl_event event;
+    cl_event event = 0;
     cl_int error = clEnqueueUnmapMemObject
         (context()->activeQueue(), memoryId(), ptr,
         after.size(), after.eventData(), &event);
     context()->reportError("QCLMemoryObject::unmapAsync:", error);
+    context()->recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
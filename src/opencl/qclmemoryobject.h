@@ -98,7 +98,7 @@ private:
 inline QCLMemoryObject::~QCLMemoryObject()
 {
     if (m_id)
-        clReleaseMemObject(m_id);
+        qt_clReleaseMemObject(m_id);
 }
 
 inline bool QCLMemoryObject::operator==(const QCLMemoryObject &other) const
@@ -115,9 +115,9 @@ inline void QCLMemoryObject::setId(QCLContext *context, cl_mem id)
 {
     m_context = context;
     if (id)
-        clRetainMemObject(id);
+        qt_clRetainMemObject(id);
     if (m_id)
-        clReleaseMemObject(m_id);
+        qt_clReleaseMemObject(m_id);
     m_id = id;
 }
 
@@ -41,6 +41,8 @@
 
 #include "qclplatform.h"
 #include "qclext_p.h"
+#include "qclproperties_p.h"
+#include "qclloader_p.h"
 #include <QtCore/qvarlengtharray.h>
 #include <QtCore/qdebug.h>
 
@@ -118,20 +120,47 @@ static QString qt_cl_platform_string(cl_platform_id id, cl_platform_info name)
     return QString::fromLatin1(buf.data());
 }
 
-static bool qt_cl_is_platform
-    (cl_platform_id id, cl_platform_info name, const char *str)
+// Defined in qcldevice.cpp.
+int qt_cl_version_flags(const QString &version);
+
+// Snapshot of the properties of a platform; see QCLDeviceProperties.
+struct QCLPlatformProperties
 {
-    size_t len = qstrlen(str);
-    size_t size;
-    if (!id || clGetPlatformInfo(id, name, 0, 0, &size) != CL_SUCCESS)
-        return false;
-    if (size <= len)
-        return false;
-    QVarLengthArray<char> buf(size);
-    clGetPlatformInfo(id, name, size, buf.data(), &size);
-    if (qstrncmp(buf.constData(), str, len) != 0)
-        return false;
-    return buf[len] == '\0';
+    QCLPlatformProperties(cl_platform_id id);
+
+    QString profile;
+    QString version;
+    QString name;
+    QString vendor;
+    QString extensionSuffix;
+    QByteArray extensionData;
+    QStringList extensions;
+    int versionFlags;
+};
+
+QCLPlatformProperties::QCLPlatformProperties(cl_platform_id id)
+{
+    profile = qt_cl_platform_string(id, CL_PLATFORM_PROFILE);
+    version = qt_cl_platform_string(id, CL_PLATFORM_VERSION);
+    name = qt_cl_platform_string(id, CL_PLATFORM_NAME);
+    vendor = qt_cl_platform_string(id, CL_PLATFORM_VENDOR);
+    extensionSuffix = qt_cl_platform_string(id, CL_PLATFORM_ICD_SUFFIX_KHR);
+    versionFlags = qt_cl_version_flags(version);
+
+    QString extns = qt_cl_platform_string(id, CL_PLATFORM_EXTENSIONS).simplified();
+    extensionData = extns.toLatin1();
+    if (!extns.isEmpty())
+        extensions = extns.split(QChar(' '));
+}
+
+typedef QCLPropertyRegistry<cl_platform_id, QCLPlatformProperties> QCLPlatformRegistry;
+Q_GLOBAL_STATIC(QCLPlatformRegistry, qt_cl_platform_registry)
+
+// Returns the property snapshot for a platform, creating it the
+// first time that any QCLPlatform object asks for it.
+static inline const QCLPlatformProperties *qt_cl_platform_properties(cl_platform_id id)
+{
+    return qt_cl_platform_registry()->find(id);
 }
 
 /*!
@@ -141,7 +170,7 @@ static bool qt_cl_is_platform
 */
 bool QCLPlatform::isFullProfile() const
 {
-    return qt_cl_is_platform(m_id, CL_PLATFORM_PROFILE, "FULL_PROFILE");
+    return qt_cl_platform_properties(m_id)->profile == QLatin1String("FULL_PROFILE");
 }
 
 /*!
@@ -151,7 +180,7 @@ bool QCLPlatform::isFullProfile() const
 */
 bool QCLPlatform::isEmbeddedProfile() const
 {
-    return qt_cl_is_platform(m_id, CL_PLATFORM_PROFILE, "EMBEDDED_PROFILE");
+    return qt_cl_platform_properties(m_id)->profile == QLatin1String("EMBEDDED_PROFILE");
 }
 
 /*!
@@ -162,7 +191,7 @@ bool QCLPlatform::isEmbeddedProfile() const
 */
 QString QCLPlatform::profile() const
 {
-    return qt_cl_platform_string(m_id, CL_PLATFORM_PROFILE);
+    return qt_cl_platform_properties(m_id)->profile;
 }
 
 /*!
@@ -176,7 +205,7 @@ QString QCLPlatform::profile() const
 */
 QString QCLPlatform::version() const
 {
-    return qt_cl_platform_string(m_id, CL_PLATFORM_VERSION);
+    return qt_cl_platform_properties(m_id)->version;
 }
 
 /*!
@@ -184,7 +213,7 @@ QString QCLPlatform::version() const
 */
 QString QCLPlatform::name() const
 {
-    return qt_cl_platform_string(m_id, CL_PLATFORM_NAME);
+    return qt_cl_platform_properties(m_id)->name;
 }
 
 /*!
@@ -192,7 +221,7 @@ QString QCLPlatform::name() const
 */
 QString QCLPlatform::vendor() const
 {
-    return qt_cl_platform_string(m_id, CL_PLATFORM_VENDOR);
+    return qt_cl_platform_properties(m_id)->vendor;
 }
 
 /*!
@@ -201,7 +230,7 @@ QString QCLPlatform::vendor() const
 */
 QString QCLPlatform::extensionSuffix() const
 {
-    return qt_cl_platform_string(m_id, CL_PLATFORM_ICD_SUFFIX_KHR);
+    return qt_cl_platform_properties(m_id)->extensionSuffix;
 }
 
 /*!
@@ -211,13 +240,7 @@ QString QCLPlatform::extensionSuffix() const
 */
 QStringList QCLPlatform::extensions() const
 {
-    if (!m_id)
-        return QStringList();
-    QString extns = qt_cl_platform_string(m_id, CL_PLATFORM_EXTENSIONS).simplified();
-    if (!extns.isEmpty())
-        return extns.split(QChar(' '));
-    else
-        return QStringList();
+    return qt_cl_platform_properties(m_id)->extensions;
 }
 
 // Defined in qcldevice.cpp.
@@ -236,14 +259,8 @@ bool qt_cl_has_extension(const char *list, size_t listLen, const char *name);
 */
 bool QCLPlatform::hasExtension(const char *name) const
 {
-    size_t size;
-    if (!m_id || clGetPlatformInfo(m_id, CL_PLATFORM_EXTENSIONS,
-                                   0, 0, &size) != CL_SUCCESS)
-        return false;
-    QVarLengthArray<char> buf(size);
-    clGetPlatformInfo(m_id, CL_PLATFORM_EXTENSIONS, size,
-                      buf.data(), &size);
-    return qt_cl_has_extension(buf.constData(), size, name);
+    const QByteArray &extns = qt_cl_platform_properties(m_id)->extensionData;
+    return qt_cl_has_extension(extns.constData(), extns.size(), name);
 }
 
 /*!
@@ -252,11 +269,9 @@ bool QCLPlatform::hasExtension(const char *name) const
 
     \value Version_1_0 OpenCL 1.0 is supported.
     \value Version_1_1 OpenCL 1.1 is supported.
+    \value Version_1_2 OpenCL 1.2 is supported.
 */
 
-// Defined in qcldevice.cpp.
-int qt_cl_version_flags(const QString &version);
-
 /*!
     Returns the OpenCL versions supported by this platform.
 
@@ -264,11 +279,7 @@ int qt_cl_version_flags(const QString &version);
 */
 QCLPlatform::VersionFlags QCLPlatform::versionFlags() const
 {
-    if (!m_flags) {
-        m_flags = qt_cl_version_flags
-            (qt_cl_platform_string(m_id, CL_PLATFORM_VERSION));
-    }
-    return QCLPlatform::VersionFlags(m_flags);
+    return QCLPlatform::VersionFlags(qt_cl_platform_properties(m_id)->versionFlags);
 }
 
 /*!
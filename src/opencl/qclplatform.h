@@ -76,7 +76,8 @@ public:
     enum VersionFlag
     {
         Version_1_0     = 0x0001,
-        Version_1_1     = 0x0002
+        Version_1_1     = 0x0002,
+        Version_1_2     = 0x0004
     };
     Q_DECLARE_FLAGS(VersionFlags, VersionFlag)
 
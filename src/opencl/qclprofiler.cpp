@@ -0,0 +1,526 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qclprofiler.h"
+#include "qclcontext.h"
+#include "qclext_p.h"
+#include "qclloader_p.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qvarlengtharray.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qjsondocument.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QCLProfiler
+    \brief The QCLProfiler class records the commands submitted to a QCLContext as a timeline.
+    \since 4.7
+    \ingroup opencl
+
+    QCLProfiler is an opt-in recorder for all of the queue activity
+    of a context: kernel launches, buffer and image reads, writes and
+    copies, maps and unmaps, and the acquisition and release of
+    OpenGL objects by QCLContextGL.  The recorded commands can be
+    exported with toTrace() or saveTrace() in the Chrome trace event
+    format, which can be loaded into \c{chrome://tracing} or the
+    Perfetto UI to see when each command ran on the device.
+
+    \code
+    QCLProfiler profiler(&context);
+    profiler.start();
+    ...
+    kernel(buffer);
+    buffer.read(data, size);
+    ...
+    profiler.stop();
+    profiler.saveTrace(QLatin1String("frame.json"));
+    \endcode
+
+    While the profiler is recording, command queues that the context
+    creates have CL_QUEUE_PROFILING_ENABLE set, and the context-wide
+    command queue is replaced with a profiling queue if necessary.
+    Commands that were enqueued without an event, such as blocking
+    reads and QCLKernel::runDetached(), are given one so that they
+    can be timed.  Commands on queues that were created without
+    profiling before start() was called, such as thread queues and
+    the queue pool, are recorded but omitted from the trace because
+    the device does not report their timings.
+
+    Each command queue appears as a separate track in the trace,
+    named after the device it runs on.  Kernel launches are labelled
+    with the name of the kernel, and other commands with the kind of
+    operation.  When a command waited for the events in a QCLEventList
+    that were also recorded, the trace contains a flow arrow from each
+    of those commands to the one that waited for them.
+
+    Only one profiler can record on a context at a time.  Recording
+    has a cost on the host and the device, so a profiler should only
+    be active while a trace is wanted.
+
+    \sa QCLEvent::runTime(), QCLCommandQueue::isProfilingEnabled()
+*/
+
+struct QCLProfilerRecord
+{
+    QCLEvent event;
+    cl_kernel kernel;
+    QVector<int> dependencies;
+};
+
+class QCLProfilerPrivate
+{
+public:
+    QCLProfilerPrivate(QCLContext *ctx)
+        : context(ctx), active(false) {}
+
+    QCLContext *context;
+    bool active;
+    mutable QMutex lock;
+    QList<QCLProfilerRecord> records;
+    QHash<cl_event, int> indexes;
+    QHash<cl_kernel, QString> kernelNames;
+};
+
+/*!
+    Constructs a profiler for \a context.  The profiler does not
+    record anything until start() is called.
+*/
+QCLProfiler::QCLProfiler(QCLContext *context)
+    : d_ptr(new QCLProfilerPrivate(context))
+{
+}
+
+/*!
+    Stops recording and destroys this profiler.
+
+    \sa stop()
+*/
+QCLProfiler::~QCLProfiler()
+{
+    stop();
+    clear();
+}
+
+/*!
+    Returns the context that this profiler records, or null if the
+    context has been destroyed.
+*/
+QCLContext *QCLProfiler::context() const
+{
+    Q_D(const QCLProfiler);
+    return d->context;
+}
+
+/*!
+    Returns true if this profiler is recording; false otherwise.
+
+    \sa start(), stop()
+*/
+bool QCLProfiler::isActive() const
+{
+    Q_D(const QCLProfiler);
+    return d->active;
+}
+
+/*!
+    Starts recording the commands that are submitted to context().
+    Commands that were recorded by an earlier start() are kept
+    until clear() is called.
+
+    Returns false if another profiler is already recording on
+    context().
+
+    \sa stop(), isActive()
+*/
+bool QCLProfiler::start()
+{
+    Q_D(QCLProfiler);
+    if (d->active)
+        return true;
+    if (!d->context)
+        return false;
+    if (!d->context->attachProfiler(this)) {
+        qWarning() << "QCLProfiler::start: another profiler is already"
+                      " recording on this context";
+        return false;
+    }
+    d->active = true;
+    return true;
+}
+
+/*!
+    Stops recording commands.  The commands that were recorded so
+    far remain available to toTrace() until clear() is called.
+
+    \sa start(), isActive()
+*/
+void QCLProfiler::stop()
+{
+    Q_D(QCLProfiler);
+    if (!d->active)
+        return;
+    if (d->context)
+        d->context->detachProfiler(this);
+    d->active = false;
+}
+
+/*!
+    \internal
+
+    Called by the context when it is destroyed while this profiler
+    is recording.  The records are kept, but the profiler cannot be
+    started again.
+*/
+void QCLProfiler::contextDestroyed()
+{
+    Q_D(QCLProfiler);
+    d->context = 0;
+    d->active = false;
+}
+
+/*!
+    Returns the number of commands that have been recorded.
+
+    \sa clear()
+*/
+int QCLProfiler::count() const
+{
+    Q_D(const QCLProfiler);
+    QMutexLocker locker(&d->lock);
+    return d->records.size();
+}
+
+/*!
+    Discards all of the commands that have been recorded.
+
+    \sa count()
+*/
+void QCLProfiler::clear()
+{
+    Q_D(QCLProfiler);
+    QMutexLocker locker(&d->lock);
+    d->records.clear();
+    d->indexes.clear();
+    QHash<cl_kernel, QString>::ConstIterator it;
+    for (it = d->kernelNames.constBegin();
+            it != d->kernelNames.constEnd(); ++it)
+        clReleaseKernel(it.key());
+    d->kernelNames.clear();
+}
+
+static QString qt_cl_profiler_kernel_name(cl_kernel kernel)
+{
+    size_t size = 0;
+    if (clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME, 0, 0, &size)
+            != CL_SUCCESS || !size)
+        return QString();
+    QVarLengthArray<char> buf(size);
+    if (clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME,
+                        size, buf.data(), 0) != CL_SUCCESS)
+        return QString();
+    return QString::fromLatin1(buf.constData());
+}
+
+/*!
+    \internal
+
+    Records the command that signals \a event, after waiting for the
+    \a after events.  If the command is a kernel launch, \a kernel is
+    the kernel that it ran.  Called by QCLContext::recordCommand().
+*/
+void QCLProfiler::record
+    (cl_event event, const QCLEventList &after, cl_kernel kernel)
+{
+    Q_D(QCLProfiler);
+    QMutexLocker locker(&d->lock);
+    if (d->indexes.contains(event))
+        return;
+    QCLProfilerRecord record;
+    clRetainEvent(event);
+    record.event = QCLEvent(event);
+    record.kernel = kernel;
+    const cl_event *ids = after.eventData();
+    for (int index = 0; index < after.size(); ++index) {
+        QHash<cl_event, int>::ConstIterator it = d->indexes.constFind(ids[index]);
+        if (it != d->indexes.constEnd())
+            record.dependencies.append(it.value());
+    }
+    if (kernel && !d->kernelNames.contains(kernel)) {
+        // Keep the kernel alive so that its handle cannot be reused
+        // for another kernel while the record refers to it.
+        clRetainKernel(kernel);
+        d->kernelNames.insert(kernel, qt_cl_profiler_kernel_name(kernel));
+    }
+    d->indexes.insert(event, d->records.size());
+    d->records.append(record);
+}
+
+// Returns the label and the category for commands that are not
+// kernel launches.
+static const char *qt_cl_profiler_label
+    (cl_command_type type, const char **category)
+{
+    *category = "transfer";
+    switch (type) {
+    case CL_COMMAND_NDRANGE_KERNEL:
+    case CL_COMMAND_TASK:
+    case CL_COMMAND_NATIVE_KERNEL:
+        *category = "kernel";
+        return "Kernel";
+    case CL_COMMAND_READ_BUFFER:        return "Read buffer";
+    case CL_COMMAND_WRITE_BUFFER:       return "Write buffer";
+    case CL_COMMAND_COPY_BUFFER:        return "Copy buffer";
+    case CL_COMMAND_READ_BUFFER_RECT:   return "Read buffer rect";
+    case CL_COMMAND_WRITE_BUFFER_RECT:  return "Write buffer rect";
+    case CL_COMMAND_COPY_BUFFER_RECT:   return "Copy buffer rect";
+    case CL_COMMAND_READ_IMAGE:         return "Read image";
+    case CL_COMMAND_WRITE_IMAGE:        return "Write image";
+    case CL_COMMAND_COPY_IMAGE:         return "Copy image";
+    case CL_COMMAND_COPY_IMAGE_TO_BUFFER: return "Copy image to buffer";
+    case CL_COMMAND_COPY_BUFFER_TO_IMAGE: return "Copy buffer to image";
+    default: break;
+    }
+    *category = "map";
+    switch (type) {
+    case CL_COMMAND_MAP_BUFFER:         return "Map buffer";
+    case CL_COMMAND_MAP_IMAGE:          return "Map image";
+    case CL_COMMAND_UNMAP_MEM_OBJECT:   return "Unmap";
+    default: break;
+    }
+    *category = "acquire";
+    switch (type) {
+    case CL_COMMAND_ACQUIRE_GL_OBJECTS: return "Acquire GL objects";
+    case CL_COMMAND_RELEASE_GL_OBJECTS: return "Release GL objects";
+    default: break;
+    }
+    *category = "other";
+    switch (type) {
+    case CL_COMMAND_MARKER:             return "Marker";
+    case CL_COMMAND_USER:               return "User event";
+    default: break;
+    }
+    return "Command";
+}
+
+static QString qt_cl_profiler_track_name(cl_command_queue queue, int track)
+{
+    QString name = QLatin1String("Queue ") + QString::number(track + 1);
+    cl_device_id device = 0;
+    if (clGetCommandQueueInfo(queue, CL_QUEUE_DEVICE,
+                              sizeof(device), &device, 0) == CL_SUCCESS &&
+            device) {
+        name += QLatin1String(" (") + QCLDevice(device).name() +
+                QLatin1Char(')');
+    }
+    return name;
+}
+
+static QJsonObject qt_cl_profiler_event
+    (const char *phase, int track, double timestamp)
+{
+    QJsonObject object;
+    object.insert(QLatin1String("ph"), QLatin1String(phase));
+    object.insert(QLatin1String("pid"), 1);
+    object.insert(QLatin1String("tid"), track);
+    object.insert(QLatin1String("ts"), timestamp);
+    return object;
+}
+
+/*!
+    Returns the recorded commands in the Chrome trace event JSON
+    format.  Each command queue is a separate track, each command
+    that has timings is a complete ("X") event on the track of its
+    queue, and the QCLEventList dependencies between commands are
+    flow events.  Timestamps are in microseconds, relative to the
+    first command that started running.
+
+    This function waits for all of the recorded commands to finish.
+
+    \sa saveTrace()
+*/
+QByteArray QCLProfiler::toTrace() const
+{
+    Q_D(const QCLProfiler);
+    QMutexLocker locker(&d->lock);
+
+    // Collect the device timings and the queue of each command.
+    int count = d->records.size();
+    QVector<quint64> starts(count);
+    QVector<quint64> ends(count);
+    QVector<int> tracks(count);
+    QList<cl_command_queue> queues;
+    QHash<cl_command_queue, int> queueTracks;
+    quint64 base = 0;
+    for (int index = 0; index < count; ++index) {
+        QCLEvent event = d->records.at(index).event;
+        event.waitForFinished();
+        starts[index] = event.runTime();
+        ends[index] = event.finishTime();
+        tracks[index] = -1;
+        if (!starts[index] || !ends[index])
+            continue;
+        cl_command_queue queue = 0;
+        if (clGetEventInfo(event.eventId(), CL_EVENT_COMMAND_QUEUE,
+                           sizeof(queue), &queue, 0) != CL_SUCCESS)
+            continue;
+        QHash<cl_command_queue, int>::ConstIterator it =
+            queueTracks.constFind(queue);
+        if (it == queueTracks.constEnd()) {
+            tracks[index] = queues.size();
+            queueTracks.insert(queue, queues.size());
+            queues.append(queue);
+        } else {
+            tracks[index] = it.value();
+        }
+        if (!base || starts[index] < base)
+            base = starts[index];
+    }
+
+    QJsonArray events;
+    QJsonObject processArgs;
+    processArgs.insert(QLatin1String("name"), QLatin1String("QtOpenCL"));
+    QJsonObject process;
+    process.insert(QLatin1String("ph"), QLatin1String("M"));
+    process.insert(QLatin1String("pid"), 1);
+    process.insert(QLatin1String("name"), QLatin1String("process_name"));
+    process.insert(QLatin1String("args"), processArgs);
+    events.append(process);
+    for (int track = 0; track < queues.size(); ++track) {
+        QJsonObject threadArgs;
+        threadArgs.insert(QLatin1String("name"),
+                          qt_cl_profiler_track_name(queues.at(track), track));
+        QJsonObject thread;
+        thread.insert(QLatin1String("ph"), QLatin1String("M"));
+        thread.insert(QLatin1String("pid"), 1);
+        thread.insert(QLatin1String("tid"), track);
+        thread.insert(QLatin1String("name"), QLatin1String("thread_name"));
+        thread.insert(QLatin1String("args"), threadArgs);
+        events.append(thread);
+    }
+
+    int flowId = 0;
+    for (int index = 0; index < count; ++index) {
+        if (tracks[index] < 0)
+            continue;
+        const QCLProfilerRecord &record = d->records.at(index);
+        const char *category;
+        const char *label =
+            qt_cl_profiler_label(record.event.commandType(), &category);
+        QString name;
+        if (record.kernel)
+            name = d->kernelNames.value(record.kernel);
+        if (name.isEmpty())
+            name = QLatin1String(label);
+
+        double start = (starts[index] - base) / 1000.0;
+        QJsonObject slice = qt_cl_profiler_event("X", tracks[index], start);
+        slice.insert(QLatin1String("name"), name);
+        slice.insert(QLatin1String("cat"), QLatin1String(category));
+        slice.insert(QLatin1String("dur"),
+                     (ends[index] - starts[index]) / 1000.0);
+        QJsonObject args;
+        quint64 queued = record.event.queueTime();
+        quint64 submitted = record.event.submitTime();
+        if (queued)
+            args.insert(QLatin1String("queued"),
+                        (qint64(queued) - qint64(base)) / 1000.0);
+        if (submitted)
+            args.insert(QLatin1String("submitted"),
+                        (qint64(submitted) - qint64(base)) / 1000.0);
+        slice.insert(QLatin1String("args"), args);
+        events.append(slice);
+
+        // Draw an arrow from each recorded command that this one
+        // waited for.  The flow events bind to the enclosing slices.
+        for (int dep = 0; dep < record.dependencies.size(); ++dep) {
+            int source = record.dependencies.at(dep);
+            if (tracks[source] < 0)
+                continue;
+            ++flowId;
+            QJsonObject from = qt_cl_profiler_event
+                ("s", tracks[source], (starts[source] - base) / 1000.0);
+            from.insert(QLatin1String("name"), QLatin1String("dependency"));
+            from.insert(QLatin1String("cat"), QLatin1String("dependency"));
+            from.insert(QLatin1String("id"), flowId);
+            events.append(from);
+            QJsonObject to = qt_cl_profiler_event("f", tracks[index], start);
+            to.insert(QLatin1String("name"), QLatin1String("dependency"));
+            to.insert(QLatin1String("cat"), QLatin1String("dependency"));
+            to.insert(QLatin1String("id"), flowId);
+            to.insert(QLatin1String("bp"), QLatin1String("e"));
+            events.append(to);
+        }
+    }
+
+    QJsonObject trace;
+    trace.insert(QLatin1String("traceEvents"), events);
+    trace.insert(QLatin1String("displayTimeUnit"), QLatin1String("ns"));
+    return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
+
+/*!
+    Writes toTrace() to \a fileName.  Returns false if the file
+    could not be written.
+
+    \sa toTrace()
+*/
+bool QCLProfiler::saveTrace(const QString &fileName) const
+{
+    QByteArray trace = toTrace();
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "QCLProfiler::saveTrace: could not open"
+                   << fileName;
+        return false;
+    }
+    if (file.write(trace) != trace.size())
+        return false;
+    return file.commit();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,94 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCLPROFILER_H
+#define QCLPROFILER_H
+
+#include "qclevent.h"
+#include <QtCore/qscopedpointer.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qstring.h>
+
+QT_BEGIN_HEADER
+
+QT_BEGIN_NAMESPACE
+
+QT_MODULE(CL)
+
+class QCLContext;
+class QCLProfilerPrivate;
+
+class Q_CL_EXPORT QCLProfiler
+{
+public:
+    explicit QCLProfiler(QCLContext *context);
+    ~QCLProfiler();
+
+    QCLContext *context() const;
+
+    bool isActive() const;
+    bool start();
+    void stop();
+
+    int count() const;
+    void clear();
+
+    QByteArray toTrace() const;
+    bool saveTrace(const QString &fileName) const;
+
+private:
+    QScopedPointer<QCLProfilerPrivate> d_ptr;
+
+    Q_DISABLE_COPY(QCLProfiler)
+    Q_DECLARE_PRIVATE(QCLProfiler)
+
+    void record(cl_event event, const QCLEventList &after, cl_kernel kernel);
+    void contextDestroyed();
+
+    friend class QCLContext;
+    friend class QCLContextPrivate;
+};
+
+QT_END_NAMESPACE
+
+QT_END_HEADER
+
+#endif
@@ -41,8 +41,13 @@
 
 #include "qclprogram.h"
 #include "qclcontext.h"
+#include "qclext_p.h"
+#include "qclloader_p.h"
 #include <QtCore/qdebug.h>
 #include <QtCore/qvarlengtharray.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qfutureinterface.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -156,6 +161,197 @@ bool QCLProgram::build(const QList<QCLDevice> &devices, const QString &options)
     return false;
 }
 
+// State for a build that was started with a notification callback.
+// Both the callback and the thread that called clBuildProgram() hold
+// a reference because some implementations invoke the callback before
+// clBuildProgram() returns, even when the build fails.
+class QCLProgramBuildRequest
+{
+public:
+    QCLProgramBuildRequest()
+        : ref(2), notified(0), context(0), program(0)
+        , notify(0), data(0) {}
+
+    QAtomicInt ref;
+    QAtomicInt notified;
+    QCLContext *context;
+    cl_program program;
+    QVector<cl_device_id> devices;
+    void (*notify)(cl_program program, bool ok, void *data);
+    void *data;
+
+    void finish(bool ok);
+    void deref();
+};
+
+void QCLProgramBuildRequest::finish(bool ok)
+{
+    if (!notified.testAndSetOrdered(0, 1))
+        return;
+    if (!ok) {
+        clRetainProgram(program);
+        QCLProgram prog(context, program);
+        qWarning() << "QCLProgram::buildAsync:"
+                   << QCLContext::errorName(CL_BUILD_PROGRAM_FAILURE);
+        qWarning() << prog.log();
+    }
+    notify(program, ok, data);
+}
+
+void QCLProgramBuildRequest::deref()
+{
+    if (!ref.deref()) {
+        clReleaseProgram(program);
+        delete this;
+    }
+}
+
+static bool qt_cl_build_succeeded
+    (cl_program program, const QVector<cl_device_id> &devices)
+{
+    QVector<cl_device_id> devs(devices);
+    if (devs.isEmpty()) {
+        cl_uint count = 0;
+        if (clGetProgramInfo(program, CL_PROGRAM_NUM_DEVICES,
+                             sizeof(count), &count, 0) != CL_SUCCESS ||
+                count == 0)
+            return false;
+        devs.resize(count);
+        if (clGetProgramInfo(program, CL_PROGRAM_DEVICES,
+                             count * sizeof(cl_device_id),
+                             devs.data(), 0) != CL_SUCCESS)
+            return false;
+    }
+    for (int index = 0; index < devs.size(); ++index) {
+        cl_build_status status = CL_BUILD_ERROR;
+        if (clGetProgramBuildInfo(program, devs[index], CL_PROGRAM_BUILD_STATUS,
+                                  sizeof(status), &status, 0) != CL_SUCCESS ||
+                status != CL_BUILD_SUCCESS)
+            return false;
+    }
+    return true;
+}
+
+extern "C" {
+
+static void CL_CALLBACK qt_cl_build_notify(cl_program program, void *user_data)
+{
+    QCLProgramBuildRequest *request =
+        reinterpret_cast<QCLProgramBuildRequest *>(user_data);
+    request->finish(qt_cl_build_succeeded(program, request->devices));
+    request->deref();
+}
+
+}
+
+// Starts building "program" without blocking and arranges for "notify"
+// to be called with "data" once the build has finished, from whichever
+// thread the OpenCL implementation uses for notifications.  "notify" is
+// called exactly once, even if clBuildProgram() fails immediately.
+// Also used by QCLContext::buildProgramsAsync().
+cl_int qt_cl_build_program_async
+    (QCLContext *context, cl_program program,
+     const QList<QCLDevice> &devices, const QString &options,
+     void (*notify)(cl_program program, bool ok, void *data), void *data)
+{
+    QCLProgramBuildRequest *request = new QCLProgramBuildRequest();
+    request->context = context;
+    request->program = program;
+    request->notify = notify;
+    request->data = data;
+    foreach (QCLDevice dev, devices) {
+        if (dev.deviceId())
+            request->devices.append(dev.deviceId());
+    }
+    clRetainProgram(program);
+    QByteArray opts = options.toLatin1();
+    cl_int error = clBuildProgram
+        (program, request->devices.size(),
+         request->devices.isEmpty() ? 0 : request->devices.constData(),
+         opts.isEmpty() ? 0 : opts.constData(),
+         qt_cl_build_notify, request);
+    if (error != CL_SUCCESS) {
+        // The callback will not be invoked if the build could not be
+        // started, so report the failure and drop its reference.
+        if (request->notified.testAndSetOrdered(0, 1)) {
+            qWarning() << "QCLProgram::buildAsync:"
+                       << QCLContext::errorName(error);
+            notify(program, false, data);
+            request->deref();
+        }
+    }
+    request->deref();
+    return error;
+}
+
+#ifndef QT_NO_CONCURRENT
+
+static void qt_cl_build_future_notify(cl_program program, bool ok, void *data)
+{
+    Q_UNUSED(program);
+    QFutureInterface<bool> *iface =
+        reinterpret_cast<QFutureInterface<bool> *>(data);
+    iface->reportResult(ok);
+    iface->reportFinished();
+    delete iface;
+}
+
+/*!
+    Starts building this program from the sources and binaries that were
+    supplied, with the specified compiler \a options, and returns
+    immediately.  The returned future will contain true once the program
+    has been built successfully, or false if the build failed.
+
+    The build is driven by the OpenCL notification callback for
+    \c{clBuildProgram()}, so no thread is blocked while the
+    compiler runs:
+
+    \code
+    QCLProgram program = context.createProgramFromSourceFile(fileName);
+    QFutureWatcher<bool> *watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, SIGNAL(finished()), this, SLOT(programBuilt()));
+    watcher->setFuture(program.buildAsync());
+    \endcode
+
+    Note that OpenCL implementations that do not support asynchronous
+    builds will compile the program before this function returns.
+
+    \sa build(), QCLContext::buildProgramsAsync()
+*/
+QFuture<bool> QCLProgram::buildAsync(const QString &options)
+{
+    return buildAsync(QList<QCLDevice>(), options);
+}
+
+/*!
+    \overload
+
+    Starts building this program for \a devices with the specified
+    compiler \a options, and returns immediately.  If \a devices is
+    empty, the program will be built for all devices on the program's
+    context.
+
+    \sa build(), QCLContext::buildProgramsAsync()
+*/
+QFuture<bool> QCLProgram::buildAsync
+    (const QList<QCLDevice> &devices, const QString &options)
+{
+    QFutureInterface<bool> *iface = new QFutureInterface<bool>();
+    iface->reportStarted();
+    QFuture<bool> future = iface->future();
+    if (!m_id) {
+        qt_cl_build_future_notify(0, false, iface);
+        return future;
+    }
+    cl_int error = qt_cl_build_program_async
+        (m_context, m_id, devices, options, qt_cl_build_future_notify, iface);
+    if (m_context)
+        m_context->setLastError(error);
+    return future;
+}
+
+#endif
+
 /*!
     Returns the error log that resulted from the last build().
 
@@ -320,6 +516,79 @@ QList<QCLKernel> QCLProgram::createKernels() const
     return list;
 }
 
+/*!
+    \enum QCLProgram::KernelCacheMode
+    This enum defines how kernels are shared by cachedKernel().
+
+    \value SharedKernel All threads receive a handle to the same
+    \c{cl_kernel} object.  Kernel arguments are shared, so the
+    application must not set arguments on the kernel from more than
+    one thread at a time.
+    \value PerThreadKernel Each thread receives its own \c{cl_kernel}
+    object for the entry point, so threads never share argument state.
+*/
+
+/*!
+    Returns a kernel for the entry point associated with \a name in
+    this program, creating it the first time it is requested.  Later
+    requests for the same \a name return a new handle to the same
+    \c{cl_kernel}, without calling \c{clCreateKernel()} again.
+    This function is thread-safe.
+
+    If \a mode is PerThreadKernel, then a separate kernel is created
+    and cached for each calling thread.  Per-thread kernels are
+    released when their thread exits, and each thread keeps at most
+    a small number of them, so a thread may occasionally receive a
+    newly created kernel for a \a name that it requested before.
+
+    The cache keeps a reference to the kernels, and therefore to the
+    program, until clearKernelCache() is called or the context is
+    released.  At that point the per-thread kernels of the calling
+    thread are released immediately, while those of other threads are
+    released the next time that the thread caches a kernel or when it
+    exits; until then they keep the underlying OpenCL context alive.
+    Since handles returned in SharedKernel mode refer to
+    the same kernel object, any arguments that are set through one
+    handle are visible through the others.
+
+    \sa createKernel(), clearKernelCache()
+*/
+QCLKernel QCLProgram::cachedKernel(const char *name, KernelCacheMode mode) const
+{
+    if (!m_id || !m_context)
+        return QCLKernel();
+    return m_context->cachedKernel(*this, name, mode == PerThreadKernel);
+}
+
+/*!
+    \overload
+*/
+QCLKernel QCLProgram::cachedKernel(const QByteArray &name, KernelCacheMode mode) const
+{
+    return cachedKernel(name.constData(), mode);
+}
+
+/*!
+    \overload
+*/
+QCLKernel QCLProgram::cachedKernel(const QString &name, KernelCacheMode mode) const
+{
+    return cachedKernel(name.toLatin1().constData(), mode);
+}
+
+/*!
+    Removes all kernels for this program from the cache that is
+    maintained by cachedKernel().  Handles that were previously
+    returned by cachedKernel() remain valid.
+
+    \sa cachedKernel()
+*/
+void QCLProgram::clearKernelCache()
+{
+    if (m_id && m_context)
+        m_context->clearKernelCache(m_id);
+}
+
 /*!
     Releases the resources associated with the OpenCL compiler.
 */
@@ -46,6 +46,7 @@
 #include "qclkernel.h"
 #include <QtCore/qstring.h>
 #include <QtCore/qbytearray.h>
+#include <QtCore/qfuture.h>
 
 QT_BEGIN_HEADER
 
@@ -58,6 +59,12 @@ class QCLContext;
 class Q_CL_EXPORT QCLProgram
 {
 public:
+    enum KernelCacheMode
+    {
+        SharedKernel,
+        PerThreadKernel
+    };
+
     QCLProgram() : m_context(0), m_id(0) {}
     QCLProgram(QCLContext *context, cl_program id)
         : m_context(context), m_id(id) {}
@@ -74,6 +81,12 @@ public:
     bool build(const QString &options = QString());
     bool build(const QList<QCLDevice> &devices, const QString &options = QString());
 
+#ifndef QT_NO_CONCURRENT
+    QFuture<bool> buildAsync(const QString &options = QString());
+    QFuture<bool> buildAsync(const QList<QCLDevice> &devices,
+                             const QString &options = QString());
+#endif
+
     QString log() const;
 
     QList<QCLDevice> devices() const;
@@ -86,6 +99,11 @@ public:
 
     QList<QCLKernel> createKernels() const;
 
+    QCLKernel cachedKernel(const char *name, KernelCacheMode mode = SharedKernel) const;
+    QCLKernel cachedKernel(const QByteArray &name, KernelCacheMode mode = SharedKernel) const;
+    QCLKernel cachedKernel(const QString &name, KernelCacheMode mode = SharedKernel) const;
+    void clearKernelCache();
+
     static void unloadCompiler();
 
     bool operator==(const QCLProgram &other) const;
@@ -105,22 +123,22 @@ inline QCLProgram::QCLProgram(const QCLProgram &other)
     : m_context(other.m_context), m_id(other.m_id)
 {
     if (m_id)
-        clRetainProgram(m_id);
+        qt_clRetainProgram(m_id);
 }
 
 inline QCLProgram::~QCLProgram()
 {
     if (m_id)
-        clReleaseProgram(m_id);
+        qt_clReleaseProgram(m_id);
 }
 
 inline QCLProgram &QCLProgram::operator=(const QCLProgram &other)
 {
     m_context = other.m_context;
     if (other.m_id)
-        clRetainProgram(other.m_id);
+        qt_clRetainProgram(other.m_id);
     if (m_id)
-        clReleaseProgram(m_id);
+        qt_clReleaseProgram(m_id);
     m_id = other.m_id;
     return *this;
 }
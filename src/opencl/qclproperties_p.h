@@ -0,0 +1,163 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QCLPROPERTIES_P_H
+#define QCLPROPERTIES_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of the QtOpenCL library.  This header file may change from version
+// to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qclglobal.h"
+#include <QtCore/qhash.h>
+#include <QtCore/qreadwritelock.h>
+#include <QtCore/qatomic.h>
+
+QT_BEGIN_NAMESPACE
+
+// Registry of immutable property snapshots, one per OpenCL identifier.
+// A snapshot is created the first time that an identifier is looked up
+// and then lives until the library is unloaded.  Null identifiers share
+// a single empty snapshot that is never entered into the registry.
+// "Properties" must have a constructor that takes the identifier and
+// performs all of the queries.
+//
+// Applications usually query the same device or platform over and over,
+// so the entry that was found last is remembered in an atomic pointer
+// and checked before taking the lock.  Entries are never deleted while
+// the registry exists, so a stale pointer is still safe to compare.
+template <typename Id, typename Properties>
+class QCLPropertyRegistry
+{
+public:
+    QCLPropertyRegistry() : m_null(0) {}
+    ~QCLPropertyRegistry() { qDeleteAll(m_entries); delete m_null; }
+
+    const Properties *find(Id id);
+    void insert(Id id, Properties *props);
+
+private:
+    struct Entry
+    {
+        Entry(Id entryId, Properties *entryProps)
+            : id(entryId), props(entryProps) {}
+        ~Entry() { delete props; }
+
+        Id id;
+        Properties *props;
+    };
+
+    QAtomicPointer<Entry> m_last;
+    QReadWriteLock m_lock;
+    QHash<Id, Entry *> m_entries;
+    Properties *m_null;
+
+    Q_DISABLE_COPY(QCLPropertyRegistry)
+};
+
+template <typename Id, typename Properties>
+Q_OUTOFLINE_TEMPLATE const Properties *
+    QCLPropertyRegistry<Id, Properties>::find(Id id)
+{
+    Entry *last = m_last.loadAcquire();
+    if (last && last->id == id)
+        return last->props;
+
+    {
+        QReadLocker locker(&m_lock);
+        if (!id && m_null)
+            return m_null;
+        typename QHash<Id, Entry *>::const_iterator it =
+            m_entries.constFind(id);
+        if (it != m_entries.constEnd()) {
+            m_last.storeRelease(it.value());
+            return it.value()->props;
+        }
+    }
+
+    if (!id) {
+        QWriteLocker locker(&m_lock);
+        if (!m_null)
+            m_null = new Properties(id);
+        return m_null;
+    }
+
+    // Query outside the lock; if another thread got there first,
+    // then discard our copy and use theirs.
+    Properties *props = new Properties(id);
+    QWriteLocker locker(&m_lock);
+    typename QHash<Id, Entry *>::const_iterator it =
+        m_entries.constFind(id);
+    if (it != m_entries.constEnd()) {
+        delete props;
+        m_last.storeRelease(it.value());
+        return it.value()->props;
+    }
+    Entry *entry = new Entry(id, props);
+    m_entries.insert(id, entry);
+    m_last.storeRelease(entry);
+    return props;
+}
+
+// Takes ownership of "props" and uses it as the snapshot for "id",
+// unless a snapshot was already created by an earlier query.
+template <typename Id, typename Properties>
+Q_OUTOFLINE_TEMPLATE void QCLPropertyRegistry<Id, Properties>::insert
+    (Id id, Properties *props)
+{
+    QWriteLocker locker(&m_lock);
+    if (!id || m_entries.contains(id))
+        delete props;
+    else
+        m_entries.insert(id, new Entry(id, props));
+}
+
+QT_END_NAMESPACE
+
+#endif
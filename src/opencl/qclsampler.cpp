@@ -41,6 +41,7 @@
 
 #include "qclsampler.h"
 #include "qclcontext.h"
+#include "qclloader_p.h"
 
 QT_BEGIN_NAMESPACE
 
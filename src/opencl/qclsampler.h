@@ -100,22 +100,22 @@ inline QCLSampler::QCLSampler(const QCLSampler &other)
     : m_context(other.m_context), m_id(other.m_id)
 {
     if (m_id)
-        clRetainSampler(m_id);
+        qt_clRetainSampler(m_id);
 }
 
 inline QCLSampler::~QCLSampler()
 {
     if (m_id)
-        clReleaseSampler(m_id);
+        qt_clReleaseSampler(m_id);
 }
 
 inline QCLSampler &QCLSampler::operator=(const QCLSampler &other)
 {
     m_context = other.m_context;
     if (other.m_id)
-        clRetainSampler(other.m_id);
+        qt_clRetainSampler(other.m_id);
     if (m_id)
-        clReleaseSampler(m_id);
+        qt_clReleaseSampler(m_id);
     m_id = other.m_id;
     return *this;
 }
@@ -0,0 +1,295 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qclstaging_p.h"
+#include "qclext_p.h"
+#include "qclloader_p.h"
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+// Maximum number of staging slots per context.  Transfers that
+// find every slot busy bypass the pool instead of blocking.
+enum { QCLStagingMaxSlots = 8 };
+
+// Value of QCLStagingSlot::inUse for a slot that was in use when the
+// pool was destroyed, and that is freed when its transfer completes.
+enum { QCLStagingAbandoned = 2 };
+
+QCLStagingPool::QCLStagingPool(cl_context context, size_t slotSize)
+    : m_context(context)
+    , m_slotSize(slotSize)
+{
+    clRetainContext(m_context);
+}
+
+// Releases a slot that no transfer is using any more.  The unmap is
+// not waited for, so this can also be called from an event callback.
+static void qt_cl_staging_free_slot(QCLStagingSlot *slot)
+{
+    if (clEnqueueUnmapMemObject(slot->queue, slot->buffer, slot->mapped,
+                                0, 0, 0) == CL_SUCCESS)
+        clFlush(slot->queue);
+    clReleaseMemObject(slot->buffer);
+    clReleaseCommandQueue(slot->queue);
+    delete slot;
+}
+
+#ifdef QT_OPENCL_1_1
+
+extern "C" {
+
+// Frees a slot that was abandoned by the pool while its staged
+// write was still waiting to run.
+static void CL_CALLBACK qt_cl_staged_write_notify
+    (cl_event event, cl_int status, void *user_data)
+{
+    Q_UNUSED(status);
+    clReleaseEvent(event);
+    qt_cl_staging_free_slot(reinterpret_cast<QCLStagingSlot *>(user_data));
+}
+
+}
+
+#endif
+
+QCLStagingPool::~QCLStagingPool()
+{
+    // Transfers that are still in flight may be waiting for user events
+    // that are never set, so they are not waited for.  Their slots are
+    // abandoned instead, and freed by a callback when they complete.
+    for (int index = 0; index < m_slots.size(); ++index) {
+        QCLStagingSlot *slot = m_slots.at(index);
+        recycle(slot);
+        if (slot->event) {
+            // Staged write that has not completed yet.
+            slot->inUse.store(QCLStagingAbandoned);
+#ifdef QT_OPENCL_1_1
+            if (clSetEventCallback(slot->event, CL_COMPLETE,
+                                   qt_cl_staged_write_notify, slot)
+                    == CL_SUCCESS)
+                continue;
+#endif
+            clWaitForEvents(1, &(slot->event));
+            clReleaseEvent(slot->event);
+        } else if (slot->inUse.testAndSetOrdered(1, QCLStagingAbandoned)) {
+            // Staged read; qt_cl_staged_read_notify() frees the slot.
+            continue;
+        }
+        qt_cl_staging_free_slot(slot);
+    }
+    clReleaseContext(m_context);
+}
+
+// Marks a slot as free if the staged write that used it has finished.
+void QCLStagingPool::recycle(QCLStagingSlot *slot)
+{
+    if (!slot->event)
+        return;
+    cl_int status = CL_COMPLETE;
+    clGetEventInfo(slot->event, CL_EVENT_COMMAND_EXECUTION_STATUS,
+                   sizeof(status), &status, 0);
+    if (status == CL_COMPLETE || status < 0) {
+        clReleaseEvent(slot->event);
+        slot->event = 0;
+        slot->inUse.store(0);
+    }
+}
+
+QCLStagingSlot *QCLStagingPool::acquire(cl_command_queue queue)
+{
+    QMutexLocker locker(&m_lock);
+    for (int index = 0; index < m_slots.size(); ++index) {
+        QCLStagingSlot *slot = m_slots.at(index);
+        recycle(slot);
+        if (slot->inUse.testAndSetOrdered(0, 1))
+            return slot;
+    }
+    if (m_slots.size() >= QCLStagingMaxSlots)
+        return 0;
+
+    // Create a new slot and map it once for the life of the pool.
+    cl_int error = CL_INVALID_VALUE;
+    cl_mem buffer = clCreateBuffer
+        (m_context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
+         m_slotSize, 0, &error);
+    if (!buffer)
+        return 0;
+    void *mapped = clEnqueueMapBuffer
+        (queue, buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE,
+         0, m_slotSize, 0, 0, 0, &error);
+    if (!mapped) {
+        clReleaseMemObject(buffer);
+        return 0;
+    }
+    QCLStagingSlot *slot = new QCLStagingSlot;
+    slot->buffer = buffer;
+    slot->queue = queue;
+    clRetainCommandQueue(queue);
+    slot->mapped = mapped;
+    slot->event = 0;
+    slot->inUse.store(1);
+    m_slots.append(slot);
+    return slot;
+}
+
+// Copies data into a staging slot and enqueues the transfer from the
+// slot to the buffer.  The caller's data may be reused as soon as this
+// returns.  Returns false if the transfer should not be staged.
+bool QCLStagingPool::write
+    (cl_command_queue queue, cl_mem buffer, size_t offset,
+     const void *data, size_t size, const QCLEventList &after,
+     cl_event *event)
+{
+    if (size > m_slotSize)
+        return false;
+    QCLStagingSlot *slot = acquire(queue);
+    if (!slot)
+        return false;
+    memcpy(slot->mapped, data, size);
+    cl_int error = clEnqueueWriteBuffer
+        (queue, buffer, CL_FALSE, offset, size, slot->mapped,
+         after.size(), after.eventData(), event);
+    if (error != CL_SUCCESS) {
+        slot->inUse.store(0);
+        return false;
+    }
+    clFlush(queue);
+    clRetainEvent(*event);
+    QMutexLocker locker(&m_lock);
+    slot->event = *event;
+    return true;
+}
+
+#ifdef QT_OPENCL_1_1
+
+struct QCLStagedRead
+{
+    QCLStagingSlot *slot;
+    void *data;
+    size_t size;
+    cl_event done;
+};
+
+extern "C" {
+
+static void CL_CALLBACK qt_cl_staged_read_notify
+    (cl_event event, cl_int status, void *user_data)
+{
+    Q_UNUSED(event);
+    QCLStagedRead *read = reinterpret_cast<QCLStagedRead *>(user_data);
+    QCLStagingSlot *slot = read->slot;
+    if (status >= 0)
+        memcpy(read->data, slot->mapped, read->size);
+    if (!slot->inUse.testAndSetOrdered(1, 0))
+        qt_cl_staging_free_slot(slot);
+    clSetUserEventStatus(read->done, status < 0 ? status : CL_COMPLETE);
+    clReleaseEvent(read->done);
+    delete read;
+}
+
+}
+
+#endif
+
+// Enqueues a transfer from the buffer into a staging slot.  The data is
+// copied to its destination when the transfer completes, and *event is
+// a user event that is signalled after that copy.  Returns false if the
+// transfer should not be staged.
+bool QCLStagingPool::read
+    (cl_command_queue queue, cl_mem buffer, size_t offset,
+     void *data, size_t size, const QCLEventList &after,
+     cl_event *event)
+{
+#ifdef QT_OPENCL_1_1
+    if (size > m_slotSize)
+        return false;
+    QCLStagingSlot *slot = acquire(queue);
+    if (!slot)
+        return false;
+    cl_int error = CL_INVALID_VALUE;
+    cl_event done = clCreateUserEvent(m_context, &error);
+    if (!done) {
+        slot->inUse.store(0);
+        return false;
+    }
+    cl_event transfer;
+    error = clEnqueueReadBuffer
+        (queue, buffer, CL_FALSE, offset, size, slot->mapped,
+         after.size(), after.eventData(), &transfer);
+    if (error != CL_SUCCESS) {
+        clReleaseEvent(done);
+        slot->inUse.store(0);
+        return false;
+    }
+    QCLStagedRead *read = new QCLStagedRead;
+    read->slot = slot;
+    read->data = data;
+    read->size = size;
+    read->done = done;
+    clRetainEvent(done);    // Reference for the callback.
+    error = clSetEventCallback
+        (transfer, CL_COMPLETE, qt_cl_staged_read_notify, read);
+    if (error != CL_SUCCESS) {
+        // Complete the read synchronously instead.
+        clWaitForEvents(1, &transfer);
+        cl_int status = CL_COMPLETE;
+        clGetEventInfo(transfer, CL_EVENT_COMMAND_EXECUTION_STATUS,
+                       sizeof(status), &status, 0);
+        qt_cl_staged_read_notify(transfer, status, read);
+    }
+    clReleaseEvent(transfer);
+    clFlush(queue);
+    *event = done;
+    return true;
+#else
+    Q_UNUSED(queue);
+    Q_UNUSED(buffer);
+    Q_UNUSED(offset);
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    Q_UNUSED(after);
+    Q_UNUSED(event);
+    return false;
+#endif
+}
+
+QT_END_NAMESPACE
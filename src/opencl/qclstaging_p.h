@@ -0,0 +1,102 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCLSTAGING_P_H
+#define QCLSTAGING_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of the QtOpenCL library.  This header file may change from version
+// to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qclevent.h"
+#include <QtCore/qmutex.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qlist.h>
+
+QT_BEGIN_NAMESPACE
+
+struct QCLStagingSlot
+{
+    cl_mem buffer;
+    cl_command_queue queue;
+    void *mapped;
+    cl_event event;
+    QAtomicInt inUse;
+};
+
+// Pool of host-accessible staging buffers that are mapped once and
+// stay mapped, so that transfers run from driver-allocated (usually
+// pinned) memory instead of arbitrary pageable host pointers.
+class QCLStagingPool
+{
+public:
+    QCLStagingPool(cl_context context, size_t slotSize);
+    ~QCLStagingPool();
+
+    size_t slotSize() const { return m_slotSize; }
+
+    bool write(cl_command_queue queue, cl_mem buffer, size_t offset,
+               const void *data, size_t size, const QCLEventList &after,
+               cl_event *event);
+    bool read(cl_command_queue queue, cl_mem buffer, size_t offset,
+              void *data, size_t size, const QCLEventList &after,
+              cl_event *event);
+
+private:
+    cl_context m_context;
+    size_t m_slotSize;
+    QMutex m_lock;
+    QList<QCLStagingSlot *> m_slots;
+
+    QCLStagingSlot *acquire(cl_command_queue queue);
+    void recycle(QCLStagingSlot *slot);
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,470 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qclstreambuffer.h"
+#include "qclcontext.h"
+#include "qclloader_p.h"
+#include <QtCore/qvector.h>
+#include <QtCore/qdebug.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QCLStreamBuffer
+    \brief The QCLStreamBuffer class streams data through the device in a ring of buffers.
+    \since 4.7
+    \ingroup opencl
+
+    QCLStreamBuffer is intended for data that arrives continuously,
+    such as camera or sensor frames, where each frame is uploaded to the
+    device, processed by a kernel, and the result downloaded again.
+    Doing this with blocking QCLBuffer::write() and QCLBuffer::read()
+    calls serializes the three steps.  QCLStreamBuffer instead keeps a
+    ring of depth() device buffers and three command queues, so that
+    the upload of frame k+1, the kernel for frame k, and the download
+    of frame k-1 can all be in progress at the same time:
+
+    \code
+    QCLStreamBuffer stream(&context, frameSize, 3);
+    kernel.setGlobalWorkSize(frameWidth, frameHeight);
+    forever {
+        int slot = stream.upload(frame.constData(), frameSize);
+        kernel.setArg(0, stream.slotBuffer(slot));
+        QCLEvent done = kernel.run(stream.computeQueue(),
+                                   stream.uploadEvent(slot));
+        stream.download(slot, results[slot], resultSize, done);
+        ...
+    }
+    \endcode
+
+    Each frame takes the next slot in the ring with acquire() or
+    upload().  A slot is handed out again only once everything that
+    used it has finished: the upload, the event given to
+    setComputeEvent(), and the download.  When the consumer falls
+    behind, acquire() provides backpressure: in blocking mode, which is
+    the default, it waits for the oldest slot to become free; with
+    setBlocking(false) it returns -1 immediately so that the producer
+    can drop or defer the frame.
+
+    Host memory passed to upload() and download() must remain valid
+    until the corresponding event has finished, unless staging is
+    enabled on the context; see QCLContext::setStagingEnabled().
+
+    QCLStreamBuffer is not thread-safe.
+
+    \sa QCLBuffer, QCLContext::createQueuePool()
+*/
+
+struct QCLStreamSlot
+{
+    QCLStreamSlot() : acquired(false) {}
+
+    QCLBuffer buffer;
+    QCLEvent upload;
+    QCLEventList busy;
+    bool acquired;
+};
+
+class QCLStreamBufferPrivate
+{
+public:
+    QCLStreamBufferPrivate(QCLContext *ctx, size_t size)
+        : context(ctx), slotSize(size), next(0), blocking(true) {}
+
+    QCLContext *context;
+    size_t slotSize;
+    QVector<QCLStreamSlot> slots;
+    int next;
+    bool blocking;
+    QCLCommandQueue uploadQueue;
+    QCLCommandQueue computeQueue;
+    QCLCommandQueue downloadQueue;
+
+    bool isValid(int slot) const
+    {
+        return slot >= 0 && slot < slots.size() && slots.at(slot).acquired;
+    }
+};
+
+// Flushes the queues of the commands behind \a events, so that a command
+// on another queue that waits for them cannot wait for work that the
+// device has never been given.  User events have no queue.
+static void qt_cl_flush_event_queues(const QCLEventList &events)
+{
+    cl_command_queue flushed = 0;
+    for (int index = 0; index < events.size(); ++index) {
+        cl_command_queue queue = 0;
+        if (clGetEventInfo(events.eventData()[index], CL_EVENT_COMMAND_QUEUE,
+                           sizeof(queue), &queue, 0) == CL_SUCCESS &&
+                queue && queue != flushed) {
+            clFlush(queue);
+            flushed = queue;
+        }
+    }
+}
+
+/*!
+    Constructs a stream buffer on \a context with \a depth slots of
+    \a slotSize bytes each, created with the specified \a access mode.
+    Three in-order command queues are created on the default device
+    of \a context for uploads, compute, and downloads.
+
+    A depth of 3 allows one frame to be uploaded, one to be processed,
+    and one to be downloaded at the same time.  A larger depth allows
+    the producer to run further ahead of the consumer before
+    backpressure is applied.
+
+    \sa isNull()
+*/
+QCLStreamBuffer::QCLStreamBuffer
+        (QCLContext *context, size_t slotSize, int depth,
+         QCLMemoryObject::Access access)
+    : d_ptr(new QCLStreamBufferPrivate(context, slotSize))
+{
+    Q_D(QCLStreamBuffer);
+    d->uploadQueue = context->createCommandQueue(0);
+    d->computeQueue = context->createCommandQueue(0);
+    d->downloadQueue = context->createCommandQueue(0);
+    if (d->uploadQueue.isNull() || d->computeQueue.isNull() ||
+            d->downloadQueue.isNull())
+        return;
+    d->slots.resize(qMax(depth, 1));
+    for (int index = 0; index < d->slots.size(); ++index) {
+        d->slots[index].buffer = context->createBufferDevice(slotSize, access);
+        if (d->slots.at(index).buffer.isNull()) {
+            d->slots.clear();
+            return;
+        }
+    }
+}
+
+/*!
+    Waits for all outstanding work on the slots to finish and
+    destroys this stream buffer.
+
+    \sa finish()
+*/
+QCLStreamBuffer::~QCLStreamBuffer()
+{
+    finish();
+}
+
+/*!
+    Returns true if the queues or buffers for this stream could not be
+    created; false otherwise.
+*/
+bool QCLStreamBuffer::isNull() const
+{
+    Q_D(const QCLStreamBuffer);
+    return d->slots.isEmpty();
+}
+
+/*!
+    Returns the context that this stream buffer was created on.
+*/
+QCLContext *QCLStreamBuffer::context() const
+{
+    Q_D(const QCLStreamBuffer);
+    return d->context;
+}
+
+/*!
+    Returns the size of each slot in bytes.
+*/
+size_t QCLStreamBuffer::slotSize() const
+{
+    Q_D(const QCLStreamBuffer);
+    return d->slotSize;
+}
+
+/*!
+    Returns the number of slots in the ring.
+*/
+int QCLStreamBuffer::depth() const
+{
+    Q_D(const QCLStreamBuffer);
+    return d->slots.size();
+}
+
+/*!
+    Returns true if acquire() waits for a slot to become free when all
+    slots are busy; false if it returns -1 instead.  The default is true.
+
+    \sa setBlocking()
+*/
+bool QCLStreamBuffer::isBlocking() const
+{
+    Q_D(const QCLStreamBuffer);
+    return d->blocking;
+}
+
+/*!
+    Sets the backpressure mode of acquire() and upload() to
+    \a blocking.
+
+    \sa isBlocking()
+*/
+void QCLStreamBuffer::setBlocking(bool blocking)
+{
+    Q_D(QCLStreamBuffer);
+    d->blocking = blocking;
+}
+
+/*!
+    Returns the command queue that upload() uses.
+*/
+QCLCommandQueue QCLStreamBuffer::uploadQueue() const
+{
+    Q_D(const QCLStreamBuffer);
+    return d->uploadQueue;
+}
+
+/*!
+    Returns the command queue that is intended for the kernels that
+    process the slots.  Kernels run on this queue, for example with
+    QCLKernel::run(const QCLCommandQueue &, const QCLEventList &),
+    overlap with transfers on the upload and download queues.
+*/
+QCLCommandQueue QCLStreamBuffer::computeQueue() const
+{
+    Q_D(const QCLStreamBuffer);
+    return d->computeQueue;
+}
+
+/*!
+    Returns the command queue that download() uses.
+*/
+QCLCommandQueue QCLStreamBuffer::downloadQueue() const
+{
+    Q_D(const QCLStreamBuffer);
+    return d->downloadQueue;
+}
+
+/*!
+    Takes the next slot in the ring and returns its index.  The slot
+    stays with the caller until it is passed to download() or release().
+
+    If the slot is still in use by earlier commands, then this function
+    waits for them to finish if isBlocking() is true, or returns -1 if
+    isBlocking() is false.  Also returns -1 if the caller still holds
+    the slot from the previous trip around the ring.
+
+    \sa upload(), release()
+*/
+int QCLStreamBuffer::acquire()
+{
+    Q_D(QCLStreamBuffer);
+    if (d->slots.isEmpty())
+        return -1;
+    int slot = d->next;
+    QCLStreamSlot &s = d->slots[slot];
+    if (s.acquired) {
+        qWarning("QCLStreamBuffer::acquire: all %d slots are held by "
+                 "the caller", d->slots.size());
+        return -1;
+    }
+    if (!s.busy.isEmpty()) {
+        if (d->blocking) {
+            s.busy.waitForFinished();
+        } else {
+            for (int index = 0; index < s.busy.size(); ++index) {
+                if (!s.busy.at(index).isFinished())
+                    return -1;
+            }
+        }
+        s.busy = QCLEventList();
+    }
+    s.upload = QCLEvent();
+    s.acquired = true;
+    d->next = (slot + 1) % d->slots.size();
+    return slot;
+}
+
+/*!
+    Acquires the next slot and uploads \a size bytes from \a data into it
+    on the uploadQueue(), after the events in \a after have finished.
+    Returns the slot index, or -1 if no slot is available; see acquire().
+
+    The upload is not waited for.  Use uploadEvent() as the dependency
+    of the kernel that processes the slot.
+
+    \sa acquire(), uploadEvent(), download()
+*/
+int QCLStreamBuffer::upload(const void *data, size_t size,
+                            const QCLEventList &after)
+{
+    Q_D(QCLStreamBuffer);
+    int slot = acquire();
+    if (slot < 0)
+        return -1;
+    QCLStreamSlot &s = d->slots[slot];
+    qt_cl_flush_event_queues(after);
+    s.upload = s.buffer.writeAsync
+        (d->uploadQueue, 0, data, qMin(size, d->slotSize), after);
+    d->uploadQueue.flush();
+    if (!s.upload.isNull())
+        s.busy.append(s.upload);
+    return slot;
+}
+
+/*!
+    Returns the device buffer for \a slot, or a null buffer if \a slot
+    is not currently held by the caller.
+*/
+QCLBuffer QCLStreamBuffer::slotBuffer(int slot) const
+{
+    Q_D(const QCLStreamBuffer);
+    if (!d->isValid(slot))
+        return QCLBuffer();
+    return d->slots.at(slot).buffer;
+}
+
+/*!
+    Returns the event for the upload() into \a slot, or a null event
+    if the slot was filled with acquire().
+*/
+QCLEvent QCLStreamBuffer::uploadEvent(int slot) const
+{
+    Q_D(const QCLStreamBuffer);
+    if (!d->isValid(slot))
+        return QCLEvent();
+    return d->slots.at(slot).upload;
+}
+
+/*!
+    Records \a event as a command that uses \a slot, typically the
+    kernel that processes it.  The slot will not be reused until
+    \a event has finished.
+
+    download() calls this implicitly for the events it waits for.
+*/
+void QCLStreamBuffer::setComputeEvent(int slot, const QCLEvent &event)
+{
+    Q_D(QCLStreamBuffer);
+    if (!d->isValid(slot) || event.isNull())
+        return;
+    d->slots[slot].busy.append(event);
+}
+
+/*!
+    Downloads \a size bytes from \a slot into \a data on the
+    downloadQueue(), once the upload and the events in \a after
+    have finished, and then gives the slot back to the ring.
+    Returns the event for the download.
+
+    The slot is reused by acquire() only after the download has
+    finished.  The command queues of the events in \a after, such as
+    computeQueue(), are flushed first, so that the download does not
+    wait for commands that have not been submitted to the device.
+
+    \sa release()
+*/
+QCLEvent QCLStreamBuffer::download(int slot, void *data, size_t size,
+                                   const QCLEventList &after)
+{
+    Q_D(QCLStreamBuffer);
+    if (!d->isValid(slot))
+        return QCLEvent();
+    QCLStreamSlot &s = d->slots[slot];
+    QCLEventList deps(after);
+    if (!s.upload.isNull())
+        deps.append(s.upload);
+    s.busy.append(after);
+    qt_cl_flush_event_queues(after);
+    QCLEvent event = s.buffer.readAsync
+        (d->downloadQueue, 0, data, qMin(size, d->slotSize), deps);
+    d->downloadQueue.flush();
+    if (!event.isNull())
+        s.busy.append(event);
+    s.acquired = false;
+    return event;
+}
+
+/*!
+    Gives \a slot back to the ring without downloading it.  The slot is
+    reused by acquire() after its upload and the events recorded with
+    setComputeEvent() have finished.
+
+    \sa download()
+*/
+void QCLStreamBuffer::release(int slot)
+{
+    Q_D(QCLStreamBuffer);
+    if (d->isValid(slot))
+        d->slots[slot].acquired = false;
+}
+
+/*!
+    Returns the number of slots that acquire() could hand out right
+    now without waiting.
+*/
+int QCLStreamBuffer::available() const
+{
+    Q_D(const QCLStreamBuffer);
+    int count = 0;
+    for (int index = 0; index < d->slots.size(); ++index) {
+        const QCLStreamSlot &s = d->slots.at(index);
+        if (s.acquired)
+            continue;
+        bool finished = true;
+        for (int event = 0; event < s.busy.size() && finished; ++event)
+            finished = s.busy.at(event).isFinished();
+        if (finished)
+            ++count;
+    }
+    return count;
+}
+
+/*!
+    Waits for all uploads, recorded compute events, and downloads
+    on all slots to finish.
+*/
+void QCLStreamBuffer::finish()
+{
+    Q_D(QCLStreamBuffer);
+    for (int index = 0; index < d->slots.size(); ++index) {
+        QCLStreamSlot &s = d->slots[index];
+        s.busy.waitForFinished();
+        s.busy = QCLEventList();
+    }
+}
+
+QT_END_NAMESPACE
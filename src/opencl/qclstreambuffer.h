@@ -0,0 +1,104 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCLSTREAMBUFFER_H
+#define QCLSTREAMBUFFER_H
+
+#include "qclbuffer.h"
+#include "qclcommandqueue.h"
+#include <QtCore/qscopedpointer.h>
+
+QT_BEGIN_HEADER
+
+QT_BEGIN_NAMESPACE
+
+QT_MODULE(CL)
+
+class QCLContext;
+class QCLStreamBufferPrivate;
+
+class Q_CL_EXPORT QCLStreamBuffer
+{
+public:
+    QCLStreamBuffer(QCLContext *context, size_t slotSize, int depth = 3,
+                    QCLMemoryObject::Access access = QCLMemoryObject::ReadWrite);
+    ~QCLStreamBuffer();
+
+    bool isNull() const;
+
+    QCLContext *context() const;
+    size_t slotSize() const;
+    int depth() const;
+
+    bool isBlocking() const;
+    void setBlocking(bool blocking);
+
+    QCLCommandQueue uploadQueue() const;
+    QCLCommandQueue computeQueue() const;
+    QCLCommandQueue downloadQueue() const;
+
+    int acquire();
+    int upload(const void *data, size_t size,
+               const QCLEventList &after = QCLEventList());
+
+    QCLBuffer slotBuffer(int slot) const;
+    QCLEvent uploadEvent(int slot) const;
+    void setComputeEvent(int slot, const QCLEvent &event);
+
+    QCLEvent download(int slot, void *data, size_t size,
+                      const QCLEventList &after = QCLEventList());
+    void release(int slot);
+
+    int available() const;
+    void finish();
+
+private:
+    QScopedPointer<QCLStreamBufferPrivate> d_ptr;
+
+    Q_DISABLE_COPY(QCLStreamBuffer)
+    Q_DECLARE_PRIVATE(QCLStreamBuffer)
+};
+
+QT_END_NAMESPACE
+
+QT_END_HEADER
+
+#endif
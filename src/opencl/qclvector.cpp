@@ -41,7 +41,12 @@
 
 #include "qclvector.h"
 #include "qclcontext.h"
+#include "qclext_p.h"
+#include "qclloader_p.h"
 #include <QtCore/qatomic.h>
+#include <QtCore/qdebug.h>
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qpair.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -69,11 +74,192 @@ QT_BEGIN_NAMESPACE
 
     Types such as float, char, int, QPointF, and QVector3D can be
     used as the type T, but types such as QString cannot.
+
+    \section1 Mapping ranges
+
+    operator[]() maps the whole vector into host memory with a blocking
+    call the first time it is used, which is expensive for large vectors
+    when only a few elements are needed.  mapRange() maps just the
+    requested elements and returns a QCLVectorView that unmaps them
+    again when the last copy of the view is destroyed:
+
+    \code
+    QCLVector<float> vector = context.createVector<float>(100000000);
+    ...
+    {
+        QCLVectorView<float> view = vector.mapRange(5000, 16, QCLMemoryObject::ReadOnly);
+        for (int index = 0; index < view.size(); ++index)
+            qDebug() << view[index];
+    }   // The range is unmapped here.
+    \endcode
+
+    The access mode of mapRange() avoids transfers that are not needed:
+    QCLMemoryObject::ReadOnly ranges are not written back to the device,
+    and QCLMemoryObject::WriteOnly ranges are not read from the device
+    first, because their previous contents are discarded.  On OpenCL 1.2
+    devices, WriteOnly uses \c{CL_MAP_WRITE_INVALIDATE_REGION}.
+
+    With \c blocking set to false, mapRange() returns immediately and
+    the view's QCLVectorView::event() is signalled when the range is
+    ready to be accessed.  Views should not be mixed with operator[]()
+    on overlapping elements.
+
+    \section1 Host vectors
+
+    If the context has not been created and host fallback is enabled
+    on it, or no OpenCL platform is available, createVector() returns
+    a vector whose elements are kept in host memory that is aligned for
+    SIMD access instead of in an OpenCL buffer.  Reading, writing, and mapping
+    such a vector operate directly on the host memory, and
+    QCLAlgorithms runs on host threads for it, so that code written
+    for QCLVector keeps working on systems without OpenCL.  Host
+    vectors cannot be passed to kernels, and toBuffer() returns a null
+    buffer for them.
+
+    \sa isHostOnly(), QCLContext::setHostFallbackEnabled()
 */
 
-#if defined(__APPLE__) || defined(__MACOSX)
-#define QT_CL_COPY_VECTOR 1
-#endif
+/*!
+    \class QCLVectorView
+    \brief The QCLVectorView class provides access to a mapped range of a QCLVector.
+    \since 4.7
+    \ingroup opencl
+
+    QCLVectorView objects are returned by QCLVector::mapRange().  Copies
+    of a view share the same mapping, which is released when the last
+    copy is destroyed or unmap() is called.  The vector's buffer stays
+    alive while it is mapped by a view.
+
+    \sa QCLVector::mapRange()
+*/
+
+class QCLVectorViewPrivate
+{
+public:
+    QCLVectorViewPrivate()
+        : id(0), queue(0), mapped(0), hostCopy(0), offset(0), size(0)
+        , access(QCLMemoryObject::ReadWrite), ownsMapping(false)
+    {
+        ref = 1;
+    }
+    ~QCLVectorViewPrivate()
+    {
+        unmap();
+        if (queue)
+            clReleaseCommandQueue(queue);
+        if (id)
+            clReleaseMemObject(id);
+    }
+
+    QBasicAtomicInt ref;
+    cl_mem id;
+    cl_command_queue queue;
+    void *mapped;
+    void *hostCopy;
+    size_t offset;
+    size_t size;
+    QCLMemoryObject::Access access;
+    QCLEvent event;
+    bool ownsMapping;
+
+    QCLEvent unmap();
+};
+
+QCLEvent QCLVectorViewPrivate::unmap()
+{
+    if (!ownsMapping)
+        return QCLEvent();
+    ownsMapping = false;
+    cl_event evid = 0;
+    cl_int error = CL_SUCCESS;
+    if (hostCopy) {
+        // Copy mode: write the range back unless it was read-only.
+        if (access != QCLMemoryObject::ReadOnly) {
+            error = clEnqueueWriteBuffer
+                (queue, id, CL_TRUE, offset, size, hostCopy, 0, 0, &evid);
+        }
+        ::free(hostCopy);
+        hostCopy = 0;
+    } else {
+        error = clEnqueueUnmapMemObject(queue, id, mapped, 0, 0, &evid);
+    }
+    mapped = 0;
+    if (error != CL_SUCCESS) {
+        qWarning() << "QCLVectorView::unmap:" << QCLContext::errorName(error);
+        return QCLEvent();
+    }
+    return QCLEvent(evid);
+}
+
+QCLVectorViewBase::QCLVectorViewBase(const QCLVectorViewBase &other)
+    : d_ptr(other.d_ptr)
+    , m_data(other.m_data)
+    , m_size(other.m_size)
+{
+    if (d_ptr)
+        d_ptr->ref.ref();
+}
+
+QCLVectorViewBase::~QCLVectorViewBase()
+{
+    if (d_ptr && !d_ptr->ref.deref())
+        delete d_ptr;
+}
+
+void QCLVectorViewBase::assign(const QCLVectorViewBase &other)
+{
+    if (other.d_ptr)
+        other.d_ptr->ref.ref();
+    if (d_ptr && !d_ptr->ref.deref())
+        delete d_ptr;
+    d_ptr = other.d_ptr;
+    m_data = other.m_data;
+    m_size = other.m_size;
+}
+
+/*!
+    Returns the access mode that the range was mapped with.
+*/
+QCLMemoryObject::Access QCLVectorViewBase::access() const
+{
+    return d_ptr ? d_ptr->access : QCLMemoryObject::ReadWrite;
+}
+
+/*!
+    Returns the event that is signalled when the mapped range is ready
+    to be accessed.  The event is null if the range was mapped
+    with a blocking call or required no transfer.
+
+    \sa waitForFinished()
+*/
+QCLEvent QCLVectorViewBase::event() const
+{
+    return d_ptr ? d_ptr->event : QCLEvent();
+}
+
+/*!
+    Waits until the mapped range is ready to be accessed.
+
+    \sa event()
+*/
+void QCLVectorViewBase::waitForFinished()
+{
+    if (d_ptr && !d_ptr->event.isNull())
+        d_ptr->event.waitForFinished();
+}
+
+/*!
+    Unmaps the range for this view and all of its copies, before the
+    last copy is destroyed.  Returns an event that is signalled when
+    the data has been handed back to the device.  The view must not
+    be accessed after it has been unmapped.
+*/
+QCLEvent QCLVectorViewBase::unmap()
+{
+    if (!d_ptr)
+        return QCLEvent();
+    return d_ptr->unmap();
+}
 
 enum QCLVectorState
 {
@@ -89,7 +275,11 @@ public:
         : state(State_Uninitialized)
         , context(0)
         , id(0)
+        , access(QCLMemoryObject::ReadWrite)
         , hostCopy(0)
+        , capacity(0)
+        , hostValid(false)
+        , hostOnly(false)
     {
         ref = 1;
     }
@@ -98,22 +288,114 @@ public:
     QCLVectorState state;
     QCLContext *context;
     cl_mem id;
+    QCLMemoryObject::Access access;
     void *hostCopy;
+    size_t capacity;
     QList<QCLVectorBase *> owners;
 
-    void *hostPointer(size_t size)
+    // Copy mode only: hostValid is true if the host copy matches the
+    // device contents, apart from the element ranges in dirty, which
+    // have been modified on the host since the last upload.
+    bool hostValid;
+    QVector<QPair<size_t, size_t> > dirty;
+    QCLEvent lastUpload;
+
+    // True if the elements live in hostCopy only, because the context
+    // could not be created.  hostCopy is then allocated with
+    // qMallocAligned() and is permanently mapped.
+    bool hostOnly;
+
+    void *hostPointer(size_t elemSize)
     {
         if (!hostCopy)
-            hostCopy = ::malloc(size);
+            hostCopy = ::malloc(capacity * elemSize);
         return hostCopy;
     }
+
+    void setSize(size_t size)
+    {
+        QList<QCLVectorBase *>::ConstIterator it;
+        for (it = owners.constBegin(); it != owners.constEnd(); ++it)
+            (*it)->m_size = size;
+    }
+
+    void setMapped(void *mapped)
+    {
+        QList<QCLVectorBase *>::ConstIterator it;
+        for (it = owners.constBegin(); it != owners.constEnd(); ++it)
+            (*it)->m_mapped = mapped;
+    }
+
+    bool isAllocated() const { return id != 0 || hostOnly; }
+
+    void addDirty(size_t start, size_t end);
+    void collectDirty();
+    void mergeDirty();
 };
 
+// Alignment of the storage for host vectors, which is large enough
+// for the widest SIMD loads on current CPUs and avoids sharing cache
+// lines between the chunks that QCLAlgorithms processes in parallel.
+enum { QCLVectorHostAlignment = 64 };
+
+// Maximum number of separate dirty ranges to track before they
+// are collapsed into a single range.
+enum { QCLVectorMaxDirtyRanges = 1024 };
+
+void QCLVectorBasePrivate::addDirty(size_t start, size_t end)
+{
+    if (start >= end)
+        return;
+    dirty.append(qMakePair(start, end));
+    if (dirty.size() > QCLVectorMaxDirtyRanges) {
+        mergeDirty();
+        if (dirty.size() > QCLVectorMaxDirtyRanges / 2) {
+            // Too fragmented to be worth tracking separately.
+            size_t first = dirty.first().first;
+            size_t last = dirty.last().second;
+            dirty.resize(1);
+            dirty[0] = qMakePair(first, last);
+        }
+    }
+}
+
+// Move the dirty runs that were recorded by operator[] in each owner.
+void QCLVectorBasePrivate::collectDirty()
+{
+    QList<QCLVectorBase *>::ConstIterator it;
+    for (it = owners.constBegin(); it != owners.constEnd(); ++it) {
+        QCLVectorBase *owner = *it;
+        addDirty(owner->m_dirtyStart, owner->m_dirtyEnd);
+        owner->m_dirtyStart = 0;
+        owner->m_dirtyEnd = 0;
+    }
+}
+
+// Sort the dirty ranges and merge those that overlap or touch.
+void QCLVectorBasePrivate::mergeDirty()
+{
+    if (dirty.size() <= 1)
+        return;
+    qSort(dirty.begin(), dirty.end());
+    int out = 0;
+    for (int index = 1; index < dirty.size(); ++index) {
+        if (dirty[index].first <= dirty[out].second) {
+            if (dirty[index].second > dirty[out].second)
+                dirty[out].second = dirty[index].second;
+        } else {
+            dirty[++out] = dirty[index];
+        }
+    }
+    dirty.resize(out + 1);
+}
+
 QCLVectorBase::QCLVectorBase(size_t elemSize)
     : d_ptr(0)
     , m_elemSize(elemSize)
     , m_size(0)
     , m_mapped(0)
+    , m_dirtyStart(0)
+    , m_dirtyEnd(0)
 {
 }
 
@@ -122,6 +404,8 @@ QCLVectorBase::QCLVectorBase(size_t elemSize, const QCLVectorBase &other)
     , m_elemSize(elemSize)
     , m_size(other.m_size)
     , m_mapped(other.m_mapped)
+    , m_dirtyStart(0)
+    , m_dirtyEnd(0)
 {
     if (d_ptr) {
         d_ptr->ref.ref();
@@ -148,6 +432,20 @@ void QCLVectorBase::assign(const QCLVectorBase &other)
     }
 }
 
+static cl_mem qt_cl_create_vector_buffer
+    (QCLContext *context, size_t size, QCLMemoryObject::Access access,
+     cl_int *error)
+{
+    return clCreateBuffer
+        (context->contextId(),
+#ifndef QT_CL_COPY_VECTOR
+            cl_mem_flags(access) | CL_MEM_ALLOC_HOST_PTR,
+#else
+            cl_mem_flags(access),
+#endif
+         size, 0, error);
+}
+
 void QCLVectorBase::create
     (QCLContext *context, int size, QCLMemoryObject::Access access)
 {
@@ -155,21 +453,33 @@ void QCLVectorBase::create
     d_ptr = new QCLVectorBasePrivate();
     Q_CHECK_PTR(d_ptr);
     d_ptr->owners.append(this);
+    if (!context->isCreated() && (context->isHostFallbackEnabled() ||
+                                  !QCLContext::isOpenCLAvailable())) {
+        // There is no device to allocate on, so fall back to host memory.
+        void *data = qMallocAligned
+            (qMax(size_t(size), size_t(1)) * m_elemSize, QCLVectorHostAlignment);
+        Q_CHECK_PTR(data);
+        d_ptr->context = context;
+        d_ptr->access = access;
+        d_ptr->state = State_InHost;
+        d_ptr->hostCopy = data;
+        d_ptr->hostOnly = true;
+        d_ptr->capacity = size;
+        m_size = size;
+        m_mapped = data;
+        return;
+    }
     cl_int error;
-    cl_mem id = clCreateBuffer
-        (context->contextId(),
-#ifndef QT_CL_COPY_VECTOR
-            cl_mem_flags(access) | CL_MEM_ALLOC_HOST_PTR,
-#else
-            cl_mem_flags(access),
-#endif
-         size * m_elemSize, 0, &error);
+    cl_mem id = qt_cl_create_vector_buffer
+        (context, size * m_elemSize, access, &error);
     context->reportError("QCLVector<T>::create:", error);
     if (id) {
         d_ptr->context = context;
         d_ptr->id = id;
+        d_ptr->access = access;
         d_ptr->state = State_Uninitialized;
         d_ptr->hostCopy = 0;
+        d_ptr->capacity = size;
         m_size = size;
     }
 }
@@ -179,9 +489,13 @@ void QCLVectorBase::release()
     if (!d_ptr)
         return;
     if (d_ptr->ref.deref()) {
+        d_ptr->addDirty(m_dirtyStart, m_dirtyEnd);
+        d_ptr->owners.removeAll(this);
         d_ptr = 0;
         m_size = 0;
         m_mapped = 0;
+        m_dirtyStart = 0;
+        m_dirtyEnd = 0;
         return;
     }
 #ifndef QT_CL_COPY_VECTOR
@@ -189,6 +503,8 @@ void QCLVectorBase::release()
 #else
     // No need to write back if we will discard the contents anyway.
     m_mapped = 0;
+    m_dirtyStart = 0;
+    m_dirtyEnd = 0;
 #endif
     if (d_ptr->id) {
         clReleaseMemObject(d_ptr->id);
@@ -198,31 +514,52 @@ void QCLVectorBase::release()
     d_ptr->state = State_Uninitialized;
     m_size = 0;
     if (d_ptr->hostCopy) {
-        ::free(d_ptr->hostCopy);
+        if (d_ptr->hostOnly)
+            qFreeAligned(d_ptr->hostCopy);
+        else
+            ::free(d_ptr->hostCopy);
         d_ptr->hostCopy = 0;
     }
+    m_mapped = 0;
     delete d_ptr;
     d_ptr = 0;
 }
 
 void QCLVectorBase::map()
 {
+    // Host vectors are always mapped.
+    if (d_ptr && d_ptr->hostOnly) {
+        m_mapped = d_ptr->hostCopy;
+        return;
+    }
+
     // Bail out if no buffer, or already mapped.
     if (!d_ptr || !d_ptr->id || m_mapped)
         return;
 
 #ifndef QT_CL_COPY_VECTOR
     cl_int error;
+    cl_event event = 0;
     m_mapped = clEnqueueMapBuffer
         (d_ptr->context->activeQueue(), d_ptr->id,
          CL_TRUE, CL_MAP_READ | CL_MAP_WRITE,
-         0, m_size * m_elemSize, 0, 0, 0, &error);
+         0, m_size * m_elemSize, 0, 0,
+         d_ptr->context->profilingEvent(&event), &error);
     d_ptr->context->reportError("QCLVector<T>::map:", error);
+    if (event) {
+        d_ptr->context->recordCommand(event, QCLEventList());
+        clReleaseEvent(event);
+    }
+    // The contents may be modified through the mapping, so they must
+    // be preserved from now on, for example by reallocate().
+    if (m_mapped)
+        d_ptr->state = State_InHost;
 #else
     // We cannot map the buffer directly, so do an explicit read-back.
-    // We skip the read-back if the buffer was not recently in a kernel.
-    void *hostPtr = d_ptr->hostPointer(m_size * m_elemSize);
-    if (d_ptr->state == State_InKernel) {
+    // We skip the read-back if the host copy is still up to date,
+    // which is the case unless a kernel may have written to the buffer.
+    void *hostPtr = d_ptr->hostPointer(m_elemSize);
+    if (d_ptr->state != State_Uninitialized && !d_ptr->hostValid) {
         cl_int error = clEnqueueReadBuffer
             (d_ptr->context->activeQueue(), d_ptr->id, CL_TRUE,
              0, m_size * m_elemSize, hostPtr, 0, 0, 0);
@@ -230,8 +567,13 @@ void QCLVectorBase::map()
         if (error == CL_SUCCESS)
             m_mapped = hostPtr;
     } else {
+        // The previous upload may still be reading from the host copy.
+        if (!d_ptr->lastUpload.isNull())
+            d_ptr->lastUpload.waitForFinished();
         m_mapped = hostPtr;
     }
+    d_ptr->lastUpload = QCLEvent();
+    d_ptr->hostValid = (m_mapped != 0);
     d_ptr->state = State_InHost;
 #endif
 
@@ -247,18 +589,33 @@ void QCLVectorBase::map()
 
 void QCLVectorBase::unmap() const
 {
-    if (m_mapped) {
+    if (m_mapped && !d_ptr->hostOnly) {
 #ifndef QT_CL_COPY_VECTOR
         cl_int error = clEnqueueUnmapMemObject
             (d_ptr->context->activeQueue(), d_ptr->id, m_mapped, 0, 0, 0);
         d_ptr->context->reportError("QCLVector<T>::unmap:", error);
 #else
-        // Write the local copy back to the OpenCL device.
+        // Write the modified ranges of the local copy back to the device.
         if (d_ptr->hostCopy && d_ptr->state == State_InHost) {
-            cl_int error = clEnqueueWriteBuffer
-                (d_ptr->context->activeQueue(), d_ptr->id, CL_FALSE,
-                 0, m_size * m_elemSize, d_ptr->hostCopy, 0, 0, 0);
-            d_ptr->context->reportError("QCLVector<T>::unmap(write):", error);
+            d_ptr->collectDirty();
+            d_ptr->mergeDirty();
+            cl_command_queue queue = d_ptr->context->activeQueue();
+            for (int index = 0; index < d_ptr->dirty.size(); ++index) {
+                size_t start = d_ptr->dirty[index].first * m_elemSize;
+                size_t end = d_ptr->dirty[index].second * m_elemSize;
+                cl_event event = 0;
+                cl_int error = clEnqueueWriteBuffer
+                    (queue, d_ptr->id, CL_FALSE, start, end - start,
+                     reinterpret_cast<uchar *>(d_ptr->hostCopy) + start,
+                     0, 0, &event);
+                d_ptr->context->reportError("QCLVector<T>::unmap(write):", error);
+                if (error != CL_SUCCESS) {
+                    d_ptr->hostValid = false;
+                    break;
+                }
+                d_ptr->lastUpload = QCLEvent(event);
+            }
+            d_ptr->dirty.clear();
         }
         d_ptr->state = State_InKernel;
 #endif
@@ -281,12 +638,16 @@ void QCLVectorBase::read(void *data, int count, int offset)
         return;
     if (m_mapped) {
         ::memcpy(data, reinterpret_cast<uchar *>(m_mapped) + offset, count);
+#ifdef QT_CL_COPY_VECTOR
+    } else if (d_ptr && d_ptr->hostCopy && d_ptr->hostValid) {
+        // The host copy is up to date, so no need to download.
+        ::memcpy(data, reinterpret_cast<uchar *>(d_ptr->hostCopy) + offset, count);
+#endif
     } else if (d_ptr && d_ptr->id) {
         cl_int error = clEnqueueReadBuffer
             (d_ptr->context->activeQueue(), d_ptr->id, CL_TRUE,
              offset, count, data, 0, 0, 0);
         d_ptr->context->reportError("QCLVector<T>::read:", error);
-        d_ptr->state = State_InKernel;
     }
 }
 
@@ -296,15 +657,224 @@ void QCLVectorBase::write(const void *data, int count, int offset)
         return;
     if (m_mapped) {
         ::memcpy(reinterpret_cast<uchar *>(m_mapped) + offset, data, count);
+#ifdef QT_CL_COPY_VECTOR
+        if (!d_ptr->hostOnly)
+            d_ptr->addDirty(offset / m_elemSize, (offset + count) / m_elemSize);
+#endif
     } else if (d_ptr && d_ptr->id) {
         cl_int error = clEnqueueWriteBuffer
             (d_ptr->context->activeQueue(), d_ptr->id, CL_TRUE,
              offset, count, data, 0, 0, 0);
         d_ptr->context->reportError("QCLVector<T>::write:", error);
+#ifdef QT_CL_COPY_VECTOR
+        // Keep the host copy in sync so that it need not be downloaded.
+        if (d_ptr->hostCopy && d_ptr->hostValid) {
+            if (error == CL_SUCCESS) {
+                ::memcpy(reinterpret_cast<uchar *>(d_ptr->hostCopy) + offset,
+                         data, count);
+            } else {
+                d_ptr->hostValid = false;
+            }
+        }
+#endif
         d_ptr->state = State_InKernel;
     }
 }
 
+void QCLVectorBase::reallocate(size_t capacity)
+{
+    if (d_ptr->hostOnly) {
+        void *data = qReallocAligned
+            (d_ptr->hostCopy, qMax(capacity, size_t(1)) * m_elemSize,
+             qMax(d_ptr->capacity, size_t(1)) * m_elemSize,
+             QCLVectorHostAlignment);
+        if (!data) {
+            qWarning() << "QCLVector<T>::reallocate: out of host memory";
+            return;
+        }
+        d_ptr->hostCopy = data;
+        d_ptr->capacity = capacity;
+        d_ptr->setMapped(data);
+        return;
+    }
+
+    // Hand any host modifications back to the device before copying.
+    unmap();
+
+    QCLContext *context = d_ptr->context;
+    cl_int error;
+    cl_mem id = qt_cl_create_vector_buffer
+        (context, capacity * m_elemSize, d_ptr->access, &error);
+    context->reportError("QCLVector<T>::reallocate:", error);
+    if (!id)
+        return;
+
+    // Copy the existing elements on the device; the old buffer will be
+    // freed by OpenCL once the copy has completed.
+    size_t count = qMin(m_size, capacity);
+    if (count > 0 && d_ptr->state != State_Uninitialized) {
+        error = clEnqueueCopyBuffer
+            (context->activeQueue(), d_ptr->id, id,
+             0, 0, count * m_elemSize, 0, 0, 0);
+        context->reportError("QCLVector<T>::reallocate(copy):", error);
+        if (error != CL_SUCCESS) {
+            clReleaseMemObject(id);
+            return;
+        }
+    }
+    clReleaseMemObject(d_ptr->id);
+    d_ptr->id = id;
+    d_ptr->capacity = capacity;
+
+    if (d_ptr->hostCopy) {
+        // Pending uploads may still be reading from the old host copy.
+        if (!d_ptr->lastUpload.isNull()) {
+            d_ptr->lastUpload.waitForFinished();
+            d_ptr->lastUpload = QCLEvent();
+        }
+        void *hostCopy = ::realloc(d_ptr->hostCopy, capacity * m_elemSize);
+        if (hostCopy) {
+            d_ptr->hostCopy = hostCopy;
+        } else {
+            ::free(d_ptr->hostCopy);
+            d_ptr->hostCopy = 0;
+            d_ptr->hostValid = false;
+        }
+    }
+}
+
+void QCLVectorBase::reserve(size_t capacity)
+{
+    if (d_ptr && d_ptr->isAllocated() && capacity > d_ptr->capacity)
+        reallocate(capacity);
+}
+
+void QCLVectorBase::resize(size_t size)
+{
+    if (!d_ptr || !d_ptr->isAllocated() || size == m_size)
+        return;
+    if (size > d_ptr->capacity) {
+        // Grow geometrically so that repeated appends are amortized.
+        reallocate(qMax(size, d_ptr->capacity * 2));
+        if (size > d_ptr->capacity)
+            return;     // Allocation failed.
+    } else if (size > m_size) {
+        // The current mapping does not cover the new elements.
+        unmap();
+    }
+    d_ptr->setSize(size);
+}
+
+void QCLVectorBase::shrinkToFit()
+{
+    if (d_ptr && d_ptr->isAllocated() && m_size > 0 && d_ptr->capacity > m_size)
+        reallocate(m_size);
+}
+
+size_t QCLVectorBase::capacity() const
+{
+    return d_ptr ? d_ptr->capacity : 0;
+}
+
+void QCLVectorBase::mapRange
+    (QCLVectorViewBase *view, size_t offset, size_t size,
+     QCLMemoryObject::Access access, bool blocking, const QCLEventList &after)
+{
+    if (!d_ptr || !d_ptr->isAllocated())
+        return;
+
+    QCLVectorViewPrivate *vd = new QCLVectorViewPrivate();
+    vd->offset = offset;
+    vd->size = size;
+    vd->access = access;
+    view->d_ptr = vd;
+    view->m_size = int(size / m_elemSize);
+
+    // Host vectors need no transfer; the view points at the elements.
+    if (d_ptr->hostOnly) {
+        view->m_data = reinterpret_cast<uchar *>(d_ptr->hostCopy) + offset;
+        return;
+    }
+
+    vd->id = d_ptr->id;
+    clRetainMemObject(vd->id);
+
+    // Use the existing whole-vector mapping from operator[] if there is one.
+    if (m_mapped) {
+        view->m_data = reinterpret_cast<uchar *>(m_mapped) + offset;
+        return;
+    }
+
+    vd->queue = d_ptr->context->activeQueue();
+    clRetainCommandQueue(vd->queue);
+    cl_event event = 0;
+    cl_int error;
+#ifndef QT_CL_COPY_VECTOR
+    cl_map_flags flags;
+    if (access == QCLMemoryObject::ReadOnly) {
+        flags = CL_MAP_READ;
+    } else if (access == QCLMemoryObject::WriteOnly) {
+        if (d_ptr->context->defaultDevice().versionFlags() &
+                QCLPlatform::Version_1_2)
+            flags = CL_MAP_WRITE_INVALIDATE_REGION;
+        else
+            flags = CL_MAP_WRITE;
+    } else {
+        flags = CL_MAP_READ | CL_MAP_WRITE;
+    }
+    vd->mapped = clEnqueueMapBuffer
+        (vd->queue, vd->id, blocking ? CL_TRUE : CL_FALSE, flags,
+         offset, size, after.size(), after.eventData(),
+         blocking ? d_ptr->context->profilingEvent(&event) : &event, &error);
+    d_ptr->context->reportError("QCLVector<T>::mapRange:", error);
+    d_ptr->context->recordCommand(event, after);
+    if (blocking && event) {
+        clReleaseEvent(event);
+        event = 0;
+    }
+    if (!vd->mapped) {
+        view->d_ptr = 0;
+        view->m_size = 0;
+        delete vd;
+        return;
+    }
+    if (access != QCLMemoryObject::ReadOnly)
+        d_ptr->state = State_InKernel;
+    vd->ownsMapping = true;
+    view->m_data = vd->mapped;
+#else
+    // We cannot map the buffer directly, so read the range into a
+    // separate host copy, unless its contents will be overwritten.
+    vd->hostCopy = ::malloc(size);
+    if (access != QCLMemoryObject::WriteOnly &&
+            d_ptr->state != State_Uninitialized) {
+        error = clEnqueueReadBuffer
+            (vd->queue, vd->id, blocking ? CL_TRUE : CL_FALSE,
+             offset, size, vd->hostCopy, after.size(), after.eventData(),
+             blocking ? 0 : &event);
+        d_ptr->context->reportError("QCLVector<T>::mapRange(read):", error);
+        if (error != CL_SUCCESS) {
+            ::free(vd->hostCopy);
+            vd->hostCopy = 0;
+            view->d_ptr = 0;
+            view->m_size = 0;
+            delete vd;
+            return;
+        }
+    }
+    vd->ownsMapping = true;
+    vd->mapped = vd->hostCopy;
+    view->m_data = vd->mapped;
+    if (access != QCLMemoryObject::ReadOnly) {
+        // The range is written straight back to the device on unmap.
+        d_ptr->hostValid = false;
+        d_ptr->state = State_InKernel;
+    }
+#endif
+    if (event)
+        vd->event = QCLEvent(event);
+}
+
 cl_mem QCLVectorBase::memoryId() const
 {
     return d_ptr ? d_ptr->id : 0;
@@ -315,11 +885,30 @@ QCLContext *QCLVectorBase::context() const
     return d_ptr ? d_ptr->context : 0;
 }
 
+bool QCLVectorBase::isHostOnly() const
+{
+    return d_ptr && d_ptr->hostOnly;
+}
+
+void QCLVectorBase::markDirty(size_t index)
+{
+    if (index >= m_dirtyStart && index < m_dirtyEnd)
+        return;
+    if (d_ptr)
+        d_ptr->addDirty(m_dirtyStart, m_dirtyEnd);
+    m_dirtyStart = index;
+    m_dirtyEnd = index + 1;
+}
+
 cl_mem QCLVectorBase::kernelArg() const
 {
     if (d_ptr) {
         unmap();
         d_ptr->state = State_InKernel;
+        // The kernel may modify the buffer unless it is read-only,
+        // in which case the host copy is still valid afterwards.
+        if (d_ptr->access != QCLMemoryObject::ReadOnly)
+            d_ptr->hostValid = false;
         return d_ptr->id;
     } else {
         return 0;
@@ -365,6 +954,16 @@ cl_mem QCLVectorBase::kernelArg() const
     Returns true if this vector is null; false otherwise.
 */
 
+/*!
+    \fn bool QCLVector::isHostOnly() const
+
+    Returns true if the elements of this vector are stored in host
+    memory because the context that created it has not been created;
+    false otherwise.
+
+    \sa {Host vectors}
+*/
+
 /*!
     \fn void QCLVector::release()
 
@@ -390,6 +989,12 @@ cl_mem QCLVectorBase::kernelArg() const
 
     Returns a reference to the element at \a index in this OpenCL vector.
     The vector will be copied to host memory if necessary.
+
+    On platforms where the vector is kept in a separate host copy
+    rather than being mapped, the element is assumed to be modified,
+    and only the modified ranges are written back to the device
+    when the vector is next used by a kernel.  Use the const version
+    of this operator to read elements without marking them as modified.
 */
 
 /*!
@@ -424,6 +1029,22 @@ cl_mem QCLVectorBase::kernelArg() const
     Writes the contents of \a data to \a offset in this vector.
 */
 
+/*!
+    \fn QCLVectorView<T> QCLVector::mapRange(int offset, int count, QCLMemoryObject::Access access, bool blocking, const QCLEventList &after)
+
+    Maps the \a count elements starting at \a offset in this vector
+    into host memory with the specified \a access mode, once the events
+    in \a after have finished.  Returns a view of the elements, which
+    unmaps them when its last copy is destroyed.  Returns a null view
+    if the range could not be mapped.
+
+    If \a blocking is true, this function waits until the elements can
+    be accessed.  Otherwise it returns immediately and the elements must
+    not be accessed until QCLVectorView::event() has finished.
+
+    \sa operator[](), {Mapping ranges}
+*/
+
 /*!
     \fn QCLContext *QCLVector::context() const
 
@@ -434,6 +1055,78 @@ cl_mem QCLVectorBase::kernelArg() const
     \fn QCLBuffer QCLVector::toBuffer() const
 
     Returns the OpenCL buffer handle for this vector.
+
+    The handle refers to the vector's current storage, which is
+    replaced when the vector is reallocated by reserve(), resize(),
+    append(), or shrink_to_fit().
+*/
+
+/*!
+    \fn int QCLVector::capacity() const
+
+    Returns the number of elements that this vector can hold before
+    its storage must be reallocated.
+
+    \sa reserve(), shrink_to_fit()
+*/
+
+/*!
+    \fn void QCLVector::reserve(int size)
+
+    Reallocates the storage for this vector so that it can hold at
+    least \a size elements without further reallocation.  The existing
+    elements are copied to the new storage on the device.  Does
+    nothing if capacity() is already at least \a size.
+
+    All copies of this vector share the new storage.  Views returned
+    by mapRange() and buffers returned by toBuffer() continue to refer
+    to the old storage, and should be released beforehand.
+
+    \sa capacity(), resize()
+*/
+
+/*!
+    \fn void QCLVector::resize(int size)
+
+    Sets the size of this vector to \a size elements.  If \a size is
+    greater than capacity(), the storage is reallocated to at least
+    twice its previous capacity, so that repeated calls to append()
+    take amortized constant time.  The contents of new elements are
+    undefined.
+
+    \sa size(), reserve(), append()
+*/
+
+/*!
+    \fn void QCLVector::append(const T &value)
+
+    Appends \a value to the end of this vector, growing its storage
+    if necessary.
+
+    \sa resize()
+*/
+
+/*!
+    \fn void QCLVector::append(const T *data, int count)
+    \overload
+
+    Appends the \a count elements at \a data to the end of this vector.
+*/
+
+/*!
+    \fn void QCLVector::append(const QVector<T> &data)
+    \overload
+
+    Appends the elements of \a data to the end of this vector.
+*/
+
+/*!
+    \fn void QCLVector::shrink_to_fit()
+
+    Reallocates the storage for this vector so that capacity() is
+    the same as size(), releasing unused device memory.
+
+    \sa capacity(), reserve()
 */
 
 QT_END_NAMESPACE
@@ -52,9 +52,84 @@ QT_BEGIN_NAMESPACE
 
 QT_MODULE(CL)
 
+// Vectors are kept in a separate host copy rather than being mapped
+// directly on platforms where mapping is known to be unreliable.
+#if defined(__APPLE__) || defined(__MACOSX)
+#define QT_CL_COPY_VECTOR 1
+#endif
+
 class QCLContext;
 class QCLKernel;
 class QCLVectorBasePrivate;
+class QCLVectorViewPrivate;
+
+template <typename Derived, typename T>
+class QCLVectorExpression;
+
+class Q_CL_EXPORT QCLVectorViewBase
+{
+public:
+    bool isNull() const { return d_ptr == 0; }
+
+    QCLMemoryObject::Access access() const;
+    QCLEvent event() const;
+    void waitForFinished();
+
+    QCLEvent unmap();
+
+protected:
+    QCLVectorViewBase() : d_ptr(0), m_data(0), m_size(0) {}
+    QCLVectorViewBase(const QCLVectorViewBase &other);
+    ~QCLVectorViewBase();
+
+    void assign(const QCLVectorViewBase &other);
+
+    QCLVectorViewPrivate *d_ptr;
+    void *m_data;
+    int m_size;
+
+    friend class QCLVectorBase;
+};
+
+template <typename T>
+class QCLVectorView : public QCLVectorViewBase
+{
+public:
+    QCLVectorView() {}
+    QCLVectorView(const QCLVectorView<T> &other)
+        : QCLVectorViewBase(other) {}
+
+    QCLVectorView<T> &operator=(const QCLVectorView<T> &other)
+    {
+        assign(other);
+        return *this;
+    }
+
+    inline bool isEmpty() const { return m_size == 0; }
+    inline int size() const { return m_size; }
+
+    inline T *data() { return reinterpret_cast<T *>(m_data); }
+    inline const T *data() const { return reinterpret_cast<const T *>(m_data); }
+    inline const T *constData() const { return reinterpret_cast<const T *>(m_data); }
+
+    inline T *begin() { return data(); }
+    inline T *end() { return data() + m_size; }
+    inline const T *begin() const { return constData(); }
+    inline const T *end() const { return constData() + m_size; }
+
+    inline T &operator[](int index)
+    {
+        Q_ASSERT_X(index >= 0 && index < m_size, "QCLVectorView<T>::operator[]",
+                   "index out of range");
+        return data()[index];
+    }
+    inline const T &operator[](int index) const
+    {
+        Q_ASSERT_X(index >= 0 && index < m_size, "QCLVectorView<T>::operator[]",
+                   "index out of range");
+        return constData()[index];
+    }
+};
 
 class Q_CL_EXPORT QCLVectorBase
 {
@@ -67,6 +142,8 @@ protected:
     size_t m_elemSize;
     size_t m_size;
     mutable void *m_mapped;
+    size_t m_dirtyStart;
+    size_t m_dirtyEnd;
 
     void assign(const QCLVectorBase &other);
 
@@ -75,16 +152,32 @@ protected:
 
     void map();
     void unmap() const;
+    void markDirty(size_t index);
 
     void read(void *data, int count, int offset);
     void write(const void *data, int count, int offset);
 
+    void reallocate(size_t capacity);
+    void reserve(size_t capacity);
+    void resize(size_t size);
+    void shrinkToFit();
+    size_t capacity() const;
+
+    void mapRange(QCLVectorViewBase *view, size_t offset, size_t size,
+                  QCLMemoryObject::Access access, bool blocking,
+                  const QCLEventList &after);
+
     cl_mem memoryId() const;
     QCLContext *context() const;
+    bool isHostOnly() const;
 
     cl_mem kernelArg() const;
 
     friend class QCLKernel;
+    friend class QCLVectorBasePrivate;
+    friend class QCLAlgorithms;
+    friend class QCLVectorExpressionBuilder;
+    friend class QCLCommandList;
 };
 
 template <typename T>
@@ -97,12 +190,25 @@ public:
 
     QCLVector<T> &operator=(const QCLVector<T> &other);
 
+    template <typename Expr>
+    QCLVector<T> &operator=(const QCLVectorExpression<Expr, T> &expression);
+
     bool isNull() const;
+    bool isHostOnly() const;
 
     void release();
 
     inline bool isEmpty() const { return m_size == 0; }
     inline int size() const { return m_size; }
+    inline int capacity() const { return int(QCLVectorBase::capacity()); }
+
+    void reserve(int size);
+    void resize(int size);
+    void shrink_to_fit();
+
+    void append(const T &value);
+    void append(const T *data, int count);
+    void append(const QVector<T> &data);
 
     T &operator[](int index);
     const T &operator[](int index) const;
@@ -111,6 +217,11 @@ public:
     void write(const T *data, int count, int offset = 0);
     void write(const QVector<T> &data, int offset = 0);
 
+    QCLVectorView<T> mapRange
+        (int offset, int count,
+         QCLMemoryObject::Access access = QCLMemoryObject::ReadWrite,
+         bool blocking = true, const QCLEventList &after = QCLEventList());
+
     QCLContext *context() const;
     QCLBuffer toBuffer() const;
 
@@ -154,6 +265,12 @@ Q_INLINE_TEMPLATE bool QCLVector<T>::isNull() const
     return d_ptr == 0;
 }
 
+template <typename T>
+Q_INLINE_TEMPLATE bool QCLVector<T>::isHostOnly() const
+{
+    return QCLVectorBase::isHostOnly();
+}
+
 template <typename T>
 Q_INLINE_TEMPLATE void QCLVector<T>::release()
 {
@@ -167,6 +284,13 @@ Q_INLINE_TEMPLATE T &QCLVector<T>::operator[](int index)
                "index out of range");
     if (!m_mapped)
         map();
+#ifdef QT_CL_COPY_VECTOR
+    // Extend the current dirty run, or start a new one.
+    if (size_t(index) == m_dirtyEnd)
+        ++m_dirtyEnd;
+    else
+        markDirty(index);
+#endif
     return (reinterpret_cast<T *>(m_mapped))[index];
 }
 
@@ -203,6 +327,62 @@ Q_INLINE_TEMPLATE void QCLVector<T>::write
     write(data.constData(), data.size(), offset);
 }
 
+template <typename T>
+Q_INLINE_TEMPLATE void QCLVector<T>::reserve(int size)
+{
+    Q_ASSERT(size >= 0);
+    QCLVectorBase::reserve(size);
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE void QCLVector<T>::resize(int size)
+{
+    Q_ASSERT(size >= 0);
+    QCLVectorBase::resize(size);
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE void QCLVector<T>::shrink_to_fit()
+{
+    QCLVectorBase::shrinkToFit();
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE void QCLVector<T>::append(const T &value)
+{
+    // Take a copy in case value refers to an element of this vector.
+    const T copy(value);
+    append(&copy, 1);
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE void QCLVector<T>::append(const T *data, int count)
+{
+    Q_ASSERT(count >= 0);
+    int offset = int(m_size);
+    QCLVectorBase::resize(m_size + count);
+    if (int(m_size) == offset + count)
+        QCLVectorBase::write(data, count * sizeof(T), offset * sizeof(T));
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE void QCLVector<T>::append(const QVector<T> &data)
+{
+    append(data.constData(), data.size());
+}
+
+template <typename T>
+Q_INLINE_TEMPLATE QCLVectorView<T> QCLVector<T>::mapRange
+    (int offset, int count, QCLMemoryObject::Access access,
+     bool blocking, const QCLEventList &after)
+{
+    Q_ASSERT(count >= 0 && offset >= 0 && (offset + count) <= int(m_size));
+    QCLVectorView<T> view;
+    QCLVectorBase::mapRange(&view, offset * sizeof(T), count * sizeof(T),
+                            access, blocking, after);
+    return view;
+}
+
 template <typename T>
 Q_INLINE_TEMPLATE QCLContext *QCLVector<T>::context() const
 {
@@ -214,7 +394,7 @@ Q_INLINE_TEMPLATE QCLBuffer QCLVector<T>::toBuffer() const
 {
     cl_mem id = QCLVectorBase::memoryId();
     if (id) {
-        clRetainMemObject(id);
+        qt_clRetainMemObject(id);
         return QCLBuffer(context(), id);
     } else {
         return QCLBuffer();
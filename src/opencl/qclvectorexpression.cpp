@@ -0,0 +1,239 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qclvectorexpression.h"
+#include "qclkernel.h"
+#include <QtCore/qdebug.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QCLVectorExpression
+    \brief The QCLVectorExpression class represents an element-wise expression over QCLVector objects.
+    \since 4.7
+    \ingroup opencl
+
+    Arithmetic on QCLVector objects does not run immediately.  Instead,
+    it builds a QCLVectorExpression that describes the whole computation.
+    When the expression is assigned to a vector, it is turned into a
+    single generated OpenCL kernel that reads each input element once
+    and writes the result, so the expression makes only one pass over
+    memory no matter how many operations it contains:
+
+    \code
+    #include <qclvectorexpression.h>
+
+    QCLVector<float> a, b, c, d;
+    ...
+    a = b * c + d;
+    a = qclSqrt(a * a + 1.0f) / 2.0f;
+    \endcode
+
+    The operands may be vectors of the same element type and size, or
+    scalars, which are passed to the kernel as arguments so that changing
+    their value does not require a new kernel.  The supported operators
+    are \c{+}, \c{-}, \c{*}, \c{/} and unary \c{-}, and the functions
+    qclMin(), qclMax(), qclSqrt(), qclExp(), qclLog(), qclSin(), and
+    qclCos(), which map to the OpenCL built-in functions of the same
+    name and so require a floating-point element type.
+
+    The generated program for each distinct expression is built once
+    and cached by the context, using the source of the kernel as the
+    key.  The kernel is queued on the context's active command queue
+    and the assignment returns without waiting for it to finish.
+
+    If the destination vector is null, it is created with the size of
+    the operands; otherwise it is resized to fit.  The destination may
+    also appear in the expression, as in \c{a = a * 2.0f}.
+
+    Expressions hold pointers to their vector operands and should
+    not be stored beyond the statement that creates them.
+
+    Expressions are always evaluated by a kernel, so they cannot involve
+    host vectors (see QCLVector::isHostOnly()).  Assigning such an
+    expression prints a warning instead of running a kernel.
+
+    \sa QCLVector
+*/
+
+/*!
+    \class QCLVectorExpressionBuilder
+    \internal
+*/
+
+QCLVectorExpressionBuilder::QCLVectorExpressionBuilder()
+    : m_context(0)
+    , m_size(-1)
+    , m_sizeMismatch(false)
+{
+}
+
+QCLVectorExpressionBuilder::~QCLVectorExpressionBuilder()
+{
+}
+
+void QCLVectorExpressionBuilder::addVector
+    (const QCLVectorBase &vector, QCLContext *context,
+     int size, const char *typeName)
+{
+    if (!m_context)
+        m_context = context;
+    if (m_size < 0)
+        m_size = size;
+    else if (m_size != size)
+        m_sizeMismatch = true;
+
+    // Vectors that appear more than once are passed to the kernel once.
+    // Copies of a vector share its private data, so compare on that.
+    for (int index = 0; index < m_arguments.size(); ++index) {
+        const Argument &arg = m_arguments.at(index);
+        if (arg.vector && vector.d_ptr && arg.vector->d_ptr == vector.d_ptr) {
+            m_body += 'a';
+            m_body += QByteArray::number(index);
+            m_body += "[i]";
+            return;
+        }
+    }
+    Argument arg;
+    arg.vector = &vector;
+    arg.typeName = typeName;
+    m_body += 'a';
+    m_body += QByteArray::number(m_arguments.size());
+    m_body += "[i]";
+    m_arguments.append(arg);
+}
+
+void QCLVectorExpressionBuilder::addScalar
+    (const void *value, size_t size, const char *typeName)
+{
+    Argument arg;
+    arg.vector = 0;
+    arg.scalar = QByteArray(reinterpret_cast<const char *>(value), int(size));
+    arg.typeName = typeName;
+    m_body += 'a';
+    m_body += QByteArray::number(m_arguments.size());
+    m_arguments.append(arg);
+}
+
+QCLEvent QCLVectorExpressionBuilder::evaluate
+    (const QCLVectorBase &result, const char *typeName)
+{
+    if (!m_context || m_size <= 0)
+        return QCLEvent();
+    if (m_sizeMismatch) {
+        qWarning("QCLVectorExpression: vectors in the expression have different sizes");
+        return QCLEvent();
+    }
+    bool hostOnly = result.isHostOnly();
+    for (int index = 0; index < m_arguments.size(); ++index) {
+        const QCLVectorBase *vector = m_arguments.at(index).vector;
+        if (vector && vector->isHostOnly())
+            hostOnly = true;
+    }
+    if (hostOnly) {
+        qWarning("QCLVectorExpression: expressions cannot be evaluated on host vectors");
+        return QCLEvent();
+    }
+
+    // Generate the kernel.  The source is also the cache key, since it
+    // encodes the structure of the expression and all of the types.
+    QByteArray source;
+    bool needsDouble = (qstrcmp(typeName, "double") == 0);
+    for (int index = 0; index < m_arguments.size(); ++index) {
+        if (qstrcmp(m_arguments.at(index).typeName, "double") == 0)
+            needsDouble = true;
+    }
+    if (needsDouble)
+        source += "#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n";
+    source += "__kernel void qt_cl_expression(__global ";
+    source += typeName;
+    source += " *result, uint n";
+    for (int index = 0; index < m_arguments.size(); ++index) {
+        const Argument &arg = m_arguments.at(index);
+        if (arg.vector)
+            source += ", __global const ";
+        else
+            source += ", ";
+        source += arg.typeName;
+        source += arg.vector ? " *a" : " a";
+        source += QByteArray::number(index);
+    }
+    source += ")\n{\n    uint i = get_global_id(0);\n    if (i < n)\n        result[i] = (";
+    source += typeName;
+    source += ")(";
+    source += m_body;
+    source += ");\n}\n";
+
+    QCLProgram program = m_context->builtinProgram
+        (QByteArray("QCLVectorExpression:") + source, source.constData());
+    if (program.isNull()) {
+        qWarning() << "QCLVectorExpression: could not build" << m_body;
+        return QCLEvent();
+    }
+    QCLKernel kernel = program.cachedKernel
+        ("qt_cl_expression", QCLProgram::PerThreadKernel);
+    if (kernel.isNull())
+        return QCLEvent();
+    kernel.setGlobalWorkSize(m_size);
+    kernel.setArg(0, result);
+    kernel.setArg(1, cl_uint(m_size));
+    for (int index = 0; index < m_arguments.size(); ++index) {
+        const Argument &arg = m_arguments.at(index);
+        if (arg.vector)
+            kernel.setArg(index + 2, *arg.vector);
+        else
+            kernel.setArg(index + 2, arg.scalar.constData(), arg.scalar.size());
+    }
+    return kernel.run();
+}
+
+/*!
+    \fn QCLVector<T> &QCLVector::operator=(const QCLVectorExpression<Expr, T> &expression)
+
+    Evaluates \a expression on the device and stores the result in
+    this vector, using a single generated kernel.  If this vector is
+    null, it is created on the context of the vectors in \a expression.
+
+    \sa QCLVectorExpression
+*/
+
+QT_END_NAMESPACE
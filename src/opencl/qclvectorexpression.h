@@ -0,0 +1,342 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QCLVECTOREXPRESSION_H
+#define QCLVECTOREXPRESSION_H
+
+#include "qclcontext.h"
+#include <QtCore/qbytearray.h>
+#include <QtCore/qvector.h>
+
+QT_BEGIN_HEADER
+
+QT_BEGIN_NAMESPACE
+
+QT_MODULE(CL)
+
+class Q_CL_EXPORT QCLVectorExpressionBuilder
+{
+public:
+    QCLVectorExpressionBuilder();
+    ~QCLVectorExpressionBuilder();
+
+    QCLContext *context() const { return m_context; }
+    int size() const { return m_size; }
+
+    void addVector(const QCLVectorBase &vector, QCLContext *context,
+                   int size, const char *typeName);
+    void addScalar(const void *value, size_t size, const char *typeName);
+    void append(const char *text) { m_body += text; }
+
+    QCLEvent evaluate(const QCLVectorBase &result, const char *typeName);
+
+private:
+    struct Argument
+    {
+        const QCLVectorBase *vector;
+        QByteArray scalar;
+        const char *typeName;
+    };
+
+    QCLContext *m_context;
+    int m_size;
+    bool m_sizeMismatch;
+    QByteArray m_body;
+    QVector<Argument> m_arguments;
+
+    Q_DISABLE_COPY(QCLVectorExpressionBuilder)
+};
+
+template <typename T>
+struct QCLVectorExpressionType;
+
+#define Q_CL_DECLARE_VECTOR_EXPRESSION_TYPE(type, typeName) \
+    template <> \
+    struct QCLVectorExpressionType<type> \
+    { \
+        static const char *name() { return typeName; } \
+    };
+
+Q_CL_DECLARE_VECTOR_EXPRESSION_TYPE(cl_char, "char")
+Q_CL_DECLARE_VECTOR_EXPRESSION_TYPE(cl_uchar, "uchar")
+Q_CL_DECLARE_VECTOR_EXPRESSION_TYPE(cl_short, "short")
+Q_CL_DECLARE_VECTOR_EXPRESSION_TYPE(cl_ushort, "ushort")
+Q_CL_DECLARE_VECTOR_EXPRESSION_TYPE(cl_int, "int")
+Q_CL_DECLARE_VECTOR_EXPRESSION_TYPE(cl_uint, "uint")
+Q_CL_DECLARE_VECTOR_EXPRESSION_TYPE(cl_long, "long")
+Q_CL_DECLARE_VECTOR_EXPRESSION_TYPE(cl_ulong, "ulong")
+Q_CL_DECLARE_VECTOR_EXPRESSION_TYPE(cl_float, "float")
+Q_CL_DECLARE_VECTOR_EXPRESSION_TYPE(cl_double, "double")
+
+// Prevents scalar arguments from taking part in template deduction,
+// so that "vector * 2" works for a QCLVector<float>.
+template <typename T>
+struct QCLVectorExpressionScalarArg
+{
+    typedef T Type;
+};
+
+template <typename Derived, typename T>
+class QCLVectorExpression
+{
+public:
+    typedef T ValueType;
+
+    const Derived &derived() const
+        { return *static_cast<const Derived *>(this); }
+};
+
+template <typename T>
+class QCLVectorExpressionTerminal
+    : public QCLVectorExpression<QCLVectorExpressionTerminal<T>, T>
+{
+public:
+    explicit QCLVectorExpressionTerminal(const QCLVector<T> &vector)
+        : m_vector(&vector) {}
+
+    void build(QCLVectorExpressionBuilder *builder) const
+    {
+        builder->addVector(*m_vector, m_vector->context(), m_vector->size(),
+                           QCLVectorExpressionType<T>::name());
+    }
+
+private:
+    const QCLVector<T> *m_vector;
+};
+
+template <typename T>
+class QCLVectorExpressionScalar
+    : public QCLVectorExpression<QCLVectorExpressionScalar<T>, T>
+{
+public:
+    explicit QCLVectorExpressionScalar(const T &value) : m_value(value) {}
+
+    void build(QCLVectorExpressionBuilder *builder) const
+    {
+        builder->addScalar(&m_value, sizeof(T),
+                           QCLVectorExpressionType<T>::name());
+    }
+
+private:
+    T m_value;
+};
+
+template <typename E, typename T>
+class QCLVectorExpressionUnary
+    : public QCLVectorExpression<QCLVectorExpressionUnary<E, T>, T>
+{
+public:
+    QCLVectorExpressionUnary(const char *op, const E &operand)
+        : m_op(op), m_operand(operand) {}
+
+    void build(QCLVectorExpressionBuilder *builder) const
+    {
+        builder->append(m_op);
+        builder->append("(");
+        m_operand.build(builder);
+        builder->append(")");
+    }
+
+private:
+    const char *m_op;
+    E m_operand;
+};
+
+template <typename L, typename R, typename T>
+class QCLVectorExpressionBinary
+    : public QCLVectorExpression<QCLVectorExpressionBinary<L, R, T>, T>
+{
+public:
+    QCLVectorExpressionBinary(const char *op, bool function,
+                              const L &left, const R &right)
+        : m_op(op), m_function(function), m_left(left), m_right(right) {}
+
+    void build(QCLVectorExpressionBuilder *builder) const
+    {
+        if (m_function) {
+            builder->append(m_op);
+            builder->append("(");
+            m_left.build(builder);
+            builder->append(", ");
+            m_right.build(builder);
+            builder->append(")");
+        } else {
+            builder->append("(");
+            m_left.build(builder);
+            builder->append(" ");
+            builder->append(m_op);
+            builder->append(" ");
+            m_right.build(builder);
+            builder->append(")");
+        }
+    }
+
+private:
+    const char *m_op;
+    bool m_function;
+    L m_left;
+    R m_right;
+};
+
+#define Q_CL_VECTOR_EXPRESSION_BINARY(name, op, function) \
+template <typename L, typename R, typename T> \
+inline QCLVectorExpressionBinary<L, R, T> name \
+    (const QCLVectorExpression<L, T> &left, \
+     const QCLVectorExpression<R, T> &right) \
+{ \
+    return QCLVectorExpressionBinary<L, R, T> \
+        (op, function, left.derived(), right.derived()); \
+} \
+template <typename L, typename T> \
+inline QCLVectorExpressionBinary<L, QCLVectorExpressionTerminal<T>, T> name \
+    (const QCLVectorExpression<L, T> &left, const QCLVector<T> &right) \
+{ \
+    return QCLVectorExpressionBinary<L, QCLVectorExpressionTerminal<T>, T> \
+        (op, function, left.derived(), QCLVectorExpressionTerminal<T>(right)); \
+} \
+template <typename R, typename T> \
+inline QCLVectorExpressionBinary<QCLVectorExpressionTerminal<T>, R, T> name \
+    (const QCLVector<T> &left, const QCLVectorExpression<R, T> &right) \
+{ \
+    return QCLVectorExpressionBinary<QCLVectorExpressionTerminal<T>, R, T> \
+        (op, function, QCLVectorExpressionTerminal<T>(left), right.derived()); \
+} \
+template <typename T> \
+inline QCLVectorExpressionBinary<QCLVectorExpressionTerminal<T>, \
+                                 QCLVectorExpressionTerminal<T>, T> name \
+    (const QCLVector<T> &left, const QCLVector<T> &right) \
+{ \
+    return QCLVectorExpressionBinary<QCLVectorExpressionTerminal<T>, \
+                                     QCLVectorExpressionTerminal<T>, T> \
+        (op, function, QCLVectorExpressionTerminal<T>(left), \
+         QCLVectorExpressionTerminal<T>(right)); \
+} \
+template <typename L, typename T> \
+inline QCLVectorExpressionBinary<L, QCLVectorExpressionScalar<T>, T> name \
+    (const QCLVectorExpression<L, T> &left, \
+     typename QCLVectorExpressionScalarArg<T>::Type right) \
+{ \
+    return QCLVectorExpressionBinary<L, QCLVectorExpressionScalar<T>, T> \
+        (op, function, left.derived(), QCLVectorExpressionScalar<T>(right)); \
+} \
+template <typename R, typename T> \
+inline QCLVectorExpressionBinary<QCLVectorExpressionScalar<T>, R, T> name \
+    (typename QCLVectorExpressionScalarArg<T>::Type left, \
+     const QCLVectorExpression<R, T> &right) \
+{ \
+    return QCLVectorExpressionBinary<QCLVectorExpressionScalar<T>, R, T> \
+        (op, function, QCLVectorExpressionScalar<T>(left), right.derived()); \
+} \
+template <typename T> \
+inline QCLVectorExpressionBinary<QCLVectorExpressionTerminal<T>, \
+                                 QCLVectorExpressionScalar<T>, T> name \
+    (const QCLVector<T> &left, \
+     typename QCLVectorExpressionScalarArg<T>::Type right) \
+{ \
+    return QCLVectorExpressionBinary<QCLVectorExpressionTerminal<T>, \
+                                     QCLVectorExpressionScalar<T>, T> \
+        (op, function, QCLVectorExpressionTerminal<T>(left), \
+         QCLVectorExpressionScalar<T>(right)); \
+} \
+template <typename T> \
+inline QCLVectorExpressionBinary<QCLVectorExpressionScalar<T>, \
+                                 QCLVectorExpressionTerminal<T>, T> name \
+    (typename QCLVectorExpressionScalarArg<T>::Type left, \
+     const QCLVector<T> &right) \
+{ \
+    return QCLVectorExpressionBinary<QCLVectorExpressionScalar<T>, \
+                                     QCLVectorExpressionTerminal<T>, T> \
+        (op, function, QCLVectorExpressionScalar<T>(left), \
+         QCLVectorExpressionTerminal<T>(right)); \
+}
+
+Q_CL_VECTOR_EXPRESSION_BINARY(operator+, "+", false)
+Q_CL_VECTOR_EXPRESSION_BINARY(operator-, "-", false)
+Q_CL_VECTOR_EXPRESSION_BINARY(operator*, "*", false)
+Q_CL_VECTOR_EXPRESSION_BINARY(operator/, "/", false)
+Q_CL_VECTOR_EXPRESSION_BINARY(qclMin, "min", true)
+Q_CL_VECTOR_EXPRESSION_BINARY(qclMax, "max", true)
+
+#define Q_CL_VECTOR_EXPRESSION_UNARY(name, op) \
+template <typename E, typename T> \
+inline QCLVectorExpressionUnary<E, T> name \
+    (const QCLVectorExpression<E, T> &operand) \
+{ \
+    return QCLVectorExpressionUnary<E, T>(op, operand.derived()); \
+} \
+template <typename T> \
+inline QCLVectorExpressionUnary<QCLVectorExpressionTerminal<T>, T> name \
+    (const QCLVector<T> &operand) \
+{ \
+    return QCLVectorExpressionUnary<QCLVectorExpressionTerminal<T>, T> \
+        (op, QCLVectorExpressionTerminal<T>(operand)); \
+}
+
+Q_CL_VECTOR_EXPRESSION_UNARY(operator-, "-")
+Q_CL_VECTOR_EXPRESSION_UNARY(qclSqrt, "sqrt")
+Q_CL_VECTOR_EXPRESSION_UNARY(qclExp, "exp")
+Q_CL_VECTOR_EXPRESSION_UNARY(qclLog, "log")
+Q_CL_VECTOR_EXPRESSION_UNARY(qclSin, "sin")
+Q_CL_VECTOR_EXPRESSION_UNARY(qclCos, "cos")
+
+template <typename T>
+template <typename Expr>
+Q_OUTOFLINE_TEMPLATE QCLVector<T> &QCLVector<T>::operator=
+    (const QCLVectorExpression<Expr, T> &expression)
+{
+    QCLVectorExpressionBuilder builder;
+    expression.derived().build(&builder);
+    if (!builder.context())
+        return *this;
+    if (isNull())
+        *this = builder.context()->createVector<T>(builder.size());
+    else if (size() != builder.size())
+        resize(builder.size());
+    builder.evaluate(*this, QCLVectorExpressionType<T>::name());
+    return *this;
+}
+
+QT_END_NAMESPACE
+
+QT_END_HEADER
+
+#endif
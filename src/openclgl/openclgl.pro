@@ -7,17 +7,25 @@ solaris-cc*:QMAKE_CXXFLAGS_RELEASE -= -O2
 #QMAKE_DOCS = $$PWD/doc/qtopenclgl.qdocconf
 load(qt_module)
 
+# Reach OpenCL through the runtime loader in QtOpenCL; see opencl.pro.
+!macx:!no_opencl_dynamic:CONFIG += opencl_dynamic
+opencl_dynamic {
+    DEFINES += QT_OPENCL_DYNAMIC
+}
+
 win32 {
     !isEmpty(QMAKE_INCDIR_OPENCL) {
         QMAKE_CXXFLAGS += -I$$QMAKE_INCDIR_OPENCL
     }
-    !isEmpty(QMAKE_LIBDIR_OPENCL) {
-        LIBS += -L$$QMAKE_LIBDIR_OPENCL
-    }
-    !isEmpty(QMAKE_LIBS_OPENCL) {
-        LIBS += $$QMAKE_LIBS_OPENCL
-    } else {
-        LIBS += -lOpenCL
+    !opencl_dynamic {
+        !isEmpty(QMAKE_LIBDIR_OPENCL) {
+            LIBS += -L$$QMAKE_LIBDIR_OPENCL
+        }
+        !isEmpty(QMAKE_LIBS_OPENCL) {
+            LIBS += $$QMAKE_LIBS_OPENCL
+        } else {
+            LIBS += -lOpenCL
+        }
     }
 }
 
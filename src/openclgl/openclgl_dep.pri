@@ -3,17 +3,20 @@ LIBS += -lQtOpenCLGL -lQtOpenCL
 macx:!opencl_configure {
     LIBS += -framework OpenCL
 }
+!macx:!no_opencl_dynamic:CONFIG += opencl_dynamic
 win32 {
     !isEmpty(QMAKE_INCDIR_OPENCL) {
         QMAKE_CXXFLAGS += -I$$QMAKE_INCDIR_OPENCL
     }
-    !isEmpty(QMAKE_LIBDIR_OPENCL) {
-        LIBS += -L$$QMAKE_LIBDIR_OPENCL
-    }
-    !isEmpty(QMAKE_LIBS_OPENCL) {
-        LIBS += $$QMAKE_LIBS_OPENCL
-    } else {
-        LIBS += -lOpenCL
+    !opencl_dynamic {
+        !isEmpty(QMAKE_LIBDIR_OPENCL) {
+            LIBS += -L$$QMAKE_LIBDIR_OPENCL
+        }
+        !isEmpty(QMAKE_LIBS_OPENCL) {
+            LIBS += $$QMAKE_LIBS_OPENCL
+        } else {
+            LIBS += -lOpenCL
+        }
     }
 }
 QT += opengl
@@ -41,6 +41,7 @@
 
 #include "qclcontextgl.h"
 #include "qcl_gl_p.h"
+#include "qclloader_p.h"
 #include <QtCore/qdebug.h>
 #include <QtCore/qvarlengtharray.h>
 
@@ -643,11 +644,12 @@ bool QCLContextGL::isRenderbuffer(const QCLImage2D &image)
 QCLEvent QCLContextGL::acquire(const QCLMemoryObject &mem)
 {
 #ifndef QT_NO_CL_OPENGL
-    cl_event event;
+    cl_event event = 0;
     cl_mem id = mem.memoryId();
     cl_int error = clEnqueueAcquireGLObjects
         (commandQueue().queueId(), 1, &id, 0, 0, &event);
     reportError("QCLContextGL::acquire:", error);
+    recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -678,12 +680,13 @@ QCLEvent QCLContextGL::acquire
     (const QCLMemoryObject &mem, const QCLEventList &after)
 {
 #ifndef QT_NO_CL_OPENGL
-    cl_event event;
+    cl_event event = 0;
     cl_mem id = mem.memoryId();
     cl_int error = clEnqueueAcquireGLObjects
         (commandQueue().queueId(), 1, &id,
          after.size(), after.eventData(), &event);
     reportError("QCLContextGL::acquire(after):", error);
+    recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -710,11 +713,12 @@ QCLEvent QCLContextGL::acquire
 QCLEvent QCLContextGL::release(const QCLMemoryObject &mem)
 {
 #ifndef QT_NO_CL_OPENGL
-    cl_event event;
+    cl_event event = 0;
     cl_mem id = mem.memoryId();
     cl_int error = clEnqueueReleaseGLObjects
         (commandQueue().queueId(), 1, &id, 0, 0, &event);
     reportError("QCLContextGL::release:", error);
+    recordCommand(event, QCLEventList());
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
@@ -746,12 +750,13 @@ QCLEvent QCLContextGL::release
     (const QCLMemoryObject &mem, const QCLEventList &after)
 {
 #ifndef QT_NO_CL_OPENGL
-    cl_event event;
+    cl_event event = 0;
     cl_mem id = mem.memoryId();
     cl_int error = clEnqueueReleaseGLObjects
         (commandQueue().queueId(), 1, &id,
          after.size(), after.eventData(), &event);
     reportError("QCLContextGL::release(after):", error);
+    recordCommand(event, after);
     if (error == CL_SUCCESS)
         return QCLEvent(event);
     else
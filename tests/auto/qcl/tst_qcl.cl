@@ -106,3 +106,11 @@ __kernel void addToVector(__global float *vector, float value)
 {
     vector[get_global_id(0)] += value;
 }
+
+__kernel void sumTwelve(__global __write_only float *output,
+                        float a1, float a2, float a3, float a4,
+                        float a5, float a6, float a7, float a8,
+                        float a9, float a10, int a11)
+{
+    output[0] = a1 + a2 + a3 + a4 + a5 + a6 + a7 + a8 + a9 + a10 + a11;
+}
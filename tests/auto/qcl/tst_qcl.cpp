@@ -41,11 +41,23 @@
 
 #include <QtTest/QtTest>
 #include "qclcontext.h"
+#include "qcleventwatcher.h"
+#include "qclbufferpool.h"
+#include "qclstreambuffer.h"
+#include "qclalgorithms.h"
+#include "qclvectorexpression.h"
+#include "qclcommandlist.h"
+#include "qclprofiler.h"
 #include <QtGui/qvector2d.h>
 #include <QtGui/qvector3d.h>
 #include <QtGui/qvector4d.h>
 #include <QtGui/qmatrix4x4.h>
 #include <QtCore/qpoint.h>
+#include <QtCore/qtemporarydir.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qjsondocument.h>
+#include <algorithm>
 
 class tst_QCL : public QObject
 {
@@ -72,6 +84,31 @@ private slots:
     void qimageFormat();
     void eventList();
     void concurrent();
+    void programCache();
+    void buildAsync();
+    void kernelCache();
+    void argumentCache();
+    void manyArguments();
+    void queuePool();
+    void threadCommandQueue();
+    void eventFutures();
+    void eventWatcher();
+    void bufferPool();
+    void staging();
+    void streamBuffer();
+    void vectorMapRange();
+    void vectorSparseUpdates();
+    void vectorResize();
+    void algorithms();
+    void vectorExpressions();
+    void autoTuneLocalWorkSize();
+    void runDetached();
+    void commandList();
+    void deviceProperties();
+    void discoveryCache();
+    void openCLAvailable();
+    void hostFallback();
+    void profiler();
 
 private:
     QCLContext context;
@@ -919,6 +956,1383 @@ void tst_QCL::concurrent()
 #endif
 }
 
+// Test the on-disk program binary cache.
+void tst_QCL::programCache()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QCLContext ctx;
+    QVERIFY(ctx.create());
+    QVERIFY(ctx.programCacheDirectory().isEmpty());
+    ctx.setProgramCacheDirectory(dir.path());
+    QCOMPARE(ctx.programCacheDirectory(), dir.path());
+    QCOMPARE(ctx.programCacheHits(), 0);
+    QCOMPARE(ctx.programCacheMisses(), 0);
+
+    // The first build is a miss and populates the cache.
+    QCLProgram prog1 = ctx.buildProgramFromSourceFile
+        (QLatin1String(":/tst_qcl.cl"));
+    QVERIFY(!prog1.isNull());
+    QCOMPARE(ctx.programCacheHits(), 0);
+    QCOMPARE(ctx.programCacheMisses(), 1);
+
+    // The second build of the same source should come from the cache.
+    QCLProgram prog2 = ctx.buildProgramFromSourceFile
+        (QLatin1String(":/tst_qcl.cl"));
+    QVERIFY(!prog2.isNull());
+    QVERIFY(prog2 != prog1);
+    QCOMPARE(ctx.programCacheHits(), 1);
+    QCOMPARE(ctx.programCacheMisses(), 1);
+
+    // Different build options must not share the cached binaries.
+    QCLProgram prog3 = ctx.buildProgramFromSourceFile
+        (QLatin1String(":/tst_qcl.cl"), QLatin1String("-cl-fast-relaxed-math"));
+    QVERIFY(!prog3.isNull());
+    QCOMPARE(ctx.programCacheHits(), 1);
+    QCOMPARE(ctx.programCacheMisses(), 2);
+
+    // The cached program must be usable.
+    QCLBuffer buffer = ctx.createBufferDevice
+        (sizeof(float) * 16, QCLMemoryObject::WriteOnly);
+    float buf[16];
+    QCLKernel storeFloat = prog2.createKernel("storeFloat");
+    storeFloat(buffer, 5.0f);
+    buffer.read(buf, sizeof(float));
+    QCOMPARE(buf[0], 5.0f);
+
+    // Corrupt entries are discarded and rebuilt from source.
+    QDir cacheDir(dir.path());
+    foreach (QString name, cacheDir.entryList(QDir::Files)) {
+        QFile file(cacheDir.filePath(name));
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write("garbage");
+    }
+    QCLProgram prog4 = ctx.buildProgramFromSourceFile
+        (QLatin1String(":/tst_qcl.cl"));
+    QVERIFY(!prog4.isNull());
+    QCOMPARE(ctx.programCacheHits(), 1);
+    QCOMPARE(ctx.programCacheMisses(), 3);
+}
+
+// Test asynchronous program builds.
+void tst_QCL::buildAsync()
+{
+#ifndef QT_NO_CONCURRENT
+    QCLProgram prog = context.createProgramFromSourceFile
+        (QLatin1String(":/tst_qcl.cl"));
+    QVERIFY(!prog.isNull());
+    QFuture<bool> future = prog.buildAsync();
+    QVERIFY(future.result());
+    QVERIFY(future.isFinished());
+
+    QCLBuffer buffer = context.createBufferDevice
+        (sizeof(float) * 16, QCLMemoryObject::WriteOnly);
+    float buf[16];
+    QCLKernel storeFloat = prog.createKernel("storeFloat");
+    storeFloat(buffer, 9.0f);
+    buffer.read(buf, sizeof(float));
+    QCOMPARE(buf[0], 9.0f);
+
+    // Build several programs in parallel, one of which is invalid.
+    QFile file(QLatin1String(":/tst_qcl.cl"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QList<QByteArray> sources;
+    sources.append(file.readAll());
+    sources.append(QByteArray("__kernel void broken(__global int *x) { x[0] = ; }"));
+    sources.append(QByteArray("__kernel void clear(__global int *x) { x[get_global_id(0)] = 0; }"));
+    QFuture<QCLProgram> programs = context.buildProgramsAsync(sources);
+    programs.waitForFinished();
+    QCOMPARE(programs.resultCount(), 3);
+    QVERIFY(!programs.resultAt(0).isNull());
+    QVERIFY(programs.resultAt(1).isNull());
+    QVERIFY(!programs.resultAt(2).isNull());
+    QVERIFY(!programs.resultAt(2).createKernel("clear").isNull());
+
+    // An empty list finishes immediately.
+    programs = context.buildProgramsAsync(QList<QByteArray>());
+    QVERIFY(programs.isFinished());
+    QCOMPARE(programs.resultCount(), 0);
+#endif
+}
+
+#ifndef QT_NO_CONCURRENT
+
+static cl_kernel perThreadKernelId(const QCLProgram &program)
+{
+    return program.cachedKernel("storeInt", QCLProgram::PerThreadKernel).kernelId();
+}
+
+#endif
+
+// Test the kernel cache in QCLProgram.
+void tst_QCL::kernelCache()
+{
+    QCLKernel kernel1 = program.cachedKernel("storeFloat");
+    QVERIFY(!kernel1.isNull());
+    QCOMPARE(kernel1.name(), QString(QLatin1String("storeFloat")));
+
+    // Same name returns the same underlying kernel.
+    QCLKernel kernel2 = program.cachedKernel(QByteArray("storeFloat"));
+    QVERIFY(kernel2 == kernel1);
+    QCLKernel kernel3 = program.cachedKernel(QString(QLatin1String("storeFloat")));
+    QVERIFY(kernel3 == kernel1);
+
+    // Different names return different kernels.
+    QCLKernel kernel4 = program.cachedKernel("storeInt");
+    QVERIFY(!kernel4.isNull());
+    QVERIFY(kernel4 != kernel1);
+
+    // Per-thread kernels are distinct from the shared kernel,
+    // but stable within a thread.
+    QCLKernel kernel5 = program.cachedKernel("storeInt", QCLProgram::PerThreadKernel);
+    QVERIFY(!kernel5.isNull());
+    QVERIFY(kernel5 != kernel4);
+    QVERIFY(program.cachedKernel("storeInt", QCLProgram::PerThreadKernel) == kernel5);
+
+#ifndef QT_NO_CONCURRENT
+    cl_kernel other = QtConcurrent::run(perThreadKernelId, program).result();
+    QVERIFY(other != 0);
+    QVERIFY(other != kernel5.kernelId());
+#endif
+
+    // Unknown kernels are not cached.
+    QVERIFY(program.cachedKernel("noSuchKernel").isNull());
+
+    // Clearing the cache creates new kernels on the next request,
+    // but existing handles remain usable.  The calling thread lets go
+    // of its per-thread kernels straight away.
+    cl_uint refs = 0;
+    QVERIFY(clGetKernelInfo(kernel5.kernelId(), CL_KERNEL_REFERENCE_COUNT,
+                            sizeof(refs), &refs, 0) == CL_SUCCESS);
+    program.clearKernelCache();
+    cl_uint refsAfter = 0;
+    QVERIFY(clGetKernelInfo(kernel5.kernelId(), CL_KERNEL_REFERENCE_COUNT,
+                            sizeof(refsAfter), &refsAfter, 0) == CL_SUCCESS);
+    QCOMPARE(refsAfter, refs - 1);
+    QCLKernel kernel6 = program.cachedKernel("storeFloat");
+    QVERIFY(!kernel6.isNull());
+    QVERIFY(kernel6 != kernel1);
+    QCLKernel kernel7 = program.cachedKernel("storeInt", QCLProgram::PerThreadKernel);
+    QVERIFY(!kernel7.isNull());
+    QVERIFY(kernel7 != kernel5);
+
+    QCLBuffer buffer = context.createBufferDevice
+        (sizeof(float) * 16, QCLMemoryObject::WriteOnly);
+    float buf[16];
+    kernel1(buffer, 3.0f);
+    buffer.read(buf, sizeof(float));
+    QCOMPARE(buf[0], 3.0f);
+}
+
+// Test that redundant argument updates are not passed to OpenCL.
+void tst_QCL::argumentCache()
+{
+    QCLBuffer buffer = context.createBufferDevice
+        (sizeof(float) * 16, QCLMemoryObject::WriteOnly);
+    QCLBuffer buffer2 = context.createBufferDevice
+        (sizeof(float) * 16, QCLMemoryObject::WriteOnly);
+    float buf[16];
+
+    QCLKernel storeFloat = program.createKernel("storeFloat");
+    QCOMPARE(storeFloat.argUpdatesIssued(), quint64(0));
+    QCOMPARE(storeFloat.argUpdatesSkipped(), quint64(0));
+
+    storeFloat(buffer, 5.0f);
+    QCOMPARE(storeFloat.argUpdatesIssued(), quint64(2));
+    QCOMPARE(storeFloat.argUpdatesSkipped(), quint64(0));
+
+    storeFloat(buffer, 5.0f);
+    QCOMPARE(storeFloat.argUpdatesIssued(), quint64(2));
+    QCOMPARE(storeFloat.argUpdatesSkipped(), quint64(2));
+
+    storeFloat(buffer, 6.0f);
+    QCOMPARE(storeFloat.argUpdatesIssued(), quint64(3));
+    QCOMPARE(storeFloat.argUpdatesSkipped(), quint64(3));
+    buffer.read(buf, sizeof(float));
+    QCOMPARE(buf[0], 6.0f);
+
+    // Copies share the argument state of the original.
+    QCLKernel copy(storeFloat);
+    copy(buffer2, 6.0f);
+    QCOMPARE(storeFloat.argUpdatesIssued(), quint64(4));
+    QCOMPARE(storeFloat.argUpdatesSkipped(), quint64(4));
+    storeFloat(buffer, 6.0f);
+    QCOMPARE(storeFloat.argUpdatesIssued(), quint64(5));
+    buffer.read(buf, sizeof(float));
+    QCOMPARE(buf[0], 6.0f);
+
+    // Invalidating the cache forces the next update through.
+    storeFloat.invalidateArgCache();
+    storeFloat(buffer, 6.0f);
+    QCOMPARE(storeFloat.argUpdatesIssued(), quint64(7));
+
+    // Per-thread cached kernels drop their buffers after each launch,
+    // but still skip unchanged values.
+    QCLKernel perThread = program.cachedKernel
+        ("storeFloat", QCLProgram::PerThreadKernel);
+    quint64 issued = perThread.argUpdatesIssued();
+    quint64 skipped = perThread.argUpdatesSkipped();
+    perThread(buffer, 7.0f);
+    perThread(buffer, 7.0f);
+    QCOMPARE(perThread.argUpdatesIssued(), issued + 3);
+    QCOMPARE(perThread.argUpdatesSkipped(), skipped + 1);
+    buffer.read(buf, sizeof(float));
+    QCOMPARE(buf[0], 7.0f);
+}
+
+// Test kernels with more arguments than the old fixed overloads allowed.
+void tst_QCL::manyArguments()
+{
+#if defined(Q_COMPILER_VARIADIC_TEMPLATES)
+    QCLBuffer buffer = context.createBufferDevice
+        (sizeof(float), QCLMemoryObject::WriteOnly);
+    float buf[1];
+
+    QCLKernel sumTwelve = program.createKernel("sumTwelve");
+    QCOMPARE(sumTwelve.argCount(), 12);
+
+    sumTwelve(buffer, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f,
+              6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11).waitForFinished();
+    buffer.read(buf, sizeof(float));
+    QCOMPARE(buf[0], 66.0f);
+
+    QFuture<void> future = QtConcurrent::run
+        (sumTwelve, buffer, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f,
+         2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2);
+    future.waitForFinished();
+    buffer.read(buf, sizeof(float));
+    QCOMPARE(buf[0], 22.0f);
+#else
+    QSKIP("Compiler does not support variadic templates");
+#endif
+}
+
+// Test the pool of command queues and dispatch to explicit queues.
+void tst_QCL::queuePool()
+{
+    QVERIFY(context.queuePool().isEmpty());
+    QCOMPARE(context.acquireQueue(), context.commandQueue());
+
+    QVERIFY(context.createQueuePool(2, 0, context.defaultDevice()));
+    QList<QCLCommandQueue> pool = context.queuePool();
+    QCOMPARE(pool.size(), 2);
+    QVERIFY(pool.at(0) != pool.at(1));
+
+    QCLCommandQueue queue1 = context.acquireQueue();
+    QCLCommandQueue queue2 = context.acquireQueue();
+    QCOMPARE(queue1, pool.at(0));
+    QCOMPARE(queue2, pool.at(1));
+    QCOMPARE(context.acquireQueue(), pool.at(0));
+
+    QCLBuffer buffer = context.createBufferDevice
+        (sizeof(float), QCLMemoryObject::ReadWrite);
+    float value = 0.0f;
+    buffer.writeAsync(queue1, 0, &value, sizeof(value)).waitForFinished();
+
+    QCLKernel addToVector = program.createKernel("addToVector");
+    addToVector.setGlobalWorkSize(1);
+    addToVector.setArg(0, buffer);
+    addToVector.setArg(1, 2.0f);
+    QCLEvent event = addToVector.run(queue2);
+    QVERIFY(!event.isNull());
+    queue2.flush();
+
+    float result = 0.0f;
+    QCLEvent readEvent = buffer.readAsync
+        (queue1, 0, &result, sizeof(result), QCLEventList(event));
+    queue1.finish();
+    QVERIFY(readEvent.isFinished());
+    QCOMPARE(result, 2.0f);
+
+    QCLEvent marker = queue2.marker();
+    QVERIFY(!marker.isNull());
+    marker.waitForFinished();
+
+    // Everything has finished, so least-busy selection is round-robin.
+    QCLCommandQueue least = context.acquireQueue(QCLContext::LeastBusy);
+    QVERIFY(pool.contains(least));
+
+    context.releaseQueuePool();
+    QVERIFY(context.queuePool().isEmpty());
+}
+
+static bool useThreadQueue(QCLContext *context, QCLCommandQueue queue)
+{
+    if (!context->threadCommandQueue().isNull())
+        return false;
+    context->setThreadCommandQueue(queue);
+    bool ok = (context->commandQueue() == queue &&
+               context->threadCommandQueue() == queue);
+    context->setThreadCommandQueue(QCLCommandQueue());
+    return ok && context->threadCommandQueue().isNull();
+}
+
+// Test that per-thread command queues do not leak into other threads.
+void tst_QCL::threadCommandQueue()
+{
+    QCLCommandQueue contextQueue = context.commandQueue();
+    QCLCommandQueue threadQueue = context.createCommandQueue(0);
+    QVERIFY(!threadQueue.isNull());
+    QVERIFY(context.threadCommandQueue().isNull());
+
+    QFuture<bool> future = QtConcurrent::run
+        (useThreadQueue, &context, threadQueue);
+    QVERIFY(future.result());
+    QCOMPARE(context.commandQueue(), contextQueue);
+
+    // Commands from this thread go to the thread's queue.
+    context.setThreadCommandQueue(threadQueue);
+    QCOMPARE(context.commandQueue(), threadQueue);
+    QCLBuffer buffer = context.createBufferDevice
+        (sizeof(float), QCLMemoryObject::ReadWrite);
+    float value = 7.0f;
+    QCLEvent event = buffer.writeAsync(0, &value, sizeof(value));
+    cl_command_queue eventQueue = 0;
+    clGetEventInfo(event.eventId(), CL_EVENT_COMMAND_QUEUE,
+                   sizeof(eventQueue), &eventQueue, 0);
+    QVERIFY(eventQueue == threadQueue.queueId());
+    event.waitForFinished();
+
+    context.setThreadCommandQueue(QCLCommandQueue());
+    QCOMPARE(context.commandQueue(), contextQueue);
+}
+
+// Test that many event futures can be outstanding at once.
+void tst_QCL::eventFutures()
+{
+#if !defined(QT_NO_CONCURRENT) && defined(QT_OPENCL_1_1)
+    QCLUserEvent gate = context.createUserEvent();
+    QVERIFY(!gate.isNull());
+    QCLUserEvent failed = context.createUserEvent();
+    QVERIFY(!failed.isNull());
+
+    // Far more futures than there are threads in the global pool.
+    const int count = QThreadPool::globalInstance()->maxThreadCount() * 16;
+    QList< QFuture<void> > futures;
+    for (int index = 0; index < count; ++index)
+        futures.append(gate.toFuture());
+    QCLEventList list;
+    list << gate << failed;
+    QFuture<void> listFuture = list.toFuture();
+    QVERIFY(!futures.first().isFinished());
+
+    gate.setFinished();
+    for (int index = 0; index < count; ++index) {
+        futures[index].waitForFinished();
+        QVERIFY(!futures.at(index).isCanceled());
+    }
+    QVERIFY(!listFuture.isFinished());
+
+    // Abnormal termination cancels the future.
+    failed.setStatus(-1);
+    listFuture.waitForFinished();
+    QVERIFY(listFuture.isCanceled());
+#else
+    QSKIP("Event callbacks require OpenCL 1.1");
+#endif
+}
+
+#ifdef QT_BUILD_INTERNAL
+QT_BEGIN_NAMESPACE
+extern Q_CL_EXPORT int qt_cl_event_watcher_queued(const QCLEventWatcher *watcher);
+QT_END_NAMESPACE
+#endif
+
+// Test signal delivery and batching in QCLEventWatcher.
+void tst_QCL::eventWatcher()
+{
+#ifdef QT_OPENCL_1_1
+    QCLEventWatcher watcher;
+    QSignalSpy finishedSpy(&watcher, SIGNAL(finished(QCLEventList)));
+    QSignalSpy erroredSpy(&watcher, SIGNAL(errored(QCLEvent,cl_int)));
+    QSignalSpy allFinishedSpy(&watcher, SIGNAL(allFinished()));
+    QVERIFY(watcher.isFinished());
+
+    QCLUserEvent event1 = context.createUserEvent();
+    QCLUserEvent event2 = context.createUserEvent();
+    QCLUserEvent event3 = context.createUserEvent();
+    watcher.addEvent(event1);
+    watcher.addEvents(QCLEventList(event2) << event3);
+    QCOMPARE(watcher.pendingCount(), 3);
+
+    // Completions that arrive before the event loop runs are
+    // delivered as a single batch.  Developer builds can wait for both
+    // callbacks to record their event without processing events, so
+    // that the delivery cannot run in between.
+    event1.setFinished();
+    event2.setFinished();
+#ifdef QT_BUILD_INTERNAL
+    QElapsedTimer timer;
+    timer.start();
+    while (qt_cl_event_watcher_queued(&watcher) < 2 && timer.elapsed() < 5000)
+        QThread::yieldCurrentThread();
+    QCOMPARE(qt_cl_event_watcher_queued(&watcher), 2);
+    QCOMPARE(finishedSpy.count(), 0);
+    QTRY_COMPARE(watcher.pendingCount(), 1);
+    QCOMPARE(finishedSpy.count(), 1);
+    QCLEventList batch = finishedSpy.at(0).at(0).value<QCLEventList>();
+#else
+    QTRY_COMPARE(watcher.pendingCount(), 1);
+    QCLEventList batch;
+    for (int index = 0; index < finishedSpy.count(); ++index)
+        batch += finishedSpy.at(index).at(0).value<QCLEventList>();
+#endif
+    QCOMPARE(batch.size(), 2);
+    QVERIFY(batch.contains(event1));
+    QVERIFY(batch.contains(event2));
+    QCOMPARE(allFinishedSpy.count(), 0);
+
+    event3.setStatus(-1);
+    QTRY_COMPARE(erroredSpy.count(), 1);
+    QCOMPARE(erroredSpy.at(0).at(0).value<QCLEvent>(), QCLEvent(event3));
+    QCOMPARE(allFinishedSpy.count(), 1);
+    QVERIFY(watcher.isFinished());
+#else
+    QSKIP("Event callbacks require OpenCL 1.1");
+#endif
+}
+
+// Test suballocation, recycling and statistics in QCLBufferPool.
+void tst_QCL::bufferPool()
+{
+#ifdef QT_OPENCL_1_1
+    QCLBufferPool pool(&context, 64 * 1024);
+    QCOMPARE(pool.blockSize(), size_t(64 * 1024));
+    QVERIFY(pool.alignment() >= size_t(context.defaultDevice().defaultAlignment()));
+    QCOMPARE(pool.blockCount(), 0);
+
+    QCLBuffer buffer1 = pool.allocate(100);
+    QCLBuffer buffer2 = pool.allocate(100);
+    QVERIFY(!buffer1.isNull());
+    QVERIFY(!buffer2.isNull());
+    QCOMPARE(buffer1.size(), size_t(100));
+    QCOMPARE(pool.blockCount(), 1);
+    QCOMPARE(pool.allocationCount(), 2);
+    QCOMPARE(buffer1.parentBuffer(), buffer2.parentBuffer());
+    QVERIFY(buffer1.offset() != buffer2.offset());
+    QCOMPARE(buffer1.offset() % pool.alignment(), size_t(0));
+    QCOMPARE(buffer2.offset() % pool.alignment(), size_t(0));
+    QCOMPARE(pool.bytesAllocated(), size_t(200));
+    QVERIFY(pool.bytesInUse() >= pool.bytesAllocated());
+
+    // The data in sub-buffers does not overlap.
+    float one = 1.0f, two = 2.0f, result = 0.0f;
+    QVERIFY(buffer1.write(&one, sizeof(float)));
+    QVERIFY(buffer2.write(&two, sizeof(float)));
+    QVERIFY(buffer1.read(&result, sizeof(float)));
+    QCOMPARE(result, 1.0f);
+
+    // Released space is reused by the same size class.
+    size_t offset2 = buffer2.offset();
+    pool.release(buffer2);
+    QCOMPARE(pool.allocationCount(), 1);
+    QVERIFY(pool.bytesFree() > 0);
+    QCLBuffer buffer3 = pool.allocate(90);
+    QCOMPARE(buffer3.offset(), offset2);
+    QCOMPARE(pool.bytesFree(), size_t(0));
+
+    // Large requests get a parent buffer of their own.
+    QCLBuffer large = pool.allocate(100 * 1024);
+    QVERIFY(!large.isNull());
+    QCOMPARE(pool.blockCount(), 2);
+    size_t highWaterMark = pool.highWaterMark();
+    QVERIFY(highWaterMark >= size_t(100 * 1024 + 200));
+
+    // Frame-scoped reset keeps the parent buffers.
+    pool.reset();
+    QCOMPARE(pool.allocationCount(), 0);
+    QCOMPARE(pool.bytesInUse(), size_t(0));
+    QCOMPARE(pool.blockCount(), 2);
+    QCOMPARE(pool.highWaterMark(), highWaterMark);
+    QCLBuffer buffer4 = pool.allocate(100);
+    QCOMPARE(buffer4.offset(), size_t(0));
+    QCOMPARE(pool.blockCount(), 2);
+    QVERIFY(pool.fragmentation() >= 0.0 && pool.fragmentation() <= 1.0);
+
+    pool.clear();
+    QCOMPARE(pool.blockCount(), 0);
+    QCOMPARE(pool.bytesReserved(), size_t(0));
+#else
+    QSKIP("Sub-buffers require OpenCL 1.1");
+#endif
+}
+
+// Test asynchronous transfers through the staging buffers.
+void tst_QCL::staging()
+{
+    QCLContext ctx;
+    QVERIFY(ctx.create());
+    QVERIFY(!ctx.isStagingEnabled());
+    ctx.setStagingSlotSize(4096);
+    QCOMPARE(ctx.stagingSlotSize(), size_t(4096));
+    ctx.setStagingEnabled(true);
+    QVERIFY(ctx.isStagingEnabled());
+
+    const int count = 32;
+    QCLBuffer buffer = ctx.createBufferDevice
+        (sizeof(int) * 256 * count, QCLMemoryObject::ReadWrite);
+
+    // The first write is always staged, so the source data can be
+    // overwritten as soon as writeAsync() returns.
+    int data[4] = {1, 2, 3, 4};
+    QCLEvent event = buffer.writeAsync(0, data, sizeof(data));
+    data[0] = data[1] = data[2] = data[3] = -1;
+    event.waitForFinished();
+    QVERIFY(buffer.read(data, sizeof(data)));
+    QCOMPARE(data[0], 1);
+    QCOMPARE(data[3], 4);
+
+    // More transfers than there are staging slots; the excess
+    // bypasses the pool.
+    QVector<int> source(256 * count);
+    for (int index = 0; index < source.size(); ++index)
+        source[index] = index;
+    QCLEventList writes;
+    for (int index = 0; index < count; ++index) {
+        writes << buffer.writeAsync
+            (sizeof(int) * 256 * index, source.constData() + 256 * index,
+             sizeof(int) * 256);
+    }
+    writes.waitForFinished();
+
+    QVector<int> result(256 * count);
+    QCLEventList reads;
+    for (int index = 0; index < count; ++index) {
+        reads << buffer.readAsync
+            (sizeof(int) * 256 * index, result.data() + 256 * index,
+             sizeof(int) * 256);
+    }
+    reads.waitForFinished();
+    for (int index = 0; index < result.size(); ++index)
+        QCOMPARE(result.at(index), index);
+
+    // Transfers larger than a slot are issued directly.
+    QVector<int> large(2048, 7);
+    QVERIFY(!buffer.writeAsync(0, large.constData(),
+                               sizeof(int) * large.size()).isNull());
+    ctx.finish();
+
+    ctx.setStagingEnabled(false);
+    QVERIFY(!ctx.isStagingEnabled());
+
+    // Discarding the pool while a staged write still holds its slot,
+    // whether or not the write has finished, must not block.
+    ctx.setStagingEnabled(true);
+    QVERIFY(!buffer.writeAsync(0, data, sizeof(data)).isNull());
+    ctx.setStagingEnabled(false);
+    ctx.setStagingEnabled(true);
+    buffer.writeAsync(0, data, sizeof(data)).waitForFinished();
+    ctx.setStagingSlotSize(8192);
+    buffer.writeAsync(0, data, sizeof(data));
+    ctx.finish();
+
+#ifdef QT_OPENCL_1_1
+    // Discarding the pool while staged transfers are waiting for a user
+    // event that has not been set yet must not block either.
+    QCLUserEvent gate = ctx.createUserEvent();
+    QVERIFY(!gate.isNull());
+    int gated[4] = {0, 0, 0, 0};
+    QCLEvent gatedRead = buffer.readAsync(0, gated, sizeof(gated), gate);
+    QCLEvent gatedWrite = buffer.writeAsync(0, data, sizeof(data), gate);
+    ctx.setStagingEnabled(false);
+    gate.setFinished();
+    gatedRead.waitForFinished();
+    gatedWrite.waitForFinished();
+    QCOMPARE(gated[0], 1);
+    QCOMPARE(gated[3], 4);
+#endif
+    ctx.release();
+}
+
+// Test the upload, compute and download ring in QCLStreamBuffer.
+void tst_QCL::streamBuffer()
+{
+    const int frameSize = 64;
+    QCLStreamBuffer stream(&context, sizeof(float) * frameSize, 3);
+    QVERIFY(!stream.isNull());
+    QCOMPARE(stream.depth(), 3);
+    QCOMPARE(stream.available(), 3);
+    QVERIFY(stream.uploadQueue() != stream.downloadQueue());
+
+    QCLKernel addToVector = program.createKernel("addToVector");
+    addToVector.setGlobalWorkSize(frameSize);
+
+    const int frames = 10;
+    QVector<float> input(frameSize * frames);
+    QVector<float> output(frameSize * frames);
+    for (int index = 0; index < input.size(); ++index)
+        input[index] = float(index);
+    QCLEventList downloads;
+    for (int frame = 0; frame < frames; ++frame) {
+        int slot = stream.upload
+            (input.constData() + frame * frameSize, sizeof(float) * frameSize);
+        QVERIFY(slot >= 0 && slot < 3);
+        addToVector.setArg(0, stream.slotBuffer(slot));
+        addToVector.setArg(1, 1.0f);
+        QCLEvent done = addToVector.run
+            (stream.computeQueue(), stream.uploadEvent(slot));
+        stream.computeQueue().flush();
+        downloads << stream.download
+            (slot, output.data() + frame * frameSize,
+             sizeof(float) * frameSize, done);
+    }
+    downloads.waitForFinished();
+    for (int index = 0; index < output.size(); ++index)
+        QCOMPARE(output.at(index), float(index) + 1.0f);
+    QCOMPARE(stream.available(), 3);
+
+    // Slots that are still held by the caller are not handed out again.
+    stream.setBlocking(false);
+    QVERIFY(!stream.isBlocking());
+    int slot1 = stream.acquire();
+    int slot2 = stream.acquire();
+    int slot3 = stream.acquire();
+    QVERIFY(slot1 >= 0 && slot2 >= 0 && slot3 >= 0);
+    QCOMPARE(stream.available(), 0);
+    QTest::ignoreMessage(QtWarningMsg, "QCLStreamBuffer::acquire: all 3 slots are held by the caller");
+    QCOMPARE(stream.acquire(), -1);
+
+    // Non-blocking backpressure: a slot with pending work is skipped.
+    QCLUserEvent gate = context.createUserEvent();
+    if (!gate.isNull()) {
+        stream.setComputeEvent(slot1, gate);
+        stream.release(slot1);
+        stream.release(slot2);
+        stream.release(slot3);
+        QCOMPARE(stream.acquire(), -1);
+        gate.setFinished();
+        QCOMPARE(stream.acquire(), slot1);
+        stream.release(slot1);
+    }
+    stream.finish();
+}
+
+// Test mapping ranges of a vector into host memory.
+void tst_QCL::vectorMapRange()
+{
+    QCLVector<int> vector = context.createVector<int>(1000);
+    QVector<int> zeroes(1000, 0);
+    vector.write(zeroes);
+
+    {
+        QCLVectorView<int> view =
+            vector.mapRange(100, 50, QCLMemoryObject::WriteOnly);
+        QVERIFY(!view.isNull());
+        QCOMPARE(view.size(), 50);
+        QVERIFY(view.access() == QCLMemoryObject::WriteOnly);
+        for (int index = 0; index < view.size(); ++index)
+            view[index] = index + 1;
+    }
+
+    {
+        QCLVectorView<int> view =
+            vector.mapRange(90, 70, QCLMemoryObject::ReadOnly, false);
+        QVERIFY(!view.isNull());
+        view.waitForFinished();
+        for (int index = 0; index < 10; ++index)
+            QCOMPARE(view[index], 0);
+        for (int index = 10; index < 60; ++index)
+            QCOMPARE(view[index], index - 9);
+        for (int index = 60; index < 70; ++index)
+            QCOMPARE(view[index], 0);
+        view.unmap().waitForFinished();
+    }
+
+    int values[50];
+    vector.read(values, 50, 100);
+    for (int index = 0; index < 50; ++index)
+        QCOMPARE(values[index], index + 1);
+    vector.read(values, 1, 99);
+    QCOMPARE(values[0], 0);
+}
+
+// Test that sparse host updates to a vector reach the kernel and that
+// results written by the kernel are read back.
+void tst_QCL::vectorSparseUpdates()
+{
+    QCLVector<float> vector = context.createVector<float>(10000);
+    for (int index = 0; index < vector.size(); ++index)
+        vector[index] = 1.0f;
+
+    QCLKernel addToVector = program.createKernel("addToVector");
+    addToVector.setGlobalWorkSize(vector.size());
+    addToVector(vector, 1.0f).waitForFinished();
+
+    // Modify a few scattered elements and a contiguous run.
+    vector[7] = 10.0f;
+    vector[5000] = 20.0f;
+    vector[3] = 30.0f;
+    for (int index = 9000; index < 9010; ++index)
+        vector[index] = 40.0f;
+    float values[4] = {50.0f, 50.0f, 50.0f, 50.0f};
+    vector.write(values, 4, 100);
+
+    addToVector(vector, 1.0f).waitForFinished();
+
+    const QCLVector<float> &cvector = vector;
+    QCOMPARE(cvector[0], 3.0f);
+    QCOMPARE(cvector[3], 31.0f);
+    QCOMPARE(cvector[7], 11.0f);
+    QCOMPARE(cvector[8], 3.0f);
+    QCOMPARE(cvector[101], 51.0f);
+    QCOMPARE(cvector[104], 3.0f);
+    QCOMPARE(cvector[5000], 21.0f);
+    QCOMPARE(cvector[8999], 3.0f);
+    QCOMPARE(cvector[9000], 41.0f);
+    QCOMPARE(cvector[9009], 41.0f);
+    QCOMPARE(cvector[9010], 3.0f);
+
+    // Reading from the host without modification must not upload
+    // stale data over the kernel's results.
+    addToVector(vector, 1.0f).waitForFinished();
+    QCOMPARE(cvector[0], 4.0f);
+    QCOMPARE(cvector[7], 12.0f);
+}
+
+// Test growing and shrinking the storage of a vector.
+void tst_QCL::vectorResize()
+{
+    QCLVector<int> vector = context.createVector<int>(4);
+    QCOMPARE(vector.size(), 4);
+    QCOMPARE(vector.capacity(), 4);
+    for (int index = 0; index < 4; ++index)
+        vector[index] = index;
+
+    QCLVector<int> copy(vector);
+
+    vector.reserve(16);
+    QCOMPARE(vector.size(), 4);
+    QCOMPARE(vector.capacity(), 16);
+    QCOMPARE(copy.capacity(), 16);
+    QVERIFY(copy.toBuffer().memoryId() == vector.toBuffer().memoryId());
+
+    // Elements that were only written through operator[] survive
+    // the reallocation.
+    for (int index = 0; index < 4; ++index)
+        QCOMPARE(vector[index], index);
+
+    vector.reserve(8);
+    QCOMPARE(vector.capacity(), 16);
+
+    for (int index = 4; index < 100; ++index)
+        vector.append(index);
+    QCOMPARE(vector.size(), 100);
+    QCOMPARE(copy.size(), 100);
+    QVERIFY(vector.capacity() >= 100);
+    QVERIFY(vector.capacity() < 200);
+
+    QVector<int> values(100);
+    copy.read(values.data(), 100);
+    for (int index = 0; index < 100; ++index)
+        QCOMPARE(values[index], index);
+
+    vector.resize(10);
+    QCOMPARE(copy.size(), 10);
+    vector.shrink_to_fit();
+    QCOMPARE(vector.capacity(), 10);
+    QCOMPARE(copy.capacity(), 10);
+
+    const QCLVector<int> &cvector = copy;
+    for (int index = 0; index < 10; ++index)
+        QCOMPARE(cvector[index], index);
+
+    QVector<int> more;
+    more << 100 << 101 << 102;
+    vector.append(more);
+    QCOMPARE(vector.size(), 13);
+    QCOMPARE(cvector[12], 102);
+    QCOMPARE(cvector[9], 9);
+
+    // Growing with resize() keeps elements written through operator[].
+    QCLVector<int> grown = context.createVector<int>(8);
+    for (int index = 0; index < 8; ++index)
+        grown[index] = index * 3;
+    grown.resize(64);
+    QCOMPARE(grown.size(), 64);
+    for (int index = 0; index < 8; ++index)
+        QCOMPARE(grown[index], index * 3);
+}
+
+// Test the device-side algorithms in QCLAlgorithms.
+void tst_QCL::algorithms()
+{
+    QCLAlgorithms algorithms(&context);
+    QVERIFY(algorithms.context() == &context);
+
+    // Use a size that is not a multiple of any work-group size.
+    const int size = 100003;
+    QVector<cl_int> data(size);
+    qsrand(42);
+    for (int index = 0; index < size; ++index)
+        data[index] = (qrand() % 2001) - 1000;
+
+    QCLVector<cl_int> vector = context.createVector<cl_int>(size);
+    vector.write(data);
+
+    qint64 sum = 0;
+    for (int index = 0; index < size; ++index)
+        sum += data[index];
+    QCOMPARE(qint64(algorithms.reduce(vector)), sum);
+    QCOMPARE(algorithms.reduce(vector, QCLAlgorithms::Minimum),
+             *std::min_element(data.constBegin(), data.constEnd()));
+    QCOMPARE(algorithms.reduce(vector, QCLAlgorithms::Maximum),
+             *std::max_element(data.constBegin(), data.constEnd()));
+
+    QCLVector<cl_int> scanned;
+    QVector<cl_int> result(size);
+    algorithms.inclusiveScan(vector, scanned);
+    QCOMPARE(scanned.size(), size);
+    scanned.read(result.data(), size);
+    cl_int running = 0;
+    for (int index = 0; index < size; ++index) {
+        running += data[index];
+        QCOMPARE(result[index], running);
+    }
+    algorithms.exclusiveScan(vector, scanned);
+    scanned.read(result.data(), size);
+    running = 0;
+    for (int index = 0; index < size; ++index) {
+        QCOMPARE(result[index], running);
+        running += data[index];
+    }
+
+    QCLVector<cl_int> compacted;
+    QVector<cl_int> nonZero;
+    for (int index = 0; index < size; ++index) {
+        if (data[index] != 0)
+            nonZero.append(data[index]);
+    }
+    QCOMPARE(algorithms.compact(vector, compacted), nonZero.size());
+    QCOMPARE(compacted.size(), nonZero.size());
+    result.resize(nonZero.size());
+    compacted.read(result.data(), nonZero.size());
+    QVERIFY(result == nonZero);
+
+    algorithms.sort(vector);
+    result.resize(size);
+    vector.read(result.data(), size);
+    qSort(data);
+    QVERIFY(result == data);
+
+    QCLVector<cl_float> floats = context.createVector<cl_float>(1000);
+    QVector<cl_float> floatData(1000);
+    for (int index = 0; index < 1000; ++index)
+        floatData[index] = float((qrand() % 2001) - 1000) / 8.0f;
+    floats.write(floatData);
+    algorithms.sort(floats);
+    QVector<cl_float> floatResult(1000);
+    floats.read(floatResult.data(), 1000);
+    qSort(floatData);
+    QVERIFY(floatResult == floatData);
+}
+
+// Test element-wise expressions over vectors.
+void tst_QCL::vectorExpressions()
+{
+    const int size = 1000;
+    QCLVector<float> b = context.createVector<float>(size);
+    QCLVector<float> c = context.createVector<float>(size);
+    QCLVector<float> d = context.createVector<float>(size);
+    for (int index = 0; index < size; ++index) {
+        b[index] = float(index);
+        c[index] = 2.0f;
+        d[index] = float(size - index);
+    }
+
+    QCLVector<float> a;
+    a = b * c + d;
+    QVERIFY(!a.isNull());
+    QCOMPARE(a.size(), size);
+    const QCLVector<float> &ca = a;
+    for (int index = 0; index < size; ++index)
+        QCOMPARE(ca[index], float(index) * 2.0f + float(size - index));
+
+    // Scalars, aliasing of the destination, and functions.
+    a = (a - d) / 2.0f + 1;
+    for (int index = 0; index < size; ++index)
+        QCOMPARE(ca[index], float(index) + 1.0f);
+    a = qclMax(-b, 3.0f * qclSqrt(c * c));
+    for (int index = 0; index < size; ++index)
+        QCOMPARE(ca[index], 6.0f);
+
+    QCLVector<cl_int> ints = context.createVector<cl_int>(size);
+    for (int index = 0; index < size; ++index)
+        ints[index] = index;
+    QCLVector<cl_int> squares;
+    squares = ints * ints - ints;
+    const QCLVector<cl_int> &csquares = squares;
+    for (int index = 0; index < size; ++index)
+        QCOMPARE(csquares[index], index * index - index);
+}
+
+#ifdef QT_BUILD_INTERNAL
+QT_BEGIN_NAMESPACE
+extern Q_CL_EXPORT QCLWorkSize qt_cl_run_local_work_size(const QCLKernel &kernel);
+QT_END_NAMESPACE
+#endif
+
+// Test tuning the local work size of a kernel and persisting the result.
+void tst_QCL::autoTuneLocalWorkSize()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + QLatin1String("/tuning.dat");
+
+    // Tune on a context of our own so that the results do not leak
+    // into the other tests.
+    QCLContext tuned;
+    QVERIFY(tuned.create());
+    tuned.setWorkSizeTuningFile(fileName);
+    QCOMPARE(tuned.workSizeTuningFile(), fileName);
+    QCLProgram tunedProgram = tuned.buildProgramFromSourceFile
+        (QLatin1String(":/tst_qcl.cl"));
+    QVERIFY(!tunedProgram.isNull());
+
+    QCLVector<float> vector = tuned.createVector<float>(4096);
+    QCLKernel addToVector = tunedProgram.createKernel("addToVector");
+    addToVector.setGlobalWorkSize(vector.size());
+    addToVector.setArg(0, vector);
+    addToVector.setArg(1, 0.0f);
+
+    QCLWorkSize best = addToVector.autoTuneLocalWorkSize(2);
+    if (best.width() != 0)
+        QCOMPARE(4096 % int(best.width()), 0);
+    QVERIFY(addToVector.localWorkSize().width() == 0);
+    QVERIFY(QFile::exists(fileName));
+#ifdef QT_BUILD_INTERNAL
+    QCOMPARE(qt_cl_run_local_work_size(addToVector), best);
+#endif
+
+    // Later runs pick up the tuned size, including for global sizes
+    // in the same size class that it does not divide.
+    QCLEvent event = addToVector.run();
+    QVERIFY(!event.isNull());
+    event.waitForFinished();
+    addToVector.setGlobalWorkSize(4093);
+    event = addToVector.run();
+    QVERIFY(!event.isNull());
+    event.waitForFinished();
+
+    // Loading the table again must succeed without duplicating entries.
+    tuned.setWorkSizeTuningFile(fileName);
+    tuned.setWorkSizeTuningFile(QString());
+
+    // A new context picks up the saved results from the file.
+    QCLContext loaded;
+    QVERIFY(loaded.create());
+    loaded.setWorkSizeTuningFile(fileName);
+    QCLProgram loadedProgram = loaded.buildProgramFromSourceFile
+        (QLatin1String(":/tst_qcl.cl"));
+    QCLKernel loadedKernel = loadedProgram.createKernel("addToVector");
+    loadedKernel.setGlobalWorkSize(4096);
+#ifdef QT_BUILD_INTERNAL
+    QCOMPARE(qt_cl_run_local_work_size(loadedKernel), best);
+
+    // The shared test context was not affected.
+    QCLKernel shared = program.createKernel("addToVector");
+    shared.setGlobalWorkSize(4096);
+    QCOMPARE(qt_cl_run_local_work_size(shared), QCLWorkSize(0));
+#endif
+}
+
+// Test queueing kernels and transfers without completion events.
+void tst_QCL::runDetached()
+{
+    float values[64];
+    for (int index = 0; index < 64; ++index)
+        values[index] = float(index);
+
+    QCLBuffer buffer = context.createBufferDevice
+        (sizeof(values), QCLMemoryObject::ReadWrite);
+    QCLBuffer copy = context.createBufferDevice
+        (sizeof(values), QCLMemoryObject::ReadWrite);
+    QVERIFY(buffer.writeDetached(0, values, sizeof(values)));
+
+    QCLKernel addToVector = program.createKernel("addToVector");
+    addToVector.setGlobalWorkSize(64);
+    addToVector.setArg(0, buffer);
+    addToVector.setArg(1, 3.0f);
+    QVERIFY(addToVector.runDetached());
+    QVERIFY(addToVector.runDetached(context.commandQueue()));
+    QVERIFY(buffer.copyToDetached(0, sizeof(values), copy, 0));
+
+    float result[64];
+    QVERIFY(copy.readDetached(0, result, sizeof(result)));
+    context.finish();
+    for (int index = 0; index < 64; ++index)
+        QCOMPARE(result[index], float(index) + 6.0f);
+}
+
+// Test recording a sequence of commands and replaying it with patches.
+void tst_QCL::commandList()
+{
+    float values[64];
+    for (int index = 0; index < 64; ++index)
+        values[index] = float(index);
+
+    QCLBuffer buffer = context.createBufferCopy
+        (values, sizeof(values), QCLMemoryObject::ReadWrite);
+    QCLBuffer copy = context.createBufferDevice
+        (sizeof(values), QCLMemoryObject::ReadWrite);
+
+    QCLKernel addToVector = program.createKernel("addToVector");
+    addToVector.setGlobalWorkSize(64);
+    addToVector.setArg(0, buffer);
+    addToVector.setArg(1, 1.0f);
+
+    QCLCommandList list(&context);
+    QVERIFY(list.isEmpty());
+    QCOMPARE(list.context(), &context);
+    int add = list.addKernel(addToVector);
+    QCOMPARE(add, 0);
+    QCOMPARE(list.addBarrier(), 1);
+    QCOMPARE(list.addCopy(buffer, 0, sizeof(values), copy, 0), 2);
+    QCOMPARE(list.count(), 3);
+
+    // Changing the kernel after recording does not affect the list.
+    addToVector.setArg(1, 100.0f);
+
+    QCLEvent event = list.replay();
+    QVERIFY(!event.isNull());
+    event.waitForFinished();
+
+    float result[64];
+    copy.read(result, sizeof(result));
+    for (int index = 0; index < 64; ++index)
+        QCOMPARE(result[index], float(index) + 1.0f);
+
+    list.patchArg(add, 1, 2.0f);
+    list.replay(context.commandQueue()).waitForFinished();
+    copy.read(result, sizeof(result));
+    for (int index = 0; index < 64; ++index)
+        QCOMPARE(result[index], float(index) + 3.0f);
+
+    // Only update the first half of the buffer on the next replay.
+    list.setGlobalWorkSize(add, 32);
+    list.replay().waitForFinished();
+    copy.read(result, sizeof(result));
+    for (int index = 0; index < 64; ++index)
+        QCOMPARE(result[index], float(index) + (index < 32 ? 5.0f : 3.0f));
+
+#ifdef QT_OPENCL_1_1
+    // On an out-of-order queue, every command waits for the events
+    // that were passed to replay(), not only the first.
+    QCLCommandQueue outOfOrder = context.createCommandQueue
+        (CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+    if (!outOfOrder.isNull()) {
+        float zeros[64];
+        for (int index = 0; index < 64; ++index)
+            zeros[index] = 0.0f;
+        QCLBuffer copy2 = context.createBufferCopy
+            (zeros, sizeof(zeros), QCLMemoryObject::ReadWrite);
+        QCLCommandList gated(&context);
+        gated.addCopy(buffer, 0, sizeof(values), copy, 0);
+        gated.addCopy(buffer, 0, sizeof(values), copy2, 0);
+        QCLUserEvent gate = context.createUserEvent();
+        QCLEvent done = gated.replay(outOfOrder, QCLEventList(gate));
+        QVERIFY(!done.isNull());
+        outOfOrder.flush();
+        copy2.read(result, sizeof(result));
+        QCOMPARE(result[1], 0.0f);
+        gate.setFinished();
+        done.waitForFinished();
+        outOfOrder.finish();
+        copy2.read(result, sizeof(result));
+        QCOMPARE(result[1], 6.0f);
+    }
+#endif
+
+    list.clear();
+    QVERIFY(list.isEmpty());
+    QVERIFY(list.replay().isNull());
+}
+
+// Test that cached device and platform properties match the raw queries.
+void tst_QCL::deviceProperties()
+{
+    QList<QCLDevice> devices = QCLDevice::allDevices();
+    foreach (QCLDevice device, devices) {
+        cl_uint units = 0;
+        QVERIFY(clGetDeviceInfo(device.deviceId(), CL_DEVICE_MAX_COMPUTE_UNITS,
+                                sizeof(units), &units, 0) == CL_SUCCESS);
+        size_t groupSize = 0;
+        QVERIFY(clGetDeviceInfo(device.deviceId(), CL_DEVICE_MAX_WORK_GROUP_SIZE,
+                                sizeof(groupSize), &groupSize, 0) == CL_SUCCESS);
+
+        QCOMPARE(device.computeUnits(), int(units));
+        QCOMPARE(device.maximumWorkItemsPerGroup(), groupSize);
+
+        // A separate object for the same device shares the snapshot.
+        QCLDevice other(device.deviceId());
+        QCOMPARE(other.computeUnits(), int(units));
+        QCOMPARE(other.name(), device.name());
+        QCOMPARE(other.extensions(), device.extensions());
+        QCOMPARE(other.versionFlags(), device.versionFlags());
+
+        QCLPlatform platform = device.platform();
+        QCLPlatform otherPlatform(platform.platformId());
+        QCOMPARE(otherPlatform.name(), platform.name());
+        QCOMPARE(otherPlatform.versionFlags(), platform.versionFlags());
+    }
+
+    QCOMPARE(context.defaultDevice(), context.devices().at(0));
+
+    // Null devices and platforms report empty properties.
+    QCLDevice nullDevice;
+    QCOMPARE(nullDevice.computeUnits(), 0);
+    QVERIFY(nullDevice.name().isEmpty());
+    QVERIFY(nullDevice.extensions().isEmpty());
+    QVERIFY(!nullDevice.hasExtension("cl_khr_fp64"));
+    QCOMPARE(nullDevice.maximumWorkItemSize(), QCLWorkSize(1, 1, 1));
+    QCLPlatform nullPlatform;
+    QVERIFY(nullPlatform.name().isEmpty());
+    QVERIFY(!nullPlatform.hasExtension("cl_khr_icd"));
+}
+
+// Test creating contexts through the device discovery cache.
+void tst_QCL::discoveryCache()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + QLatin1String("/devices.dat");
+
+    QCLContext first;
+    first.setDiscoveryCacheFile(fileName);
+    QCOMPARE(first.discoveryCacheFile(), fileName);
+    QVERIFY(first.create());
+    QVERIFY(QFile::exists(fileName));
+
+    // The second context is created from the cache.
+    QCLContext second;
+    second.setDiscoveryCacheFile(fileName);
+    QVERIFY(second.create());
+    QCOMPARE(second.defaultDevice(), first.defaultDevice());
+    QCOMPARE(second.defaultDevice().name(), first.defaultDevice().name());
+    QCOMPARE(second.defaultDevice().computeUnits(),
+             first.defaultDevice().computeUnits());
+
+    // A cache for a different device type is ignored and replaced.
+    QCLContext all;
+    all.setDiscoveryCacheFile(fileName);
+    QVERIFY(all.create(QCLDevice::All));
+    QVERIFY(!all.devices().isEmpty());
+
+    // A corrupt cache is ignored and rewritten.
+    {
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("not a discovery cache");
+    }
+    QCLContext third;
+    third.setDiscoveryCacheFile(fileName);
+    QVERIFY(third.create());
+    QCOMPARE(third.defaultDevice(), first.defaultDevice());
+    QVERIFY(QFileInfo(fileName).size() > 32);
+}
+
+// Test that OpenCL is reported as available on a system that has it.
+void tst_QCL::openCLAvailable()
+{
+    // The test context was created, so the library and a platform exist.
+    QVERIFY(context.isCreated());
+    QVERIFY(QCLContext::isOpenCLAvailable());
+}
+
+static cl_float qt_test_square(cl_float value)
+{
+    return value * value;
+}
+
+// Test vectors and algorithms on a context that has not been created.
+void tst_QCL::hostFallback()
+{
+    QCLContext host;
+    QVERIFY(!host.isCreated());
+
+    // Without host fallback, an uncreated context has no vectors.
+    QVERIFY(!host.isHostFallbackEnabled());
+    QVERIFY(host.createVector<cl_float>(16).isNull());
+    host.setHostFallbackEnabled(true);
+
+    // Large enough to be split across several host threads.
+    const int size = 100003;
+    QCLVector<cl_float> vector = host.createVector<cl_float>(size);
+    QVERIFY(!vector.isNull());
+    QVERIFY(vector.isHostOnly());
+    QCOMPARE(vector.size(), size);
+    QVERIFY(vector.toBuffer().isNull());
+    QCOMPARE(quintptr(&vector[0]) % 64, quintptr(0));
+
+    QVector<cl_float> data(size);
+    for (int index = 0; index < size; ++index)
+        data[index] = float(index % 100) - 50.0f;
+    vector.write(data);
+    QCOMPARE(vector[10], -40.0f);
+    {
+        QCLVectorView<cl_float> view = vector.mapRange(100, 4);
+        QCOMPARE(view.size(), 4);
+        QCOMPARE(view[1], -49.0f);
+        view[1] = 7.0f;
+    }
+    QCOMPARE(vector[101], 7.0f);
+    vector[101] = -49.0f;
+
+    QCLAlgorithms algorithms(&host);
+    double sum = 0.0;
+    for (int index = 0; index < size; ++index)
+        sum += data[index];
+    QCOMPARE(double(algorithms.reduce(vector)), sum);
+    QCOMPARE(algorithms.reduce(vector, QCLAlgorithms::Minimum), -50.0f);
+    QCOMPARE(algorithms.reduce(vector, QCLAlgorithms::Maximum), 49.0f);
+
+    QCLVector<cl_float> squares;
+    algorithms.transform(vector, squares, qt_test_square);
+    QVERIFY(squares.isHostOnly());
+    QCOMPARE(squares.size(), size);
+    for (int index = 0; index < size; index += 997)
+        QCOMPARE(squares[index], data[index] * data[index]);
+
+    QCLVector<cl_float> copied;
+    algorithms.copy(vector, copied);
+    QVector<cl_float> result(size);
+    copied.read(result.data(), size);
+    QVERIFY(result == data);
+
+    algorithms.fill(copied, 3.0f);
+    QCOMPARE(algorithms.reduce(copied), float(size) * 3.0f);
+
+    algorithms.sort(vector);
+    vector.read(result.data(), size);
+    qSort(data);
+    QVERIFY(result == data);
+
+    // Growing a host vector keeps its contents.
+    vector.append(100.0f);
+    QCOMPARE(vector.size(), size + 1);
+    QCOMPARE(vector[size], 100.0f);
+    QCOMPARE(vector[0], -50.0f);
+
+    // fill(), copy() and transform() also work on device vectors.
+    QCLAlgorithms device(&context);
+    QCLVector<cl_float> values = context.createVector<cl_float>(1000);
+    device.fill(values, 2.0f);
+    QCLVector<cl_float> deviceCopy;
+    device.copy(values, deviceCopy);
+    device.transform(deviceCopy, deviceCopy, qt_test_square);
+    QCOMPARE(device.reduce(deviceCopy), 4000.0f);
+    QCOMPARE(device.reduce(values), 2000.0f);
+
+    // Host changes to device vectors reach kernels that run afterwards.
+    device.transform(values, values, qt_test_square);
+    deviceCopy = values * 2.0f;
+    QCOMPARE(deviceCopy[999], 8.0f);
+
+    // Expressions need a kernel, so they reject host vectors, even
+    // when the same host vector appears more than once.
+    QCLVector<cl_float> sum;
+    QTest::ignoreMessage(QtWarningMsg, "QCLVectorExpression: expressions cannot be evaluated on host vectors");
+    sum = squares + copied;
+    QTest::ignoreMessage(QtWarningMsg, "QCLVectorExpression: expressions cannot be evaluated on host vectors");
+    sum = squares * squares;
+}
+
+// Test recording queue activity and exporting it as a Chrome trace.
+void tst_QCL::profiler()
+{
+    float values[64];
+    for (int index = 0; index < 64; ++index)
+        values[index] = float(index);
+    QCLBuffer buffer = context.createBufferCopy
+        (values, sizeof(values), QCLMemoryObject::ReadWrite);
+    QCLBuffer copy = context.createBufferDevice
+        (sizeof(values), QCLMemoryObject::ReadWrite);
+
+    QCLKernel addToVector = program.createKernel("addToVector");
+    addToVector.setGlobalWorkSize(64);
+    addToVector.setArg(0, buffer);
+    addToVector.setArg(1, 1.0f);
+
+    QCLProfiler profiler(&context);
+    QCOMPARE(profiler.context(), &context);
+    QVERIFY(!profiler.isActive());
+    QVERIFY(profiler.start());
+    QVERIFY(profiler.isActive());
+    QVERIFY(context.commandQueue().isProfilingEnabled());
+
+    // Only one profiler can record on a context at a time.
+    QCLProfiler other(&context);
+    QTest::ignoreMessage(QtWarningMsg, "QCLProfiler::start: another profiler is already recording on this context");
+    QVERIFY(!other.start());
+
+    QCLEvent run = addToVector.run();
+    QCLEvent copied = buffer.copyToAsync
+        (0, sizeof(values), copy, 0, QCLEventList(run));
+    copied.waitForFinished();
+    profiler.stop();
+    QVERIFY(!profiler.isActive());
+    QCOMPARE(profiler.count(), 2);
+
+    // Commands after stop() are not recorded.
+    addToVector.run().waitForFinished();
+    QCOMPARE(profiler.count(), 2);
+
+    QJsonDocument trace = QJsonDocument::fromJson(profiler.toTrace());
+    QVERIFY(trace.isObject());
+    QJsonArray events = trace.object().value(QLatin1String("traceEvents")).toArray();
+    QStringList slices;
+    int flows = 0;
+    int tracks = 0;
+    for (int index = 0; index < events.size(); ++index) {
+        QJsonObject event = events.at(index).toObject();
+        QString phase = event.value(QLatin1String("ph")).toString();
+        if (phase == QLatin1String("X")) {
+            slices.append(event.value(QLatin1String("name")).toString());
+            QVERIFY(event.value(QLatin1String("dur")).toDouble() >= 0.0);
+        } else if (phase == QLatin1String("s") || phase == QLatin1String("f")) {
+            ++flows;
+        } else if (event.value(QLatin1String("name")).toString() ==
+                        QLatin1String("thread_name")) {
+            ++tracks;
+        }
+    }
+    QCOMPARE(slices.size(), 2);
+    QVERIFY(slices.contains(QLatin1String("addToVector")));
+    QVERIFY(slices.contains(QLatin1String("Copy buffer")));
+    QCOMPARE(flows, 2);
+    QCOMPARE(tracks, 1);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + QLatin1String("/trace.json");
+    QVERIFY(profiler.saveTrace(fileName));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(QJsonDocument::fromJson(file.readAll()).isObject());
+
+    profiler.clear();
+    QCOMPARE(profiler.count(), 0);
+
+    // A queue that is set while profiling is kept after stop().
+    QCLCommandQueue original = context.commandQueue();
+    QVERIFY(profiler.start());
+    QCLCommandQueue chosen = context.createCommandQueue(0);
+    QVERIFY(!chosen.isNull());
+    context.setCommandQueue(chosen);
+    profiler.stop();
+    QVERIFY(context.commandQueue() == chosen);
+    context.setCommandQueue(original);
+
+    // A profiler can outlive the context that it records.
+    QCLContext *shortLived = new QCLContext();
+    QVERIFY(shortLived->create());
+    QCLProfiler orphan(shortLived);
+    QVERIFY(orphan.start());
+    delete shortLived;
+    QVERIFY(!orphan.isActive());
+    QVERIFY(orphan.context() == 0);
+}
+
 QTEST_MAIN(tst_QCL)
 
 #include "tst_qcl.moc"
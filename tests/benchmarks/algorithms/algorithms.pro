@@ -0,0 +1,5 @@
+TEMPLATE=app
+QT += testlib opencl
+CONFIG += unittest warn_on
+
+SOURCES += tst_algorithms.cpp
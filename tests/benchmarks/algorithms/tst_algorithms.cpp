@@ -0,0 +1,235 @@
+/****************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (qt-info@nokia.com)
+**
+** This file is part of the QtOpenCL module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** No Commercial Usage
+** This file contains pre-release code and may not be distributed.
+** You may use this file in accordance with the terms and conditions
+** contained in the Technology Preview License Agreement accompanying
+** this package.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain additional
+** rights.  These rights are described in the Nokia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at qt-info@nokia.com.
+**
+**
+**
+**
+**
+**
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include "qclcontext.h"
+#include "qclalgorithms.h"
+#include <algorithm>
+#include <numeric>
+
+// Compare the device-side algorithms in QCLAlgorithms with the
+// equivalent host-side std:: algorithms, including the cost of
+// reading the data back to the host.
+class tst_Algorithms : public QObject
+{
+    Q_OBJECT
+public:
+    tst_Algorithms() : algorithms(0) {}
+    virtual ~tst_Algorithms() { delete algorithms; }
+
+private slots:
+    void initTestCase();
+
+    void reduce_data();
+    void reduce();
+    void reduceHost_data();
+    void reduceHost();
+
+    void scan_data();
+    void scan();
+    void scanHost_data();
+    void scanHost();
+
+    void sort_data();
+    void sort();
+    void sortHost_data();
+    void sortHost();
+
+private:
+    QCLContext context;
+    QCLAlgorithms *algorithms;
+
+    void sizes();
+    QVector<float> randomData(int size);
+};
+
+void tst_Algorithms::initTestCase()
+{
+    QVERIFY(context.create());
+    algorithms = new QCLAlgorithms(&context);
+}
+
+void tst_Algorithms::sizes()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("64K") << 65536;
+    QTest::newRow("1M") << 1048576;
+    QTest::newRow("16M") << 16777216;
+}
+
+QVector<float> tst_Algorithms::randomData(int size)
+{
+    QVector<float> data(size);
+    qsrand(size);
+    for (int index = 0; index < size; ++index)
+        data[index] = float(qrand()) / float(RAND_MAX);
+    return data;
+}
+
+void tst_Algorithms::reduce_data()
+{
+    sizes();
+}
+
+void tst_Algorithms::reduce()
+{
+    QFETCH(int, size);
+    QCLVector<float> vector = context.createVector<float>(size);
+    vector.write(randomData(size));
+
+    // Build the program outside the benchmark loop.
+    algorithms->reduce(vector);
+
+    float sum = 0.0f;
+    QBENCHMARK {
+        sum = algorithms->reduce(vector);
+    }
+    QVERIFY(sum > 0.0f);
+}
+
+void tst_Algorithms::reduceHost_data()
+{
+    sizes();
+}
+
+void tst_Algorithms::reduceHost()
+{
+    QFETCH(int, size);
+    QCLVector<float> vector = context.createVector<float>(size);
+    vector.write(randomData(size));
+    QVector<float> data(size);
+
+    float sum = 0.0f;
+    QBENCHMARK {
+        vector.read(data.data(), size);
+        sum = std::accumulate(data.constBegin(), data.constEnd(), 0.0f);
+    }
+    QVERIFY(sum > 0.0f);
+}
+
+void tst_Algorithms::scan_data()
+{
+    sizes();
+}
+
+void tst_Algorithms::scan()
+{
+    QFETCH(int, size);
+    QCLVector<float> vector = context.createVector<float>(size);
+    vector.write(randomData(size));
+    QCLVector<float> output = context.createVector<float>(size);
+
+    algorithms->inclusiveScan(vector, output);
+    context.finish();
+
+    QBENCHMARK {
+        algorithms->inclusiveScan(vector, output);
+        context.finish();
+    }
+}
+
+void tst_Algorithms::scanHost_data()
+{
+    sizes();
+}
+
+void tst_Algorithms::scanHost()
+{
+    QFETCH(int, size);
+    QCLVector<float> vector = context.createVector<float>(size);
+    vector.write(randomData(size));
+    QCLVector<float> output = context.createVector<float>(size);
+    QVector<float> data(size);
+
+    QBENCHMARK {
+        vector.read(data.data(), size);
+        std::partial_sum(data.begin(), data.end(), data.begin());
+        output.write(data);
+    }
+}
+
+void tst_Algorithms::sort_data()
+{
+    sizes();
+}
+
+void tst_Algorithms::sort()
+{
+    QFETCH(int, size);
+    QVector<float> data = randomData(size);
+    QCLVector<float> vector = context.createVector<float>(size);
+
+    vector.write(data);
+    algorithms->sort(vector);
+    context.finish();
+
+    QBENCHMARK {
+        vector.write(data);
+        algorithms->sort(vector);
+        context.finish();
+    }
+}
+
+void tst_Algorithms::sortHost_data()
+{
+    sizes();
+}
+
+void tst_Algorithms::sortHost()
+{
+    QFETCH(int, size);
+    QVector<float> data = randomData(size);
+    QCLVector<float> vector = context.createVector<float>(size);
+    QVector<float> sorted(size);
+
+    QBENCHMARK {
+        vector.write(data);
+        vector.read(sorted.data(), size);
+        std::sort(sorted.begin(), sorted.end());
+        vector.write(sorted);
+    }
+}
+
+QTEST_MAIN(tst_Algorithms)
+
+#include "tst_algorithms.moc"
@@ -1,3 +1,3 @@
 TEMPLATE = subdirs
-SUBDIRS += mandelbrot overhead
+SUBDIRS += algorithms mandelbrot overhead
 contains(QT_CONFIG, private_tests): SUBDIRS += blur
@@ -4,3 +4,16 @@ CONFIG += unittest warn_on
 
 SOURCES += tst_overhead.cpp
 RESOURCES += overhead.qrc
+
+# The test calls OpenCL directly as well as through QtOpenCL, which
+# does not link against OpenCL itself when it loads it at runtime.
+!macx {
+    !isEmpty(QMAKE_LIBDIR_OPENCL) {
+        LIBS += -L$$QMAKE_LIBDIR_OPENCL
+    }
+    !isEmpty(QMAKE_LIBS_OPENCL) {
+        LIBS += $$QMAKE_LIBS_OPENCL
+    } else {
+        LIBS += -lOpenCL
+    }
+}
@@ -41,6 +41,7 @@
 
 #include <QtTest/QtTest>
 #include "qclcontext.h"
+#include "qclcommandlist.h"
 
 // Test the overhead of QtOpenCL operations compared to performing
 // them directly with raw OpenCL C API calls.
@@ -63,6 +64,18 @@ private slots:
     // Test the overhead of kernel execution.
     void kernelExec();
     void kernelExecRaw();
+    void kernelExecSameArgs();
+    void kernelExecOneArgChanged();
+
+    // Test the overhead of event creation on enqueued commands.
+    void kernelExecAsync();
+    void kernelExecDetached();
+    void bufferWriteAsync();
+    void bufferWriteDetached();
+
+    // Test the overhead of replaying a recorded command sequence.
+    void kernelSequence();
+    void kernelSequenceCommandList();
 
 private:
     QCLContext context;
@@ -184,6 +197,159 @@ void tst_OpenCLOverhead::kernelExecRaw()
     }
 }
 
+// Same launch as kernelExecRaw(), but the argument cache in QCLKernel
+// suppresses the redundant clSetKernelArg() calls.
+void tst_OpenCLOverhead::kernelExecSameArgs()
+{
+    float args[] = {1.0f, 2.0f, -5.0f, 10.0f};
+
+    QCLBuffer buffer;
+    buffer = context.createBufferDevice(1024, QCLMemoryObject::ReadWrite);
+
+    QCLKernel kernel = program.createKernel("storeVec4");
+
+    QBENCHMARK {
+        kernel(buffer, args[0], args[1], args[2], args[3]).waitForFinished();
+    }
+
+    // Only the first launch should have reached the driver.
+    QCOMPARE(kernel.argUpdatesIssued(), quint64(5));
+}
+
+// Typical render loop: only one of the five arguments changes per launch.
+void tst_OpenCLOverhead::kernelExecOneArgChanged()
+{
+    float args[] = {1.0f, 2.0f, -5.0f, 10.0f};
+
+    QCLBuffer buffer;
+    buffer = context.createBufferDevice(1024, QCLMemoryObject::ReadWrite);
+
+    QCLKernel kernel = program.createKernel("storeVec4");
+
+    QBENCHMARK {
+        args[3] += 1.0f;
+        kernel(buffer, args[0], args[1], args[2], args[3]).waitForFinished();
+    }
+
+    QVERIFY(kernel.argUpdatesIssued() >= quint64(5));
+    QCOMPARE(kernel.argUpdatesIssued() + kernel.argUpdatesSkipped(),
+             quint64(5) * (kernel.argUpdatesIssued() - 4));
+}
+
+// Queue launches back-to-back and wait once at the end, creating and
+// releasing an event for every launch.
+void tst_OpenCLOverhead::kernelExecAsync()
+{
+    QCLBuffer buffer;
+    buffer = context.createBufferDevice(1024, QCLMemoryObject::ReadWrite);
+
+    QCLKernel kernel = program.createKernel("storeVec4");
+    kernel.setArg(0, buffer);
+    kernel.setArg(1, 1.0f);
+    kernel.setArg(2, 2.0f);
+    kernel.setArg(3, -5.0f);
+    kernel.setArg(4, 10.0f);
+
+    QBENCHMARK {
+        for (int index = 0; index < 100; ++index)
+            kernel.run();
+        context.finish();
+    }
+}
+
+// Same as kernelExecAsync(), but without asking the driver for events.
+void tst_OpenCLOverhead::kernelExecDetached()
+{
+    QCLBuffer buffer;
+    buffer = context.createBufferDevice(1024, QCLMemoryObject::ReadWrite);
+
+    QCLKernel kernel = program.createKernel("storeVec4");
+    kernel.setArg(0, buffer);
+    kernel.setArg(1, 1.0f);
+    kernel.setArg(2, 2.0f);
+    kernel.setArg(3, -5.0f);
+    kernel.setArg(4, 10.0f);
+
+    QBENCHMARK {
+        for (int index = 0; index < 100; ++index)
+            QVERIFY(kernel.runDetached());
+        context.finish();
+    }
+}
+
+void tst_OpenCLOverhead::bufferWriteAsync()
+{
+    float data[4] = {1.0f, 2.0f, -5.0f, 10.0f};
+
+    QCLBuffer buffer;
+    buffer = context.createBufferDevice(1024, QCLMemoryObject::ReadWrite);
+
+    QBENCHMARK {
+        for (int index = 0; index < 64; ++index)
+            buffer.writeAsync(index * sizeof(data), data, sizeof(data));
+        context.finish();
+    }
+}
+
+void tst_OpenCLOverhead::bufferWriteDetached()
+{
+    float data[4] = {1.0f, 2.0f, -5.0f, 10.0f};
+
+    QCLBuffer buffer;
+    buffer = context.createBufferDevice(1024, QCLMemoryObject::ReadWrite);
+
+    QBENCHMARK {
+        for (int index = 0; index < 64; ++index)
+            QVERIFY(buffer.writeDetached(index * sizeof(data), data, sizeof(data)));
+        context.finish();
+    }
+}
+
+// A frame of 20 launches that are set up from scratch every time.
+void tst_OpenCLOverhead::kernelSequence()
+{
+    QCLBuffer buffer;
+    buffer = context.createBufferDevice(1024, QCLMemoryObject::ReadWrite);
+
+    QCLKernel kernel = program.createKernel("storeVec4");
+    float time = 0.0f;
+
+    QBENCHMARK {
+        time += 1.0f;
+        for (int index = 0; index < 20; ++index)
+            kernel(buffer, float(index), 2.0f, -5.0f, time);
+        context.finish();
+    }
+}
+
+// Same frame as kernelSequence(), recorded once and replayed with
+// one patched argument per launch.
+void tst_OpenCLOverhead::kernelSequenceCommandList()
+{
+    QCLBuffer buffer;
+    buffer = context.createBufferDevice(1024, QCLMemoryObject::ReadWrite);
+
+    QCLKernel kernel = program.createKernel("storeVec4");
+    QCLCommandList list(&context);
+    for (int index = 0; index < 20; ++index) {
+        kernel.setArg(0, buffer);
+        kernel.setArg(1, float(index));
+        kernel.setArg(2, 2.0f);
+        kernel.setArg(3, -5.0f);
+        kernel.setArg(4, 0.0f);
+        list.addKernel(kernel);
+    }
+    float time = 0.0f;
+
+    QBENCHMARK {
+        time += 1.0f;
+        for (int index = 0; index < 20; ++index)
+            list.patchArg(index, 4, time);
+        list.replay();
+        context.finish();
+    }
+}
+
 QTEST_MAIN(tst_OpenCLOverhead)
 
 #include "tst_overhead.moc"